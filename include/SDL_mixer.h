@@ -287,6 +287,23 @@ typedef enum Mix_Fading {
     MIX_FADING_IN
 } Mix_Fading;
 
+/**
+ * The shapes of the channel fades
+ */
+typedef enum Mix_FadeCurve {
+    MIX_FADE_LINEAR,        /* The gain changes linearly (the default) */
+    MIX_FADE_EXPONENTIAL    /* The gain changes by the same decibels per time */
+} Mix_FadeCurve;/*MixerX*/
+
+/**
+ * The resamplers of the low-end audio stream (ENABLE_LOWEND_RESAMPLER)
+ */
+typedef enum Mix_ResamplerQuality {
+    MIX_RESAMPLER_NEAREST,  /* Nearest-neighbour, the cheapest one (the default) */
+    MIX_RESAMPLER_LINEAR,   /* Linear interpolation */
+    MIX_RESAMPLER_SINC      /* 16-tap windowed-sinc filter */
+} Mix_ResamplerQuality;/*MixerX*/
+
 /**
  * These are types of music files (not libraries used to load them)
  */
@@ -626,6 +643,98 @@ extern DECLSPEC int MIXCALL Mix_OpenAudioDevice(int frequency, Uint16 format, in
  */
 extern DECLSPEC void MIXCALL Mix_PauseAudio(int pause_on);
 
+/**
+ * Open the mixer without an audio device to render audio offline.
+ *
+ * The mixer works like opened by Mix_OpenAudio() with the exact format
+ * given, but nothing plays it: the audio is produced only by
+ * Mix_RenderFrames() (or Mix_RenderWAV()) as fast as the CPU allows, so
+ * musics and scenes can be pre-rendered, or checked by tests, with no
+ * audio hardware. Audio locking is not needed, call all functions of the
+ * library from the same thread.
+ *
+ * The decode-ahead of musics (see Mix_SetMusicDecodeAhead()) and the
+ * parallel rendering of multi-music streams (see
+ * Mix_SetMultiMusicThreads()) keep working, but they wait for late
+ * threads instead of dropping the audio.
+ *
+ * Close the mixer by Mix_CloseAudio().
+ *
+ * This is the MixerX fork exclusive function.
+ *
+ * \param frequency the sample rate in Hz.
+ * \param format the audio format, one of SDL's AUDIO_* values.
+ * \param channels number of audio channels (1 to 8).
+ * \param chunksize the number of frames the mixer renders at once, this
+ *                  is the granularity of fades, effects and hooks.
+ * \returns 0 if successful, -1 on error.
+ *
+ * \since This function is available at the MixerX only
+ *
+ * \sa Mix_RenderFrames
+ * \sa Mix_RenderWAV
+ * \sa Mix_CloseAudio
+ */
+extern DECLSPEC int MIXCALL Mix_OpenAudioOffline(int frequency, Uint16 format, int channels, int chunksize);/*MixerX*/
+
+/**
+ * Render the mixed audio into the buffer.
+ *
+ * The mixer runs the same way as the audio callback does, advancing all
+ * channels and musics by the given number of frames. This is only possible
+ * when no audio device got been opened by the mixer, normally after
+ * Mix_OpenAudioOffline(), or Mix_InitMixer().
+ *
+ * This is the MixerX fork exclusive function.
+ *
+ * \param buffer the buffer of at least `frames` frames in the mixer format.
+ * \param frames the number of frames to render.
+ * \returns the number of frames rendered, or -1 on error.
+ *
+ * \since This function is available at the MixerX only
+ *
+ * \sa Mix_OpenAudioOffline
+ * \sa Mix_RenderWAV_RW
+ */
+extern DECLSPEC int MIXCALL Mix_RenderFrames(void *buffer, int frames);/*MixerX*/
+
+/**
+ * Render the mixed audio into a WAVE stream.
+ *
+ * Works like Mix_RenderFrames(), but writes a complete RIFF WAVE file.
+ * The mixer format must be one of AUDIO_U8, AUDIO_S16LSB, AUDIO_S32LSB or
+ * AUDIO_F32LSB.
+ *
+ * This is the MixerX fork exclusive function.
+ *
+ * \param dst the stream to write into.
+ * \param freedst non-zero to close/free the SDL_RWops before returning,
+ *                zero to leave it open.
+ * \param frames the number of frames to render.
+ * \returns 0 if successful, -1 on error.
+ *
+ * \since This function is available at the MixerX only
+ *
+ * \sa Mix_RenderWAV
+ * \sa Mix_RenderFrames
+ */
+extern DECLSPEC int MIXCALL Mix_RenderWAV_RW(SDL_RWops *dst, int freedst, int frames);/*MixerX*/
+
+/**
+ * Render the mixed audio into a WAVE file.
+ *
+ * This is the MixerX fork exclusive function.
+ *
+ * \param file the path of the file to write.
+ * \param frames the number of frames to render.
+ * \returns 0 if successful, -1 on error.
+ *
+ * \since This function is available at the MixerX only
+ *
+ * \sa Mix_RenderWAV_RW
+ */
+extern DECLSPEC int MIXCALL Mix_RenderWAV(const char *file, int frames);/*MixerX*/
+
 /**
  * Find out what the actual audio device parameters are.
  *
@@ -682,6 +791,45 @@ extern DECLSPEC int MIXCALL Mix_QuerySpec(int *frequency, Uint16 *format, int *c
  */
 extern DECLSPEC int MIXCALL Mix_QuerySpecEx(SDL_AudioSpec *out_spec);
 
+/**
+ * Set the quality of the low-end resampler.
+ *
+ * When the library is built with the ENABLE_LOWEND_RESAMPLER option, musics
+ * are resampled to the output rate (and by Mix_SetMusicSpeed()) with the
+ * custom resampler instead of the SDL_AudioStream. The nearest-neighbour
+ * resampler is the cheapest one, the linear and the sinc ones cost more but
+ * sound much better. Formats which the chosen resampler can't process fall
+ * back to the nearest-neighbour one.
+ *
+ * The quality applies to musics loaded since now, and to already loaded ones
+ * once they change the speed or the format of the stream.
+ *
+ * This is the MixerX fork exclusive function.
+ *
+ * \param quality the resampler to use.
+ * \returns 0 on success or -1 if the library is built without the low-end
+ *          resampler, or the quality is unknown.
+ *
+ * \since This function is available at the MixerX only
+ *
+ * \sa Mix_GetResamplerQuality
+ */
+extern DECLSPEC int MIXCALL Mix_SetResamplerQuality(Mix_ResamplerQuality quality);/*MixerX*/
+
+/**
+ * Get the quality of the low-end resampler.
+ *
+ * This is the MixerX fork exclusive function.
+ *
+ * \returns the current resampler or -1 if the library is built without the
+ *          low-end resampler.
+ *
+ * \since This function is available at the MixerX only
+ *
+ * \sa Mix_SetResamplerQuality
+ */
+extern DECLSPEC int MIXCALL Mix_GetResamplerQuality(void);/*MixerX*/
+
 /**
  * Dynamically change the number of channels managed by the mixer.
  *
@@ -886,6 +1034,23 @@ extern DECLSPEC void MIXCALL Mix_SetMusicFileName(Mix_Music *music, const char *
  */
 extern DECLSPEC Mix_Music * MIXCALL Mix_LoadMUS_RW(SDL_RWops *src, int freesrc);
 
+/* Set this hint (or environment variable) before loading the MP3 music to
+ * choose how the dr_mp3 codec builds its seek table:
+ *  "0" - don't build it, every seek decodes the stream from the start,
+ *  "1" - (default) take the Xing TOC if the file has it, or scan the headers
+ *        of all frames otherwise,
+ *  "2" - always scan the headers of all frames, so seeking is exact.
+ * The scan is done while loading, by Mix_LoadMUS() or by the loader thread
+ * of Mix_LoadMUSAsync(), never by the seek itself. */
+#define MIX_MP3SEEKTABLE  "MIX_MP3SEEKTABLE" /*MixerX*/
+
+/* Set this hint (or environment variable) before opening the audio device to
+ * limit the memory, in kilobytes, taken by the PXTone cache of prepared
+ * voices (decoded Ogg, converted PCM and built noise). Songs loaded again, or
+ * sharing the same voices, take them from the cache instead of preparing
+ * them again. The default is "32768", "0" disables the cache. */
+#define MIX_PXTONE_VOICECACHE  "MIX_PXTONE_VOICECACHE" /*MixerX*/
+
 /**
  * Load a supported audio format into a music object with the music arguments.
  *
@@ -1152,6 +1317,260 @@ extern DECLSPEC Mix_Chunk * MIXCALL Mix_QuickLoad_WAV(Uint8 *mem);
  */
 extern DECLSPEC Mix_Chunk * MIXCALL Mix_QuickLoad_RAW(Uint8 *mem, Uint32 len);
 
+/**
+ * Load a chunk which stays compressed in memory.
+ *
+ * Works like Mix_LoadWAV(), but the file is kept in memory as is (files
+ * mapped into memory are not even copied), and it gets decoded by every
+ * channel playing it. It's best for the big banks of sounds like voice lines
+ * in OGG Vorbis or QOA which take many times more memory being decoded.
+ *
+ * Chunks which got been played through are kept decoded in a cache, so the
+ * frequently played ones are not decoded again. The cache size is set by
+ * Mix_SetChunkCacheMemory().
+ *
+ * The `abuf` of the returned chunk is NULL, and its `alen` is the length of
+ * the decoded audio, as it's estimated by the duration of the file.
+ *
+ * This is the MixerX fork exclusive function.
+ *
+ * \param file the filesystem path to load data from.
+ * \returns a new chunk, or NULL on error.
+ *
+ * \since This function is available at the MixerX only
+ *
+ * \sa Mix_LoadWAVCompressed_RW
+ * \sa Mix_SetChunkCacheMemory
+ * \sa Mix_FreeChunk
+ */
+extern DECLSPEC Mix_Chunk * MIXCALL Mix_LoadWAVCompressed(const char *file);/*MixerX*/
+
+/**
+ * Load a chunk which stays compressed in memory from an SDL_RWops.
+ *
+ * Works like Mix_LoadWAVCompressed(). The data is copied from `src`, except
+ * of files mapped by the default file opener when `freesrc` is non-zero.
+ *
+ * This is the MixerX fork exclusive function.
+ *
+ * \param src an SDL_RWops that data will be read from.
+ * \param freesrc non-zero to close/free the SDL_RWops before returning, zero
+ *                to leave it open.
+ * \returns a new chunk, or NULL on error.
+ *
+ * \since This function is available at the MixerX only
+ *
+ * \sa Mix_LoadWAVCompressed
+ */
+extern DECLSPEC Mix_Chunk * MIXCALL Mix_LoadWAVCompressed_RW(SDL_RWops *src, int freesrc);/*MixerX*/
+
+/**
+ * Set the memory budget of the decoded compressed chunks cache.
+ *
+ * The least recently played chunks are dropped from the cache once it's
+ * over the budget. Chunks bigger than the budget are never cached. Zero
+ * disables the cache, so compressed chunks are always decoded while playing.
+ * The default is 8 MB.
+ *
+ * This is the MixerX fork exclusive function.
+ *
+ * \param bytes the memory budget in bytes.
+ *
+ * \since This function is available at the MixerX only
+ *
+ * \sa Mix_GetChunkCacheMemory
+ * \sa Mix_LoadWAVCompressed
+ */
+extern DECLSPEC void MIXCALL Mix_SetChunkCacheMemory(Sint64 bytes);/*MixerX*/
+
+/**
+ * Get the memory budget of the decoded compressed chunks cache.
+ *
+ * This is the MixerX fork exclusive function.
+ *
+ * \returns the memory budget in bytes.
+ *
+ * \since This function is available at the MixerX only
+ *
+ * \sa Mix_SetChunkCacheMemory
+ */
+extern DECLSPEC Sint64 MIXCALL Mix_GetChunkCacheMemory(void);/*MixerX*/
+
+/**
+ * The handle of a chunk or music being loaded in background.
+ *
+ * This is the MixerX fork exclusive type.
+ */
+typedef struct Mix_AsyncLoad Mix_AsyncLoad;/*MixerX*/
+
+/**
+ * The state of a background loading.
+ *
+ * This is the MixerX fork exclusive type.
+ */
+typedef enum
+{
+    MIX_ASYNC_LOADING,
+    MIX_ASYNC_DONE,
+    MIX_ASYNC_FAILED
+} Mix_AsyncLoadStatus;/*MixerX*/
+
+/**
+ * The callback called once the background loading got been finished.
+ *
+ * It's called from the loader thread, keep it short. It's allowed to call
+ * Mix_FinishLoadWAVAsync(), Mix_FinishLoadMUSAsync(), or Mix_CancelAsyncLoad()
+ * on the `load` inside this callback.
+ *
+ * This is the MixerX fork exclusive type.
+ */
+typedef void (SDLCALL *Mix_AsyncLoadCallback)(Mix_AsyncLoad *load, Mix_AsyncLoadStatus status, void *user_data);/*MixerX*/
+
+/**
+ * Start loading a chunk from a file at background.
+ *
+ * Works like Mix_LoadWAV(), but the decoding is performed by the pool of
+ * loader threads. The audio lock is not held while decoding, so it's safe to
+ * load many sounds while playing.
+ *
+ * WAV, OGG, MP3, FLAC, Opus, WavPack and QOA files are decoded by several
+ * threads at once. Other formats (MIDI, trackers, GME, FFmpeg, PXTone) keep
+ * a shared state, their files are opened by one loader thread at a time.
+ *
+ * The result should be taken with Mix_FinishLoadWAVAsync(), or the loading
+ * should be dropped by Mix_CancelAsyncLoad().
+ *
+ * This is the MixerX fork exclusive function.
+ *
+ * \param file the filesystem path to load data from.
+ * \param callback the function to call on finish, or NULL.
+ * \param user_data a pointer that is passed to `callback`.
+ * \returns the loading handle, or NULL on error.
+ *
+ * \since This function is available at the MixerX only
+ *
+ * \sa Mix_GetAsyncLoadStatus
+ * \sa Mix_FinishLoadWAVAsync
+ * \sa Mix_CancelAsyncLoad
+ */
+extern DECLSPEC Mix_AsyncLoad * MIXCALL Mix_LoadWAVAsync(const char *file, Mix_AsyncLoadCallback callback, void *user_data);/*MixerX*/
+
+/**
+ * Start loading a chunk from an SDL_RWops at background.
+ *
+ * Works like Mix_LoadWAV_RW(). The `src` must not be used by the caller
+ * until the loading got been finished.
+ *
+ * This is the MixerX fork exclusive function.
+ *
+ * \param src an SDL_RWops that data will be read from.
+ * \param freesrc non-zero to close/free the SDL_RWops once loaded, zero to
+ *                leave it open.
+ * \param callback the function to call on finish, or NULL.
+ * \param user_data a pointer that is passed to `callback`.
+ * \returns the loading handle, or NULL on error.
+ *
+ * \since This function is available at the MixerX only
+ *
+ * \sa Mix_FinishLoadWAVAsync
+ */
+extern DECLSPEC Mix_AsyncLoad * MIXCALL Mix_LoadWAVAsync_RW(SDL_RWops *src, int freesrc, Mix_AsyncLoadCallback callback, void *user_data);/*MixerX*/
+
+/**
+ * Start loading a music from a file at background.
+ *
+ * Works like Mix_LoadMUS(), including the path arguments.
+ *
+ * This is the MixerX fork exclusive function.
+ *
+ * \param file the filesystem path to load data from.
+ * \param callback the function to call on finish, or NULL.
+ * \param user_data a pointer that is passed to `callback`.
+ * \returns the loading handle, or NULL on error.
+ *
+ * \since This function is available at the MixerX only
+ *
+ * \sa Mix_FinishLoadMUSAsync
+ */
+extern DECLSPEC Mix_AsyncLoad * MIXCALL Mix_LoadMUSAsync(const char *file, Mix_AsyncLoadCallback callback, void *user_data);/*MixerX*/
+
+/**
+ * Start loading a music from an SDL_RWops at background.
+ *
+ * Works like Mix_LoadMUS_RW(). The `src` must not be used by the caller
+ * until the loading got been finished.
+ *
+ * This is the MixerX fork exclusive function.
+ *
+ * \param src an SDL_RWops that data will be read from.
+ * \param freesrc non-zero to give the ownership of the SDL_RWops to the music.
+ * \param callback the function to call on finish, or NULL.
+ * \param user_data a pointer that is passed to `callback`.
+ * \returns the loading handle, or NULL on error.
+ *
+ * \since This function is available at the MixerX only
+ *
+ * \sa Mix_FinishLoadMUSAsync
+ */
+extern DECLSPEC Mix_AsyncLoad * MIXCALL Mix_LoadMUSAsync_RW(SDL_RWops *src, int freesrc, Mix_AsyncLoadCallback callback, void *user_data);/*MixerX*/
+
+/**
+ * Get the state of the background loading.
+ *
+ * This is the MixerX fork exclusive function.
+ *
+ * \param load the loading handle.
+ * \returns MIX_ASYNC_LOADING while it's in progress, MIX_ASYNC_DONE once
+ *          loaded, or MIX_ASYNC_FAILED on error.
+ *
+ * \since This function is available at the MixerX only
+ */
+extern DECLSPEC Mix_AsyncLoadStatus MIXCALL Mix_GetAsyncLoadStatus(Mix_AsyncLoad *load);/*MixerX*/
+
+/**
+ * Take the chunk loaded at background.
+ *
+ * Waits until the loading got been finished, then frees the handle. If the
+ * loading failed, the error is available from Mix_GetError().
+ *
+ * This is the MixerX fork exclusive function.
+ *
+ * \param load the handle returned by Mix_LoadWAVAsync() or Mix_LoadWAVAsync_RW().
+ * \returns the loaded chunk, or NULL on error.
+ *
+ * \since This function is available at the MixerX only
+ */
+extern DECLSPEC Mix_Chunk * MIXCALL Mix_FinishLoadWAVAsync(Mix_AsyncLoad *load);/*MixerX*/
+
+/**
+ * Take the music loaded at background.
+ *
+ * Waits until the loading got been finished, then frees the handle. If the
+ * loading failed, the error is available from Mix_GetError().
+ *
+ * This is the MixerX fork exclusive function.
+ *
+ * \param load the handle returned by Mix_LoadMUSAsync() or Mix_LoadMUSAsync_RW().
+ * \returns the loaded music, or NULL on error.
+ *
+ * \since This function is available at the MixerX only
+ */
+extern DECLSPEC Mix_Music * MIXCALL Mix_FinishLoadMUSAsync(Mix_AsyncLoad *load);/*MixerX*/
+
+/**
+ * Drop the background loading and free the handle.
+ *
+ * The loading which is not started yet is dropped, otherwise the result is
+ * freed once loaded. The callback is not called for the dropped loading.
+ *
+ * This is the MixerX fork exclusive function.
+ *
+ * \param load the loading handle.
+ *
+ * \since This function is available at the MixerX only
+ */
+extern DECLSPEC void MIXCALL Mix_CancelAsyncLoad(Mix_AsyncLoad *load);/*MixerX*/
+
 /**
  * Free an audio chunk.
  *
@@ -1890,6 +2309,10 @@ extern DECLSPEC int MIXCALL Mix_UnregisterAllMusicEffects(Mix_Music *mus); /*MIX
 
 #define MIX_EFFECTSMAXSPEED  "MIX_EFFECTSMAXSPEED"
 
+/* Set this environment variable before Mix_OpenAudio() to prevent
+ * the positional effects from using SSE2/NEON code. */
+#define MIX_EFFECTSDISABLESIMD  "MIX_EFFECTSDISABLESIMD" /*MixerX*/
+
 /*
  * These are the internally-defined mixing effects. They use the same API that
  *  effects defined in the application use, but are provided here as a
@@ -2319,6 +2742,145 @@ extern DECLSPEC int MIXCALL Mix_GroupOldest(int tag);
  */
 extern DECLSPEC int MIXCALL Mix_GroupNewer(int tag);
 
+/**
+ * Let the chunks played at any channel take busy channels.
+ *
+ * By default, Mix_PlayChannel() and Mix_FadeInChannel() with the channel -1
+ * fail when no free channel is left. With the voice stealing enabled, they
+ * take the channel of the least important sound instead: the one of the
+ * lowest priority, then the quietest, then the oldest. Sounds of a higher
+ * priority than the new one are never stolen, as well as the reserved
+ * channels (see Mix_ReserveChannels()).
+ *
+ * The stolen sound gets faded out over `fade_ms` milliseconds under the
+ * new one, so it doesn't click. The tail is mixed without the effects of
+ * the channel, as they get removed with the stolen sound, and the channel
+ * finished callback is called for the stolen sound right away.
+ *
+ * This also lets chunks limited by Mix_SetChunkMaxVoices() take over their
+ * own oldest voices instead of failing.
+ *
+ * This is the MixerX fork exclusive function.
+ *
+ * \param enable non-zero to steal the busy channels, zero to fail.
+ * \param fade_ms the length of the fade out of stolen sounds, in
+ *                milliseconds, 0 to cut them. 5 to 20 ms are enough.
+ * \returns 0 on success or -1 on error.
+ *
+ * \since This function is available at the MixerX only
+ *
+ * \sa Mix_SetChunkPriority
+ * \sa Mix_SetChunkMaxVoices
+ * \sa Mix_SetChannelPriority
+ */
+extern DECLSPEC int MIXCALL Mix_SetVoiceStealing(int enable, int fade_ms);/*MixerX*/
+
+/**
+ * Set the priority of the chunk.
+ *
+ * Every time the chunk gets played, its channel takes this priority. When
+ * the voice stealing is enabled, sounds of lower priorities are stolen
+ * first, and sounds of higher priorities than the new one are never stolen.
+ * The priority is 0 by default, higher values are more important.
+ *
+ * This is the MixerX fork exclusive function.
+ *
+ * \param chunk the chunk to change.
+ * \param priority the new priority.
+ * \returns 0 on success or -1 on error.
+ *
+ * \since This function is available at the MixerX only
+ *
+ * \sa Mix_GetChunkPriority
+ * \sa Mix_SetVoiceStealing
+ * \sa Mix_SetChannelPriority
+ */
+extern DECLSPEC int MIXCALL Mix_SetChunkPriority(Mix_Chunk *chunk, int priority);/*MixerX*/
+
+/**
+ * Get the priority of the chunk.
+ *
+ * This is the MixerX fork exclusive function.
+ *
+ * \param chunk the chunk to query.
+ * \returns the priority set by Mix_SetChunkPriority(), 0 by default.
+ *
+ * \since This function is available at the MixerX only
+ *
+ * \sa Mix_SetChunkPriority
+ */
+extern DECLSPEC int MIXCALL Mix_GetChunkPriority(Mix_Chunk *chunk);/*MixerX*/
+
+/**
+ * Limit the number of the chunk's sounds playing at once.
+ *
+ * Once the limit is reached, playing the chunk at the channel -1 fails, or
+ * takes over its least important voice when the voice stealing is enabled
+ * (see Mix_SetVoiceStealing()). This keeps sound storms of the same chunk
+ * from occupying all channels. Playing at a specific channel isn't limited.
+ *
+ * This is the MixerX fork exclusive function.
+ *
+ * \param chunk the chunk to change.
+ * \param max_voices the most sounds of the chunk at once, 0 for no limit.
+ * \returns 0 on success or -1 on error.
+ *
+ * \since This function is available at the MixerX only
+ *
+ * \sa Mix_GetChunkMaxVoices
+ * \sa Mix_SetVoiceStealing
+ */
+extern DECLSPEC int MIXCALL Mix_SetChunkMaxVoices(Mix_Chunk *chunk, int max_voices);/*MixerX*/
+
+/**
+ * Get the limit of the chunk's sounds playing at once.
+ *
+ * This is the MixerX fork exclusive function.
+ *
+ * \param chunk the chunk to query.
+ * \returns the limit set by Mix_SetChunkMaxVoices(), 0 means no limit.
+ *
+ * \since This function is available at the MixerX only
+ *
+ * \sa Mix_SetChunkMaxVoices
+ */
+extern DECLSPEC int MIXCALL Mix_GetChunkMaxVoices(Mix_Chunk *chunk);/*MixerX*/
+
+/**
+ * Change the priority of the sound playing at a channel.
+ *
+ * The channel gets the priority of the chunk every time it starts playing,
+ * this changes it for the current sound only.
+ *
+ * Specifying a channel of -1 will set the priority of _all_ channels.
+ *
+ * This is the MixerX fork exclusive function.
+ *
+ * \param which the channel to change, or -1 for all.
+ * \param priority the new priority.
+ * \returns 0 on success or -1 on error.
+ *
+ * \since This function is available at the MixerX only
+ *
+ * \sa Mix_GetChannelPriority
+ * \sa Mix_SetChunkPriority
+ */
+extern DECLSPEC int MIXCALL Mix_SetChannelPriority(int which, int priority);/*MixerX*/
+
+/**
+ * Get the priority of the sound playing at a channel.
+ *
+ * This is the MixerX fork exclusive function.
+ *
+ * \param which the channel to query.
+ * \returns the priority of the channel, or 0 if the channel is invalid.
+ *
+ * \since This function is available at the MixerX only
+ *
+ * \sa Mix_SetChannelPriority
+ */
+extern DECLSPEC int MIXCALL Mix_GetChannelPriority(int which);/*MixerX*/
+
 /**
  * Play an audio chunk on a specific channel.
  *
@@ -2418,6 +2980,48 @@ extern DECLSPEC int MIXCALL Mix_PlayMusic(Mix_Music *music, int loops);
  */
 extern DECLSPEC int MIXCALL Mix_PlayChannelTimedVolume(int which, Mix_Chunk *chunk, int loops, int ticks, int volume);/*MIXER-X*/
 
+/**
+ * Get the mixer clock: the number of sample frames mixed since the audio
+ * device got been opened.
+ *
+ * Between audio callbacks this is the frame the next callback begins with,
+ * so it's the earliest frame that still can be scheduled.
+ *
+ * \returns the number of mixed sample frames.
+ *
+ * \since This function is available at the MixerX only
+ *
+ * \sa Mix_PlayChannelAt
+ * \sa Mix_ExpireChannelAt
+ */
+extern DECLSPEC Uint64 MIXCALL Mix_GetMixerClock(void);/*MixerX*/
+
+/**
+ * Play an audio chunk on a specific channel starting at the exact sample
+ * frame of the mixer clock.
+ *
+ * This works like Mix_PlayChannel(), but the chunk begins playing right at
+ * the `frame`, even in the middle of the audio buffer. This allows to play
+ * sequences of sounds without gaps and jitter of the audio buffer size.
+ *
+ * Frames which were already mixed make the chunk playing immediately. The
+ * channel is reported as playing since this call.
+ *
+ * \param which the channel on which to play the new chunk, or -1 to find
+ *              any available.
+ * \param chunk the new chunk to play.
+ * \param loops the number of times the chunk should loop, -1 to loop (not
+ *              actually) infinitely.
+ * \param frame the frame of the mixer clock to start at.
+ * \returns which channel was used to play the sound, or -1 if sound could
+ *          not be played.
+ *
+ * \since This function is available at the MixerX only
+ *
+ * \sa Mix_GetMixerClock
+ */
+extern DECLSPEC int MIXCALL Mix_PlayChannelAt(int which, Mix_Chunk *chunk, int loops, Uint64 frame);/*MixerX*/
+
 /**
  * TODO: Describe this
  *
@@ -2774,6 +3378,92 @@ extern DECLSPEC void MIXCALL Mix_VolumeMusicGeneral(int volume);/*MixerX*/
  */
 extern DECLSPEC int MIXCALL Mix_GetVolumeMusicGeneral(void);/*MixerX*/
 
+/**
+ * Render multi-music streams in parallel on worker threads.
+ *
+ * Every playing stream gets rendered into its own buffer together with its
+ * effects, and the audio callback mixes these buffers once all of them are
+ * ready. This helps when several heavy streams (like MIDI with chip
+ * emulators, or trackers) are playing at once. The audio thread renders
+ * streams too, and streams of libraries which aren't thread-safe (ModPlug,
+ * native MIDI, and command music) are always rendered by it.
+ *
+ * Effects registered by Mix_RegisterMusicEffect() are called by the worker
+ * threads in this mode, while music finished hooks are still called by the
+ * audio thread.
+ *
+ * If workers didn't complete in the duration of the audio buffer, the mixer
+ * renders streams serially for a while.
+ *
+ * The audio device must be opened, and the mode gets disabled once it's
+ * closed.
+ *
+ * \param threads number of worker threads, or 0 to render serially (the
+ *                default).
+ * \returns 0 on success or -1 on error.
+ *
+ * \since This function is available at the MixerX only
+ *
+ * \sa Mix_GetMultiMusicThreads
+ */
+extern DECLSPEC int MIXCALL Mix_SetMultiMusicThreads(int threads);/*MixerX*/
+
+/**
+ * Get the number of threads rendering multi-music streams in parallel.
+ *
+ * \returns the number of worker threads, or 0 if streams are rendered
+ *          serially.
+ *
+ * \since This function is available at the MixerX only
+ *
+ * \sa Mix_SetMultiMusicThreads
+ */
+extern DECLSPEC int MIXCALL Mix_GetMultiMusicThreads(void);/*MixerX*/
+
+/**
+ * Decode the music ahead of the audio callback by a separate thread.
+ *
+ * The music gets decoded into a ring buffer of the given duration, and the
+ * audio callback just copies the decoded data from it. This prevents
+ * underruns caused by slow reading of the file or by expensive decoding of
+ * some frames.
+ *
+ * Seeking, playing, stopping, and changing of the tempo, speed, pitch, or
+ * tracks drop the decoded data, so these take effect immediately. The
+ * tempo, speed, pitch, and tracks changes start from the position being
+ * heard, so nothing gets skipped. These calls never wait for the decoding
+ * thread: while it decodes, they are run by it right after. Volume changes
+ * (including fades) are applied to the decoded data when it's played, gain
+ * changes are applied to the data decoded after them, so these are late by
+ * the buffered duration at most.
+ *
+ * It's best to set this before playing the music. This doesn't work for
+ * musics played by external players (like native MIDI and command music).
+ *
+ * \param music the music object.
+ * \param ms the duration of the buffer in milliseconds, or 0 to decode in
+ *           the audio callback (the default).
+ * \returns 0 on success or -1 on error.
+ *
+ * \since This function is available at the MixerX only
+ *
+ * \sa Mix_GetMusicDecodeAhead
+ */
+extern DECLSPEC int MIXCALL Mix_SetMusicDecodeAhead(Mix_Music *music, int ms);/*MixerX*/
+
+/**
+ * Get the duration of the decode-ahead buffer of the music.
+ *
+ * \param music the music object.
+ * \returns the duration in milliseconds, or 0 if the music is decoded in
+ *          the audio callback.
+ *
+ * \since This function is available at the MixerX only
+ *
+ * \sa Mix_SetMusicDecodeAhead
+ */
+extern DECLSPEC int MIXCALL Mix_GetMusicDecodeAhead(Mix_Music *music);/*MixerX*/
+
 /**
  * Set the master volume for all channels.
  *
@@ -2926,6 +3616,25 @@ extern DECLSPEC int MIXCALL Mix_HaltMusic(void);
  */
 extern DECLSPEC int MIXCALL Mix_ExpireChannel(int channel, int ticks);
 
+/**
+ * Halt a particular channel at the exact sample frame of the mixer clock.
+ *
+ * This works like Mix_ExpireChannel(), but the channel stops right at the
+ * `frame`, even in the middle of the audio buffer. Frames which were already
+ * mixed halt the channel with the next audio callback.
+ *
+ * Specifying a channel of -1 will set an expiration for _all_ channels.
+ *
+ * \param which the channel to change the expiration time on.
+ * \param frame the frame of the mixer clock to halt at, 0 to not halt.
+ * \returns the number of channels that changed expirations.
+ *
+ * \since This function is available at the MixerX only
+ *
+ * \sa Mix_GetMixerClock
+ */
+extern DECLSPEC int MIXCALL Mix_ExpireChannelAt(int which, Uint64 frame);/*MixerX*/
+
 /**
  * Halt a channel after fading it out for a specified time.
  *
@@ -3112,6 +3821,27 @@ extern DECLSPEC Mix_Fading MIXCALL Mix_FadingMusic(void);
  */
 extern DECLSPEC Mix_Fading MIXCALL Mix_FadingChannel(int which);
 
+/**
+ * Set the shape of fades of a channel.
+ *
+ * Fades of channels are applied per sample frame. The linear curve changes
+ * the gain evenly, while the exponential one changes it by the same amount
+ * of decibels per time (from -60 dB to 0 dB), which sounds smoother on long
+ * fades. The new curve is used by the fade already running as well.
+ *
+ * Specifying a channel of -1 will set the curve for _all_ channels.
+ *
+ * \param which the channel to change, or -1 for all.
+ * \param curve the curve of fades, MIX_FADE_LINEAR by default.
+ * \returns 0 on success or -1 on error.
+ *
+ * \since This function is available at the MixerX only
+ *
+ * \sa Mix_FadeInChannel
+ * \sa Mix_FadeOutChannel
+ */
+extern DECLSPEC int MIXCALL Mix_SetChannelFadeCurve(int which, Mix_FadeCurve curve);/*MixerX*/
+
 /**
  * Pause a particular channel.
  *
@@ -3702,6 +4432,52 @@ extern DECLSPEC int MIXCALL Mix_EachSoundFont(Mix_EachSoundFontCallback function
  */
 extern DECLSPEC int MIXCALL Mix_EachSoundFontEx(const char* cpaths, Mix_EachSoundFontCallback function, void *data);
 
+/**
+ * Load MIDI banks and SoundFonts into the cache before they are needed.
+ *
+ * Custom bank files of ADLMIDI and OPNMIDI and the synthesizer with all
+ * SoundFonts loaded for FluidSynth are kept in the process-wide cache which
+ * is shared by all MIDI music objects. Files are recognized by their paths,
+ * and are reloaded once their modification time or size got changed. Loading
+ * of a MIDI song costs only the loading of the song itself then.
+ *
+ * This function preloads currently set custom banks and SoundFonts. The audio
+ * device should be opened before this call.
+ *
+ * \returns 0 on success or -1 on error.
+ *
+ * \since This function is available at the MixerX only
+ *
+ * \sa Mix_EvictMidiBanks
+ * \sa Mix_GetMidiBanksMemory
+ */
+extern DECLSPEC int MIXCALL Mix_PreloadMidiBanks(void);/*MixerX*/
+
+/**
+ * Free all cached MIDI banks and SoundFonts.
+ *
+ * Entries which are in use by music objects are freed once these musics
+ * are freed.
+ *
+ * \since This function is available at the MixerX only
+ *
+ * \sa Mix_PreloadMidiBanks
+ */
+extern DECLSPEC void MIXCALL Mix_EvictMidiBanks(void);/*MixerX*/
+
+/**
+ * Get the size of all cached MIDI banks and SoundFonts.
+ *
+ * The size of SoundFonts is counted by their files sizes.
+ *
+ * \returns the total size in bytes.
+ *
+ * \since This function is available at the MixerX only
+ *
+ * \sa Mix_PreloadMidiBanks
+ */
+extern DECLSPEC Sint64 MIXCALL Mix_GetMidiBanksMemory(void);/*MixerX*/
+
 /**
  * Set full path of the Timidity config file.
  *
@@ -3763,12 +4539,157 @@ extern DECLSPEC void MIXCALL Mix_FreeMixer(void);/*MixerX*/
 
 /**
  * Set a function that MixerX will use to open RWops handles from file paths,
- * or pass NULL to use the default SDL_RWFromFile.
+ * or pass NULL to use the default opener.
+ *
+ * The default opener maps files opened for reading into the memory on
+ * systems which have mmap() (Linux, BSD, macOS), so uncompressed wave files
+ * of the mixer format and whole-file codecs (MIDI, GME, MOD) are used
+ * without copying them, and uses SDL_RWFromFile otherwise. Pass
+ * SDL_RWFromFile to always read files through it.
  *
  * This is the MixerX fork exclusive function.
  */
 extern DECLSPEC void MIXCALL Mix_SetRWFromFile(Mix_RWFromFile_cb cb);/*MixerX*/
 
+/**
+ * Enable or disable mixing through the Float32 internal bus.
+ *
+ * When enabled, all channels and music streams are added into a float
+ * accumulator owned by the mixer instead of the output buffer. The result
+ * gets converted into the output format and soft-clipped once at the end
+ * of the callback, so there is no clipping between the mixing stages.
+ * Post-mix effects and the post-mix callback are receiving the converted
+ * output as before.
+ *
+ * The setting may be changed at any time, also before opening the audio.
+ *
+ * \param enable 1 to enable, 0 to disable, or -1 to query the current state.
+ * \returns the previous state, or -1 on error.
+ *
+ * \since This function is available since MixerX 2.8.0.
+ */
+extern DECLSPEC int MIXCALL Mix_SetFloatMixBus(int enable);/*MixerX*/
+
+/**
+ * Timing statistics of a stage of the audio callback.
+ *
+ * Durations are in milliseconds. Loads are ratios of durations to the
+ * duration of the audio buffer: the closer they are to 1.0, the higher is
+ * the risk of underruns.
+ *
+ * \since This structure is available at the MixerX only
+ */
+typedef struct Mix_PerfStats
+{
+    Uint32 count;       /**< Number of measured runs */
+    Uint32 overruns;    /**< Number of runs longer than the audio buffer */
+    double min_ms;
+    double avg_ms;
+    double max_ms;
+    double p99_ms;      /**< 99th percentile, approximate (up to 25% higher) */
+    double period_ms;   /**< Duration of the audio buffer */
+    double avg_load;
+    double p99_load;
+    double max_load;
+} Mix_PerfStats;
+
+/**
+ * Stages of the audio callback measured by the timing statistics.
+ *
+ * \since This enum is available at the MixerX only
+ */
+typedef enum
+{
+    MIX_PERF_CALLBACK,      /**< The whole mixing callback */
+    MIX_PERF_MUSIC,         /**< The music played by Mix_PlayMusic() */
+    MIX_PERF_MULTI_MUSIC,   /**< All streams played by Mix_PlayMusicStream() */
+    MIX_PERF_CHANNELS,      /**< All channels with their effects */
+    MIX_PERF_POST_EFFECTS   /**< Post-mix effects and the post-mix callback */
+} Mix_PerfStage;
+
+/**
+ * Enable or disable collecting of the audio callback timing statistics.
+ *
+ * Statistics are disabled by default, since measuring costs a bit of time
+ * per each stage. Statistics collected so far are kept while disabled.
+ *
+ * \param enable 1 to enable, 0 to disable, or -1 to query the current state.
+ * \returns the previous state.
+ *
+ * \since This function is available at the MixerX only
+ *
+ * \sa Mix_GetPerfStats
+ * \sa Mix_ResetPerfStats
+ */
+extern DECLSPEC int MIXCALL Mix_SetPerfStats(int enable);/*MixerX*/
+
+/**
+ * Clear all collected timing statistics.
+ *
+ * \since This function is available at the MixerX only
+ */
+extern DECLSPEC void MIXCALL Mix_ResetPerfStats(void);/*MixerX*/
+
+/**
+ * Get the timing statistics of a stage of the audio callback.
+ *
+ * \param stage the stage to report.
+ * \param stats the structure to fill.
+ * \returns 0 on success or -1 on error.
+ *
+ * \since This function is available at the MixerX only
+ *
+ * \sa Mix_SetPerfStats
+ */
+extern DECLSPEC int MIXCALL Mix_GetPerfStats(Mix_PerfStage stage, Mix_PerfStats *stats);/*MixerX*/
+
+/**
+ * Get the timing statistics of the effects chain of a channel.
+ *
+ * Only runs of non-empty chains are counted (including positional effects),
+ * `MIX_CHANNEL_POST` reports post-mix effects.
+ *
+ * \param channel the channel to report.
+ * \param stats the structure to fill.
+ * \returns 0 on success or -1 on error.
+ *
+ * \since This function is available at the MixerX only
+ *
+ * \sa Mix_SetPerfStats
+ */
+extern DECLSPEC int MIXCALL Mix_GetChannelPerfStats(int channel, Mix_PerfStats *stats);/*MixerX*/
+
+/**
+ * Get the timing statistics of the decoding of a music.
+ *
+ * Each run is one read of the audio from the music's decoder made by the
+ * audio callback (or by a worker thread, see Mix_SetMultiMusicThreads()).
+ *
+ * \param music the music to report.
+ * \param stats the structure to fill.
+ * \returns 0 on success or -1 on error.
+ *
+ * \since This function is available at the MixerX only
+ *
+ * \sa Mix_SetPerfStats
+ * \sa Mix_GetMusicDecoderPerfStats
+ */
+extern DECLSPEC int MIXCALL Mix_GetMusicPerfStats(Mix_Music *music, Mix_PerfStats *stats);/*MixerX*/
+
+/**
+ * Get the timing statistics of the decoding by all musics of a decoder.
+ *
+ * \param name the decoder name, as reported by Mix_GetMusicDecoder().
+ * \param stats the structure to fill.
+ * \returns 0 on success or -1 on error.
+ *
+ * \since This function is available at the MixerX only
+ *
+ * \sa Mix_SetPerfStats
+ * \sa Mix_GetMusicPerfStats
+ */
+extern DECLSPEC int MIXCALL Mix_GetMusicDecoderPerfStats(const char *name, Mix_PerfStats *stats);/*MixerX*/
+
 /**
  * Close the mixer, halting all playing audio.
  *
@@ -2355,8 +2355,19 @@ DRMP3_API int drmp3dec_decode_frame(drmp3dec *dec, const drmp3_uint8 *mp3, int m
             drmp3dec_init(dec);
             return 0;
         }
-        success = drmp3_L3_restore_reservoir(dec, bs_frame, &dec->scratch, main_data_begin);
-        if (success && pcm != NULL)
+        if (!drmp3_L3_restore_reservoir(dec, bs_frame, &dec->scratch, main_data_begin))
+        {
+            /*
+            MIXER-X local patch, keep it when updating dr_mp3: upstream drops such frames.
+
+            The bit reservoir of the previous frames is missing, which happens right after seeking. Keep the frame as silence,
+            otherwise it gets dropped, and all following frames get shifted against the seek point.
+            */
+            if (pcm != NULL)
+            {
+                DRMP3_ZERO_MEMORY(pcm, sizeof(drmp3d_sample_t)*drmp3_hdr_frame_samples(hdr)*info->channels);
+            }
+        } else if (pcm != NULL)
         {
             for (igr = 0; igr < (DRMP3_HDR_TEST_MPEG1(hdr) ? 2 : 1); igr++, pcm = DRMP3_OFFSET_PTR(pcm, sizeof(drmp3d_sample_t)*576*info->channels))
             {
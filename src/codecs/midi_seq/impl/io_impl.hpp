@@ -108,8 +108,6 @@ double BW_MidiSequencer::seek(double seconds, const double granularity)
 {
     if(seconds < 0.0)
         return 0.0; // Seeking negative position is forbidden! :-P
-    const double granualityHalf = granularity * 0.5,
-                 s = seconds; // m_setup.delay < m_setup.maxdelay ? m_setup.delay : m_setup.maxdelay;
 
     /* Attempt to go away out of song end must rewind position to begin */
     if(seconds > m_fullSongTimeLength)
@@ -126,6 +124,7 @@ double BW_MidiSequencer::seek(double seconds, const double granularity)
      * Seeking search is similar to regular ticking, except of next things:
      * - We don't processsing arpeggio and vibrato
      * - To keep correctness of the state after seek, begin every search from begin
+     *   or from the nearest keyframe of the seek index
      * - All sustaining notes must be killed
      * - Ignore Note-On events
      */
@@ -141,31 +140,12 @@ double BW_MidiSequencer::seek(double seconds, const double granularity)
 
     m_loop.temporaryBroken = (seconds >= m_loopEndTime);
 
-    while((m_currentPosition.absTimePosition < seconds) &&
-          (m_currentPosition.absTimePosition < m_fullSongTimeLength))
-    {
-        m_currentPosition.wait -= s;
-        m_currentPosition.absTimePosition += s;
-        int antiFreezeCounter = 10000; // Limit 10000 loops to avoid freezing
-        double dstWait = m_currentPosition.wait + granualityHalf;
-        while((m_currentPosition.wait <= granualityHalf)/*&& (antiFreezeCounter > 0)*/)
-        {
-            // std::fprintf(stderr, "wait = %g...\n", CurrentPosition.wait);
-            if(!processEvents(true))
-                break;
-            // Avoid freeze because of no waiting increasing in more than 10000 cycles
-            if(m_currentPosition.wait <= dstWait)
-                antiFreezeCounter--;
-            else
-            {
-                dstWait = m_currentPosition.wait + granualityHalf;
-                antiFreezeCounter = 10000;
-            }
-        }
-        if(antiFreezeCounter <= 0)
-            m_currentPosition.wait += 1.0;/* Add extra 1 second when over 10000 events
-                                             with zero delay are been detected */
-    }
+    // Continue from the nearest keyframe instead of replaying everything from the begin
+    seekIndexRestore(seekIndexFind(seconds));
+
+    m_seekCapture = true;
+    seekWalk(seconds, granularity);
+    m_seekCapture = false;
 
     if(m_currentPosition.wait < 0.0)
         m_currentPosition.wait = 0.0;
@@ -74,6 +74,8 @@ void BW_MidiSequencer::buildSmfSetupReset(size_t trackCount)
     m_trackData.clear();
     m_trackState.clear();
 
+    seekIndexReset();
+
     m_loop.reset();
     m_loop.invalidLoop = false;
     m_time.reset();
@@ -92,6 +92,9 @@ void BW_MidiSequencer::handleEvent(size_t track, const BW_MidiSequencer::MidiEve
     if(tk.state.track_channel != midCh)
         tk.state.track_channel = midCh; // Remember track's current channel if changed
 
+    if(m_seekCapture)
+        seekIndexTrackEvent(track, evt, midCh);
+
     switch(evt.type)
     {
     case MidiEvent::T_SYSEX:
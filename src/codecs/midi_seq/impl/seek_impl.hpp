@@ -0,0 +1,474 @@
+/*
+ * BW_Midi_Sequencer - MIDI Sequencer for C++
+ *
+ * Copyright (c) 2015-2026 Vitaly Novichkov <admin@wohlnet.ru>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+#ifndef BW_MIDISEQ_SEEK_IMPL_HPP
+#define BW_MIDISEQ_SEEK_IMPL_HPP
+
+#include <cstring>
+
+#include "../midi_sequencer.hpp"
+
+#ifndef BWMIDI_SEEK_KEYFRAME_INTERVAL
+//! Time between keyframes of the seek index in seconds
+#   define BWMIDI_SEEK_KEYFRAME_INTERVAL 5.0
+#endif
+
+
+void BW_MidiSequencer::seekIndexChannelInit(SeekChannelState &st)
+{
+    std::memset(&st, 0xFF, sizeof(st));
+    std::memset(st.rpnReplay, 0, sizeof(st.rpnReplay));
+    st.used = 0;
+    st.nrpnSelected = 0;
+    st.resetAll = 0;
+}
+
+static void seekMutedNoteOn(void *, uint8_t, uint8_t, uint8_t) {}
+static void seekMutedNoteOff(void *, uint8_t, uint8_t) {}
+static void seekMutedNoteAfterTouch(void *, uint8_t, uint8_t, uint8_t) {}
+static void seekMutedChannelAfterTouch(void *, uint8_t, uint8_t) {}
+static void seekMutedControllerChange(void *, uint8_t, uint8_t, uint8_t) {}
+static void seekMutedPatchChange(void *, uint8_t, uint8_t) {}
+static void seekMutedPitchBend(void *, uint8_t, uint8_t, uint8_t) {}
+
+
+void BW_MidiSequencer::seekIndexReset()
+{
+    m_seekKeyframes.clear();
+    m_seekChannelsBank.clear();
+    m_seekReplay.clear();
+    m_seekReplayCount = 0;
+}
+
+BW_MidiSequencer::SeekChannelState &BW_MidiSequencer::seekIndexChannel(size_t channel)
+{
+    size_t oldSize = m_seekChannels.size;
+
+    if(channel >= oldSize)
+    {
+        m_seekChannels.resize(channel + 1);
+        for(size_t i = oldSize; i < m_seekChannels.size; ++i)
+            seekIndexChannelInit(m_seekChannels[i]);
+    }
+
+    return m_seekChannels[channel];
+}
+
+void BW_MidiSequencer::seekIndexReplay(const SeekReplayEvent &replay)
+{
+    // The replay list is shared by all keyframes: the walk is always the same
+    if(m_seekReplayCount < m_seekReplay.size)
+        m_seekReplay[m_seekReplayCount] = replay;
+    else
+        m_seekReplay.push_back(replay);
+
+    ++m_seekReplayCount;
+}
+
+void BW_MidiSequencer::seekIndexTrackEvent(size_t track, const MidiEvent &evt, size_t midCh)
+{
+    SeekReplayEvent replay;
+
+    std::memset(&replay, 0, sizeof(replay));
+    replay.track = track;
+    replay.event = static_cast<size_t>(&evt - m_eventBank.begin());
+
+    switch(evt.type)
+    {
+    case MidiEvent::T_SPECIAL:
+        if(evt.subtype != MidiEvent::ST_DEVICESWITCH)
+            return;
+        /* fallthrough */
+    case MidiEvent::T_SYSEX:
+    case MidiEvent::T_SYSEX2:
+        seekIndexReplay(replay);
+        return;
+
+    case MidiEvent::T_CTRLCHANGE:
+    {
+        SeekChannelState &st = seekIndexChannel(midCh & 0xFF);
+        uint8_t cc = evt.data_loc[0] & 0x7F, value = evt.data_loc[1];
+
+        st.used = 1;
+
+        switch(cc)
+        {
+        case 6:  // Data entry MSB
+        case 38: // Data entry LSB
+            if(!st.nrpnSelected && st.cc[101] == 0 && st.cc[100] < SEEK_RPN_COUNT)
+            {
+                st.rpn[st.cc[100]][cc == 6 ? 0 : 1] = value;
+                st.rpnReplay[st.cc[100]] = m_seekReplayCount;
+                break;
+            }
+            /* fallthrough */
+        case 96: // Data increment
+        case 97: // Data decrement
+        {
+            // Any NRPN and the relative changes can't be kept as values, replay them
+            const uint8_t msb = st.nrpnSelected ? 99 : 101;
+
+            if(st.cc[msb] > 127 || st.cc[msb - 1] > 127 || (st.cc[msb] == 127 && st.cc[msb - 1] == 127))
+                break; // No parameter is selected, the data goes nowhere
+
+            replay.channel = midCh & 0xFF;
+            replay.isParam = 1;
+            replay.nrpn = st.nrpnSelected;
+            replay.param[0] = st.cc[msb];
+            replay.param[1] = st.cc[msb - 1];
+            seekIndexReplay(replay);
+            break;
+        }
+
+        case 120: // All sounds off
+        case 123: // All notes off
+            break;
+
+        case 98: // NRPN LSB
+        case 99: // NRPN MSB
+            st.nrpnSelected = 1;
+            st.cc[cc] = value;
+            break;
+
+        case 100: // RPN LSB
+        case 101: // RPN MSB
+            st.nrpnSelected = 0;
+            st.cc[cc] = value;
+            break;
+
+        case 121: // Reset all controllers: forget everything it resets, it will be re-sent first
+            st.cc[1] = 0xFF;
+            st.cc[11] = 0xFF;
+            std::memset(st.cc + 64, 0xFF, 4);
+            std::memset(st.cc + 98, 127, 4); // Parameter numbers are set to NULL
+            st.wheel[0] = 0xFF;
+            st.wheel[1] = 0xFF;
+            st.chanAtt = 0xFF;
+            st.nrpnSelected = 0;
+            st.resetAll = 1;
+            break;
+
+        default:
+            st.cc[cc] = value;
+            break;
+        }
+        return;
+    }
+
+    case MidiEvent::T_PATCHCHANGE:
+    {
+        SeekChannelState &st = seekIndexChannel(midCh & 0xFF);
+        st.used = 1;
+        st.patch = evt.data_loc[0];
+        return;
+    }
+
+    case MidiEvent::T_CHANAFTTOUCH:
+    {
+        SeekChannelState &st = seekIndexChannel(midCh & 0xFF);
+        st.used = 1;
+        st.chanAtt = evt.data_loc[0];
+        return;
+    }
+
+    case MidiEvent::T_WHEEL:
+    {
+        SeekChannelState &st = seekIndexChannel(midCh & 0xFF);
+        st.used = 1;
+        st.wheel[0] = evt.data_loc[0];
+        st.wheel[1] = evt.data_loc[1];
+        return;
+    }
+
+    default:
+        return;
+    }
+}
+
+void BW_MidiSequencer::seekIndexCapture()
+{
+    SeekKeyframe key;
+    const SeekKeyframe *last = m_seekKeyframes.back();
+    // Time of the next events row
+    const double time = m_currentPosition.absTimePosition + m_currentPosition.wait;
+
+    if(m_atEnd)
+        return;
+
+    if(time < (last ? last->position.absTimePosition : 0.0) + BWMIDI_SEEK_KEYFRAME_INTERVAL)
+        return;
+
+    if(m_seekKeyframes.capacity == 0)
+        m_seekKeyframes.reserve(static_cast<size_t>(m_fullSongTimeLength / BWMIDI_SEEK_KEYFRAME_INTERVAL) + 2);
+
+    key.position = m_currentPosition;
+    key.position.absTimePosition = time;
+    key.position.wait = 0.0;
+
+    for(size_t tk = 0; tk < m_tracksCount; ++tk)
+        std::memcpy(&key.position.track[tk].state, &m_trackState[tk].state, sizeof(TrackStateSaved));
+
+    key.tempo = m_tempo;
+    key.stateRestoreSetup = m_stateRestoreSetup;
+    key.replayCount = m_seekReplayCount;
+    key.channelsOffset = m_seekChannelsBank.size;
+    key.channelsCount = m_seekChannels.size;
+
+    if(m_seekChannels.size > 0)
+        m_seekChannelsBank.push_back_list(m_seekChannels.data, m_seekChannels.size);
+
+    m_seekKeyframes.push_back(key);
+}
+
+const BW_MidiSequencer::SeekKeyframe *BW_MidiSequencer::seekIndexFind(double seconds) const
+{
+    size_t lo = 0, hi = m_seekKeyframes.size;
+
+    // Find the first keyframe after the time point
+    while(lo < hi)
+    {
+        size_t mid = lo + (hi - lo) / 2;
+        if(m_seekKeyframes[mid].position.absTimePosition <= seconds)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return lo > 0 ? &m_seekKeyframes[lo - 1] : NULL;
+}
+
+void BW_MidiSequencer::seekIndexRestore(const SeekKeyframe *key)
+{
+    void *ud = m_interface->rtUserData;
+
+    if(!key)
+    {
+        for(size_t i = 0; i < m_seekChannels.size; ++i)
+            seekIndexChannelInit(m_seekChannels[i]);
+        m_seekReplayCount = 0;
+        return;
+    }
+
+    m_currentPosition = key->position;
+    for(size_t tk = 0; tk < m_tracksCount; ++tk)
+        std::memcpy(&m_trackState[tk].state, &m_currentPosition.track[tk].state, sizeof(TrackStateSaved));
+
+    m_tempo = key->tempo;
+    m_stateRestoreSetup = key->stateRestoreSetup;
+    m_seekReplayCount = key->replayCount;
+
+    m_seekChannels.resize(key->channelsCount);
+    if(key->channelsCount > 0)
+        std::memcpy(m_seekChannels.data, m_seekChannelsBank.data + key->channelsOffset,
+                    key->channelsCount * sizeof(SeekChannelState));
+
+    // SysEx queries usually reset the synthesizer, send them first
+    for(size_t i = 0; i < m_seekReplayCount; ++i)
+    {
+        const SeekReplayEvent &replay = m_seekReplay[i];
+        const MidiEvent &evt = m_eventBank[replay.event];
+
+        if(replay.isParam)
+            continue; // Sent with the channel state
+
+        if(evt.type == MidiEvent::T_SPECIAL)
+        {
+            size_t length = evt.data_block.size > 0 ? evt.data_block.size : static_cast<size_t>(evt.data_loc_size);
+            const uint8_t *datau = evt.data_block.size > 0 ? getData(evt.data_block) : evt.data_loc;
+            const char *data = (length ? reinterpret_cast<const char *>(datau) : "\0\0\0\0\0\0\0\0");
+
+            if(m_interface->rt_deviceSwitch)
+                m_interface->rt_deviceSwitch(ud, replay.track, data, length);
+        }
+        else if(m_interface->rt_systemExclusive)
+            m_interface->rt_systemExclusive(ud, getData(evt.data_block), evt.data_block.size);
+    }
+
+    for(size_t c = 0; c < m_seekChannels.size; ++c)
+    {
+        const SeekChannelState &st = m_seekChannels[c];
+        const uint8_t ch = static_cast<uint8_t>(c);
+
+        if(!st.used)
+            continue;
+
+        if(st.resetAll)
+            m_interface->rt_controllerChange(ud, ch, 121, 0);
+
+        // Bank must be selected before the patch change
+        if(st.cc[0] <= 127)
+            m_interface->rt_controllerChange(ud, ch, 0, st.cc[0]);
+        if(st.cc[32] <= 127)
+            m_interface->rt_controllerChange(ud, ch, 32, st.cc[32]);
+        if(st.patch <= 127)
+            m_interface->rt_patchChange(ud, ch, st.patch);
+
+        for(uint8_t i = 1; i < 120; ++i)
+        {
+            if(i == 6 || i == 32 || i == 38 || (i >= 96 && i <= 101))
+                continue; // Bank, data entries, and parameter numbers are handled separately
+
+            if(st.cc[i] <= 127)
+                m_interface->rt_controllerChange(ud, ch, i, st.cc[i]);
+        }
+
+        for(uint8_t r = 0; r < SEEK_RPN_COUNT; ++r)
+        {
+            if(st.rpn[r][0] > 127)
+                continue;
+
+            m_interface->rt_controllerChange(ud, ch, 101, 0);
+            m_interface->rt_controllerChange(ud, ch, 100, r);
+            m_interface->rt_controllerChange(ud, ch, 6, st.rpn[r][0]);
+            if(st.rpn[r][1] <= 127)
+                m_interface->rt_controllerChange(ud, ch, 38, st.rpn[r][1]);
+        }
+
+        // NRPN data and increments go on top of the values above, in the order they came
+        int selected = -1;
+        for(size_t i = 0; i < m_seekReplayCount; ++i)
+        {
+            const SeekReplayEvent &replay = m_seekReplay[i];
+
+            if(!replay.isParam || replay.channel != c)
+                continue;
+
+            if(!replay.nrpn && replay.param[0] == 0 && replay.param[1] < SEEK_RPN_COUNT &&
+               i < st.rpnReplay[replay.param[1]])
+                continue; // Overridden by the data entry sent above
+
+            const int param = (replay.nrpn << 14) | (replay.param[0] << 7) | replay.param[1];
+            if(param != selected)
+            {
+                m_interface->rt_controllerChange(ud, ch, replay.nrpn ? 99 : 101, replay.param[0]);
+                m_interface->rt_controllerChange(ud, ch, replay.nrpn ? 98 : 100, replay.param[1]);
+                selected = param;
+            }
+
+            const MidiEvent &evt = m_eventBank[replay.event];
+            m_interface->rt_controllerChange(ud, ch, evt.data_loc[0], evt.data_loc[1]);
+        }
+
+        // Restore the parameter numbers selection, the last selected goes last
+        for(int pass = 0; pass < 2; ++pass)
+        {
+            const uint8_t msb = ((pass == 0) == (st.nrpnSelected != 0)) ? 101 : 99;
+
+            if(st.cc[msb] <= 127)
+                m_interface->rt_controllerChange(ud, ch, msb, st.cc[msb]);
+            if(st.cc[msb - 1] <= 127)
+                m_interface->rt_controllerChange(ud, ch, msb - 1, st.cc[msb - 1]);
+        }
+
+        if(st.wheel[0] <= 127)
+            m_interface->rt_pitchBend(ud, ch, st.wheel[1], st.wheel[0]);
+
+        if(st.chanAtt <= 127)
+            m_interface->rt_channelAfterTouch(ud, ch, st.chanAtt);
+    }
+}
+
+void BW_MidiSequencer::seekWalk(double seconds, double granularity)
+{
+    const double granualityHalf = granularity * 0.5;
+
+    while((m_currentPosition.absTimePosition < seconds) &&
+          (m_currentPosition.absTimePosition < m_fullSongTimeLength))
+    {
+        const double s = seconds - m_currentPosition.absTimePosition;
+        m_currentPosition.wait -= s;
+        m_currentPosition.absTimePosition += s;
+        int antiFreezeCounter = 10000; // Limit 10000 loops to avoid freezing
+        double dstWait = m_currentPosition.wait + granualityHalf;
+        while((m_currentPosition.wait <= granualityHalf)/*&& (antiFreezeCounter > 0)*/)
+        {
+            // std::fprintf(stderr, "wait = %g...\n", CurrentPosition.wait);
+            if(!processEvents(true))
+                break;
+
+            if(m_seekCapture)
+                seekIndexCapture();
+
+            // Avoid freeze because of no waiting increasing in more than 10000 cycles
+            if(m_currentPosition.wait <= dstWait)
+                antiFreezeCounter--;
+            else
+            {
+                dstWait = m_currentPosition.wait + granualityHalf;
+                antiFreezeCounter = 10000;
+            }
+        }
+        if(antiFreezeCounter <= 0)
+            m_currentPosition.wait += 1.0;/* Add extra 1 second when over 10000 events
+                                             with zero delay are been detected */
+    }
+}
+
+bool BW_MidiSequencer::buildSeekIndex()
+{
+    BW_MidiRtInterface muted;
+    const BW_MidiRtInterface *output = m_interface;
+    TriggerHandler triggerHandler = m_triggerHandler;
+    Tempo_t tempo = m_tempo;
+    uint32_t stateRestoreSetup = m_stateRestoreSetup;
+    bool loopFlagState = m_loopEnabled;
+
+    if(!m_interface || m_interface->rt_currentDevice || m_tracksCount == 0)
+        return false;
+
+    // Walk through the whole song like a seek does, but with no output and no hooks
+    std::memset(&muted, 0, sizeof(muted));
+    muted.rt_noteOn = seekMutedNoteOn;
+    muted.rt_noteOff = seekMutedNoteOff;
+    muted.rt_noteAfterTouch = seekMutedNoteAfterTouch;
+    muted.rt_channelAfterTouch = seekMutedChannelAfterTouch;
+    muted.rt_controllerChange = seekMutedControllerChange;
+    muted.rt_patchChange = seekMutedPatchChange;
+    muted.rt_pitchBend = seekMutedPitchBend;
+
+    m_interface = &muted;
+    m_triggerHandler = NULL;
+    m_loopEnabled = false;
+
+    seekIndexReset();
+    this->rewind();
+    m_loop.caughtStart = false;
+    seekIndexRestore(NULL);
+
+    m_seekCapture = true;
+    seekWalk(m_fullSongTimeLength, m_time.minDelay);
+    m_seekCapture = false;
+
+    m_interface = output;
+    m_triggerHandler = triggerHandler;
+    m_loopEnabled = loopFlagState;
+    m_tempo = tempo;
+    m_stateRestoreSetup = stateRestoreSetup;
+
+    this->rewind();
+
+    return !m_seekKeyframes.empty();
+}
+
+#endif /* BW_MIDISEQ_SEEK_IMPL_HPP */
@@ -759,6 +759,77 @@ private:
         MidiTrackState();
     };
 
+    //! Count of registered parameters (RPN 0x0000...0x0005) which values are kept by the seek index
+    static const size_t SEEK_RPN_COUNT = 6;
+
+    /**
+     * @brief The state of the MIDI channel collected while seeking, the seek index keyframes are keeping it
+     */
+    struct SeekChannelState
+    {
+        //! Last values of controllers (0xFF - never been set)
+        uint8_t cc[128];
+        //! Data entry values [MSB, LSB] of registered parameters (0xFF - never been set)
+        uint8_t rpn[SEEK_RPN_COUNT][2];
+        //! Count of replay events when the registered parameter got its data entry, older increments are overridden
+        size_t rpnReplay[SEEK_RPN_COUNT];
+        //! Current patch (0xFF - never been set)
+        uint8_t patch;
+        //! Pitch bend value [LSB, MSB] (0xFF - never been set)
+        uint8_t wheel[2];
+        //! Channel after-touch (0xFF - never been set)
+        uint8_t chanAtt;
+        //! Channel got any state events
+        uint8_t used;
+        //! The NRPN was selected after the RPN
+        uint8_t nrpnSelected;
+        //! The "Reset All Controllers" was been sent
+        uint8_t resetAll;
+    };
+
+    /**
+     * @brief The event which can't be reduced into the channel state and should be re-sent in the same order
+     * (SysEx, device switch, data entries of NRPNs, data increments and decrements)
+     */
+    struct SeekReplayEvent
+    {
+        //! Track where the event was been handled
+        size_t track;
+        //! Index of the event in the events bank
+        size_t event;
+        //! Channel of the parameter data event
+        size_t channel;
+        //! It's the parameter data event, re-sent after the channel state
+        uint8_t isParam;
+        //! The parameter is NRPN
+        uint8_t nrpn;
+        //! Number of the parameter [MSB, LSB] selected for the event
+        uint8_t param[2];
+    };
+
+    /**
+     * @brief The seek index keyframe: the full state of the sequencer at the specific time point
+     */
+    struct SeekKeyframe
+    {
+        //! Position of all tracks, including their saved states. Time of the keyframe is the absTimePosition
+        Position position;
+        //! Tempo at the keyframe
+        Tempo_t tempo;
+        //! Song-wide on-loop state restore setup at the keyframe
+        uint32_t stateRestoreSetup;
+        //! Count of events to replay before the keyframe
+        size_t replayCount;
+        //! Offset of the channel states in the bank
+        size_t channelsOffset;
+        //! Count of channel states
+        size_t channelsCount;
+    };
+
+    typedef miditrack_arr<SeekChannelState>     SeekChannelsList;
+    typedef miditrack_arr<SeekReplayEvent>      SeekReplayList;
+    typedef miditrack_arr<SeekKeyframe, true>   SeekKeyframesList;
+
     /**********************************************************************************
      *                      Private variable fields definitions                       *
      **********************************************************************************/
@@ -890,6 +961,19 @@ private:
     //! Sequencer's time processor
     SequencerTime m_time;
 
+    //! Seek index: periodic keyframes captured while seeking
+    SeekKeyframesList m_seekKeyframes;
+    //! Channel states of all keyframes
+    SeekChannelsList m_seekChannelsBank;
+    //! Current channel states collected while seeking
+    SeekChannelsList m_seekChannels;
+    //! Ordered list of events to replay when restoring a keyframe
+    SeekReplayList m_seekReplay;
+    //! Count of replay events handled by the current seek
+    size_t m_seekReplayCount;
+    //! Seek is in progress: collect the state and capture keyframes
+    bool m_seekCapture;
+
     /**********************************************************************************
      *                             Tempo fraction                                     *
      **********************************************************************************/
@@ -1090,6 +1174,68 @@ private:
     bool processEvents(bool isSeek = false);
 
 
+    /**********************************************************************************
+     *                                 Seek index                                     *
+     **********************************************************************************/
+
+    /**
+     * @brief Drop all keyframes of the seek index (the song or the track filtering got been changed)
+     */
+    void seekIndexReset();
+
+    /**
+     * @brief Set the channel state as never been touched
+     * @param st Channel state to initialize
+     */
+    static void seekIndexChannelInit(SeekChannelState &st);
+
+    /**
+     * @brief Get the collected state of the MIDI channel, extend the list if needed
+     * @param channel MIDI channel
+     * @return State of the channel
+     */
+    SeekChannelState &seekIndexChannel(size_t channel);
+
+    /**
+     * @brief Append the event to the replay list of the seek index
+     * @param replay Event to replay
+     */
+    void seekIndexReplay(const SeekReplayEvent &replay);
+
+    /**
+     * @brief Collect the state changed by the event while seeking
+     * @param track Track where the event was been handled
+     * @param evt Handled event
+     * @param midCh Resulting MIDI channel of the event
+     */
+    void seekIndexTrackEvent(size_t track, const MidiEvent &evt, size_t midCh);
+
+    /**
+     * @brief Store the current state as a new keyframe when the time since the last keyframe passed
+     */
+    void seekIndexCapture();
+
+    /**
+     * @brief Find the latest keyframe at or before the time position
+     * @param seconds Time position in seconds
+     * @return Keyframe or NULL if there is no one suitable
+     */
+    const SeekKeyframe *seekIndexFind(double seconds) const;
+
+    /**
+     * @brief Apply the state of the keyframe to the sequencer and send it to the synthesizer
+     * @param key Keyframe to restore or NULL to begin collecting the state from the song begin
+     */
+    void seekIndexRestore(const SeekKeyframe *key);
+
+    /**
+     * @brief Walk through the song events until the time position will be reached
+     * @param seconds Destination time position in seconds
+     * @param granularity don't expect intervals smaller than this, in seconds
+     */
+    void seekWalk(double seconds, double granularity);
+
+
     /**********************************************************************************
      *                             Private file parser functions                      *
      **********************************************************************************/
@@ -1539,6 +1685,15 @@ public:
      */
     double seek(double seconds, const double granularity);
 
+    /**
+     * @brief Build the seek index of the whole song without any output to make all further seeks fast
+     *
+     * Otherwise, the index gets built by seeks themselves. Does nothing if events routing
+     * depends on the synthesizer's state (the current device hook is set).
+     * @return true if index got been built
+     */
+    bool buildSeekIndex();
+
     /**
      * @brief Gives current time position in seconds
      * @return Current time position in seconds
@@ -44,6 +44,7 @@
 #include "impl/mididata_impl.hpp"
 
 #include "impl/process_impl.hpp"
+#include "impl/seek_impl.hpp"
 
 #include "impl/io_impl.hpp"
 #include "impl/load_music_impl.hpp"
@@ -112,7 +113,9 @@ BW_MidiSequencer::BW_MidiSequencer() :
     m_deviceMask(Device_ANY),
     m_deviceMaskAvailable(Device_ANY),
     m_trackSolo(~static_cast<size_t>(0)),
-    m_tempoMultiplier(1.0)
+    m_tempoMultiplier(1.0),
+    m_seekReplayCount(0),
+    m_seekCapture(false)
 {
     m_loop.reset();
     m_loop.invalidLoop = false;
@@ -142,6 +145,9 @@ BW_MidiSequencer::BW_MidiSequencer() :
     midi_dpmi_lock_class_code<MidiTrackStateList>();
     midi_dpmi_lock_class_code<BranchesList>();
     midi_dpmi_lock_class_code<TemposList>();
+    midi_dpmi_lock_class_code<SeekChannelsList>();
+    midi_dpmi_lock_class_code<SeekReplayList>();
+    midi_dpmi_lock_class_code<SeekKeyframesList>();
 
     midi_dpmi_lock_class_code<MidiTrackQueue>();
 #endif
@@ -167,6 +173,9 @@ BW_MidiSequencer::~BW_MidiSequencer()
     midi_dpmi_unlock_class_code<MidiTrackStateList>();
     midi_dpmi_unlock_class_code<BranchesList>();
     midi_dpmi_unlock_class_code<TemposList>();
+    midi_dpmi_unlock_class_code<SeekChannelsList>();
+    midi_dpmi_unlock_class_code<SeekReplayList>();
+    midi_dpmi_unlock_class_code<SeekKeyframesList>();
 
     midi_dpmi_unlock_class_code<MidiTrackQueue>();
 #endif
@@ -203,6 +212,8 @@ void BW_MidiSequencer::setInterface(const BW_MidiRtInterface *intrf)
     }
 
     m_interface = intrf;
+    // Events routing may differ with another interface
+    seekIndexReset();
 }
 
 BW_MidiSequencer::FileFormat BW_MidiSequencer::getFormat()
@@ -222,6 +233,7 @@ bool BW_MidiSequencer::setTrackEnabled(size_t track, bool enable)
         return false;
 
     m_trackState[track].disabled = !enable;
+    seekIndexReset();
     return true;
 }
 
@@ -255,6 +267,7 @@ bool BW_MidiSequencer::setChannelEnabled(size_t channel, bool enable)
 void BW_MidiSequencer::setSoloTrack(size_t track)
 {
     m_trackSolo = track;
+    seekIndexReset();
 }
 
 void BW_MidiSequencer::setSongNum(int track)
@@ -290,6 +303,7 @@ void BW_MidiSequencer::setSongNum(int track)
 void BW_MidiSequencer::setDeviceMask(uint32_t devMask)
 {
     m_deviceMask = devMask;
+    seekIndexReset();
 }
 
 static void devmask2string(char *masks_list, size_t max_length, uint32_t mask)
@@ -77,6 +77,8 @@ int midi_seq_openData(void *seq, void *bytes, unsigned long len)
 {
     MixerSeqInternal *seqi = reinterpret_cast<MixerSeqInternal*>(seq);
     bool ret = seqi->seq.loadMIDI(bytes, static_cast<size_t>(len));
+    if(ret)
+        seqi->seq.buildSeekIndex();
     return ret ? 0 : -1;
 }
 
@@ -84,6 +86,8 @@ int midi_seq_openFile(void *seq, const char *path)
 {
     MixerSeqInternal *seqi = reinterpret_cast<MixerSeqInternal*>(seq);
     bool ret = seqi->seq.loadMIDI(path);
+    if(ret)
+        seqi->seq.buildSeekIndex();
     return ret ? 0 : -1;
 }
 
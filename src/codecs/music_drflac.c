@@ -59,8 +59,10 @@ typedef struct {
     int status;
     int sample_rate;
     int channels;
+    SDL_AudioFormat format;
+    int frame_size;
     SDL_AudioStream *stream;
-    drflac_int16 *buffer;
+    void *buffer;
     int buffer_size;
     int loop;
     SDL_bool loop_flag;
@@ -181,6 +183,18 @@ static void DRFLAC_MetaCB(void *context, drflac_metadata *metadata)
 
 static int DRFLAC_Seek(void *context, double position);
 
+static drflac_uint64 DRFLAC_ReadFrames(DRFLAC_Music *music, void *dst, drflac_uint64 frames)
+{
+    switch (music->format) {
+    case AUDIO_F32SYS:
+        return drflac_read_pcm_frames_f32(music->dec, frames, (float *)dst);
+    case AUDIO_S32SYS:
+        return drflac_read_pcm_frames_s32(music->dec, frames, (drflac_int32 *)dst);
+    default:
+        return drflac_read_pcm_frames_s16(music->dec, frames, (drflac_int16 *)dst);
+    }
+}
+
 static void *DRFLAC_CreateFromRW(SDL_RWops *src, int freesrc)
 {
     DRFLAC_Music *music;
@@ -206,27 +220,41 @@ static void *DRFLAC_CreateFromRW(SDL_RWops *src, int freesrc)
         return NULL;
     }
 
-    /* We should have channels and sample rate set up here */
-    music->stream = SDL_NewAudioStream(AUDIO_S16SYS,
-                                       (Uint8)music->channels,
-                                       music->sample_rate,
-                                       music_spec.format,
-                                       music_spec.channels,
-                                       music_spec.freq);
-    if (!music->stream) {
-        SDL_OutOfMemory();
-        drflac_close(music->dec);
-        SDL_free(music);
-        return NULL;
+    /* Decode into float or 32-bit samples for such output, so 24-bit files keep their precision */
+    if (SDL_AUDIO_ISFLOAT(music_spec.format)) {
+        music->format = AUDIO_F32SYS;
+    } else if (SDL_AUDIO_BITSIZE(music_spec.format) == 32) {
+        music->format = AUDIO_S32SYS;
+    } else {
+        music->format = AUDIO_S16SYS;
     }
+    music->frame_size = (SDL_AUDIO_BITSIZE(music->format) / 8) * music->channels;
+
+    /* We should have channels and sample rate set up here.
+     * Without a conversion, the frames are decoded right into the output. */
+    if (!music_pcm_is_native(music->format, music->channels, music->sample_rate)) {
+        music->stream = SDL_NewAudioStream(music->format,
+                                           (Uint8)music->channels,
+                                           music->sample_rate,
+                                           music_spec.format,
+                                           music_spec.channels,
+                                           music_spec.freq);
+        if (!music->stream) {
+            SDL_OutOfMemory();
+            drflac_close(music->dec);
+            SDL_free(music);
+            return NULL;
+        }
 
-    music->buffer_size = music_spec.samples * sizeof(drflac_int16) * music->channels;
-    music->buffer = (drflac_int16*)SDL_calloc(1, music->buffer_size);
-    if (!music->buffer) {
-        drflac_close(music->dec);
-        SDL_OutOfMemory();
-        SDL_free(music);
-        return NULL;
+        music->buffer_size = music_spec.samples * music->frame_size;
+        music->buffer = SDL_calloc(1, music->buffer_size);
+        if (!music->buffer) {
+            drflac_close(music->dec);
+            SDL_FreeAudioStream(music->stream);
+            SDL_OutOfMemory();
+            SDL_free(music);
+            return NULL;
+        }
     }
 
     /* loop_start, loop_end and loop_len get set by metadata callback if tags
@@ -264,7 +292,9 @@ static int DRFLAC_Play(void *context, int play_count)
 static void DRFLAC_Stop(void *context)
 {
     DRFLAC_Music *music = (DRFLAC_Music *)context;
-    SDL_AudioStreamClear(music->stream);
+    if (music->stream) {
+        SDL_AudioStreamClear(music->stream);
+    }
 }
 
 static int DRFLAC_GetSome(void *context, void *data, int bytes, SDL_bool *done)
@@ -299,20 +329,29 @@ static int DRFLAC_GetSome(void *context, void *data, int bytes, SDL_bool *done)
         }
     }
 
-    amount = drflac_read_pcm_frames_s16(music->dec, music_spec.samples, music->buffer);
+    if (music->stream) {
+        amount = DRFLAC_ReadFrames(music, music->buffer, music_spec.samples);
+    } else {
+        amount = DRFLAC_ReadFrames(music, data, (drflac_uint64)(bytes / music->frame_size));
+    }
     if (amount > 0) {
         if (music->loop && (music->play_count != 1) &&
             ((Sint64)music->dec->currentPCMFrame >= music->loop_end)) {
             amount -= (music->dec->currentPCMFrame - music->loop_end);
             music->loop_flag = SDL_TRUE;
         }
-        if (SDL_AudioStreamPut(music->stream, music->buffer, (int)amount * sizeof(drflac_int16) * music->channels) < 0) {
+        if (!music->stream) {
+            return (int)amount * music->frame_size;
+        }
+        if (SDL_AudioStreamPut(music->stream, music->buffer, (int)amount * music->frame_size) < 0) {
             return -1;
         }
     } else {
         if (music->play_count == 1) {
             music->play_count = 0;
-            SDL_AudioStreamFlush(music->stream);
+            if (music->stream) {
+                SDL_AudioStreamFlush(music->stream);
+            }
         } else {
             int play_count = -1;
             if (music->play_count > 0) {
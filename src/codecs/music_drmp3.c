@@ -48,6 +48,14 @@
 #   include "stream_custom.h"
 #endif
 
+/* Values of the MIX_MP3SEEKTABLE hint */
+#define DRMP3_SEEK_TABLE_OFF    0
+#define DRMP3_SEEK_TABLE_AUTO   1
+#define DRMP3_SEEK_TABLE_EXACT  2
+
+/* Count of seek points of the scanned table, besides the start of the stream */
+#define DRMP3_SEEK_POINTS       512
+
 typedef struct {
     struct mp3file_t file;
     drmp3 dec;
@@ -56,9 +64,21 @@ typedef struct {
     int volume;
     int status;
     SDL_AudioStream *stream;
-    drmp3_int16 *buffer;
+    void *buffer;
     int buffer_size;
     int channels;
+    SDL_AudioFormat format;
+    int frame_size;
+
+    drmp3_seek_point *seek_points;
+    drmp3_uint64 pcm_frames;
+
+    /* Xing/Info header of the stream */
+    SDL_bool has_toc;
+    Uint8 toc[100];
+    drmp3_uint64 toc_offset;
+    drmp3_uint32 toc_frames;
+    drmp3_uint32 toc_bytes;
 
     Mix_MusicMetaTags tags;
 } DRMP3_Music;
@@ -102,11 +122,126 @@ static drmp3_bool32 DRMP3_TellCB(void *context, drmp3_int64 *pos)
     return (*pos < 0) ? DRMP3_FALSE : DRMP3_TRUE;
 }
 
+static drmp3_uint32 DRMP3_ReadBE32(const Uint8 *data)
+{
+    return ((drmp3_uint32)data[0] << 24) | ((drmp3_uint32)data[1] << 16) |
+           ((drmp3_uint32)data[2] << 8) | (drmp3_uint32)data[3];
+}
+
+/* Keeps the TOC of the Xing/Info header, dr_mp3 skips it */
+static void DRMP3_MetaCB(void *context, const drmp3_metadata *meta)
+{
+    DRMP3_Music *music = (DRMP3_Music *)context;
+    const Uint8 *data = (const Uint8 *)meta->pRawData;
+    size_t pos = 8;
+    Uint8 flags;
+
+    /* dr_mp3 reports the "Info" header as VBRI */
+    if (meta->type != DRMP3_METADATA_TYPE_XING && meta->type != DRMP3_METADATA_TYPE_VBRI) {
+        return;
+    }
+
+    if (meta->rawDataSize < pos) {
+        return;
+    }
+
+    flags = data[7];
+    if ((flags & 0x07) != 0x07 || meta->rawDataSize < pos + 108) {
+        return; /* Frames, bytes, and TOC are all needed */
+    }
+
+    music->toc_frames = DRMP3_ReadBE32(data + pos);
+    music->toc_bytes = DRMP3_ReadBE32(data + pos + 4);
+    SDL_memcpy(music->toc, data + pos + 8, sizeof(music->toc));
+    /* The header frame is the base of the TOC offsets, it's not skipped yet */
+    music->toc_offset = music->dec.streamStartOffset;
+    music->has_toc = (music->toc_frames > 0 && music->toc_bytes > 0);
+}
+
+/* Replaces the bound seek table, the first point is always the start of the stream */
+static void DRMP3_BindSeekTable(DRMP3_Music *music, drmp3_seek_point *points, drmp3_uint32 count)
+{
+    points[0].seekPosInBytes = music->dec.streamStartOffset;
+    points[0].pcmFrameIndex = 0;
+    points[0].mp3FramesToDiscard = 0;
+    points[0].pcmFramesToDiscard = 0;
+
+    drmp3_bind_seek_table(&music->dec, count, points);
+    if (music->seek_points) {
+        SDL_free(music->seek_points);
+    }
+    music->seek_points = points;
+}
+
+/*
+ * Turns the Xing TOC into seek points without reading the stream. The TOC
+ * keeps the byte offset of every percent of the duration with 1/256 of
+ * the stream precision, so such seeking is approximate.
+ */
+static void DRMP3_BindTocSeekTable(DRMP3_Music *music)
+{
+    drmp3_seek_point *points;
+    drmp3_uint64 total = music->dec.totalPCMFrameCount, frame_size, offset, last = 0;
+    drmp3_uint32 count = 1;
+    int i;
+
+    if (!music->has_toc || total == DRMP3_UINT64_MAX) {
+        return;
+    }
+
+    points = (drmp3_seek_point *)SDL_malloc(sizeof(drmp3_seek_point) * 100);
+    if (!points) {
+        return;
+    }
+
+    frame_size = total / music->toc_frames;
+    for (i = 1; i < 100; ++i) {
+        offset = music->toc_offset + ((drmp3_uint64)music->toc[i] * music->toc_bytes) / 256;
+        if (offset <= music->dec.streamStartOffset || offset <= last) {
+            continue; /* Broken or too coarse TOC */
+        }
+        last = offset;
+
+        /* The last of the discarded frames is the one which gets decoded */
+        points[count].seekPosInBytes = offset;
+        points[count].pcmFrameIndex = (total * i) / 100 + frame_size * (DRMP3_SEEK_LEADING_MP3_FRAMES - 1);
+        points[count].mp3FramesToDiscard = DRMP3_SEEK_LEADING_MP3_FRAMES;
+        points[count].pcmFramesToDiscard = 0;
+        ++count;
+    }
+
+    DRMP3_BindSeekTable(music, points, count);
+}
+
+/* Scans headers of all frames of the stream to make an exact seek table */
+static void DRMP3_ScanSeekTable(DRMP3_Music *music)
+{
+    drmp3_seek_point *points;
+    drmp3_uint32 count = DRMP3_SEEK_POINTS;
+    Uint32 start = SDL_GetTicks();
+
+    points = (drmp3_seek_point *)SDL_malloc(sizeof(drmp3_seek_point) * (count + 1));
+    if (!points) {
+        return;
+    }
+
+    /* Done while loading only, the decoder is at the start of the stream yet */
+    if (!drmp3_calculate_seek_points(&music->dec, &count, points + 1)) {
+        SDL_free(points);
+        return;
+    }
+
+    DRMP3_BindSeekTable(music, points, count + 1);
+    SDL_LogDebug(SDL_LOG_CATEGORY_AUDIO, "music_drmp3: seek table of %u points got been built in %u ms",
+                 (unsigned int)count, (unsigned int)(SDL_GetTicks() - start));
+}
+
 static int DRMP3_Seek(void *context, double position);
 
 static void *DRMP3_CreateFromRW(SDL_RWops *src, int freesrc)
 {
     DRMP3_Music *music;
+    int seek_table;
 
     music = (DRMP3_Music *)SDL_calloc(1, sizeof(DRMP3_Music));
     if (!music) {
@@ -129,33 +264,59 @@ static void *DRMP3_CreateFromRW(SDL_RWops *src, int freesrc)
 
     MP3_RWseek(&music->file, 0, RW_SEEK_SET);
 
-    if (!drmp3_init(&music->dec, DRMP3_ReadCB, DRMP3_SeekCB, DRMP3_TellCB, NULL, music, NULL)) {
+    if (!drmp3_init(&music->dec, DRMP3_ReadCB, DRMP3_SeekCB, DRMP3_TellCB, DRMP3_MetaCB, music, NULL)) {
         SDL_free(music);
         Mix_SetError("music_drmp3: corrupt mp3 file (bad stream).");
         return NULL;
     }
 
-    music->channels = music->dec.channels;
-    music->stream = SDL_NewAudioStream(AUDIO_S16SYS,
-                                       (Uint8)music->channels,
-                                       (int)music->dec.sampleRate,
-                                       music_spec.format,
-                                       music_spec.channels,
-                                       music_spec.freq);
-    if (!music->stream) {
-        SDL_OutOfMemory();
-        drmp3_uninit(&music->dec);
-        SDL_free(music);
-        return NULL;
+    /* The seek table is made here, by Mix_LoadMUS() or by the loader thread,
+       so seeking under the audio lock never scans the stream */
+    seek_table = SDL_GetHint(MIX_MP3SEEKTABLE) ?
+                 SDL_atoi(SDL_GetHint(MIX_MP3SEEKTABLE)) : DRMP3_SEEK_TABLE_AUTO;
+    if (seek_table == DRMP3_SEEK_TABLE_AUTO) {
+        DRMP3_BindTocSeekTable(music);
+    }
+    if (seek_table != DRMP3_SEEK_TABLE_OFF && !music->seek_points) {
+        DRMP3_ScanSeekTable(music);
     }
 
-    music->buffer_size = music_spec.samples * sizeof(drmp3_int16) * music->channels;
-    music->buffer = (drmp3_int16*)SDL_calloc(1, music->buffer_size);
-    if (!music->buffer) {
-        drmp3_uninit(&music->dec);
-        SDL_OutOfMemory();
-        SDL_free(music);
-        return NULL;
+    music->channels = music->dec.channels;
+
+    /* The decoder makes floats itself, so it's better to take them for such output */
+    music->format = SDL_AUDIO_ISFLOAT(music_spec.format) ? AUDIO_F32SYS : AUDIO_S16SYS;
+    music->frame_size = (SDL_AUDIO_BITSIZE(music->format) / 8) * music->channels;
+
+    /* Without a conversion, the frames are decoded right into the output */
+    if (!music_pcm_is_native(music->format, music->channels, (int)music->dec.sampleRate)) {
+        music->stream = SDL_NewAudioStream(music->format,
+                                           (Uint8)music->channels,
+                                           (int)music->dec.sampleRate,
+                                           music_spec.format,
+                                           music_spec.channels,
+                                           music_spec.freq);
+        if (!music->stream) {
+            SDL_OutOfMemory();
+            drmp3_uninit(&music->dec);
+            if (music->seek_points) {
+                SDL_free(music->seek_points);
+            }
+            SDL_free(music);
+            return NULL;
+        }
+
+        music->buffer_size = music_spec.samples * music->frame_size;
+        music->buffer = SDL_calloc(1, music->buffer_size);
+        if (!music->buffer) {
+            drmp3_uninit(&music->dec);
+            SDL_OutOfMemory();
+            SDL_FreeAudioStream(music->stream);
+            if (music->seek_points) {
+                SDL_free(music->seek_points);
+            }
+            SDL_free(music);
+            return NULL;
+        }
     }
 
     music->freesrc = freesrc;
@@ -185,7 +346,17 @@ static int DRMP3_Play(void *context, int play_count)
 static void DRMP3_Stop(void *context)
 {
     DRMP3_Music *music = (DRMP3_Music *)context;
-    SDL_AudioStreamClear(music->stream);
+    if (music->stream) {
+        SDL_AudioStreamClear(music->stream);
+    }
+}
+
+static drmp3_uint64 DRMP3_ReadFrames(DRMP3_Music *music, void *dst, drmp3_uint64 frames)
+{
+    if (music->format == AUDIO_F32SYS) {
+        return drmp3_read_pcm_frames_f32(&music->dec, frames, (float *)dst);
+    }
+    return drmp3_read_pcm_frames_s16(&music->dec, frames, (drmp3_int16 *)dst);
 }
 
 static int DRMP3_GetSome(void *context, void *data, int bytes, SDL_bool *done)
@@ -207,15 +378,24 @@ static int DRMP3_GetSome(void *context, void *data, int bytes, SDL_bool *done)
         return 0;
     }
 
-    amount = drmp3_read_pcm_frames_s16(&music->dec, music_spec.samples, music->buffer);
+    if (music->stream) {
+        amount = DRMP3_ReadFrames(music, music->buffer, music_spec.samples);
+    } else {
+        amount = DRMP3_ReadFrames(music, data, (drmp3_uint64)(bytes / music->frame_size));
+    }
     if (amount > 0) {
-        if (SDL_AudioStreamPut(music->stream, music->buffer, (int)amount * sizeof(drmp3_int16) * music->channels) < 0) {
+        if (!music->stream) {
+            return (int)amount * music->frame_size;
+        }
+        if (SDL_AudioStreamPut(music->stream, music->buffer, (int)amount * music->frame_size) < 0) {
             return -1;
         }
     } else {
         if (music->play_count == 1) {
             music->play_count = 0;
-            SDL_AudioStreamFlush(music->stream);
+            if (music->stream) {
+                SDL_AudioStreamFlush(music->stream);
+            }
         } else {
             int play_count = -1;
             if (music->play_count > 0) {
@@ -253,8 +433,13 @@ static double DRMP3_Tell(void *context)
 static double DRMP3_Duration(void *context)
 {
     DRMP3_Music *music = (DRMP3_Music *)context;
-    drmp3_uint64 samples = drmp3_get_pcm_frame_count(&music->dec);
-    return (double)samples / music->dec.sampleRate;
+
+    /* Without the Xing header, this scans the whole stream */
+    if (!music->pcm_frames) {
+        music->pcm_frames = drmp3_get_pcm_frame_count(&music->dec);
+    }
+
+    return (double)music->pcm_frames / music->dec.sampleRate;
 }
 
 static const char* DRMP3_GetMetaTag(void *context, Mix_MusicMetaTag tag_type)
@@ -270,6 +455,9 @@ static void DRMP3_Delete(void *context)
     drmp3_uninit(&music->dec);
     meta_tags_clear(&music->tags);
 
+    if (music->seek_points) {
+        SDL_free(music->seek_points);
+    }
     if (music->stream) {
         SDL_FreeAudioStream(music->stream);
     }
@@ -30,6 +30,8 @@
 #include "SDL_rwops.h"
 
 #include "utils.h"
+#include "mix_bank_cache.h"
+#include "mix_mmap.h"
 #include "music_fluidsynth.h"
 #include "midi_seq/mix_midi_seq.h"
 
@@ -99,6 +101,7 @@ typedef struct {
     int (*fluid_synth_write_float)(fluid_synth_t*, int, void*, int, int, void*, int, int);
     fluid_settings_t* (*new_fluid_settings)(void);
     fluid_synth_t* (*new_fluid_synth)(fluid_settings_t*);
+    int (*fluid_synth_system_reset)(fluid_synth_t*);
     /* Real-Time MIDI API */
     int (*fluid_synth_noteon)(fluid_synth_t*, int, int, int);
     int (*fluid_synth_noteoff)(fluid_synth_t*, int, int);
@@ -172,6 +175,7 @@ static int FLUIDSYNTH_Load()
         FUNCTION_LOADER(fluid_synth_write_float, int(*)(fluid_synth_t*, int, void*, int, int, void*, int, int))
         FUNCTION_LOADER(new_fluid_settings, fluid_settings_t* (*)(void))
         FUNCTION_LOADER(new_fluid_synth, fluid_synth_t* (*)(fluid_settings_t*))
+        FUNCTION_LOADER(fluid_synth_system_reset, int (*)(fluid_synth_t*))
         /* Real-Time MIDI API */
         FUNCTION_LOADER(fluid_synth_noteon, int (*)(fluid_synth_t*, int, int, int))
         FUNCTION_LOADER(fluid_synth_noteoff, int (*)(fluid_synth_t*, int, int))
@@ -215,6 +219,8 @@ static void FLUIDSYNTH_Unload()
         return;
     }
     if (fluidsynth.loaded == 1) {
+        /* Cached synthesizers can't outlive the library */
+        _Mix_BankCacheFlush("FLUIDSYNTH");
 #ifdef FLUIDSYNTH_DYNAMIC
         SDL_UnloadObject(fluidsynth.handle);
 #endif
@@ -301,9 +307,16 @@ void _Mix_FLUIDSYNTH_setSetDefaults(void)
 
 
 
+/* The synthesizer with SoundFonts loaded, it's kept in the bank cache once the
+   music got been freed, so next songs playing same SoundFonts reuse it */
 typedef struct {
-    fluid_synth_t *synth;
     fluid_settings_t *settings;
+    fluid_synth_t *synth;
+} FLUIDSYNTH_Synth;
+
+typedef struct {
+    fluid_synth_t *synth;
+    FLUIDSYNTH_Synth *instance;
     BW_MidiRtInterface seq_if;
     int (*synth_write)(fluid_synth_t*, int, void*, int, int, void*, int, int);
     int synth_write_ret;
@@ -462,6 +475,119 @@ static int SDLCALL fluidsynth_load_soundfont(const char *path, void *data)
     return 1;
 }
 
+typedef struct {
+    Uint64 stamp;
+    Sint64 size;
+} FLUIDSYNTH_Stamp;
+
+static int SDLCALL fluidsynth_stamp_soundfont(const char *path, void *data)
+{
+    FLUIDSYNTH_Stamp *st = (FLUIDSYNTH_Stamp *)data;
+    st->stamp = st->stamp * 31 + _Mix_BankCacheFileStamp(path, &st->size);
+    return 1;
+}
+
+static void fluidsynth_synth_free(void *object)
+{
+    FLUIDSYNTH_Synth *instance = (FLUIDSYNTH_Synth *)object;
+
+    if (instance->synth) {
+        fluidsynth.delete_fluid_synth(instance->synth);
+    }
+    if (instance->settings) {
+        fluidsynth.delete_fluid_settings(instance->settings);
+    }
+    SDL_free(instance);
+}
+
+/* Take the unused synthesizer with given SoundFonts from the cache, or make the new one */
+static FLUIDSYNTH_Synth *fluidsynth_synth_acquire(const char *soundfonts)
+{
+    FLUIDSYNTH_Synth *instance;
+    FLUIDSYNTH_Stamp st;
+    double gain;
+    size_t key_len;
+    char *key;
+
+    if (!soundfonts) {
+        Mix_SetError("No SoundFonts have been requested");
+        return NULL;
+    }
+
+    key_len = SDL_strlen(soundfonts) + 16;
+    if (!(key = (char *)SDL_malloc(key_len))) {
+        SDL_OutOfMemory();
+        return NULL;
+    }
+    SDL_snprintf(key, key_len, "%d:%s", music_spec.freq, soundfonts);
+
+    st.stamp = 0;
+    st.size = 0;
+    Mix_EachSoundFontEx(soundfonts, fluidsynth_stamp_soundfont, &st);
+
+    instance = (FLUIDSYNTH_Synth *)_Mix_BankCacheAcquire("FLUIDSYNTH", key, st.stamp, NULL);
+    if (instance) {
+        SDL_free(key);
+        gain = 0.2; /* FluidSynth's default */
+        fluidsynth.fluid_settings_getnum(instance->settings, "synth.gain", &gain);
+        fluidsynth.fluid_synth_set_gain(instance->synth, (float)gain);
+        return instance;
+    }
+
+    if (!(instance = (FLUIDSYNTH_Synth *)SDL_calloc(1, sizeof(FLUIDSYNTH_Synth)))) {
+        SDL_free(key);
+        SDL_OutOfMemory();
+        return NULL;
+    }
+
+    if (!(instance->settings = fluidsynth.new_fluid_settings())) {
+        Mix_SetError("Failed to create FluidSynth settings");
+        goto fail;
+    }
+
+    fluidsynth.fluid_settings_setnum(instance->settings, "synth.sample-rate", (double) music_spec.freq);
+
+    if (!(instance->synth = fluidsynth.new_fluid_synth(instance->settings))) {
+        Mix_SetError("Failed to create FluidSynth synthesizer");
+        goto fail;
+    }
+
+    if (!Mix_EachSoundFontEx(soundfonts, fluidsynth_load_soundfont, instance->synth)) {
+        goto fail;
+    }
+
+    if (_Mix_BankCacheInsert("FLUIDSYNTH", key, st.stamp, instance, st.size, SDL_TRUE, fluidsynth_synth_free) < 0) {
+        goto fail;
+    }
+
+    SDL_free(key);
+    return instance;
+
+fail:
+    SDL_free(key);
+    fluidsynth_synth_free(instance);
+    return NULL;
+}
+
+static void fluidsynth_synth_release(FLUIDSYNTH_Synth *instance)
+{
+    /* Forget everything the previous song did */
+    fluidsynth.fluid_synth_system_reset(instance->synth);
+    _Mix_BankCacheRelease(instance);
+}
+
+int _Mix_FLUIDSYNTH_preloadSoundFonts(void)
+{
+    FLUIDSYNTH_Synth *instance = fluidsynth_synth_acquire(Mix_GetSoundFonts());
+
+    if (!instance) {
+        return -1;
+    }
+
+    fluidsynth_synth_release(instance);
+    return 0;
+}
+
 static int FLUIDSYNTH_Open(const SDL_AudioSpec *spec)
 {
     (void)spec;
@@ -647,6 +773,7 @@ static FLUIDSYNTH_Music *FLUIDSYNTH_LoadMusicArg(void *data, const char *args)
     double samplerate; /* as set by the lib. */
     int src_format = AUDIO_S16SYS;
     const Uint8 channels = 2;
+    const void *rw_data;
     void *rw_mem;
     size_t rw_size;
     int ret;
@@ -671,31 +798,15 @@ static FLUIDSYNTH_Music *FLUIDSYNTH_LoadMusicArg(void *data, const char *args)
         goto fail;
     }
 
-    if (!(music->settings = fluidsynth.new_fluid_settings())) {
-        Mix_SetError("Failed to create FluidSynth settings");
+    music->instance = fluidsynth_synth_acquire(setup.custom_soundfonts[0] ? setup.custom_soundfonts : Mix_GetSoundFonts());
+    if (!music->instance) {
         goto fail;
     }
 
-    fluidsynth.fluid_settings_setnum(music->settings, "synth.sample-rate", (double) music_spec.freq);
-    fluidsynth.fluid_settings_getnum(music->settings, "synth.sample-rate", &samplerate);
+    music->synth = music->instance->synth;
+    fluidsynth.fluid_settings_getnum(music->instance->settings, "synth.sample-rate", &samplerate);
     music->seq_if.pcmSampleRate = samplerate;
 
-    if (!(music->synth = fluidsynth.new_fluid_synth(music->settings))) {
-        Mix_SetError("Failed to create FluidSynth synthesizer");
-        goto fail;
-    }
-
-
-    if (setup.custom_soundfonts[0]) {
-        ret = Mix_EachSoundFontEx(setup.custom_soundfonts, fluidsynth_load_soundfont, music->synth);
-    } else {
-        ret = Mix_EachSoundFont(fluidsynth_load_soundfont, music->synth);
-    }
-
-    if (!ret) {
-        goto fail;
-    }
-
 #if !defined(MUSIC_MID_FLUIDLITE) && (FLUIDSYNTH_VERSION_MAJOR >= 2)
     fluidsynth.fluid_synth_reverb_on(music->synth, -1, setup.reverb);
     fluidsynth.fluid_synth_set_reverb_group_roomsize(music->synth, -1, setup.reverb_roomsize);
@@ -728,8 +839,8 @@ static FLUIDSYNTH_Music *FLUIDSYNTH_LoadMusicArg(void *data, const char *args)
         goto fail;
     }
 
-    rw_mem = SDL_LoadFile_RW(src, &rw_size, SDL_FALSE);
-    if (!rw_mem) {
+    rw_data = _Mix_LoadDataRW(src, &rw_size, &rw_mem);
+    if (!rw_data) {
         SDL_OutOfMemory();
         goto fail;
     }
@@ -737,7 +848,7 @@ static FLUIDSYNTH_Music *FLUIDSYNTH_LoadMusicArg(void *data, const char *args)
     midi_seq_set_device_mask(music->player, DEFAULT_MASK_GM);
     midi_seq_set_mode_emidi(music->player, setup.mode_emidi);
 
-    ret = midi_seq_openData(music->player, rw_mem, rw_size);
+    ret = midi_seq_openData(music->player, (void *)rw_data, rw_size);
     SDL_free(rw_mem);
 
     if (ret < 0) {
@@ -995,11 +1106,8 @@ static void FLUIDSYNTH_Delete(void *context)
 
     meta_tags_clear(&music->tags);
 
-    if (music->synth) {
-        fluidsynth.delete_fluid_synth(music->synth);
-    }
-    if (music->settings) {
-        fluidsynth.delete_fluid_settings(music->settings);
+    if (music->instance) {
+        fluidsynth_synth_release(music->instance);
     }
     if (music->stream) {
         SDL_FreeAudioStream(music->stream);
@@ -32,5 +32,6 @@ extern Mix_MusicInterface Mix_MusicInterface_FLUIDXMI;
 extern int _Mix_FLUIDSYNTH_getModeEMIDI(void);
 extern void _Mix_FLUIDSYNTH_setModeEMIDI(int en);
 extern void _Mix_FLUIDSYNTH_setSetDefaults(void);
+extern int _Mix_FLUIDSYNTH_preloadSoundFonts(void);
 
 /* vi: set ts=4 sw=4 expandtab: */
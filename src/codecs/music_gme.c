@@ -23,6 +23,7 @@
 
 #include "SDL_loadso.h"
 #include "utils.h"
+#include "mix_mmap.h"
 
 #include "music_gme.h"
 
@@ -349,6 +350,7 @@ static int initialize_from_track_info(GME_Music *music, int track)
 
 static GME_Music *GME_CreateFromRW(SDL_RWops *src, const char *args)
 {
+    const void *data;
     void *mem = 0;
     size_t size;
     GME_Music *music;
@@ -367,11 +369,13 @@ static GME_Music *GME_CreateFromRW(SDL_RWops *src, const char *args)
     music->tempo = setup.tempo;
     music->gain = setup.gain;
 
-    music->stream = SDL_NewAudioStream(AUDIO_S16SYS, 2, music_spec.freq,
-                                       music_spec.format, music_spec.channels, music_spec.freq);
-    if (!music->stream) {
-        GME_Delete(music);
-        return NULL;
+    if (!music_pcm_is_native(AUDIO_S16SYS, 2, music_spec.freq)) {
+        music->stream = SDL_NewAudioStream(AUDIO_S16SYS, 2, music_spec.freq,
+                                           music_spec.format, music_spec.channels, music_spec.freq);
+        if (!music->stream) {
+            GME_Delete(music);
+            return NULL;
+        }
     }
 
     music->buffer_size = music_spec.samples * sizeof(Sint16) * 2/*channels*/ * music_spec.channels;
@@ -383,9 +387,9 @@ static GME_Music *GME_CreateFromRW(SDL_RWops *src, const char *args)
     }
 
     SDL_RWseek(src, 0, RW_SEEK_SET);
-    mem = SDL_LoadFile_RW(src, &size, SDL_FALSE);
-    if (mem) {
-        err = gme.gme_open_data(mem, (long)size, &music->game_emu, music_spec.freq);
+    data = _Mix_LoadDataRW(src, &size, &mem);
+    if (data) {
+        err = gme.gme_open_data(data, (long)size, &music->game_emu, music_spec.freq);
         SDL_free(mem);
         if (err != 0) {
             GME_Delete(music);
@@ -458,7 +462,9 @@ static int GME_Play(void *music_p, int play_count)
     GME_Music *music = (GME_Music*)music_p;
     int fade_start;
     if (music) {
-        SDL_AudioStreamClear(music->stream);
+        if (music->stream) {
+            SDL_AudioStreamClear(music->stream);
+        }
         music->play_count = play_count;
         fade_start = play_count > 0 ? music->intro_length + (music->loop_length * play_count) : -1;
         /* libgme >= 0.6.4 has gme_set_fade_msecs(),
@@ -476,9 +482,11 @@ static int GME_GetSome(void *context, void *data, int bytes, SDL_bool *done)
     int filled;
     const char *err = NULL;
 
-    filled = SDL_AudioStreamGet(music->stream, data, bytes);
-    if (filled != 0) {
-        return filled;
+    if (music->stream) {
+        filled = SDL_AudioStreamGet(music->stream, data, bytes);
+        if (filled != 0) {
+            return filled;
+        }
     }
 
     if (gme.gme_track_ended(music->game_emu)) {
@@ -487,6 +495,18 @@ static int GME_GetSome(void *context, void *data, int bytes, SDL_bool *done)
         return 0;
     }
 
+    if (!music->stream) {
+        /* Play right into the output, by whole stereo frames */
+        filled = bytes < (int)music->buffer_size ? bytes : (int)music->buffer_size;
+        filled &= ~3;
+        err = gme.gme_play(music->game_emu, filled / 2, (short*)data);
+        if (err != NULL) {
+            Mix_SetError("GME: %s", err);
+            return 0;
+        }
+        return filled;
+    }
+
     err = gme.gme_play(music->game_emu, (int)(music->buffer_size / 2), (short*)music->buffer);
     if (err != NULL) {
         Mix_SetError("GME: %s", err);
@@ -29,6 +29,8 @@
 #include "SDL_loadso.h"
 #endif
 #include "utils.h"
+#include "mix_bank_cache.h"
+#include "mix_mmap.h"
 
 #include <adlmidi.h>
 
@@ -457,6 +459,30 @@ void _Mix_ADLMIDI_setCustomBankFile(const char *bank_wonl_path)
     }
 }
 
+int _Mix_ADLMIDI_preloadCustomBank(void)
+{
+    SDL_RWops *rw_bank;
+    void *bytes;
+    size_t size;
+
+    if (adlmidi_setup.custom_bank_path[0] == '\0') {
+        return 0;
+    }
+
+    rw_bank = _Mix_RWFromFile(adlmidi_setup.custom_bank_path, "rb");
+    if (!rw_bank) {
+        return -1;
+    }
+
+    bytes = _Mix_BankCacheLoadRW("ADLMIDI", adlmidi_setup.custom_bank_path, rw_bank, &size);
+    if (!bytes) {
+        return -1;
+    }
+
+    _Mix_BankCacheRelease(bytes);
+    return 0;
+}
+
 typedef struct
 {
     int play_count;
@@ -622,6 +648,7 @@ static void ADLMIDI_delete(void *music_p);
 static AdlMIDI_Music *ADLMIDI_LoadSongRW(SDL_RWops *src, const char *args)
 {
     void *bytes = 0, *bytes2 = 0;
+    const void *data = NULL;
     int err = 0, src_rate, num_chips;
     size_t length = 0;
     AdlMIDI_Music *music = NULL;
@@ -689,12 +716,14 @@ static AdlMIDI_Music *ADLMIDI_LoadSongRW(SDL_RWops *src, const char *args)
         src_format = AUDIO_F32SYS;
     }
 
-    music->stream = SDL_NewAudioStream(src_format, 2, src_rate,
-                                       music_spec.format, music_spec.channels, music_spec.freq);
+    if (!music_pcm_is_native(src_format, 2, src_rate)) {
+        music->stream = SDL_NewAudioStream(src_format, 2, src_rate,
+                                           music_spec.format, music_spec.channels, music_spec.freq);
 
-    if (!music->stream) {
-        ADLMIDI_delete(music);
-        return NULL;
+        if (!music->stream) {
+            ADLMIDI_delete(music);
+            return NULL;
+        }
     }
 
     music->buffer_samples = music_spec.samples * 2 /*channels*/;
@@ -706,8 +735,8 @@ static AdlMIDI_Music *ADLMIDI_LoadSongRW(SDL_RWops *src, const char *args)
         return NULL;
     }
 
-    bytes = SDL_LoadFile_RW(src, &length, SDL_FALSE);
-    if (!bytes) {
+    data = _Mix_LoadDataRW(src, &length, &bytes);
+    if (!data) {
         SDL_OutOfMemory();
         ADLMIDI_delete(music);
         return NULL;
@@ -727,7 +756,7 @@ static AdlMIDI_Music *ADLMIDI_LoadSongRW(SDL_RWops *src, const char *args)
     if (setup.custom_bank_path[0] != '\0') {
         rw_bank = _Mix_RWFromFile((char*)setup.custom_bank_path, "rb");
         if (rw_bank) {
-            bytes2 = SDL_LoadFile_RW(rw_bank, &rw_bank_size, SDL_TRUE);
+            bytes2 = _Mix_BankCacheLoadRW("ADLMIDI", setup.custom_bank_path, rw_bank, &rw_bank_size);
             if (!bytes2) {
                 SDL_OutOfMemory();
                 SDL_free(bytes);
@@ -735,7 +764,7 @@ static AdlMIDI_Music *ADLMIDI_LoadSongRW(SDL_RWops *src, const char *args)
                 return NULL;
             }
             err = ADLMIDI.adl_openBankData(music->adlmidi, bytes2, rw_bank_size);
-            SDL_free(bytes2);
+            _Mix_BankCacheRelease(bytes2);
         }
     } else {
         err = ADLMIDI.adl_setBank(music->adlmidi, setup.bank);
@@ -772,7 +801,7 @@ static AdlMIDI_Music *ADLMIDI_LoadSongRW(SDL_RWops *src, const char *args)
         ADLMIDI.adl_setModeEMIDI(music->adlmidi, setup.mode_emidi);
     }
 
-    err = ADLMIDI.adl_openData(music->adlmidi, bytes, (unsigned long)length);
+    err = ADLMIDI.adl_openData(music->adlmidi, data, (unsigned long)length);
     SDL_free(bytes);
 
     if (err != 0) {
@@ -819,11 +848,21 @@ static int ADLMIDI_play(void *music_p, int play_counts)
 static int ADLMIDI_playSome(void *context, void *data, int bytes, SDL_bool *done)
 {
     AdlMIDI_Music *music = (AdlMIDI_Music *)context;
-    int filled, gottenLen, amount;
+    int filled, gottenLen, amount, samples = (int)music->buffer_samples;
+    Uint8 *buffer = (Uint8 *)music->buffer;
 
-    filled = SDL_AudioStreamGet(music->stream, data, bytes);
-    if (filled != 0) {
-        return filled;
+    if (music->stream) {
+        filled = SDL_AudioStreamGet(music->stream, data, bytes);
+        if (filled != 0) {
+            return filled;
+        }
+    } else {
+        /* Generate right into the output, by whole stereo frames */
+        buffer = (Uint8 *)data;
+        filled = bytes / (int)music->sample_format.containerSize;
+        if (samples > filled) {
+            samples = filled & ~1;
+        }
     }
 
     if (!music->play_count) {
@@ -833,9 +872,9 @@ static int ADLMIDI_playSome(void *context, void *data, int bytes, SDL_bool *done
     }
 
     gottenLen = ADLMIDI.adl_playFormat(music->adlmidi,
-                                      music->buffer_samples,
-                                      (ADL_UInt8*)music->buffer,
-                                      (ADL_UInt8*)music->buffer + music->sample_format.containerSize,
+                                      samples,
+                                      (ADL_UInt8*)buffer,
+                                      (ADL_UInt8*)buffer + music->sample_format.containerSize,
                                       &music->sample_format);
 
     if (gottenLen <= 0) {
@@ -845,13 +884,18 @@ static int ADLMIDI_playSome(void *context, void *data, int bytes, SDL_bool *done
 
     amount = gottenLen * (int)music->sample_format.containerSize;
     if (amount > 0) {
-        if (SDL_AudioStreamPut(music->stream, music->buffer, amount) < 0) {
+        if (!music->stream) {
+            return amount;
+        }
+        if (SDL_AudioStreamPut(music->stream, buffer, amount) < 0) {
             return -1;
         }
     } else {
         if (music->play_count == 1) {
             music->play_count = 0;
-            SDL_AudioStreamFlush(music->stream);
+            if (music->stream) {
+                SDL_AudioStreamFlush(music->stream);
+            }
         } else {
             int play_count = -1;
             if (music->play_count > 0) {
@@ -80,6 +80,7 @@ extern void _Mix_ADLMIDI_setModeEMIDI(int en);
 extern void _Mix_ADLMIDI_setSetDefaults(void);
 
 extern void _Mix_ADLMIDI_setCustomBankFile(const char *bank_wonl_path);
+extern int _Mix_ADLMIDI_preloadCustomBank(void);
 
 #endif /* MUSIC_MID_ADLMIDI */
 
@@ -27,6 +27,7 @@
 
 #include "SDL_loadso.h"
 #include "utils.h"
+#include "mix_mmap.h"
 
 #include <emu_de_midi.h>
 
@@ -311,6 +312,7 @@ static void EDMIDI_delete(void *music_p);
 static EDMIDI_Music *EDMIDI_LoadSongRW(SDL_RWops *src, const char *args)
 {
     void *bytes = 0;
+    const void *data = NULL;
     int err = 0;
     size_t length = 0;
     EDMIDI_Music *music = NULL;
@@ -388,8 +390,8 @@ static EDMIDI_Music *EDMIDI_LoadSongRW(SDL_RWops *src, const char *args)
         return NULL;
     }
 
-    bytes = SDL_LoadFile_RW(src, &length, SDL_FALSE);
-    if (!bytes) {
+    data = _Mix_LoadDataRW(src, &length, &bytes);
+    if (!data) {
         SDL_OutOfMemory();
         EDMIDI_delete(music);
         return NULL;
@@ -416,7 +418,7 @@ static EDMIDI_Music *EDMIDI_LoadSongRW(SDL_RWops *src, const char *args)
         EDMIDI.edmidi_setModeEMIDI(music->edmidi, setup.mode_emidi);
     }
 
-    err = EDMIDI.edmidi_openData(music->edmidi, bytes, (unsigned long)length);
+    err = EDMIDI.edmidi_openData(music->edmidi, data, (unsigned long)length);
     SDL_free(bytes);
 
     if (err != 0) {
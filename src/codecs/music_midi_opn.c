@@ -29,6 +29,8 @@
 #include "SDL_loadso.h"
 #endif
 #include "utils.h"
+#include "mix_bank_cache.h"
+#include "mix_mmap.h"
 
 #include <opnmidi.h>
 #include "OPNMIDI/gm_opn_bank.h"
@@ -359,6 +361,30 @@ void _Mix_OPNMIDI_setCustomBankFile(const char *bank_wonp_path)
     }
 }
 
+int _Mix_OPNMIDI_preloadCustomBank(void)
+{
+    SDL_RWops *rw_bank;
+    void *bytes;
+    size_t size;
+
+    if (opnmidi_setup.custom_bank_path[0] == '\0') {
+        return 0;
+    }
+
+    rw_bank = _Mix_RWFromFile(opnmidi_setup.custom_bank_path, "rb");
+    if (!rw_bank) {
+        return -1;
+    }
+
+    bytes = _Mix_BankCacheLoadRW("OPNMIDI", opnmidi_setup.custom_bank_path, rw_bank, &size);
+    if (!bytes) {
+        return -1;
+    }
+
+    _Mix_BankCacheRelease(bytes);
+    return 0;
+}
+
 
 /* This structure supports OPNMIDI-based MIDI music streams */
 typedef struct
@@ -513,6 +539,7 @@ static void OPNMIDI_delete(void *music_p);
 static OpnMIDI_Music *OPNMIDI_LoadSongRW(SDL_RWops *src, const char *args)
 {
     void *bytes = 0, *bytes2 = 0;
+    const void *data = NULL;
     int err = 0, src_rate, num_chips;
     size_t length = 0;
     OpnMIDI_Music *music = NULL;
@@ -597,8 +624,8 @@ static OpnMIDI_Music *OPNMIDI_LoadSongRW(SDL_RWops *src, const char *args)
         return NULL;
     }
 
-    bytes = SDL_LoadFile_RW(src, &length, SDL_FALSE);
-    if (!bytes) {
+    data = _Mix_LoadDataRW(src, &length, &bytes);
+    if (!data) {
         SDL_OutOfMemory();
         OPNMIDI_delete(music);
         return NULL;
@@ -615,7 +642,7 @@ static OpnMIDI_Music *OPNMIDI_LoadSongRW(SDL_RWops *src, const char *args)
     if (setup.custom_bank_path[0] != '\0') {
         rw_bank = _Mix_RWFromFile((char*)setup.custom_bank_path, "rb");
         if (rw_bank) {
-            bytes2 = SDL_LoadFile_RW(rw_bank, &rw_bank_size, SDL_TRUE);
+            bytes2 = _Mix_BankCacheLoadRW("OPNMIDI", setup.custom_bank_path, rw_bank, &rw_bank_size);
             if (!bytes2) {
                 SDL_OutOfMemory();
                 SDL_free(bytes);
@@ -623,7 +650,7 @@ static OpnMIDI_Music *OPNMIDI_LoadSongRW(SDL_RWops *src, const char *args)
                 return NULL;
             }
             err = OPNMIDI.opn2_openBankData(music->opnmidi, bytes2, rw_bank_size);
-            SDL_free(bytes2);
+            _Mix_BankCacheRelease(bytes2);
         }
     } else {
         err = OPNMIDI.opn2_openBankData(music->opnmidi, g_gm_opn2_bank, sizeof(g_gm_opn2_bank));
@@ -661,7 +688,7 @@ static OpnMIDI_Music *OPNMIDI_LoadSongRW(SDL_RWops *src, const char *args)
         OPNMIDI.opn2_setModeEMIDI(music->opnmidi, setup.mode_emidi);
     }
 
-    err = OPNMIDI.opn2_openData( music->opnmidi, bytes, (unsigned long)length);
+    err = OPNMIDI.opn2_openData( music->opnmidi, data, (unsigned long)length);
     SDL_free(bytes);
 
     if (err != 0) {
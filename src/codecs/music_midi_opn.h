@@ -63,6 +63,7 @@ extern void _Mix_OPNMIDI_setModeEMIDI(int en);
 
 extern void _Mix_OPNMIDI_setSetDefaults(void);
 extern void _Mix_OPNMIDI_setCustomBankFile(const char *bank_wonp_path);
+extern int _Mix_OPNMIDI_preloadCustomBank(void);
 
 #endif /* MUSIC_MID_OPNMIDI */
 
@@ -24,6 +24,7 @@
 #include "SDL_loadso.h"
 
 #include "music_modplug.h"
+#include "mix_mmap.h"
 
 #ifdef MODPLUG_HEADER
 #include MODPLUG_HEADER
@@ -172,6 +173,7 @@ static int MODPLUG_Open(const SDL_AudioSpec *spec)
 void *MODPLUG_CreateFromRW(SDL_RWops *src, int freesrc)
 {
     MODPLUG_Music *music;
+    const void *data;
     void *buffer;
     size_t size;
 
@@ -197,9 +199,9 @@ void *MODPLUG_CreateFromRW(SDL_RWops *src, int freesrc)
         return NULL;
     }
 
-    buffer = SDL_LoadFile_RW(src, &size, SDL_FALSE);
-    if (buffer) {
-        music->file = modplug.ModPlug_Load(buffer, (int)size);
+    data = _Mix_LoadDataRW(src, &size, &buffer);
+    if (data) {
+        music->file = modplug.ModPlug_Load(data, (int)size);
         if (!music->file) {
             Mix_SetError("ModPlug_Load failed");
         }
@@ -163,6 +163,9 @@ typedef struct {
     char *buffer;
     char *buffer_seek;
     int buffer_size;
+    int buffer_alloc;
+    int buffer_left;
+    int buffer_left_pos;
     int loop;
     ogg_int64_t loop_start;
     ogg_int64_t loop_end;
@@ -230,22 +233,21 @@ static int sdl_close_func(void *datasource)
 static int OGG_Seek(void *context, double time);
 static void OGG_Delete(void *context);
 
-static int OGG_UpdateSpeed(OGG_music *music)
+/* Make the stream only when the decoded PCM needs a conversion, otherwise it goes right into the output */
+static int OGG_UpdateStream(OGG_music *music)
 {
-    if (music->computed_src_rate != -1) {
-        return 0;
-    }
-
-    music->computed_src_rate = music->vi.rate * music->speed;
-    if (music->computed_src_rate < 1000) {
-        music->computed_src_rate = 1000;
-    }
+    int channels = music->multitrack ? music->multitrack_channels : music->vi.channels;
 
     if (music->stream) {
         SDL_FreeAudioStream(music->stream);
+        music->stream = NULL;
     }
 
-    music->stream = SDL_NewAudioStream(AUDIO_S16SYS, (Uint8)(music->multitrack ? music->multitrack_channels : music->vi.channels), music->computed_src_rate,
+    if (music_pcm_is_native(AUDIO_S16SYS, channels, music->computed_src_rate)) {
+        return 0;
+    }
+
+    music->stream = SDL_NewAudioStream(AUDIO_S16SYS, (Uint8)channels, music->computed_src_rate,
                                        music_spec.format, music_spec.channels, music_spec.freq);
     if (!music->stream) {
         return -1;
@@ -254,10 +256,25 @@ static int OGG_UpdateSpeed(OGG_music *music)
     return 0;
 }
 
+static int OGG_UpdateSpeed(OGG_music *music)
+{
+    if (music->computed_src_rate != -1) {
+        return 0;
+    }
+
+    music->computed_src_rate = music->vi.rate * music->speed;
+    if (music->computed_src_rate < 1000) {
+        music->computed_src_rate = 1000;
+    }
+
+    return OGG_UpdateStream(music);
+}
+
 static int OGG_UpdateSection(OGG_music *music)
 {
     vorbis_info *vi;
-    Uint8 in_channels;
+    char *ptr;
+    int size;
 
     vi = vorbis.ov_info(&music->vf, -1);
     if (!vi) {
@@ -274,43 +291,27 @@ static int OGG_UpdateSection(OGG_music *music)
         music->computed_src_rate = 1000;
     }
 
-    if (music->buffer) {
-        SDL_free(music->buffer);
-        music->buffer = NULL;
-    }
-
-    if (music->buffer_seek) {
-        SDL_free(music->buffer_seek);
-        music->buffer_seek = NULL;
-    }
-
-    if (music->stream) {
-        SDL_FreeAudioStream(music->stream);
-        music->stream = NULL;
-    }
-
-    if (music->multitrack) {
-        in_channels = (Uint8)music->multitrack_channels;
-    } else {
-        in_channels = (Uint8)vi->channels;
-    }
-
-    music->stream = SDL_NewAudioStream(AUDIO_S16SYS, in_channels, music->computed_src_rate,
-                                       music_spec.format, music_spec.channels, music_spec.freq);
-    if (!music->stream) {
+    if (OGG_UpdateStream(music) < 0) {
         return -1;
     }
 
-    music->buffer_size = music_spec.samples * (int)sizeof(Sint16) * vi->channels;
-    music->buffer = (char *)SDL_malloc((size_t)music->buffer_size);
-    if (!music->buffer) {
-        return -1;
-    }
+    /* Only ever grow the buffers: the PCM of the new section is already decoded into them */
+    size = music_spec.samples * (int)sizeof(Sint16) * vi->channels;
+    if (size > music->buffer_alloc) {
+        ptr = (char *)SDL_realloc(music->buffer, (size_t)size);
+        if (!ptr) {
+            return SDL_OutOfMemory();
+        }
+        music->buffer = ptr;
 
-    music->buffer_seek = (char *)SDL_malloc((size_t)music->buffer_size);
-    if (!music->buffer_seek) {
-        return -1;
+        ptr = (char *)SDL_realloc(music->buffer_seek, (size_t)size);
+        if (!ptr) {
+            return SDL_OutOfMemory();
+        }
+        music->buffer_seek = ptr;
+        music->buffer_alloc = size;
     }
+    music->buffer_size = size;
 
     if (music->multitrack) {
         if (music->multitrack_channels * music->multitrack_tracks > music->vi.channels) {
@@ -534,7 +535,10 @@ static int OGG_Play(void *context, int play_count)
 static void OGG_Stop(void *context)
 {
     OGG_music *music = (OGG_music *)context;
-    SDL_AudioStreamClear(music->stream);
+    music->buffer_left = 0;
+    if (music->stream) {
+        SDL_AudioStreamClear(music->stream);
+    }
 }
 
 static int ogg_quick_seek_to_loop_start(OGG_music *music)
@@ -588,15 +592,27 @@ static int OGG_GetSome(void *context, void *data, int bytes, SDL_bool *done)
     OGG_music *music = (OGG_music *)context;
     SDL_bool looped = SDL_FALSE, retry_get = SDL_FALSE;
     int filled, amount, result, amount_samples, channels, div_chans, i, j, k;
-    int section;
+    int section, size;
     ogg_int64_t pcmPos;
     Sint16 buf_mid[8];
     Sint16 *buf_in, *buf_out;
+    char *buffer;
+
+    if (music->buffer_left > 0) {
+        /* The rest of a read that switched to the native output, hand it out before decoding further */
+        amount = SDL_min(music->buffer_left, bytes);
+        SDL_memcpy(data, music->buffer + music->buffer_left_pos, (size_t)amount);
+        music->buffer_left_pos += amount;
+        music->buffer_left -= amount;
+        return amount;
+    }
 
 try_get:
-    filled = SDL_AudioStreamGet(music->stream, data, bytes);
-    if (filled != 0) {
-        return filled;
+    if (music->stream) {
+        filled = SDL_AudioStreamGet(music->stream, data, bytes);
+        if (filled != 0) {
+            return filled;
+        }
     }
 
     if (!music->play_count) {
@@ -613,11 +629,27 @@ try_get:
         retry_get = SDL_TRUE;
     }
 
+    buffer = music->buffer;
+    size = music->buffer_size;
+    if (!music->stream) {
+        /* Decode right into the output, multiple tracks are mixed down there afterwards */
+        if (music->multitrack) {
+            i = bytes / (int)(sizeof(Sint16) * music->multitrack_channels);
+            i *= (int)sizeof(Sint16) * music->vi.channels;
+        } else {
+            buffer = (char *)data;
+            i = bytes;
+        }
+        if (size > i) {
+            size = i;
+        }
+    }
+
     section = music->section;
 #ifdef OGG_USE_TREMOR
-    amount = (int)vorbis.ov_read(&music->vf, music->buffer, music->buffer_size, &section);
+    amount = (int)vorbis.ov_read(&music->vf, buffer, size, &section);
 #else
-    amount = (int)vorbis.ov_read(&music->vf, music->buffer, music->buffer_size, SDL_BYTEORDER == SDL_BIG_ENDIAN, 2, 1, &section);
+    amount = (int)vorbis.ov_read(&music->vf, buffer, size, SDL_BYTEORDER == SDL_BIG_ENDIAN, 2, 1, &section);
 #endif
     if (amount < 0) {
         return set_ov_error("ov_read", amount);
@@ -630,8 +662,8 @@ try_get:
         amount = music->multitrack_channels * amount_samples * sizeof(Sint16);
         channels = music->multitrack_channels;
         div_chans = (music->vi.channels / music->multitrack_channels);
-        buf_in = (Sint16*)music->buffer;
-        buf_out = (Sint16*)music->buffer;
+        buf_in = (Sint16*)buffer;
+        buf_out = (Sint16*)buffer;
 
         for (i = 0; i < amount_samples; ++i) {
             for (k = 0; k < music->multitrack_channels; ++k) {
@@ -663,6 +695,9 @@ try_get:
         if (OGG_UpdateSection(music) < 0) {
             return -1;
         }
+        if (buffer != data) {
+            buffer = music->buffer;
+        }
     }
 
     pcmPos = vorbis.ov_pcm_tell(&music->vf);
@@ -683,13 +718,26 @@ try_get:
     }
 
     if (amount > 0) {
-        if (SDL_AudioStreamPut(music->stream, music->buffer, amount) < 0) {
+        if (!music->stream) {
+            if (buffer != data) {
+                if (amount > bytes) {
+                    music->buffer_left_pos = bytes;
+                    music->buffer_left = amount - bytes;
+                    amount = bytes;
+                }
+                SDL_memcpy(data, buffer, (size_t)amount);
+            }
+            return amount;
+        }
+        if (SDL_AudioStreamPut(music->stream, buffer, amount) < 0) {
             return -1;
         }
     } else if (!looped) {
         if (music->play_count == 1) {
             music->play_count = 0;
-            SDL_AudioStreamFlush(music->stream);
+            if (music->stream) {
+                SDL_AudioStreamFlush(music->stream);
+            }
         } else {
             int play_count = -1;
             if (music->play_count > 0) {
@@ -726,6 +774,7 @@ static int OGG_Seek(void *context, double time)
     if (result < 0) {
         return set_ov_error("ov_time_seek", result);
     }
+    music->buffer_left = 0;
     return 0;
 }
 
@@ -27,6 +27,7 @@ extern "C" {
 
 #include "./pxtone/pxtnService.h"
 #include "./pxtone/pxtnError.h"
+#include "./pxtone/pxtnMem.h"
 
 /* Global flags which are applying on initializing of PXTone player with a file */
 typedef struct {
@@ -89,6 +90,126 @@ static bool _pxtn_p(void* user, int32_t* p_pos)
     return true;
 }
 
+/* Prepared samples of voices (decoded Ogg, converted PCM and built noise),
+ * shared between the loaded songs, most recently used first */
+typedef struct PXTONE_CachedVoice {
+    Uint64 key;
+    int32_t smp_head_w;
+    int32_t smp_body_w;
+    int32_t smp_tail_w;
+    int32_t smp_size;
+    Uint8 *smp;
+    struct PXTONE_CachedVoice *next;
+} PXTONE_CachedVoice;
+
+#define PXTONE_VOICECACHE_DEFAULT   32768 /* KB */
+
+static SDL_mutex *voice_cache_lock = NULL;
+static PXTONE_CachedVoice *voice_cache = NULL;
+static size_t voice_cache_size = 0;
+static size_t voice_cache_max = 0;
+
+static void PXTONE_TrimVoiceCache(size_t max)
+{
+    PXTONE_CachedVoice **p = &voice_cache, *entry;
+    size_t size = 0;
+
+    while (*p) {
+        entry = *p;
+        if (size + (size_t)entry->smp_size > max) {
+            *p = entry->next;
+            voice_cache_size -= (size_t)entry->smp_size;
+            SDL_free(entry);
+        } else {
+            size += (size_t)entry->smp_size;
+            p = &entry->next;
+        }
+    }
+}
+
+static bool _pxtn_cache_load(void *user, uint64_t key, pxtnVOICEINSTANCE *p_vi)
+{
+    PXTONE_CachedVoice **p, *entry;
+    bool found = false;
+    (void)user;
+
+    SDL_LockMutex(voice_cache_lock);
+    for (p = &voice_cache; *p; p = &(*p)->next) {
+        entry = *p;
+        if (entry->key != key) {
+            continue;
+        }
+        if (pxtnMem_zero_alloc((void **)&p_vi->p_smp_w, (uint32_t)entry->smp_size)) {
+            SDL_memcpy(p_vi->p_smp_w, entry->smp, (size_t)entry->smp_size);
+            p_vi->smp_head_w = entry->smp_head_w;
+            p_vi->smp_body_w = entry->smp_body_w;
+            p_vi->smp_tail_w = entry->smp_tail_w;
+            found = true;
+        }
+        *p = entry->next;
+        entry->next = voice_cache;
+        voice_cache = entry;
+        break;
+    }
+    SDL_UnlockMutex(voice_cache_lock);
+
+    return found;
+}
+
+static void _pxtn_cache_save(void *user, uint64_t key, const pxtnVOICEINSTANCE *p_vi, int32_t smp_size)
+{
+    PXTONE_CachedVoice *entry;
+    (void)user;
+
+    if (smp_size <= 0 || (size_t)smp_size > voice_cache_max) {
+        return;
+    }
+
+    /* The samples are kept in the same block with the entry */
+    entry = (PXTONE_CachedVoice *)SDL_malloc(sizeof(PXTONE_CachedVoice) + (size_t)smp_size);
+    if (!entry) {
+        return;
+    }
+    entry->key = key;
+    entry->smp_head_w = p_vi->smp_head_w;
+    entry->smp_body_w = p_vi->smp_body_w;
+    entry->smp_tail_w = p_vi->smp_tail_w;
+    entry->smp_size = smp_size;
+    entry->smp = (Uint8 *)(entry + 1);
+    SDL_memcpy(entry->smp, p_vi->p_smp_w, (size_t)smp_size);
+
+    SDL_LockMutex(voice_cache_lock);
+    entry->next = voice_cache;
+    voice_cache = entry;
+    voice_cache_size += (size_t)smp_size;
+    if (voice_cache_size > voice_cache_max) {
+        PXTONE_TrimVoiceCache(voice_cache_max);
+    }
+    SDL_UnlockMutex(voice_cache_lock);
+}
+
+static int PXTONE_Open(const SDL_AudioSpec *spec)
+{
+    const char *hint = SDL_GetHint(MIX_PXTONE_VOICECACHE);
+    int max_kb = hint ? SDL_atoi(hint) : PXTONE_VOICECACHE_DEFAULT;
+    (void)spec;
+
+    voice_cache_max = max_kb > 0 ? (size_t)max_kb * 1024 : 0;
+    if (voice_cache_max > 0) {
+        voice_cache_lock = SDL_CreateMutex();
+    }
+    return 0;
+}
+
+static void PXTONE_Close(void)
+{
+    if (voice_cache_lock) {
+        PXTONE_TrimVoiceCache(0);
+        SDL_DestroyMutex(voice_cache_lock);
+        voice_cache_lock = NULL;
+    }
+}
+
 static void process_args(const char *args, PXTONE_Setup *setup)
 {
 #define ARG_BUFFER_SIZE    1024
@@ -197,6 +318,10 @@ static void *PXTONE_NewRWex(struct SDL_RWops *src, int freesrc, const char *args
         return NULL;
     }
 
+    if (voice_cache_lock) {
+        music->pxtn->set_voice_cache(_pxtn_cache_load, _pxtn_cache_save, NULL);
+    }
+
     /* LOAD MUSIC DATA */
     ret = music->pxtn->read(src);
     if (ret != pxtnOK) {
@@ -506,7 +631,7 @@ Mix_MusicInterface Mix_MusicInterface_PXTONE =
     SDL_FALSE,
 
     NULL,   /* Load */
-    NULL,   /* Open */
+    PXTONE_Open,
     PXTONE_NewRW,
     PXTONE_NewRWex, /* [MIXER-X]*/
     NULL,   /* CreateFromFile */
@@ -540,7 +665,7 @@ Mix_MusicInterface Mix_MusicInterface_PXTONE =
     NULL,   /* Resume */
     NULL,   /* Stop */
     PXTONE_Delete,
-    NULL,   /* Close */
+    PXTONE_Close,
     NULL    /* Unload */
 };
 
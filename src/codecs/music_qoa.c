@@ -112,22 +112,23 @@ static int QOA_Seek(void *ctx, double pos);
 static void QOA_Delete(void *ctx);
 static void QOA_CleanUp(SDL_RWops *src, QOA_Music *music);
 
-static int QOA_UpdateSpeed(QOA_Music *music)
+/* Without resampling and remixing, samples go right into the output (as floats
+ * for the float one), and the stream is made only when it's really needed */
+static int QOA_UpdateStream(QOA_Music *music)
 {
-    if (music->computed_src_rate != -1) {
-        return 0;
-    }
-
-    music->computed_src_rate = music->info.samplerate * music->speed;
-    if (music->computed_src_rate < 1000) {
-        music->computed_src_rate = 1000;
-    }
+    int channels = music->multitrack ? (int)music->multitrack_channels : (int)music->info.channels;
 
     if (music->stream) {
         SDL_FreeAudioStream(music->stream);
+        music->stream = NULL;
+    }
+
+    if (music_pcm_is_native(AUDIO_S16SYS, channels, music->computed_src_rate) ||
+        music_pcm_is_native(AUDIO_F32SYS, channels, music->computed_src_rate)) {
+        return 0;
     }
 
-    music->stream = SDL_NewAudioStream(AUDIO_S16SYS, (Uint8)(music->multitrack ? music->multitrack_channels : music->info.channels), music->computed_src_rate,
+    music->stream = SDL_NewAudioStream(AUDIO_S16SYS, (Uint8)channels, music->computed_src_rate,
                                        music_spec.format, music_spec.channels, music_spec.freq);
     if (!music->stream) {
         return -1;
@@ -136,6 +137,20 @@ static int QOA_UpdateSpeed(QOA_Music *music)
     return 0;
 }
 
+static int QOA_UpdateSpeed(QOA_Music *music)
+{
+    if (music->computed_src_rate != -1) {
+        return 0;
+    }
+
+    music->computed_src_rate = music->info.samplerate * music->speed;
+    if (music->computed_src_rate < 1000) {
+        music->computed_src_rate = 1000;
+    }
+
+    return QOA_UpdateStream(music);
+}
+
 static SDL_bool _XQOA_ReadMetaTag(QOA_Music *music, const char *tag_name, Mix_MusicMetaTag tag_type)
 {
     Uint8 read_buf[4];
@@ -232,7 +247,6 @@ void *QOA_CreateFromRWex(SDL_RWops *src, int freesrc, const char *args)
     Uint8 read_buf[4];
     Uint32 xqoa_head_size;
     Uint32 xqoa_data_size;
-    Uint8 in_channels;
     QOAVorbis_Setup setup = qoa_setup;
 
     music = (QOA_Music *)SDL_calloc(1, sizeof(*music));
@@ -418,15 +432,7 @@ void *QOA_CreateFromRWex(SDL_RWops *src, int freesrc, const char *args)
         }
     }
 
-    if (music->multitrack) {
-        in_channels = (Uint8)music->multitrack_channels;
-    } else {
-        in_channels = (Uint8)music->info.channels;
-    }
-
-    music->stream = SDL_NewAudioStream(AUDIO_S16SYS, in_channels, music->computed_src_rate,
-                                       music_spec.format, music_spec.channels, music_spec.freq);
-    if (!music->stream) {
+    if (QOA_UpdateStream(music) < 0) {
         Mix_SetError("QOA: Can't initialize stream.");
         QOA_CleanUp(src, music);
         return NULL;
@@ -477,7 +483,9 @@ static int QOA_Play(void *context, int play_count)
 static void QOA_Stop(void *context)
 {
     QOA_Music *music = (QOA_Music *)context;
-    SDL_AudioStreamClear(music->stream);
+    if (music->stream) {
+        SDL_AudioStreamClear(music->stream);
+    }
 }
 
 static unsigned int _QOA_DecodeFrame(QOA_Music *music)
@@ -589,16 +597,19 @@ static int QOA_GetSome(void *context, void *data, int bytes, SDL_bool *done)
 {
     QOA_Music *music = (QOA_Music *)context;
     SDL_bool looped = SDL_FALSE, retry_get = SDL_FALSE;
-    int filled, amount, channels, result, amount_samples, div_chans, i;
+    int filled, amount, channels, result, amount_samples, div_chans, i, max_samples;
     int frame_size = (sizeof(Sint16) * music->num_channels);
     Uint32 pcmPos, j, k;
     Sint16 buf_mid[8];
-    Sint16 *buf_in, *buf_out;
+    Sint16 *buf_in, *buf_out, *pcm;
+    float *out_f32;
 
 try_get:
-    filled = SDL_AudioStreamGet(music->stream, data, bytes);
-    if (filled != 0) {
-        return filled;
+    if (music->stream) {
+        filled = SDL_AudioStreamGet(music->stream, data, bytes);
+        if (filled != 0) {
+            return filled;
+        }
     }
 
     if (!music->play_count) {
@@ -615,7 +626,19 @@ try_get:
         retry_get = SDL_TRUE;
     }
 
-    amount = _QOA_ReadSamples(music, (Sint16*)music->buffer, music->buffer_size / frame_size);
+    max_samples = music->buffer_size / frame_size;
+    pcm = (Sint16*)music->buffer;
+    if (!music->stream) {
+        i = bytes / ((SDL_AUDIO_BITSIZE(music_spec.format) / 8) * music_spec.channels);
+        if (i < max_samples) {
+            max_samples = i;
+        }
+        if (music_spec.format == AUDIO_S16SYS && !music->multitrack) {
+            pcm = (Sint16*)data;
+        }
+    }
+
+    amount = _QOA_ReadSamples(music, pcm, max_samples);
     amount *= frame_size;
 
     channels = music->info.channels;
@@ -669,14 +692,28 @@ try_get:
         looped = SDL_TRUE;
     }
 
-    if (amount > 0) {
+    if (amount > 0 && !music->stream) {
+        if (music_spec.format == AUDIO_F32SYS) {
+            out_f32 = (float *)data;
+            for (i = 0; i < amount / (int)sizeof(Sint16); ++i) {
+                out_f32[i] = (float)pcm[i] * (1.0f / 32768.0f);
+            }
+            return amount * 2;
+        }
+        if (pcm != data) {
+            SDL_memcpy(data, pcm, (size_t)amount);
+        }
+        return amount;
+    } else if (amount > 0) {
         if (SDL_AudioStreamPut(music->stream, music->buffer, amount) < 0) {
             return -1;
         }
     } else if (!looped) {
         if (music->play_count == 1) {
             music->play_count = 0;
-            SDL_AudioStreamFlush(music->stream);
+            if (music->stream) {
+                SDL_AudioStreamFlush(music->stream);
+            }
         } else {
             int play_count = -1;
             if (music->play_count > 0) {
@@ -800,6 +837,10 @@ static void QOA_CleanUp(SDL_RWops *src, QOA_Music *music)
 {
     meta_tags_clear(&music->tags);
 
+    if (music->stream) {
+        SDL_FreeAudioStream(music->stream);
+    }
+
     if (music->buffer) {
         SDL_free(music->buffer);
     }
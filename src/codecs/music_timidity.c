@@ -104,11 +104,59 @@ static void TIMIDITY_Close(void)
     }
 }
 
-void *TIMIDITY_CreateFromRW(SDL_RWops *src, int freesrc)
+/* Get the interpolation mode from the "i" music argument, -1 if not set */
+static int process_args(const char *args)
+{
+#define ARG_BUFFER_SIZE    1024
+    char arg[ARG_BUFFER_SIZE];
+    char type = '-';
+    size_t maxlen, i, j = 0;
+    int value_opened = 0;
+    int interpolation = -1;
+
+    if (args == NULL) {
+        return -1;
+    }
+
+    maxlen = SDL_strlen(args) + 1;
+
+    for (i = 0; i < maxlen; i++) {
+        char c = args[i];
+        if (value_opened == 1) {
+            if ((c == ';') || (c == '\0')) {
+                arg[j] = '\0';
+                switch(type)
+                {
+                case 'i':
+                    interpolation = SDL_atoi(arg);
+                    break;
+                default:
+                    break;
+                }
+                value_opened = 0;
+            } else if (j < ARG_BUFFER_SIZE - 1) {
+                arg[j++] = c;
+            }
+        } else {
+            if (c == '\0') {
+                break;
+            }
+            type = c;
+            value_opened = 1;
+            j = 0;
+        }
+    }
+
+    return interpolation;
+#undef ARG_BUFFER_SIZE
+}
+
+static void *TIMIDITY_CreateFromRWex(SDL_RWops *src, int freesrc, const char *args)
 {
     TIMIDITY_Music *music;
     SDL_AudioSpec spec;
     SDL_bool need_stream = SDL_FALSE;
+    int interpolation;
 
     if (TIMIDITY_Open(NULL) < 0) {
         Mix_SetError("Timidity: Can't initialize library");
@@ -134,6 +182,11 @@ void *TIMIDITY_CreateFromRW(SDL_RWops *src, int freesrc)
         return NULL;
     }
 
+    interpolation = process_args(args);
+    if (interpolation >= 0) {
+        Timidity_SetInterpolation(music->song, interpolation);
+    }
+
     if (need_stream) {
         music->stream = SDL_NewAudioStream(spec.format, spec.channels, spec.freq,
                                            music_spec.format, music_spec.channels, music_spec.freq);
@@ -157,6 +210,11 @@ void *TIMIDITY_CreateFromRW(SDL_RWops *src, int freesrc)
     return music;
 }
 
+void *TIMIDITY_CreateFromRW(SDL_RWops *src, int freesrc)
+{
+    return TIMIDITY_CreateFromRWex(src, freesrc, NULL);
+}
+
 static void TIMIDITY_SetVolume(void *context, int volume)
 {
     TIMIDITY_Music *music = (TIMIDITY_Music *)context;
@@ -294,7 +352,7 @@ Mix_MusicInterface Mix_MusicInterface_TIMIDITY =
     NULL,   /* Load */
     NULL,   /* Open */
     TIMIDITY_CreateFromRW,
-    NULL,   /* CreateFromRWex [MIXER-X]*/
+    TIMIDITY_CreateFromRWex,   /* CreateFromRWex [MIXER-X]*/
     NULL,   /* CreateFromFile */
     NULL,   /* CreateFromFileEx [MIXER-X]*/
     TIMIDITY_SetVolume,
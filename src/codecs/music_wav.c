@@ -97,7 +97,7 @@ typedef struct {
     WAVLoopPoint *loops;
     Mix_MusicMetaTags tags;
     Uint16 encoding;
-    int (*decode)(void *music, int length);
+    int (*decode)(void *music, Uint8 *dst, int length);
     /* For player indication */
     double loop_start_time;
     double loop_end_time;
@@ -230,7 +230,7 @@ static SDL_bool LoadAIFFMusic(WAV_Music *wave);
 
 static void WAV_Delete(void *context);
 
-static int fetch_pcm(void *context, int length);
+static int fetch_pcm(void *context, Uint8 *dst, int length);
 
 /* Load a WAV stream from the given RWops object */
 static void *WAV_CreateFromRW(SDL_RWops *src, int freesrc)
@@ -277,12 +277,17 @@ static void *WAV_CreateFromRW(SDL_RWops *src, int freesrc)
         WAV_Delete(music);
         return NULL;
     }
-    music->stream = SDL_NewAudioStream(
-        music->spec.format, music->spec.channels, music->spec.freq,
-        music_spec.format, music_spec.channels, music_spec.freq);
-    if (!music->stream) {
-        WAV_Delete(music);
-        return NULL;
+    /* Without a conversion, samples are decoded right into the output, unless
+     * the source frames are larger than the decoded ones (they're read in place) */
+    if (!music_pcm_is_native(music->spec.format, music->spec.channels, music->spec.freq) ||
+        music->samplesize > (int)(SDL_AUDIO_BITSIZE(music->spec.format) / 8) * music->spec.channels) {
+        music->stream = SDL_NewAudioStream(
+            music->spec.format, music->spec.channels, music->spec.freq,
+            music_spec.format, music_spec.channels, music_spec.freq);
+        if (!music->stream) {
+            WAV_Delete(music);
+            return NULL;
+        }
     }
 
     music->freesrc = freesrc;
@@ -321,13 +326,15 @@ static int WAV_Play(void *context, int play_count)
 static void WAV_Stop(void *context)
 {
     WAV_Music *music = (WAV_Music *)context;
-    SDL_AudioStreamClear(music->stream);
+    if (music->stream) {
+        SDL_AudioStreamClear(music->stream);
+    }
 }
 
-static int fetch_pcm(void *context, int length)
+static int fetch_pcm(void *context, Uint8 *dst, int length)
 {
     WAV_Music *music = (WAV_Music *)context;
-    return (int)SDL_RWread(music->src, music->buffer, 1, (size_t)length);
+    return (int)SDL_RWread(music->src, dst, 1, (size_t)length);
 }
 
 static Uint32 PCM_S24_to_S32_BE(Uint8 *x) {
@@ -348,38 +355,38 @@ static Uint32 PCM_S24_to_S32_LE(Uint8 *x) {
     return (in ^ m) - m;
 }
 
-static int fetch_pcm24be(void *context, int length)
+static int fetch_pcm24be(void *context, Uint8 *dst, int length)
 {
     WAV_Music *music = (WAV_Music *)context;
     int i = 0, o = 0;
-    length = (int)SDL_RWread(music->src, music->buffer, 1, (size_t)((length / 4) * 3));
+    length = (int)SDL_RWread(music->src, dst, 1, (size_t)((length / 4) * 3));
     if (length % music->samplesize != 0) {
         length -= length % music->samplesize;
     }
     for (i = length - 3, o = ((length - 3) / 3) * 4; i >= 0; i -= 3, o -= 4) {
-        Uint32 decoded = PCM_S24_to_S32_BE(music->buffer + i);
-        music->buffer[o + 0] = (decoded >> 0) & 0xFF;
-        music->buffer[o + 1] = (decoded >> 8) & 0xFF;
-        music->buffer[o + 2] = (decoded >> 16) & 0xFF;
-        music->buffer[o + 3] = (decoded >> 24) & 0xFF;
+        Uint32 decoded = PCM_S24_to_S32_BE(dst + i);
+        dst[o + 0] = (decoded >> 0) & 0xFF;
+        dst[o + 1] = (decoded >> 8) & 0xFF;
+        dst[o + 2] = (decoded >> 16) & 0xFF;
+        dst[o + 3] = (decoded >> 24) & 0xFF;
     }
     return (length / 3) * 4;
 }
 
-static int fetch_pcm24le(void *context, int length)
+static int fetch_pcm24le(void *context, Uint8 *dst, int length)
 {
     WAV_Music *music = (WAV_Music *)context;
     int i = 0, o = 0;
-    length = (int)SDL_RWread(music->src, music->buffer, 1, (size_t)((length / 4) * 3));
+    length = (int)SDL_RWread(music->src, dst, 1, (size_t)((length / 4) * 3));
     if (length % music->samplesize != 0) {
         length -= length % music->samplesize;
     }
     for (i = length - 3, o = ((length - 3) / 3) * 4; i >= 0; i -= 3, o -= 4) {
-        Uint32 decoded = PCM_S24_to_S32_LE(music->buffer + i);
-        music->buffer[o + 3] = (decoded >> 0) & 0xFF;
-        music->buffer[o + 2] = (decoded >> 8) & 0xFF;
-        music->buffer[o + 1] = (decoded >> 16) & 0xFF;
-        music->buffer[o + 0] = (decoded >> 24) & 0xFF;
+        Uint32 decoded = PCM_S24_to_S32_LE(dst + i);
+        dst[o + 3] = (decoded >> 0) & 0xFF;
+        dst[o + 2] = (decoded >> 8) & 0xFF;
+        dst[o + 1] = (decoded >> 16) & 0xFF;
+        dst[o + 0] = (decoded >> 24) & 0xFF;
     }
     return (length / 3) * 4;
 }
@@ -405,11 +412,11 @@ Mix_SwapDouble(double x)
 #define Mix_SwapDoubleBE(X)  (X)
 #endif
 
-static int fetch_float64be(void *context, int length)
+static int fetch_float64be(void *context, Uint8 *dst, int length)
 {
     WAV_Music *music = (WAV_Music *)context;
     int i = 0, o = 0;
-    length = (int)SDL_RWread(music->src, music->buffer, 1, (size_t)(length));
+    length = (int)SDL_RWread(music->src, dst, 1, (size_t)(length));
     if (length % music->samplesize != 0) {
         length -= length % music->samplesize;
     }
@@ -419,20 +426,20 @@ static int fetch_float64be(void *context, int length)
             float f;
             Uint32 ui32;
         } sample;
-        sample.f = (float)Mix_SwapDoubleBE(*(double*)(music->buffer + i));
-        music->buffer[o + 0] = (sample.ui32 >> 0) & 0xFF;
-        music->buffer[o + 1] = (sample.ui32 >> 8) & 0xFF;
-        music->buffer[o + 2] = (sample.ui32 >> 16) & 0xFF;
-        music->buffer[o + 3] = (sample.ui32 >> 24) & 0xFF;
+        sample.f = (float)Mix_SwapDoubleBE(*(double*)(dst + i));
+        dst[o + 0] = (sample.ui32 >> 0) & 0xFF;
+        dst[o + 1] = (sample.ui32 >> 8) & 0xFF;
+        dst[o + 2] = (sample.ui32 >> 16) & 0xFF;
+        dst[o + 3] = (sample.ui32 >> 24) & 0xFF;
     }
     return length / 2;
 }
 
-static int fetch_float64le(void *context, int length)
+static int fetch_float64le(void *context, Uint8 *dst, int length)
 {
     WAV_Music *music = (WAV_Music *)context;
     int i = 0, o = 0;
-    length = (int)SDL_RWread(music->src, music->buffer, 1, (size_t)(length));
+    length = (int)SDL_RWread(music->src, dst, 1, (size_t)(length));
     if (length % music->samplesize != 0) {
         length -= length % music->samplesize;
     }
@@ -442,11 +449,11 @@ static int fetch_float64le(void *context, int length)
             float f;
             Uint32 ui32;
         } sample;
-        sample.f = (float)Mix_SwapDoubleLE(*(double*)(music->buffer + i));
-        music->buffer[o + 0] = (sample.ui32 >> 0) & 0xFF;
-        music->buffer[o + 1] = (sample.ui32 >> 8) & 0xFF;
-        music->buffer[o + 2] = (sample.ui32 >> 16) & 0xFF;
-        music->buffer[o + 3] = (sample.ui32 >> 24) & 0xFF;
+        sample.f = (float)Mix_SwapDoubleLE(*(double*)(dst + i));
+        dst[o + 0] = (sample.ui32 >> 0) & 0xFF;
+        dst[o + 1] = (sample.ui32 >> 8) & 0xFF;
+        dst[o + 2] = (sample.ui32 >> 16) & 0xFF;
+        dst[o + 3] = (sample.ui32 >> 24) & 0xFF;
     }
     return length / 2;
 }
@@ -1010,12 +1017,11 @@ static void ADPCM_Cleanup(ADPCM_DecoderState *state)
     }
 }
 
-static int fetch_adpcm(void *context, int length, int (*DecodeBlockHeader)(ADPCM_DecoderState *state), int (*DecodeBlockData)(ADPCM_DecoderState *state))
+static int fetch_adpcm(void *context, Uint8 *dst, int length, int (*DecodeBlockHeader)(ADPCM_DecoderState *state), int (*DecodeBlockData)(ADPCM_DecoderState *state))
 {
     WAV_Music *music = (WAV_Music *)context;
     ADPCM_DecoderState *state = &music->adpcm_state;
     size_t len, left = (size_t)length;
-    Uint8 *dst = music->buffer;
 
     while (left > 0) {
         if (state->output.read == state->output.pos) {
@@ -1048,14 +1054,14 @@ static int fetch_adpcm(void *context, int length, int (*DecodeBlockHeader)(ADPCM
     return length;
 }
 
-static int fetch_ms_adpcm(void *context, int length)
+static int fetch_ms_adpcm(void *context, Uint8 *dst, int length)
 {
-    return fetch_adpcm(context, length, MS_ADPCM_DecodeBlockHeader, MS_ADPCM_DecodeBlockData);
+    return fetch_adpcm(context, dst, length, MS_ADPCM_DecodeBlockHeader, MS_ADPCM_DecodeBlockData);
 }
 
-static int fetch_ima_adpcm(void *context, int length)
+static int fetch_ima_adpcm(void *context, Uint8 *dst, int length)
 {
-    return fetch_adpcm(context, length, IMA_ADPCM_DecodeBlockHeader, IMA_ADPCM_DecodeBlockData);
+    return fetch_adpcm(context, dst, length, IMA_ADPCM_DecodeBlockHeader, IMA_ADPCM_DecodeBlockData);
 }
 
 /*
@@ -1139,30 +1145,30 @@ static Sint16 ALAW_To_PCM16(Uint8 a_val)
 #endif
 }
 
-static int fetch_xlaw(Sint16 (*decode_sample)(Uint8), void *context, int length)
+static int fetch_xlaw(Sint16 (*decode_sample)(Uint8), void *context, Uint8 *dst, int length)
 {
     WAV_Music *music = (WAV_Music *)context;
     int i = 0, o = 0;
-    length = (int)SDL_RWread(music->src, music->buffer, 1, (size_t)(length / 2));
+    length = (int)SDL_RWread(music->src, dst, 1, (size_t)(length / 2));
     if (length % music->samplesize != 0) {
         length -= length % music->samplesize;
     }
     for (i = length - 1, o = (length - 1) * 2; i >= 0; i--, o -= 2) {
-        Uint16 decoded = (Uint16)decode_sample(music->buffer[i]);
-        music->buffer[o] = decoded & 0xFF;
-        music->buffer[o + 1] = (decoded >> 8) & 0xFF;
+        Uint16 decoded = (Uint16)decode_sample(dst[i]);
+        dst[o] = decoded & 0xFF;
+        dst[o + 1] = (decoded >> 8) & 0xFF;
     }
     return length * 2;
 }
 
-static int fetch_ulaw(void *context, int length)
+static int fetch_ulaw(void *context, Uint8 *dst, int length)
 {
-    return fetch_xlaw(uLAW_To_PCM16, context, length);
+    return fetch_xlaw(uLAW_To_PCM16, context, dst, length);
 }
 
-static int fetch_alaw(void *context, int length)
+static int fetch_alaw(void *context, Uint8 *dst, int length)
 {
-    return fetch_xlaw(ALAW_To_PCM16, context, length);
+    return fetch_xlaw(ALAW_To_PCM16, context, dst, length);
 }
 
 static Sint64 WAV_Position(WAV_Music *music)
@@ -1183,9 +1189,11 @@ static int WAV_GetSome(void *context, void *data, int bytes, SDL_bool *done)
     unsigned int i;
     int filled, amount, result;
 
-    filled = SDL_AudioStreamGet(music->stream, data, bytes);
-    if (filled != 0) {
-        return filled;
+    if (music->stream) {
+        filled = SDL_AudioStreamGet(music->stream, data, bytes);
+        if (filled != 0) {
+            return filled;
+        }
     }
 
     if (!music->play_count) {
@@ -1216,13 +1224,23 @@ static int WAV_GetSome(void *context, void *data, int bytes, SDL_bool *done)
         amount = (int)(stop - pos);
     }
 
-    amount = music->decode(music, amount);
-    if (amount > 0) {
-        result = SDL_AudioStreamPut(music->stream, music->buffer, amount);
-        if (result < 0) {
-            return -1;
+    filled = 0;
+    if (!music->stream) {
+        /* Decode right into the output */
+        if (amount > bytes) {
+            amount = bytes;
         }
+        amount = filled = music->decode(music, (Uint8 *)data, amount);
     } else {
+        amount = music->decode(music, music->buffer, amount);
+        if (amount > 0) {
+            result = SDL_AudioStreamPut(music->stream, music->buffer, amount);
+            if (result < 0) {
+                return -1;
+            }
+        }
+    }
+    if (amount <= 0) {
         /* We might be looping, continue */
         at_end = SDL_TRUE;
     }
@@ -1243,7 +1261,9 @@ static int WAV_GetSome(void *context, void *data, int bytes, SDL_bool *done)
     if (!looped && (at_end || WAV_Position(music) >= music->stop)) {
         if (music->play_count == 1) {
             music->play_count = 0;
-            SDL_AudioStreamFlush(music->stream);
+            if (music->stream) {
+                SDL_AudioStreamFlush(music->stream);
+            }
         } else {
             int play_count = -1;
             if (music->play_count > 0) {
@@ -1256,7 +1276,7 @@ static int WAV_GetSome(void *context, void *data, int bytes, SDL_bool *done)
     }
 
     /* We'll get called again in the case where we looped or have more data */
-    return 0;
+    return filled > 0 ? filled : 0;
 }
 
 static int WAV_GetAudio(void *context, void *data, int bytes)
@@ -1284,7 +1304,7 @@ static int WAV_Seek(void *context, double position)
         music->buffered = 0;
         music->adpcm_state.output.read = music->adpcm_state.output.pos;
         if (remainder > 0) {
-            music->decode(music, remainder);
+            music->decode(music, music->buffer, remainder);
         }
     } else {
         Sint64 sample_size = music->spec.freq * music->samplesize;
@@ -24,6 +24,7 @@
 #include "SDL_loadso.h"
 
 #include "music_xmp.h"
+#include "mix_mmap.h"
 
 #ifdef LIBXMP_HEADER
 #include LIBXMP_HEADER
@@ -242,12 +243,13 @@ void *XMP_CreateFromRW(SDL_RWops *src, int freesrc)
     {
 #endif
         size_t size;
-        void *mem = SDL_LoadFile_RW(src, &size, SDL_FALSE);
-        if (!mem) {
+        void *mem;
+        const void *data = _Mix_LoadDataRW(src, &size, &mem);
+        if (!data) {
             SDL_OutOfMemory();
             goto e1;
         }
-        err = libxmp.xmp_load_module_from_memory(music->ctx, mem, (long)size);
+        err = libxmp.xmp_load_module_from_memory(music->ctx, (void *)data, (long)size);
         SDL_free(mem);
     }
 
@@ -265,10 +267,12 @@ void *XMP_CreateFromRW(SDL_RWops *src, int freesrc)
     music->volume = MIX_MAX_VOLUME;
     music->tempo = 1.0;
 
-    music->stream = SDL_NewAudioStream(AUDIO_S16SYS, 2, music_spec.freq,
-                                       music_spec.format, music_spec.channels, music_spec.freq);
-    if (!music->stream) {
-        goto e3;
+    if (!music_pcm_is_native(AUDIO_S16SYS, 2, music_spec.freq)) {
+        music->stream = SDL_NewAudioStream(AUDIO_S16SYS, 2, music_spec.freq,
+                                           music_spec.format, music_spec.channels, music_spec.freq);
+        if (!music->stream) {
+            goto e3;
+        }
     }
 
     meta_tags_init(&music->tags);
@@ -320,7 +324,9 @@ static int XMP_Play(void *context, int play_count)
 static void XMP_Stop(void *context)
 {
     XMP_Music *music = (XMP_Music *)context;
-    SDL_AudioStreamClear(music->stream);
+    if (music->stream) {
+        SDL_AudioStreamClear(music->stream);
+    }
 }
 
 /* Play some of a stream previously started with xmp_play() */
@@ -328,10 +334,13 @@ static int XMP_GetSome(void *context, void *data, int bytes, SDL_bool *done)
 {
     XMP_Music *music = (XMP_Music *)context;
     int filled, amount, ret;
+    void *buffer = music->buffer;
 
-    filled = SDL_AudioStreamGet(music->stream, data, bytes);
-    if (filled != 0) {
-        return filled;
+    if (music->stream) {
+        filled = SDL_AudioStreamGet(music->stream, data, bytes);
+        if (filled != 0) {
+            return filled;
+        }
     }
 
     if (!music->play_count) {
@@ -344,11 +353,21 @@ static int XMP_GetSome(void *context, void *data, int bytes, SDL_bool *done)
      * the loop param is the max number that the current sequence of song
      * will be looped, or 0 to disable loop checking:  0 for play_count < 0
      * for an endless loop, or 1 for our own loop checks to do their job. */
-    ret = libxmp.xmp_play_buffer(music->ctx, music->buffer, music->buffer_size, (music->play_count > 0));
     amount = music->buffer_size;
+    if (!music->stream) {
+        /* Render right into the output */
+        buffer = data;
+        if (amount > bytes) {
+            amount = bytes;
+        }
+    }
+    ret = libxmp.xmp_play_buffer(music->ctx, buffer, amount, (music->play_count > 0));
 
     if (ret == 0) {
-        if (SDL_AudioStreamPut(music->stream, music->buffer, amount) < 0) {
+        if (!music->stream) {
+            return amount;
+        }
+        if (SDL_AudioStreamPut(music->stream, buffer, amount) < 0) {
             return -1;
         }
     } else {
@@ -357,7 +376,9 @@ static int XMP_GetSome(void *context, void *data, int bytes, SDL_bool *done)
         }
         if (music->play_count == 1) {
             music->play_count = 0;
-            SDL_AudioStreamFlush(music->stream);
+            if (music->stream) {
+                SDL_AudioStreamFlush(music->stream);
+            }
         } else {
             int play_count = -1;
             if (music->play_count > 0) {
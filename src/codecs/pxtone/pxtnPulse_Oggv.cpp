@@ -432,6 +432,12 @@ int32_t  pxtnPulse_Oggv::GetSize() const
 	return sizeof(int32_t)*4 + _size;
 }
 
+const void* pxtnPulse_Oggv::GetData( int32_t *p_size ) const
+{
+	if( p_size ) *p_size = _p_data ? _size : 0;
+	return _p_data;
+}
+
 
 
 bool pxtnPulse_Oggv::ogg_write( void* desc ) const
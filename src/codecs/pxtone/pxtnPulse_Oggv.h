@@ -30,6 +30,7 @@ public :
 	void    Release();
 	bool    GetInfo( int32_t *p_ch, int32_t *p_sps, int32_t *p_smp_num );
 	int32_t GetSize() const;
+	const void* GetData( int32_t *p_size ) const;
 
 	bool    ogg_write ( void* desc ) const;
 	pxtnERR ogg_read  ( void* desc );
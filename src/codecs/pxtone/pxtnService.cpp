@@ -108,6 +108,8 @@ pxtnService::pxtnService( pxtnIO_r io_read, pxtnIO_w io_write, pxtnIO_seek io_se
 	_sampled_proc = NULL;
 	_sampled_user = NULL;
 
+	memset( &_voice_cache, 0, sizeof(_voice_cache) );
+
 	_moo_constructor();
 }
 
@@ -226,7 +228,7 @@ pxtnERR pxtnService::tones_ready()
 	}
 	for( int32_t i = 0; i < _woice_num; i++ )
 	{
-		res = _woices[ i ]->Tone_Ready( _ptn_bldr, _dst_sps );
+		res = _woices[ i ]->Tone_Ready( _ptn_bldr, _dst_sps, &_voice_cache );
 		if( res != pxtnOK ) return res;
 	}
 	return pxtnOK;
@@ -380,7 +382,7 @@ pxtnERR pxtnService::Woice_ReadyTone( int32_t idx )
 {
 	if( !_b_init ) return pxtnERR_INIT;
 	if( idx < 0 || idx >= _woice_num ) return pxtnERR_param;
-	return _woices[ idx ]->Tone_Ready( _ptn_bldr, _dst_sps );
+	return _woices[ idx ]->Tone_Ready( _ptn_bldr, _dst_sps, &_voice_cache );
 }
 
 bool pxtnService::Woice_Remove( int32_t idx )
@@ -537,6 +539,15 @@ bool pxtnService::set_sampled_callback   ( pxtnSampledCallback proc, void* user
 	return true;
 }
 
+bool pxtnService::set_voice_cache        ( pxtnVoiceCacheLoad load, pxtnVoiceCacheSave save, void* user )
+{
+	if( !_b_init ) return false;
+	_voice_cache.load = load;
+	_voice_cache.save = save;
+	_voice_cache.user = user;
+	return true;
+}
+
 
 static _enum_Tag _CheckTagCode( const char *p_code )
 {
@@ -16,6 +16,8 @@
 
 #define PXTONEERRORSIZE 64
 
+#define pxtnBUFSIZE_MOOBLOCK 256 // samples rendered between events at once
+
 #define pxtnVOMITPREPFLAG_loop      0x01
 #define pxtnVOMITPREPFLAG_unit_mute 0x02
 
@@ -126,7 +128,7 @@ private:
 	int32_t  _moo_bt_clock    ;
 	int32_t  _moo_bt_num      ;
 
-	int32_t* _moo_group_smps  ;
+	int32_t* _moo_group_smps  ; // [ sample ][ channel ][ group ] of the block
 
 	const EVERECORD*     _moo_p_eve;
 
@@ -144,11 +146,14 @@ private:
 
 	bool _moo_ResetVoiceOn ( pxtnUnit *p_u, int32_t w ) const;
 	bool _moo_InitUnitTone ();
-	bool _moo_PXTONE_SAMPLE( void *p_data );
+	void _moo_PXTONE_EVENTS( int32_t clock );
+	bool _moo_PXTONE_BLOCK ( int16_t *p_data, int32_t smp_num, int32_t *p_smp_w );
 
 	pxtnSampledCallback _sampled_proc;
 	void*               _sampled_user;
 
+	pxtnVOICECACHE      _voice_cache ;
+
 public :
 
 	 pxtnService( pxtnIO_r io_read, pxtnIO_w io_write, pxtnIO_seek io_seek, pxtnIO_pos io_pos );
@@ -219,6 +224,7 @@ public :
 	bool set_destination_quality( int32_t    ch_num, int32_t    sps );
 	bool get_destination_quality( int32_t *p_ch_num, int32_t *p_sps ) const;
 	bool set_sampled_callback   ( pxtnSampledCallback proc, void* user );
+	bool set_voice_cache        ( pxtnVoiceCacheLoad load, pxtnVoiceCacheSave save, void* user );
 
 	//////////////
 	// Moo..
@@ -47,7 +47,7 @@ bool pxtnService::_moo_init()
 	bool b_ret = false;
 
 	if( !(_moo_freq = new pxtnPulse_Frequency( _io_read, _io_write, _io_seek, _io_pos ) ) ||  !_moo_freq->Init() ) goto term;
-	if( !pxtnMem_zero_alloc( (void **)&_moo_group_smps, sizeof(int32_t) * _group_num ) ) goto term;
+	if( !pxtnMem_zero_alloc( (void **)&_moo_group_smps, sizeof(int32_t) * pxtnMAX_CHANNEL * _group_num * pxtnBUFSIZE_MOOBLOCK ) ) goto term;
 
 	_moo_b_init = true;
 	b_ret       = true;
@@ -107,15 +107,8 @@ bool pxtnService::_moo_InitUnitTone()
 }
 
 
-bool pxtnService::_moo_PXTONE_SAMPLE( void *p_data )
+void pxtnService::_moo_PXTONE_EVENTS( int32_t clock )
 {
-	if( !_moo_b_init ) return false;
-
-	// envelope..
-	for( int32_t u = 0; u < _unit_num;  u++ ) _units[ u ]->Tone_Envelope();
-
-	int32_t  clock = (int32_t)( _moo_smp_count / _moo_clock_rate );
-
 	// events..
 	for( ; _moo_p_eve && _moo_p_eve->clock <= clock; _moo_p_eve = _moo_p_eve->next )
 	{
@@ -191,69 +184,95 @@ bool pxtnService::_moo_PXTONE_SAMPLE( void *p_data )
 		case EVENTKIND_TUNING    : p_u->Tone_Tuning    ( pxtnData::cast_to_float(_moo_p_eve->value) ); break;
 		}
 	}
+}
+
+// Renders up to smp_num samples, stopping before the clock of the next event.
+// Returns false when the song is over, *p_smp_w gets the count of samples written.
+bool pxtnService::_moo_PXTONE_BLOCK( int16_t *p_data, int32_t smp_num, int32_t *p_smp_w )
+{
+	*p_smp_w = 0;
+	if( !_moo_b_init ) return false;
+
+	if( smp_num > pxtnBUFSIZE_MOOBLOCK ) smp_num = pxtnBUFSIZE_MOOBLOCK;
+
+	// envelope..
+	for( int32_t u = 0; u < _unit_num;  u++ ) _units[ u ]->Tone_Envelope();
+
+	// events..
+	_moo_PXTONE_EVENTS( (int32_t)( _moo_smp_count / _moo_clock_rate ) );
+
+	// the block ends before the next event, at the end of the song, or at the end of the fade out
+	int32_t blk_num = 1;
+	for( ; blk_num < smp_num; blk_num++ )
+	{
+		int32_t smp = _moo_smp_count + blk_num;
+		if( smp >= _moo_smp_end ) break;
+		if( _moo_fade_fade < 0 && blk_num > _moo_fade_count ) break;
+		if( _moo_p_eve && _moo_p_eve->clock <= (int32_t)( smp / _moo_clock_rate ) ) break;
+	}
 
 	// sampling..
+	memset( _moo_group_smps, 0, sizeof(int32_t) * pxtnMAX_CHANNEL * _group_num * blk_num );
 	for( int32_t u = 0; u < _unit_num; u++ )
 	{
-		_units[ u ]->Tone_Sample( _moo_b_mute_by_unit, _dst_ch_num, _moo_time_pan_index, _moo_smp_smooth );
+		_units[ u ]->Tone_Render( _moo_group_smps, _group_num, blk_num, _moo_b_mute_by_unit, _dst_ch_num,
+								  _moo_time_pan_index, _moo_smp_smooth, _moo_freq, _moo_smp_stride );
 	}
 
-	for( int32_t ch = 0; ch < _dst_ch_num; ch++ )
+	for( int32_t i = 0; i < blk_num; i++ )
 	{
-		for( int32_t g = 0; g < _group_num; g++ ) _moo_group_smps[ g ] = 0;
-		for( int32_t u = 0; u < _unit_num ; u++ ) _units [ u ]->Tone_Supple(     _moo_group_smps, ch, _moo_time_pan_index );
-		for( int32_t o = 0; o < _ovdrv_num; o++ ) _ovdrvs[ o ]->Tone_Supple(     _moo_group_smps );
-		for( int32_t d = 0; d < _delay_num; d++ ) _delays[ d ]->Tone_Supple( ch, _moo_group_smps );
-
-		// collect.
-		int32_t  work = 0;
-		for( int32_t g = 0; g < _group_num; g++ ) work += _moo_group_smps[ g ];
+		for( int32_t ch = 0; ch < _dst_ch_num; ch++ )
+		{
+			int32_t *group_smps = &_moo_group_smps[ ( i * pxtnMAX_CHANNEL + ch ) * _group_num ];
+			for( int32_t o = 0; o < _ovdrv_num; o++ ) _ovdrvs[ o ]->Tone_Supple(     group_smps );
+			for( int32_t d = 0; d < _delay_num; d++ ) _delays[ d ]->Tone_Supple( ch, group_smps );
 
-		// fade..
-		if( _moo_fade_fade ) work = work * ( _moo_fade_count >> 8 ) / _moo_fade_max;
+			// collect.
+			int32_t  work = 0;
+			for( int32_t g = 0; g < _group_num; g++ ) work += group_smps[ g ];
 
-		// master volume
-		work = (int32_t)( work * _moo_master_vol );
+			// fade..
+			if( _moo_fade_fade ) work = work * ( _moo_fade_count >> 8 ) / _moo_fade_max;
 
-		// to buffer..
-		if( work >  _moo_top ) work =  _moo_top;
-		if( work < -_moo_top ) work = -_moo_top;
-		*( (int16_t*)p_data + ch ) = (int16_t)( work );
-	}
+			// master volume
+			work = (int32_t)( work * _moo_master_vol );
 
-	// --------------
-	// increments..
+			// to buffer..
+			if( work >  _moo_top ) work =  _moo_top;
+			if( work < -_moo_top ) work = -_moo_top;
+			p_data[ i * _dst_ch_num + ch ] = (int16_t)( work );
+		}
 
-	_moo_smp_count++;
-	_moo_time_pan_index = ( _moo_time_pan_index + 1 ) & ( pxtnBUFSIZE_TIMEPAN - 1 );
+		// --------------
+		// increments..
 
-	for( int32_t u = 0; u < _unit_num;  u++ )
-	{
-		int32_t  key_now = _units[ u ]->Tone_Increment_Key();
-		_units[ u ]->Tone_Increment_Sample( _moo_freq->Get2( key_now ) *_moo_smp_stride );
-	}
+		_moo_smp_count++;
+		_moo_time_pan_index = ( _moo_time_pan_index + 1 ) & ( pxtnBUFSIZE_TIMEPAN - 1 );
 
-	// delay
-	for( int32_t d = 0; d < _delay_num; d++ ) _delays[ d ]->Tone_Increment();
+		// delay
+		for( int32_t d = 0; d < _delay_num; d++ ) _delays[ d ]->Tone_Increment();
 
-	// fade out
-	if( _moo_fade_fade < 0 )
-	{
-		if( _moo_fade_count > 0  ) _moo_fade_count--;
-		else return false;
-	}
-	// fade in
-	else if( _moo_fade_fade > 0 )
-	{
-		if( _moo_fade_count < (_moo_fade_max << 8) ) _moo_fade_count++;
-		else                                         _moo_fade_fade = 0;
+		// fade out
+		if( _moo_fade_fade < 0 )
+		{
+			if( _moo_fade_count > 0  ) _moo_fade_count--;
+			else { *p_smp_w = i; return false; }
+		}
+		// fade in
+		else if( _moo_fade_fade > 0 )
+		{
+			if( _moo_fade_count < (_moo_fade_max << 8) ) _moo_fade_count++;
+			else                                         _moo_fade_fade = 0;
+		}
 	}
 
+	*p_smp_w = blk_num;
+
 	if( _moo_smp_count >= _moo_smp_end )
 	{
 		if( _moo_loops_num > 0)       _moo_loops_num--;
 		else if( _moo_loops_num == 0) _moo_b_loop = false;
-		if( !_moo_b_loop ) return false;
+		if( !_moo_b_loop ){ *p_smp_w = blk_num - 1; return false; }
 		_moo_smp_count = _moo_smp_repeat;
 		_moo_p_eve     = evels->get_Records();
 		_moo_InitUnitTone();
@@ -481,14 +500,15 @@ bool pxtnService::Moo( void* p_buf, int32_t  size )
 
 	{
 		int16_t  *p16 = (int16_t*)p_buf;
-		int16_t  sample[ 2 ];
+		int32_t  blk_w;
 
-		for( smp_w = 0; smp_w < smp_num; smp_w++ )
+		while( smp_w < smp_num )
 		{
-			if( !_moo_PXTONE_SAMPLE( sample ) ){ _moo_b_end_vomit = true; break; }
-			for( int32_t ch = 0; ch < _dst_ch_num; ch++, p16++ ) *p16 = sample[ ch ];
+			bool b_play = _moo_PXTONE_BLOCK( p16 + smp_w * _dst_ch_num, smp_num - smp_w, &blk_w );
+			smp_w += blk_w;
+			if( !b_play ){ _moo_b_end_vomit = true; break; }
 		}
-		for( ;          smp_w < smp_num; smp_w++ )
+		for( p16 += smp_w * _dst_ch_num; smp_w < smp_num; smp_w++ )
 		{
 			for( int32_t ch = 0; ch < _dst_ch_num; ch++, p16++ ) *p16 = 0;
 		}
@@ -147,14 +147,25 @@ void pxtnUnit::Tone_Portament( int32_t val ){ _portament_sample_num = val; }
 void pxtnUnit::Tone_GroupNo  ( int32_t val ){ _v_GROUPNO            = val; }
 void pxtnUnit::Tone_Tuning   ( float   val ){ _v_TUNING             = val; }
 
-void pxtnUnit::Tone_Envelope()
+// voices of the woice, taken once for a block of samples.
+int32_t pxtnUnit::_get_voices( const pxtnVOICEINSTANCE **p_vis, uint32_t *p_flags ) const
 {
-	if( !_p_woice ) return;
+	int32_t voice_num = _p_woice->get_voice_num();
 
-	for( int32_t v = 0; v < _p_woice->get_voice_num(); v++ )
+	for( int32_t v = 0; v < voice_num; v++ )
 	{
-		const pxtnVOICEINSTANCE *p_vi = _p_woice->get_instance( v );
-		pxtnVOICETONE           *p_vt = &_vts                 [ v ];
+		p_vis  [ v ] = _p_woice->get_instance( v );
+		p_flags[ v ] = _p_woice->get_voice   ( v )->voice_flags;
+	}
+	return voice_num;
+}
+
+void pxtnUnit::_Tone_Envelope( int32_t voice_num, const pxtnVOICEINSTANCE **p_vis )
+{
+	for( int32_t v = 0; v < voice_num; v++ )
+	{
+		const pxtnVOICEINSTANCE *p_vi = p_vis[ v ];
+		pxtnVOICETONE           *p_vt = &_vts[ v ];
 
 		if( p_vt->life_count > 0 && p_vi->env_size )
 		{
@@ -176,10 +187,9 @@ void pxtnUnit::Tone_Envelope()
 	}
 }
 
-void pxtnUnit::Tone_Sample( bool b_mute_by_unit, int32_t ch_num, int32_t  time_pan_index, int32_t  smooth_smp )
+void pxtnUnit::_Tone_Sample( int32_t voice_num, const pxtnVOICEINSTANCE **p_vis, const uint32_t *p_flags,
+							 bool b_mute_by_unit, int32_t ch_num, int32_t time_pan_index, int32_t smooth_smp )
 {
-	if( !_p_woice ) return;
-
 	if( b_mute_by_unit && !_bPlayed )
 	{
 		for( int32_t ch = 0; ch < ch_num; ch++ ) _pan_time_bufs[ ch ][ time_pan_index ] = 0;
@@ -190,10 +200,10 @@ void pxtnUnit::Tone_Sample( bool b_mute_by_unit, int32_t ch_num, int32_t  time_p
 	{
 		int32_t  time_pan_buf = 0;
 
-		for( int32_t v = 0; v < _p_woice->get_voice_num(); v++ )
+		for( int32_t v = 0; v < voice_num; v++ )
 		{
-			pxtnVOICETONE*           p_vt = &_vts                 [ v ];
-			const pxtnVOICEINSTANCE* p_vi = _p_woice->get_instance( v );
+			pxtnVOICETONE*           p_vt = &_vts [ v ];
+			const pxtnVOICEINSTANCE* p_vi = p_vis[ v ];
 
 			int32_t  work = 0;
 
@@ -215,7 +225,7 @@ void pxtnUnit::Tone_Sample( bool b_mute_by_unit, int32_t ch_num, int32_t  time_p
 				if( p_vi->env_size ) work = work * p_vt->env_volume / 128;
 
 				// smooth tail
-				if( _p_woice->get_voice( v )->voice_flags & PTV_VOICEFLAG_SMOOTH && p_vt->life_count < smooth_smp )
+				if( p_flags[ v ] & PTV_VOICEFLAG_SMOOTH && p_vt->life_count < smooth_smp )
 				{
 					work = work * p_vt->life_count / smooth_smp;
 				}
@@ -226,6 +236,63 @@ void pxtnUnit::Tone_Sample( bool b_mute_by_unit, int32_t ch_num, int32_t  time_p
 	}
 }
 
+void pxtnUnit::_Tone_Increment_Sample( int32_t voice_num, const pxtnVOICEINSTANCE **p_vis, const uint32_t *p_flags, float freq )
+{
+	for( int32_t v = 0; v < voice_num; v++ )
+	{
+		const pxtnVOICEINSTANCE* p_vi = p_vis[ v ];
+		pxtnVOICETONE*           p_vt = &_vts [ v ];
+
+		if( p_vt->life_count > 0 ) p_vt->life_count--;
+		if( p_vt->life_count > 0 )
+		{
+			p_vt->on_count--;
+
+			p_vt->smp_pos += p_vt->offset_freq * _v_TUNING * freq;
+
+			if( p_vt->smp_pos >= p_vi->smp_body_w )
+			{
+				if( p_flags[ v ] & PTV_VOICEFLAG_WAVELOOP )
+				{
+					if( p_vt->smp_pos >= p_vi->smp_body_w ) p_vt->smp_pos -= p_vi->smp_body_w;
+					if( p_vt->smp_pos >= p_vi->smp_body_w ) p_vt->smp_pos  = 0;
+				}
+				else
+				{
+					p_vt->life_count = 0;
+				}
+			}
+
+			// OFF
+			if( p_vt->on_count == 0 && p_vi->env_size )
+			{
+				p_vt->env_start = p_vt->env_volume;
+				p_vt->env_pos   = 0;
+			}
+		}
+	}
+}
+
+void pxtnUnit::Tone_Envelope()
+{
+	const pxtnVOICEINSTANCE *p_vis  [ pxtnMAX_UNITCONTROLVOICE ];
+	uint32_t                 p_flags[ pxtnMAX_UNITCONTROLVOICE ];
+
+	if( !_p_woice ) return;
+
+	_Tone_Envelope( _get_voices( p_vis, p_flags ), p_vis );
+}
+
+void pxtnUnit::Tone_Sample( bool b_mute_by_unit, int32_t ch_num, int32_t  time_pan_index, int32_t  smooth_smp )
+{
+	const pxtnVOICEINSTANCE *p_vis  [ pxtnMAX_UNITCONTROLVOICE ];
+	uint32_t                 p_flags[ pxtnMAX_UNITCONTROLVOICE ];
+
+	if( !_p_woice ) return;
+
+	_Tone_Sample( _get_voices( p_vis, p_flags ), p_vis, p_flags, b_mute_by_unit, ch_num, time_pan_index, smooth_smp );
+}
+
 void pxtnUnit::Tone_Supple( int32_t  *group_smps, int32_t ch, int32_t  time_pan_index ) const
 {
 	int32_t  idx = ( time_pan_index - _pan_times[ ch ] ) & ( pxtnBUFSIZE_TIMEPAN - 1 );
@@ -258,40 +325,40 @@ int32_t  pxtnUnit::Tone_Increment_Key()
 
 void pxtnUnit::Tone_Increment_Sample( float freq )
 {
+	const pxtnVOICEINSTANCE *p_vis  [ pxtnMAX_UNITCONTROLVOICE ];
+	uint32_t                 p_flags[ pxtnMAX_UNITCONTROLVOICE ];
+
 	if( !_p_woice ) return;
 
-	for( int32_t v = 0; v < _p_woice->get_voice_num(); v++ )
-	{
-		const pxtnVOICEINSTANCE* p_vi = _p_woice->get_instance( v );
-		pxtnVOICETONE*           p_vt = &_vts                 [ v ];
+	_Tone_Increment_Sample( _get_voices( p_vis, p_flags ), p_vis, p_flags, freq );
+}
 
-		if( p_vt->life_count > 0 ) p_vt->life_count--;
-		if( p_vt->life_count > 0 )
-		{
-			p_vt->on_count--;
+// Runs the tone over the block of samples, adding it into group_smps[ sample ][ channel ][ group ].
+// The envelope of the first sample must be already done, the events come after it,
+// so the woice stays the same for the whole block.
+void pxtnUnit::Tone_Render( int32_t *group_smps, int32_t group_num, int32_t smp_num, bool b_mute_by_unit, int32_t ch_num,
+							int32_t time_pan_index, int32_t smooth_smp, pxtnPulse_Frequency *freq, float smp_stride )
+{
+	const pxtnVOICEINSTANCE *p_vis  [ pxtnMAX_UNITCONTROLVOICE ];
+	uint32_t                 p_flags[ pxtnMAX_UNITCONTROLVOICE ];
+	int32_t                  voice_num = _p_woice ? _get_voices( p_vis, p_flags ) : 0;
 
-			p_vt->smp_pos += p_vt->offset_freq * _v_TUNING * freq;
+	for( int32_t s = 0; s < smp_num; s++ )
+	{
+		if( _p_woice )
+		{
+			if( s ) _Tone_Envelope( voice_num, p_vis );
+			_Tone_Sample( voice_num, p_vis, p_flags, b_mute_by_unit, ch_num, time_pan_index, smooth_smp );
+		}
+		for( int32_t ch = 0; ch < ch_num; ch++ )
+		{
+			Tone_Supple( &group_smps[ ( s * pxtnMAX_CHANNEL + ch ) * group_num ], ch, time_pan_index );
+		}
 
-			if( p_vt->smp_pos >= p_vi->smp_body_w )
-			{
-				if( _p_woice->get_voice( v )->voice_flags & PTV_VOICEFLAG_WAVELOOP )
-				{
-					if( p_vt->smp_pos >= p_vi->smp_body_w ) p_vt->smp_pos -= p_vi->smp_body_w;
-					if( p_vt->smp_pos >= p_vi->smp_body_w ) p_vt->smp_pos  = 0;
-				}
-				else
-				{
-					p_vt->life_count = 0;
-				}
-			}
+		int32_t  key_now = Tone_Increment_Key();
+		if( _p_woice ) _Tone_Increment_Sample( voice_num, p_vis, p_flags, freq->Get2( key_now ) * smp_stride );
 
-			// OFF
-			if( p_vt->on_count == 0 && p_vi->env_size )
-			{
-				p_vt->env_start = p_vt->env_volume;
-				p_vt->env_pos   = 0;
-			}
-		}
+		time_pan_index = ( time_pan_index + 1 ) & ( pxtnBUFSIZE_TIMEPAN - 1 );
 	}
 }
 
@@ -7,6 +7,7 @@
 
 #include "./pxtnMax.h"
 #include "./pxtnWoice.h"
+#include "./pxtnPulse_Frequency.h"
 
 class pxtnUnit: public pxtnData
 {
@@ -37,6 +38,12 @@ private:
 
 	pxtnVOICETONE _vts[ pxtnMAX_UNITCONTROLVOICE ];
 
+	int32_t _get_voices            ( const pxtnVOICEINSTANCE **p_vis, uint32_t *p_flags ) const;
+	void    _Tone_Envelope         ( int32_t voice_num, const pxtnVOICEINSTANCE **p_vis );
+	void    _Tone_Sample           ( int32_t voice_num, const pxtnVOICEINSTANCE **p_vis, const uint32_t *p_flags,
+									 bool b_mute_by_unit, int32_t ch_num, int32_t time_pan_index, int32_t smooth_smp );
+	void    _Tone_Increment_Sample ( int32_t voice_num, const pxtnVOICEINSTANCE **p_vis, const uint32_t *p_flags, float freq );
+
 public :
 	 pxtnUnit( pxtnIO_r io_read, pxtnIO_w io_write, pxtnIO_seek io_seek, pxtnIO_pos io_pos );
 	~pxtnUnit();
@@ -63,6 +70,8 @@ public :
 	void    Tone_Supple    ( int32_t *group_smps, int32_t ch_num, int32_t time_pan_index ) const;
 	int32_t Tone_Increment_Key   ();
 	void    Tone_Increment_Sample( float freq );
+	void    Tone_Render( int32_t *group_smps, int32_t group_num, int32_t smp_num, bool b_mute_by_unit, int32_t ch_num,
+						 int32_t time_pan_index, int32_t smooth_smp, pxtnPulse_Frequency *freq, float smp_stride );
 
 	bool             set_woice( const pxtnWoice *p_woice );
 	const pxtnWoice* get_woice() const;
@@ -332,7 +332,99 @@ void pxtnWoice::_UpdateWavePTV( pxtnVOICEUNIT* p_vc, pxtnVOICEINSTANCE* p_vi, in
 	}
 }
 
-pxtnERR pxtnWoice::Tone_Ready_sample( const pxtnPulse_NoiseBuilder *ptn_bldr )
+// FNV-1a
+static uint64_t _Hash( uint64_t key, const void* p, int32_t size )
+{
+	const uint8_t* p_ = (const uint8_t*)p;
+	for( int32_t i = 0; i < size; i++ ){ key ^= p_[ i ]; key *= ( (uint64_t)0x100 << 32 ) | 0x1b3; }
+	return key;
+}
+
+static uint64_t _HashI( uint64_t key, int32_t v ){ return _Hash( key, &v, sizeof(v) ); }
+static uint64_t _HashF( uint64_t key, float   v ){ return _Hash( key, &v, sizeof(v) ); }
+
+static uint64_t _HashOscillator( uint64_t key, const pxNOISEDESIGN_OSCILLATOR* p_osc )
+{
+	key = _HashI( key, p_osc->type   );
+	key = _HashF( key, p_osc->freq   );
+	key = _HashF( key, p_osc->volume );
+	key = _HashF( key, p_osc->offset );
+	key = _HashI( key, p_osc->b_rev  );
+	return key;
+}
+
+// key of the sample cache from everything Tone_Ready_sample() uses. the coodinate and overtone are cheap, no key.
+bool pxtnWoice::_CacheKey( const pxtnVOICEUNIT* p_vc, int32_t  ch, int32_t  sps, int32_t  bps, uint64_t *p_key ) const
+{
+	uint64_t key = ( (uint64_t)0xcbf29ce4 << 32 ) | 0x84222325;
+
+	key = _HashI( key, p_vc->type );
+	key = _HashI( key, ch         );
+	key = _HashI( key, sps        );
+	key = _HashI( key, bps        );
+
+	switch( p_vc->type )
+	{
+	case pxtnVOICE_OggVorbis:
+#ifdef pxINCLUDE_OGGVORBIS
+		{
+			int32_t     size   = 0;
+			const void* p_data = p_vc->p_oggv->GetData( &size );
+			if( !p_data ) return false;
+			key = _HashI( key, size );
+			key = _Hash ( key, p_data, size );
+			break;
+		}
+#else
+		return false;
+#endif
+
+	case pxtnVOICE_Sampling:
+		{
+			const pxtnPulse_PCM* p_pcm = p_vc->p_pcm;
+			if( !p_pcm->get_p_buf() ) return false;
+			key = _HashI( key, p_pcm->get_ch      () );
+			key = _HashI( key, p_pcm->get_sps     () );
+			key = _HashI( key, p_pcm->get_bps     () );
+			key = _HashI( key, p_pcm->get_smp_head() );
+			key = _HashI( key, p_pcm->get_smp_body() );
+			key = _HashI( key, p_pcm->get_smp_tail() );
+			key = _Hash ( key, p_pcm->get_p_buf(), p_pcm->get_buf_size() );
+			break;
+		}
+
+	case pxtnVOICE_Noise:
+		{
+			pxtnPulse_Noise* p_ptn = p_vc->p_ptn;
+			key = _HashI( key, p_ptn->get_smp_num_44k() );
+			key = _HashI( key, p_ptn->get_unit_num   () );
+			for( int32_t u = 0; u < p_ptn->get_unit_num(); u++ )
+			{
+				const pxNOISEDESIGN_UNIT* p_u = p_ptn->get_unit( u );
+				key = _HashI( key, p_u->bEnable  );
+				key = _HashI( key, p_u->enve_num );
+				for( int32_t e = 0; e < p_u->enve_num; e++ )
+				{
+					key = _HashI( key, p_u->enves[ e ].x );
+					key = _HashI( key, p_u->enves[ e ].y );
+				}
+				key = _HashI( key, p_u->pan );
+				key = _HashOscillator( key, &p_u->main );
+				key = _HashOscillator( key, &p_u->freq );
+				key = _HashOscillator( key, &p_u->volu );
+			}
+			break;
+		}
+
+	default:
+		return false;
+	}
+
+	*p_key = key;
+	return true;
+}
+
+pxtnERR pxtnWoice::Tone_Ready_sample( const pxtnPulse_NoiseBuilder *ptn_bldr, const pxtnVOICECACHE *p_cache )
 {
 	pxtnERR            res   = pxtnERR_VOID;
 	pxtnVOICEINSTANCE* p_vi  = NULL ;
@@ -342,6 +434,10 @@ pxtnERR pxtnWoice::Tone_Ready_sample( const pxtnPulse_NoiseBuilder *ptn_bldr )
 	int32_t            ch    =     2;
 	int32_t            sps   = 44100;
 	int32_t            bps   =    16;
+	uint64_t           key   =     0;
+	bool               b_key = false;
+
+	if( p_cache && ( !p_cache->load || !p_cache->save ) ) p_cache = NULL;
 
 	for( int32_t v = 0; v < _voice_num; v++ )
 	{
@@ -357,6 +453,10 @@ pxtnERR pxtnWoice::Tone_Ready_sample( const pxtnPulse_NoiseBuilder *ptn_bldr )
 		p_vi = &_voinsts[ v ];
 		p_vc = &_voices [ v ];
 
+		if( p_cache && p_vc->type == pxtnVOICE_Noise ) p_vc->p_ptn->Fix(); // as BuildNoise() does, before the key.
+		b_key = p_cache && _CacheKey( p_vc, ch, sps, bps, &key );
+		if( b_key && p_cache->load( p_cache->user, key, p_vi ) ) continue;
+
 		switch( p_vc->type )
 		{
 		case pxtnVOICE_OggVorbis:
@@ -406,6 +506,11 @@ pxtnERR pxtnWoice::Tone_Ready_sample( const pxtnPulse_NoiseBuilder *ptn_bldr )
 				break;
 			}
 		}
+
+		if( b_key && p_vi->p_smp_w )
+		{
+			p_cache->save( p_cache->user, key, p_vi, ( p_vi->smp_head_w + p_vi->smp_body_w + p_vi->smp_tail_w ) * ch * bps / 8 );
+		}
 	}
 
 	res = pxtnOK;
@@ -510,10 +615,10 @@ term:
 	return res;
 }
 
-pxtnERR pxtnWoice::Tone_Ready( const pxtnPulse_NoiseBuilder *ptn_bldr, int32_t sps )
+pxtnERR pxtnWoice::Tone_Ready( const pxtnPulse_NoiseBuilder *ptn_bldr, int32_t sps, const pxtnVOICECACHE *p_cache )
 {
 	pxtnERR res = pxtnERR_VOID;
-	res = Tone_Ready_sample  ( ptn_bldr ); if( res != pxtnOK ) return res;
+	res = Tone_Ready_sample  ( ptn_bldr, p_cache ); if( res != pxtnOK ) return res;
 	res = Tone_Ready_envelope( sps      ); if( res != pxtnOK ) return res;
 	return pxtnOK;
 }
@@ -59,6 +59,19 @@ typedef struct
 }
 pxtnVOICEINSTANCE;
 
+// cache of prepared samples, shared between projects. the key is made from the voice's source data.
+// load allocates p_smp_w with pxtnMem_zero_alloc() and sets smp_*_w, or returns false when the key is unknown.
+typedef bool (* pxtnVoiceCacheLoad)( void* user, uint64_t key,       pxtnVOICEINSTANCE* p_vi );
+typedef void (* pxtnVoiceCacheSave)( void* user, uint64_t key, const pxtnVOICEINSTANCE* p_vi, int32_t smp_size );
+
+typedef struct
+{
+	pxtnVoiceCacheLoad load;
+	pxtnVoiceCacheSave save;
+	void*              user;
+}
+pxtnVOICECACHE;
+
 typedef struct
 {
 	int32_t    fps     ;
@@ -142,6 +155,7 @@ private:
 	pxtnERR _Read_Envelope ( void* desc, pxtnVOICEUNIT *p_vc );
 
 	void    _UpdateWavePTV( pxtnVOICEUNIT* p_vc, pxtnVOICEINSTANCE* p_vi, int32_t  ch, int32_t  sps, int32_t  bps );
+	bool    _CacheKey     ( const pxtnVOICEUNIT* p_vc, int32_t  ch, int32_t  sps, int32_t  bps, uint64_t *p_key ) const;
 
 
 public :
@@ -185,9 +199,9 @@ public :
 	pxtnERR io_mateOGGV_r( void* desc );
 #endif
 
-	pxtnERR Tone_Ready_sample  ( const pxtnPulse_NoiseBuilder *ptn_bldr  );
+	pxtnERR Tone_Ready_sample  ( const pxtnPulse_NoiseBuilder *ptn_bldr, const pxtnVOICECACHE *p_cache = NULL );
 	pxtnERR Tone_Ready_envelope( int32_t sps );
-	pxtnERR Tone_Ready         ( const pxtnPulse_NoiseBuilder *ptn_bldr, int32_t sps );
+	pxtnERR Tone_Ready         ( const pxtnPulse_NoiseBuilder *ptn_bldr, int32_t sps, const pxtnVOICECACHE *p_cache = NULL );
 };
 
 #endif
@@ -36,6 +36,54 @@ static void free_instrument(Instrument *ip)
   SDL_free(ip);
 }
 
+/* Loaded patches are shared between songs: they are never modified once
+   loaded, and the key holds everything the loading depends on. Unused
+   patches are kept until Timidity_Exit() to make the next song loading
+   free of the disk I/O and resampling. Patches which failed to load are
+   kept as well, so missing files aren't searched again and again. */
+typedef struct _InstrumentCache {
+  char *name;
+  int panning, amp, note_to_use, strip_loop, strip_envelope, strip_tail;
+  Sint32 rate, control_ratio;
+  Instrument *ip;
+  int refcount;
+  int stale; /* Left by Timidity_Exit() while still in use */
+  struct _InstrumentCache *next;
+} InstrumentCache;
+
+static InstrumentCache *instrument_cache = NULL;
+static SDL_SpinLock instrument_cache_lock = 0;
+
+static void release_instrument(Instrument *ip)
+{
+  InstrumentCache **it, *c, *dead = NULL;
+  int found = 0;
+
+  SDL_AtomicLock(&instrument_cache_lock);
+  for (it = &instrument_cache; (c = *it) != NULL; it = &c->next)
+    {
+      if (c->ip != ip)
+	continue;
+      found = 1;
+      if (--c->refcount == 0 && c->stale)
+	{
+	  *it = c->next;
+	  dead = c;
+	}
+      break;
+    }
+  SDL_AtomicUnlock(&instrument_cache_lock);
+
+  if (!found) /* Wasn't shared */
+    free_instrument(ip);
+  else if (dead)
+    {
+      free_instrument(dead->ip);
+      SDL_free(dead->name);
+      SDL_free(dead);
+    }
+}
+
 static void free_bank(MidiSong *song, int dr, int b)
 {
   int i;
@@ -44,7 +92,7 @@ static void free_bank(MidiSong *song, int dr, int b)
     if (bank->instrument[i])
       {
 	if (bank->instrument[i] != MAGIC_LOAD_INSTRUMENT)
-	  free_instrument(bank->instrument[i]);
+	  release_instrument(bank->instrument[i]);
 	bank->instrument[i] = NULL;
       }
 }
@@ -502,6 +550,100 @@ badpat:
   *out = NULL;
 }
 
+static InstrumentCache *find_cached_instrument(MidiSong *song, const char *name,
+					      int panning, int amp, int note_to_use,
+					      int strip_loop, int strip_envelope,
+					      int strip_tail)
+{
+  InstrumentCache *c;
+
+  for (c = instrument_cache; c; c = c->next)
+    {
+      if (!c->stale && c->panning == panning && c->amp == amp &&
+	  c->note_to_use == note_to_use && c->strip_loop == strip_loop &&
+	  c->strip_envelope == strip_envelope && c->strip_tail == strip_tail &&
+	  c->rate == song->rate && c->control_ratio == song->control_ratio &&
+	  !SDL_strcmp(c->name, name))
+	return c;
+    }
+
+  return NULL;
+}
+
+/* Like load_instrument(), but takes the patch from the cache when possible */
+static void load_cached_instrument(MidiSong *song, const char *name,
+				   Instrument **out,
+				   int percussion, int panning,
+				   int amp, int note_to_use,
+				   int strip_loop, int strip_envelope,
+				   int strip_tail)
+{
+  InstrumentCache *c, *added;
+
+  SDL_AtomicLock(&instrument_cache_lock);
+  c = find_cached_instrument(song, name, panning, amp, note_to_use,
+			     strip_loop, strip_envelope, strip_tail);
+  if (c)
+    {
+      if (c->ip)
+	c->refcount++;
+      *out = c->ip;
+    }
+  SDL_AtomicUnlock(&instrument_cache_lock);
+
+  if (c)
+    return;
+
+  /* Load it out of the lock, other songs may load patches meanwhile */
+  load_instrument(song, name, out, percussion, panning, amp, note_to_use,
+		  strip_loop, strip_envelope, strip_tail);
+  if (song->oom)
+    return;
+
+  added = SDL_calloc(1, sizeof(InstrumentCache));
+  if (!added || !(added->name = SDL_strdup(name)))
+    {
+      /* Still usable, just not shared */
+      SDL_free(added);
+      return;
+    }
+
+  added->panning = panning;
+  added->amp = amp;
+  added->note_to_use = note_to_use;
+  added->strip_loop = strip_loop;
+  added->strip_envelope = strip_envelope;
+  added->strip_tail = strip_tail;
+  added->rate = song->rate;
+  added->control_ratio = song->control_ratio;
+  added->ip = *out;
+  added->refcount = (*out) ? 1 : 0;
+
+  SDL_AtomicLock(&instrument_cache_lock);
+  c = find_cached_instrument(song, name, panning, amp, note_to_use,
+			     strip_loop, strip_envelope, strip_tail);
+  if (c)
+    {
+      /* Another song got it loaded first, use that one */
+      if (c->ip)
+	c->refcount++;
+    }
+  else
+    {
+      added->next = instrument_cache;
+      instrument_cache = added;
+    }
+  SDL_AtomicUnlock(&instrument_cache_lock);
+
+  if (c)
+    {
+      free_instrument(*out);
+      *out = c->ip;
+      SDL_free(added->name);
+      SDL_free(added);
+    }
+}
+
 static int fill_bank(MidiSong *song, int dr, int b)
 {
   int i, errors=0;
@@ -543,7 +685,7 @@ static int fill_bank(MidiSong *song, int dr, int b)
 	    }
 	  else
 	    {
-	      load_instrument(song,
+	      load_cached_instrument(song,
 				     bank->tone[i].name, 
 				     &bank->instrument[i],
 				     (dr) ? 1 : 0,
@@ -596,6 +738,37 @@ void free_instruments(MidiSong *song)
     }
 }
 
+void free_instrument_cache(void)
+{
+  InstrumentCache **it, *c, *dead = NULL;
+
+  SDL_AtomicLock(&instrument_cache_lock);
+  it = &instrument_cache;
+  while ((c = *it) != NULL)
+    {
+      if (c->refcount > 0)
+	{
+	  /* Gets freed once the last song using it is freed */
+	  c->stale = 1;
+	  it = &c->next;
+	  continue;
+	}
+      *it = c->next;
+      c->next = dead;
+      dead = c;
+    }
+  SDL_AtomicUnlock(&instrument_cache_lock);
+
+  while (dead)
+    {
+      c = dead->next;
+      free_instrument(dead->ip);
+      SDL_free(dead->name);
+      SDL_free(dead);
+      dead = c;
+    }
+}
+
 int set_default_instrument(MidiSong *song, const char *name)
 {
   load_instrument(song, name, &song->default_instrument, 0, -1, -1, -1, 0, 0, 0);
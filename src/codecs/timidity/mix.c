@@ -168,6 +168,140 @@ static int update_signal(MidiSong *song, int v)
 
 #define MIXATION(a)	*lp++ += (a)*s;
 
+/* Vectorized runs take the volumes as 16-bit, which they always are being
+   limited by MAX_AMP_VALUE. The results are exactly the same. */
+#define MIX_FITS_S16(a)	((a) >= -32768 && (a) <= 32767)
+
+/* Mix 'count' samples into both channels of the stereo buffer */
+static void mix_stereo_run(const sample_t *sp, Sint32 *lp,
+			   final_volume_t left, final_volume_t right, int count)
+{
+  sample_t s;
+
+#if defined(TIMIDITY_SSE2)
+  if (MIX_FITS_S16(left) && MIX_FITS_S16(right))
+    {
+      const __m128i vol = _mm_setr_epi16((short)left, (short)right,
+					 (short)left, (short)right,
+					 (short)left, (short)right,
+					 (short)left, (short)right);
+      __m128i v, d, lo, hi;
+      for (; count >= 8; count -= 8)
+	{
+	  v = _mm_loadu_si128((const __m128i *)sp);
+	  d = _mm_unpacklo_epi16(v, v);
+	  lo = _mm_mullo_epi16(d, vol);
+	  hi = _mm_mulhi_epi16(d, vol);
+	  _mm_storeu_si128((__m128i *)lp, _mm_add_epi32(_mm_loadu_si128((const __m128i *)lp), _mm_unpacklo_epi16(lo, hi)));
+	  _mm_storeu_si128((__m128i *)(lp + 4), _mm_add_epi32(_mm_loadu_si128((const __m128i *)(lp + 4)), _mm_unpackhi_epi16(lo, hi)));
+	  d = _mm_unpackhi_epi16(v, v);
+	  lo = _mm_mullo_epi16(d, vol);
+	  hi = _mm_mulhi_epi16(d, vol);
+	  _mm_storeu_si128((__m128i *)(lp + 8), _mm_add_epi32(_mm_loadu_si128((const __m128i *)(lp + 8)), _mm_unpacklo_epi16(lo, hi)));
+	  _mm_storeu_si128((__m128i *)(lp + 12), _mm_add_epi32(_mm_loadu_si128((const __m128i *)(lp + 12)), _mm_unpackhi_epi16(lo, hi)));
+	  sp += 8;
+	  lp += 16;
+	}
+    }
+#elif defined(TIMIDITY_NEON)
+  if (MIX_FITS_S16(left) && MIX_FITS_S16(right))
+    {
+      int16_t lr[4];
+      int16x4_t vol;
+      int16x8x2_t d;
+      lr[0] = lr[2] = (int16_t)left;
+      lr[1] = lr[3] = (int16_t)right;
+      vol = vld1_s16(lr);
+      for (; count >= 8; count -= 8)
+	{
+	  int16x8_t v = vld1q_s16((const int16_t *)sp);
+	  d = vzipq_s16(v, v);
+	  vst1q_s32((int32_t *)lp, vmlal_s16(vld1q_s32((const int32_t *)lp), vget_low_s16(d.val[0]), vol));
+	  vst1q_s32((int32_t *)(lp + 4), vmlal_s16(vld1q_s32((const int32_t *)(lp + 4)), vget_high_s16(d.val[0]), vol));
+	  vst1q_s32((int32_t *)(lp + 8), vmlal_s16(vld1q_s32((const int32_t *)(lp + 8)), vget_low_s16(d.val[1]), vol));
+	  vst1q_s32((int32_t *)(lp + 12), vmlal_s16(vld1q_s32((const int32_t *)(lp + 12)), vget_high_s16(d.val[1]), vol));
+	  sp += 8;
+	  lp += 16;
+	}
+    }
+#endif
+
+  while (count--)
+    {
+      s = *sp++;
+      MIXATION(left);
+      MIXATION(right);
+    }
+}
+
+/* Mix 'count' samples into the left channel of the stereo buffer */
+static void mix_single_run(const sample_t *sp, Sint32 *lp,
+			   final_volume_t left, int count)
+{
+  sample_t s;
+
+#if defined(TIMIDITY_SSE2) || defined(TIMIDITY_NEON)
+  /* Adding zeroes to the right channel is cheaper than skipping them */
+  if (count >= 8)
+    {
+      mix_stereo_run(sp, lp, left, 0, count & ~7);
+      sp += count & ~7;
+      lp += (count & ~7) * 2;
+      count &= 7;
+    }
+#endif
+
+  while (count--)
+    {
+      s = *sp++;
+      MIXATION(left);
+      lp++;
+    }
+}
+
+/* Mix 'count' samples into the mono buffer */
+static void mix_mono_run(const sample_t *sp, Sint32 *lp,
+			 final_volume_t left, int count)
+{
+  sample_t s;
+
+#if defined(TIMIDITY_SSE2)
+  if (MIX_FITS_S16(left))
+    {
+      const __m128i vol = _mm_set1_epi16((short)left);
+      __m128i v, lo, hi;
+      for (; count >= 8; count -= 8)
+	{
+	  v = _mm_loadu_si128((const __m128i *)sp);
+	  lo = _mm_mullo_epi16(v, vol);
+	  hi = _mm_mulhi_epi16(v, vol);
+	  _mm_storeu_si128((__m128i *)lp, _mm_add_epi32(_mm_loadu_si128((const __m128i *)lp), _mm_unpacklo_epi16(lo, hi)));
+	  _mm_storeu_si128((__m128i *)(lp + 4), _mm_add_epi32(_mm_loadu_si128((const __m128i *)(lp + 4)), _mm_unpackhi_epi16(lo, hi)));
+	  sp += 8;
+	  lp += 8;
+	}
+    }
+#elif defined(TIMIDITY_NEON)
+  if (MIX_FITS_S16(left))
+    {
+      for (; count >= 8; count -= 8)
+	{
+	  int16x8_t v = vld1q_s16((const int16_t *)sp);
+	  vst1q_s32((int32_t *)lp, vmlal_n_s16(vld1q_s32((const int32_t *)lp), vget_low_s16(v), (int16_t)left));
+	  vst1q_s32((int32_t *)(lp + 4), vmlal_n_s16(vld1q_s32((const int32_t *)(lp + 4)), vget_high_s16(v), (int16_t)left));
+	  sp += 8;
+	  lp += 8;
+	}
+    }
+#endif
+
+  while (count--)
+    {
+      s = *sp++;
+      MIXATION(left);
+    }
+}
+
 static void mix_mystery_signal(MidiSong *song, sample_t *sp, Sint32 *lp, int v,
 			       int count)
 {
@@ -176,7 +310,6 @@ static void mix_mystery_signal(MidiSong *song, sample_t *sp, Sint32 *lp, int v,
     left=vp->left_mix, 
     right=vp->right_mix;
   int cc;
-  sample_t s;
 
   if (!(cc = vp->control_counter))
     {
@@ -191,12 +324,9 @@ static void mix_mystery_signal(MidiSong *song, sample_t *sp, Sint32 *lp, int v,
     if (cc < count)
       {
 	count -= cc;
-	while (cc--)
-	  {
-	    s = *sp++;
-	    MIXATION(left);
-	    MIXATION(right);
-	  }
+	mix_stereo_run(sp, lp, left, right, cc);
+	sp += cc;
+	lp += cc * 2;
 	cc = song->control_ratio;
 	if (update_signal(song, v))
 	  return;	/* Envelope ran out */
@@ -206,12 +336,7 @@ static void mix_mystery_signal(MidiSong *song, sample_t *sp, Sint32 *lp, int v,
     else
       {
 	vp->control_counter = cc - count;
-	while (count--)
-	  {
-	    s = *sp++;
-	    MIXATION(left);
-	    MIXATION(right);
-	  }
+	mix_stereo_run(sp, lp, left, right, count);
 	return;
       }
 }
@@ -223,7 +348,6 @@ static void mix_center_signal(MidiSong *song, sample_t *sp, Sint32 *lp, int v,
   final_volume_t 
     left=vp->left_mix;
   int cc;
-  sample_t s;
 
   if (!(cc = vp->control_counter))
     {
@@ -237,12 +361,9 @@ static void mix_center_signal(MidiSong *song, sample_t *sp, Sint32 *lp, int v,
     if (cc < count)
       {
 	count -= cc;
-	while (cc--)
-	  {
-	    s = *sp++;
-	    MIXATION(left);
-	    MIXATION(left);
-	  }
+	mix_stereo_run(sp, lp, left, left, cc);
+	sp += cc;
+	lp += cc * 2;
 	cc = song->control_ratio;
 	if (update_signal(song, v))
 	  return;	/* Envelope ran out */
@@ -251,12 +372,7 @@ static void mix_center_signal(MidiSong *song, sample_t *sp, Sint32 *lp, int v,
     else
       {
 	vp->control_counter = cc - count;
-	while (count--)
-	  {
-	    s = *sp++;
-	    MIXATION(left);
-	    MIXATION(left);
-	  }
+	mix_stereo_run(sp, lp, left, left, count);
 	return;
       }
 }
@@ -268,7 +384,6 @@ static void mix_single_signal(MidiSong *song, sample_t *sp, Sint32 *lp, int v,
   final_volume_t 
     left=vp->left_mix;
   int cc;
-  sample_t s;
 
   if (!(cc = vp->control_counter))
     {
@@ -282,12 +397,9 @@ static void mix_single_signal(MidiSong *song, sample_t *sp, Sint32 *lp, int v,
     if (cc < count)
       {
 	count -= cc;
-	while (cc--)
-	  {
-	    s = *sp++;
-	    MIXATION(left);
-	    lp++;
-	  }
+	mix_single_run(sp, lp, left, cc);
+	sp += cc;
+	lp += cc * 2;
 	cc = song->control_ratio;
 	if (update_signal(song, v))
 	  return;	/* Envelope ran out */
@@ -296,12 +408,7 @@ static void mix_single_signal(MidiSong *song, sample_t *sp, Sint32 *lp, int v,
     else
       {
 	vp->control_counter = cc - count;
-	while (count--)
-	  {
-	    s = *sp++;
-	    MIXATION(left);
-	    lp++;
-	  }
+	mix_single_run(sp, lp, left, count);
 	return;
       }
 }
@@ -313,7 +420,6 @@ static void mix_mono_signal(MidiSong *song, sample_t *sp, Sint32 *lp, int v,
   final_volume_t 
     left=vp->left_mix;
   int cc;
-  sample_t s;
 
   if (!(cc = vp->control_counter))
     {
@@ -327,11 +433,9 @@ static void mix_mono_signal(MidiSong *song, sample_t *sp, Sint32 *lp, int v,
     if (cc < count)
       {
 	count -= cc;
-	while (cc--)
-	  {
-	    s = *sp++;
-	    MIXATION(left);
-	  }
+	mix_mono_run(sp, lp, left, cc);
+	sp += cc;
+	lp += cc;
 	cc = song->control_ratio;
 	if (update_signal(song, v))
 	  return;	/* Envelope ran out */
@@ -340,69 +444,29 @@ static void mix_mono_signal(MidiSong *song, sample_t *sp, Sint32 *lp, int v,
     else
       {
 	vp->control_counter = cc - count;
-	while (count--)
-	  {
-	    s = *sp++;
-	    MIXATION(left);
-	  }
+	mix_mono_run(sp, lp, left, count);
 	return;
       }
 }
 
 static void mix_mystery(MidiSong *song, sample_t *sp, Sint32 *lp, int v, int count)
 {
-  final_volume_t 
-    left = song->voice[v].left_mix, 
-    right = song->voice[v].right_mix;
-  sample_t s;
-
-  while (count--)
-    {
-      s = *sp++;
-      MIXATION(left);
-      MIXATION(right);
-    }
+  mix_stereo_run(sp, lp, song->voice[v].left_mix, song->voice[v].right_mix, count);
 }
 
 static void mix_center(MidiSong *song, sample_t *sp, Sint32 *lp, int v, int count)
 {
-  final_volume_t 
-    left = song->voice[v].left_mix;
-  sample_t s;
-
-  while (count--)
-    {
-      s = *sp++;
-      MIXATION(left);
-      MIXATION(left);
-    }
+  mix_stereo_run(sp, lp, song->voice[v].left_mix, song->voice[v].left_mix, count);
 }
 
 static void mix_single(MidiSong *song, sample_t *sp, Sint32 *lp, int v, int count)
 {
-  final_volume_t 
-    left = song->voice[v].left_mix;
-  sample_t s;
-
-  while (count--)
-    {
-      s = *sp++;
-      MIXATION(left);
-      lp++;
-    }
+  mix_single_run(sp, lp, song->voice[v].left_mix, count);
 }
 
 static void mix_mono(MidiSong *song, sample_t *sp, Sint32 *lp, int v, int count)
 {
-  final_volume_t 
-    left = song->voice[v].left_mix;
-  sample_t s;
-
-  while (count--)
-    {
-      s = *sp++;
-      MIXATION(left);
-    }
+  mix_mono_run(sp, lp, song->voice[v].left_mix, count);
 }
 
 /* Ramp a note out in c samples */
@@ -104,4 +104,15 @@
 #define PI 3.14159265358979323846
 #endif
 
+/* Vectorized resampling and mixing loops */
+#if !defined(MIXERX_DISABLE_SIMD) && (SDL_BYTEORDER == SDL_LIL_ENDIAN)
+#  if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#    define TIMIDITY_SSE2
+#    include <emmintrin.h>
+#  elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+#    define TIMIDITY_NEON
+#    include <arm_neon.h>
+#  endif
+#endif
+
 #endif /* TIMIDITY_OPTIONS_H */
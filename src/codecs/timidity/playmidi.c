@@ -800,3 +800,10 @@ void Timidity_SetVolume(MidiSong *song, int volume)
 	apply_envelope_to_amp(song, i);
       }
 }
+
+void Timidity_SetInterpolation(MidiSong *song, int mode)
+{
+  if (mode < TIMIDITY_INTERP_NEAREST || mode > TIMIDITY_INTERP_CUBIC)
+    return;
+  song->interpolation = mode;
+}
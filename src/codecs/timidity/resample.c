@@ -21,6 +21,135 @@
 
 #define PRECALC_LOOP_COUNT(start, end, incr) (((end) - (start) + (incr) - 1) / (incr))
 
+/*************** interpolation *****************/
+
+/* These fill 'count' samples of 'dest' from 'src' starting at the fixed
+   point offset 'ofs' and stepping by 'incr', and return the offset past
+   the last one. Sample data has two guard samples behind its end, so
+   the next samples can be always read. */
+
+static Sint32 interp_nearest(const sample_t *src, sample_t *dest,
+			     Sint32 ofs, Sint32 incr, Sint32 count)
+{
+  while (count--)
+    {
+      *dest++ = src[(ofs + (1 << (FRACTION_BITS-1))) >> FRACTION_BITS];
+      ofs += incr;
+    }
+  return ofs;
+}
+
+static Sint32 interp_linear(const sample_t *src, sample_t *dest,
+			    Sint32 ofs, Sint32 incr, Sint32 count)
+{
+  sample_t v1, v2;
+
+  /* v1 * (1 - f) + v2 * f is exactly the same as v1 + (v2 - v1) * f,
+     but it's done with one 16-bit multiply-add per pair of samples */
+#if defined(TIMIDITY_SSE2)
+  const __m128i one = _mm_set1_epi32(1 << FRACTION_BITS);
+  const __m128i mask = _mm_set1_epi32((int)FRACTION_MASK);
+  const __m128i step = _mm_set1_epi32(incr * 4);
+  __m128i o = _mm_setr_epi32(ofs, ofs + incr, ofs + incr * 2, ofs + incr * 3);
+  __m128i f, w, r;
+  Sint32 p0, p1, p2, p3;
+
+  for (; count >= 4; count -= 4)
+    {
+      f = _mm_and_si128(o, mask);
+      w = _mm_or_si128(_mm_sub_epi32(one, f), _mm_slli_epi32(f, 16));
+      SDL_memcpy(&p0, src + (ofs >> FRACTION_BITS), 4); ofs += incr;
+      SDL_memcpy(&p1, src + (ofs >> FRACTION_BITS), 4); ofs += incr;
+      SDL_memcpy(&p2, src + (ofs >> FRACTION_BITS), 4); ofs += incr;
+      SDL_memcpy(&p3, src + (ofs >> FRACTION_BITS), 4); ofs += incr;
+      r = _mm_madd_epi16(_mm_setr_epi32(p0, p1, p2, p3), w);
+      r = _mm_srai_epi32(r, FRACTION_BITS);
+      _mm_storel_epi64((__m128i *)dest, _mm_packs_epi32(r, r));
+      dest += 4;
+      o = _mm_add_epi32(o, step);
+    }
+#elif defined(TIMIDITY_NEON)
+  const int32x4_t one = vdupq_n_s32(1 << FRACTION_BITS);
+  const int32x4_t mask = vdupq_n_s32((int)FRACTION_MASK);
+  int32x4_t f, r;
+  Sint32 o[4];
+  sample_t a[4], b[4];
+  int k;
+
+  for (; count >= 4; count -= 4)
+    {
+      for (k = 0; k < 4; k++)
+	{
+	  o[k] = ofs;
+	  a[k] = src[ofs >> FRACTION_BITS];
+	  b[k] = src[(ofs >> FRACTION_BITS)+1];
+	  ofs += incr;
+	}
+      f = vandq_s32(vld1q_s32((const int32_t *)o), mask);
+      r = vmull_s16(vld1_s16((const int16_t *)a), vmovn_s32(vsubq_s32(one, f)));
+      r = vmlal_s16(r, vld1_s16((const int16_t *)b), vmovn_s32(f));
+      r = vshrq_n_s32(r, FRACTION_BITS);
+      vst1_s16((int16_t *)dest, vqmovn_s32(r));
+      dest += 4;
+    }
+#endif
+
+  while (count--)
+    {
+      v1 = src[ofs >> FRACTION_BITS];
+      v2 = src[(ofs >> FRACTION_BITS)+1];
+      *dest++ = v1 + (((v2 - v1) * (ofs & FRACTION_MASK)) >> FRACTION_BITS);
+      ofs += incr;
+    }
+  return ofs;
+}
+
+static Sint32 interp_cubic(const sample_t *src, sample_t *dest,
+			   Sint32 ofs, Sint32 incr, Sint32 count)
+{
+  Sint32 i;
+  float x, v0, v1, v2, v3, r;
+
+  /* Catmull-Rom spline through the four nearest samples */
+  while (count--)
+    {
+      i = ofs >> FRACTION_BITS;
+      x = (float)(ofs & FRACTION_MASK) * (1.0f / (1 << FRACTION_BITS));
+      v0 = (float)src[(i > 0) ? i-1 : 0];
+      v1 = (float)src[i];
+      v2 = (float)src[i+1];
+      v3 = (float)src[i+2];
+      r = v1 + 0.5f * x * (v2 - v0 + x * (2.0f * v0 - 5.0f * v1 + 4.0f * v2 - v3 +
+			   x * (3.0f * (v1 - v2) + v3 - v0)));
+      if (r > 32767.0f)
+	r = 32767.0f;
+      else if (r < -32768.0f)
+	r = -32768.0f;
+      *dest++ = (sample_t)r;
+      ofs += incr;
+    }
+  return ofs;
+}
+
+static sample_t *resample_run(MidiSong *song, const sample_t *src,
+			      sample_t *dest, Sint32 *ofs, Sint32 incr,
+			      Sint32 count)
+{
+  switch (song->interpolation)
+    {
+    case TIMIDITY_INTERP_NEAREST:
+      *ofs = interp_nearest(src, dest, *ofs, incr, count);
+      break;
+    case TIMIDITY_INTERP_CUBIC:
+      *ofs = interp_cubic(src, dest, *ofs, incr, count);
+      break;
+    default:
+      *ofs = interp_linear(src, dest, *ofs, incr, count);
+      break;
+    }
+  return dest + count;
+}
+
 /*************** resampling with fixed increment *****************/
 
 static sample_t *rs_plain(MidiSong *song, int v, Sint32 *countptr)
@@ -28,7 +157,6 @@ static sample_t *rs_plain(MidiSong *song, int v, Sint32 *countptr)
 
   /* Play sample until end, then free the voice. */
 
-  sample_t v1, v2;
   Voice 
     *vp=&(song->voice[v]);
   sample_t 
@@ -39,7 +167,7 @@ static sample_t *rs_plain(MidiSong *song, int v, Sint32 *countptr)
     incr=vp->sample_increment,
     le=vp->sample->data_length,
     count=*countptr;
-  Sint32 i, j;
+  Sint32 i;
 
   if (incr<0) incr = -incr; /* In case we're coming out of a bidir loop */
 
@@ -54,13 +182,7 @@ static sample_t *rs_plain(MidiSong *song, int v, Sint32 *countptr)
     }
   else count -= i;
 
-  for (j = 0; j < i; j++)
-    {
-      v1 = src[ofs >> FRACTION_BITS];
-      v2 = src[(ofs >> FRACTION_BITS)+1];
-      *dest++ = v1 + (((v2 - v1) * (ofs & FRACTION_MASK)) >> FRACTION_BITS);
-      ofs += incr;
-    }
+  dest = resample_run(song, src, dest, &ofs, incr, i);
 
   if (ofs >= le)
     {
@@ -78,7 +200,6 @@ static sample_t *rs_loop(MidiSong *song, Voice *vp, Sint32 count)
 {
   /* Play sample until end-of-loop, skip back and continue. */
 
-  sample_t v1, v2;
   Sint32 
     ofs=vp->sample_offset,
     incr=vp->sample_increment,
@@ -87,7 +208,7 @@ static sample_t *rs_loop(MidiSong *song, Voice *vp, Sint32 count)
   sample_t
     *dest=song->resample_buffer,
     *src=vp->sample->data;
-  Sint32 i, j;
+  Sint32 i;
 
   while (count)
     {
@@ -101,13 +222,7 @@ static sample_t *rs_loop(MidiSong *song, Voice *vp, Sint32 count)
 	  count = 0;
 	}
       else count -= i;
-      for (j = 0; j < i; j++)
-	{
-	  v1 = src[ofs >> FRACTION_BITS];
-	  v2 = src[(ofs >> FRACTION_BITS)+1];
-	  *dest++ = v1 + (((v2 - v1) * (ofs & FRACTION_MASK)) >> FRACTION_BITS);
-	  ofs += incr;
-	}
+      dest = resample_run(song, src, dest, &ofs, incr, i);
     }
 
   vp->sample_offset=ofs; /* Update offset */
@@ -116,7 +231,6 @@ static sample_t *rs_loop(MidiSong *song, Voice *vp, Sint32 count)
 
 static sample_t *rs_bidir(MidiSong *song, Voice *vp, Sint32 count)
 {
-  sample_t v1, v2;
   Sint32 
     ofs=vp->sample_offset,
     incr=vp->sample_increment,
@@ -128,7 +242,7 @@ static sample_t *rs_bidir(MidiSong *song, Voice *vp, Sint32 count)
   Sint32
     le2 = le<<1,
     ls2 = ls<<1,
-    i, j;
+    i;
   /* Play normally until inside the loop region */
 
   if (incr > 0 && ofs < ls)
@@ -143,13 +257,7 @@ static sample_t *rs_bidir(MidiSong *song, Voice *vp, Sint32 count)
 	  count = 0;
 	}
       else count -= i;
-      for (j = 0; j < i; j++)
-	{
-	  v1 = src[ofs >> FRACTION_BITS];
-	  v2 = src[(ofs >> FRACTION_BITS)+1];
-	  *dest++ = v1 + (((v2 - v1) * (ofs & FRACTION_MASK)) >> FRACTION_BITS);
-	  ofs += incr;
-	}
+      dest = resample_run(song, src, dest, &ofs, incr, i);
     }
 
   /* Then do the bidirectional looping */
@@ -163,13 +271,7 @@ static sample_t *rs_bidir(MidiSong *song, Voice *vp, Sint32 count)
 	  count = 0;
 	}
       else count -= i;
-      for (j = 0; j < i; j++)
-	{
-	  v1 = src[ofs >> FRACTION_BITS];
-	  v2 = src[(ofs >> FRACTION_BITS)+1];
-	  *dest++ = v1 + (((v2 - v1) * (ofs & FRACTION_MASK)) >> FRACTION_BITS);
-	  ofs += incr;
-	}
+      dest = resample_run(song, src, dest, &ofs, incr, i);
       if (ofs>=le)
 	{
 	  /* fold the overshoot back in */
@@ -268,7 +370,6 @@ static sample_t *rs_vib_plain(MidiSong *song, int v, Sint32 *countptr)
 {
   /* Play sample until end, then free the voice. */
 
-  sample_t v1, v2;
   Voice *vp=&(song->voice[v]);
   sample_t 
     *dest=song->resample_buffer, 
@@ -292,10 +393,7 @@ static sample_t *rs_vib_plain(MidiSong *song, int v, Sint32 *countptr)
 	  cc=vp->vibrato_control_ratio;
 	  incr=update_vibrato(song, vp, 0);
 	}
-      v1 = src[ofs >> FRACTION_BITS];
-      v2 = src[(ofs >> FRACTION_BITS)+1];
-      *dest++ = v1 + (((v2 - v1) * (ofs & FRACTION_MASK)) >> FRACTION_BITS);
-      ofs += incr;
+      dest = resample_run(song, src, dest, &ofs, incr, 1);
       if (ofs >= le)
 	{
 	  if (ofs == le)
@@ -316,7 +414,6 @@ static sample_t *rs_vib_loop(MidiSong *song, Voice *vp, Sint32 count)
 {
   /* Play sample until end-of-loop, skip back and continue. */
 
-  sample_t v1, v2;
   Sint32 
     ofs=vp->sample_offset,
     incr=vp->sample_increment,
@@ -327,7 +424,7 @@ static sample_t *rs_vib_loop(MidiSong *song, Voice *vp, Sint32 count)
     *src=vp->sample->data;
   int 
     cc=vp->vibrato_control_counter;
-  Sint32 i, j;
+  Sint32 i;
   int
     vibflag=0;
 
@@ -347,13 +444,7 @@ static sample_t *rs_vib_loop(MidiSong *song, Voice *vp, Sint32 count)
 	}
       else cc -= i;
       count -= i;
-      for (j = 0; j < i; j++)
-	{
-	  v1 = src[ofs >> FRACTION_BITS];
-	  v2 = src[(ofs >> FRACTION_BITS)+1];
-	  *dest++ = v1 + (((v2 - v1) * (ofs & FRACTION_MASK)) >> FRACTION_BITS);
-	  ofs += incr;
-	}
+      dest = resample_run(song, src, dest, &ofs, incr, i);
       if(vibflag)
 	{
 	  cc = vp->vibrato_control_ratio;
@@ -370,7 +461,6 @@ static sample_t *rs_vib_loop(MidiSong *song, Voice *vp, Sint32 count)
 
 static sample_t *rs_vib_bidir(MidiSong *song, Voice *vp, Sint32 count)
 {
-  sample_t v1, v2;
   Sint32 
     ofs=vp->sample_offset,
     incr=vp->sample_increment,
@@ -384,7 +474,7 @@ static sample_t *rs_vib_bidir(MidiSong *song, Voice *vp, Sint32 count)
   Sint32
     le2=le<<1,
     ls2=ls<<1,
-    i, j;
+    i;
   int
     vibflag = 0;
 
@@ -400,13 +490,7 @@ static sample_t *rs_vib_bidir(MidiSong *song, Voice *vp, Sint32 count)
 	}
       else cc -= i;
       count -= i;
-      for (j = 0; j < i; j++)
-	{
-	  v1 = src[ofs >> FRACTION_BITS];
-	  v2 = src[(ofs >> FRACTION_BITS)+1];
-	  *dest++ = v1 + (((v2 - v1) * (ofs & FRACTION_MASK)) >> FRACTION_BITS);
-	  ofs += incr;
-	}
+      dest = resample_run(song, src, dest, &ofs, incr, i);
       if (vibflag)
 	{
 	  cc = vp->vibrato_control_ratio;
@@ -428,13 +512,7 @@ static sample_t *rs_vib_bidir(MidiSong *song, Voice *vp, Sint32 count)
 	}
       else cc -= i;
       count -= i;
-      while (i--)
-	{
-	  v1 = src[ofs >> FRACTION_BITS];
-	  v2 = src[(ofs >> FRACTION_BITS)+1];
-	  *dest++ = v1 + (((v2 - v1) * (ofs & FRACTION_MASK)) >> FRACTION_BITS);
-	  ofs += incr;
-	}
+      dest = resample_run(song, src, dest, &ofs, incr, i);
       if (vibflag)
 	{
 	  cc = vp->vibrato_control_ratio;
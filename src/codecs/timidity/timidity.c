@@ -23,6 +23,7 @@
 static ToneBank *master_tonebank[MAXBANK], *master_drumset[MAXBANK];
 
 static char def_instr_name[256] = "";
+static int def_interpolation = TIMIDITY_INTERP_LINEAR;
 
 #define MAXWORDS 10
 #define MAX_RCFCOUNT 50
@@ -227,6 +228,29 @@ static int read_config_file(const char *name, int rcf_count)
       SNDDBG(("FIXME: Implement \"map\" in TiMidity config.\n"));
     }
 
+    else if (!SDL_strcmp(w[0], "interpolation")) /* "interpolation" nearest|linear|cubic */
+    {
+      /* An SDL_mixer extension: the quality of the voice resampler */
+      if (words != 2)
+      {
+	SNDDBG(("%s: line %d: Must specify exactly one interpolation mode\n",
+		name, line));
+	goto fail;
+      }
+      if (!SDL_strcmp(w[1], "nearest"))
+	def_interpolation = TIMIDITY_INTERP_NEAREST;
+      else if (!SDL_strcmp(w[1], "linear"))
+	def_interpolation = TIMIDITY_INTERP_LINEAR;
+      else if (!SDL_strcmp(w[1], "cubic"))
+	def_interpolation = TIMIDITY_INTERP_CUBIC;
+      else
+      {
+	SNDDBG(("%s: line %d: Unknown interpolation mode `%s'\n",
+		name, line, w[1]));
+	goto fail;
+      }
+    }
+
     /* Standard TiMidity config */
     else if (!SDL_strcmp(w[0], "dir"))
     {
@@ -492,6 +516,7 @@ int Timidity_Init_NoConfig(void)
 {
   master_tonebank[0] = NULL;
   master_drumset[0] = NULL;
+  def_interpolation = TIMIDITY_INTERP_LINEAR;
   return init_alloc_banks();
 }
 
@@ -536,6 +561,7 @@ static void do_song_load(SDL_RWops *rw, SDL_AudioSpec *audio, MidiSong **out)
   }
 
   song->amplification = DEFAULT_AMPLIFICATION;
+  song->interpolation = def_interpolation;
   song->voices = DEFAULT_VOICES;
   song->drumchannels = DEFAULT_DRUMCHANNELS;
 
@@ -681,5 +707,6 @@ void Timidity_Exit(void)
     }
   }
 
+  free_instrument_cache();
   timi_free_pathlist();
 }
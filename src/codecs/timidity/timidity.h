@@ -18,6 +18,11 @@ typedef Sint32 final_volume_t;
 
 #define VIBRATO_SAMPLE_INCREMENTS 32
 
+/* Interpolation of the voice resampler, from the fastest to the best */
+#define TIMIDITY_INTERP_NEAREST 0
+#define TIMIDITY_INTERP_LINEAR  1
+#define TIMIDITY_INTERP_CUBIC   2
+
 /* Maximum polyphony. */
 /* #define MAX_VOICES	48 */
 #define MAX_VOICES	256
@@ -143,6 +148,7 @@ typedef struct {
     Sint32 event_count;
     Sint32 at;
     Sint32 groomed_event_count;
+    int interpolation;
 } MidiSong;
 
 /* Some of these are not defined in timidity.c but are here for convenience */
@@ -150,6 +156,7 @@ typedef struct {
 extern int Timidity_Init(const char *config_file);
 extern int Timidity_Init_NoConfig(void);
 extern void Timidity_SetVolume(MidiSong *song, int volume);
+extern void Timidity_SetInterpolation(MidiSong *song, int mode);
 extern int Timidity_PlaySome(MidiSong *song, void *stream, Sint32 len);
 extern MidiSong *Timidity_LoadSong(SDL_RWops *rw, SDL_AudioSpec *audio);
 extern void Timidity_Start(MidiSong *song);
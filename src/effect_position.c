@@ -28,10 +28,21 @@
 #include "SDL_mixer.h"
 
 #include "mixer.h"
+#include "mix_command.h"
 
 #define MIX_INTERNAL_EFFECT__
 #include "effects_internal.h"
 
+#if !defined(MIXERX_DISABLE_SIMD) && (SDL_BYTEORDER == SDL_LIL_ENDIAN)
+#   if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#       define EFF_POSITION_SSE2
+#       include <emmintrin.h>
+#   elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+#       define EFF_POSITION_NEON
+#       include <arm_neon.h>
+#   endif
+#endif
+
 /* profile code:
     #include <sys/time.h>
     #include <unistd.h>
@@ -75,6 +86,10 @@ typedef struct _Eff_positionargs
 static position_args **pos_args_array = NULL;
 static position_args *pos_args_global = NULL;
 static int position_channels = 0;
+/* Guards the pointers above against the lock-free lookups of the setters,
+   they are changed under the audio lock too. The arguments themselves
+   stay allocated until deinit, so the found ones never go away. */
+static SDL_SpinLock pos_args_lock = 0;
 
 extern void _Mix_SetMusicPositionArgs(Mix_Music *mus, position_args *args);
 extern position_args *_Mix_GetMusicPositionArgs(Mix_Music *mus);
@@ -82,6 +97,8 @@ extern position_args *_Mix_GetMusicPositionArgs(Mix_Music *mus);
 void _Eff_PositionDeinit(void)
 {
     int i;
+
+    SDL_AtomicLock(&pos_args_lock);
     for (i = 0; i < position_channels; i++) {
         SDL_free(pos_args_array[i]);
     }
@@ -92,24 +109,18 @@ void _Eff_PositionDeinit(void)
     pos_args_global = NULL;
     SDL_free(pos_args_array);
     pos_args_array = NULL;
+    SDL_AtomicUnlock(&pos_args_lock);
 }
 
 
-/* This just frees up the callback-specific data. */
+/* The callback-specific data is kept for the next registration, as this
+   runs at the audio thread too, when the channel finishes playing. */
 static void SDLCALL _Eff_PositionDone(int channel, void *udata)
 {
-    (void)udata;
+    position_args *args = (position_args *)udata;
+    (void)channel;
 
-    if (channel < 0) {
-        if (pos_args_global != NULL) {
-            SDL_free(pos_args_global);
-            pos_args_global = NULL;
-        }
-    }
-    else if (pos_args_array[channel] != NULL) {
-        SDL_free(pos_args_array[channel]);
-        pos_args_array[channel] = NULL;
-    }
+    args->in_use = 0;
 }
 
 /* This just frees up the callback-specific data. */
@@ -1597,6 +1608,306 @@ static void SDLCALL _Eff_position_f32sys_c6(int chan, void *stream, int len, voi
     }
 }
 
+/*
+ * Vectorized versions of the native-endian 16/32-bit integer and float
+ *  stereo and 5.1 routines. They are producing exactly the same output
+ *  as the scalar ones above: the same two multiplications are done in the
+ *  same order and the result is truncated the same way. Frames that don't
+ *  fill a whole vector, and the rotated 5.1 rooms are passed to the scalar
+ *  routines.
+ */
+#if defined(EFF_POSITION_SSE2) || defined(EFF_POSITION_NEON)
+#define EFF_POSITION_SIMD
+
+#if defined(EFF_POSITION_SSE2)
+typedef __m128 eff_v4f;
+
+static SDL_INLINE eff_v4f eff_v4f_set(float a, float b, float c, float d)
+{
+    return _mm_setr_ps(a, b, c, d);
+}
+
+static SDL_INLINE eff_v4f eff_v4f_gain(eff_v4f v, eff_v4f gain, eff_v4f dist)
+{
+    return _mm_mul_ps(_mm_mul_ps(v, gain), dist);
+}
+
+static SDL_INLINE eff_v4f eff_v4f_load(const float *src)
+{
+    return _mm_loadu_ps(src);
+}
+
+static SDL_INLINE void eff_v4f_store(float *dst, eff_v4f v)
+{
+    _mm_storeu_ps(dst, v);
+}
+
+static SDL_INLINE eff_v4f eff_s32x4_load(const Sint32 *src)
+{
+    return _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i *)src));
+}
+
+static SDL_INLINE void eff_s32x4_store(Sint32 *dst, eff_v4f v)
+{
+    _mm_storeu_si128((__m128i *)dst, _mm_cvttps_epi32(v));
+}
+
+static SDL_INLINE void eff_s16x8_load(const Sint16 *src, eff_v4f *lo, eff_v4f *hi)
+{
+    __m128i v = _mm_loadu_si128((const __m128i *)src);
+    *lo = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16));
+    *hi = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16));
+}
+
+static SDL_INLINE void eff_s16x8_store(Sint16 *dst, eff_v4f lo, eff_v4f hi)
+{
+    _mm_storeu_si128((__m128i *)dst, _mm_packs_epi32(_mm_cvttps_epi32(lo), _mm_cvttps_epi32(hi)));
+}
+
+#elif defined(EFF_POSITION_NEON)
+typedef float32x4_t eff_v4f;
+
+static SDL_INLINE eff_v4f eff_v4f_set(float a, float b, float c, float d)
+{
+    float v[4];
+    v[0] = a; v[1] = b; v[2] = c; v[3] = d;
+    return vld1q_f32(v);
+}
+
+static SDL_INLINE eff_v4f eff_v4f_gain(eff_v4f v, eff_v4f gain, eff_v4f dist)
+{
+    return vmulq_f32(vmulq_f32(v, gain), dist);
+}
+
+static SDL_INLINE eff_v4f eff_v4f_load(const float *src)
+{
+    return vld1q_f32(src);
+}
+
+static SDL_INLINE void eff_v4f_store(float *dst, eff_v4f v)
+{
+    vst1q_f32(dst, v);
+}
+
+static SDL_INLINE eff_v4f eff_s32x4_load(const Sint32 *src)
+{
+    return vcvtq_f32_s32(vld1q_s32((const int32_t *)src));
+}
+
+static SDL_INLINE void eff_s32x4_store(Sint32 *dst, eff_v4f v)
+{
+    vst1q_s32((int32_t *)dst, vcvtq_s32_f32(v));
+}
+
+static SDL_INLINE void eff_s16x8_load(const Sint16 *src, eff_v4f *lo, eff_v4f *hi)
+{
+    int16x8_t v = vld1q_s16((const int16_t *)src);
+    *lo = vcvtq_f32_s32(vmovl_s16(vget_low_s16(v)));
+    *hi = vcvtq_f32_s32(vmovl_s16(vget_high_s16(v)));
+}
+
+static SDL_INLINE void eff_s16x8_store(Sint16 *dst, eff_v4f lo, eff_v4f hi)
+{
+    vst1q_s16((int16_t *)dst, vcombine_s16(vqmovn_s32(vcvtq_s32_f32(lo)), vqmovn_s32(vcvtq_s32_f32(hi))));
+}
+#endif
+
+static SDL_bool _Eff_position_has_simd(void)
+{
+#if defined(EFF_POSITION_SSE2)
+    return SDL_HasSSE2();
+#else
+    return SDL_HasNEON();
+#endif
+}
+
+static void SDLCALL _Eff_position_s16lsb_simd(int chan, void *stream, int len, void *udata)
+{
+    /* 16 signed bits (lsb) * 2 channels, 4 frames at once. */
+    position_args *args = (position_args *)udata;
+    Sint16 *ptr = (Sint16 *) stream;
+    const eff_v4f dist = eff_v4f_set(args->distance_f, args->distance_f, args->distance_f, args->distance_f);
+    const eff_v4f gain = eff_v4f_set(args->left_f, args->right_f, args->left_f, args->right_f);
+    eff_v4f lo, hi;
+    int i, vec_len;
+
+    if (args->room_angle == 180) {
+        _Eff_position_s16lsb(chan, stream, len, udata);
+        return;
+    }
+
+    vec_len = len - (len % (int)(sizeof(Sint16) * 8));
+
+    for (i = 0; i < vec_len; i += sizeof(Sint16) * 8) {
+        eff_s16x8_load(ptr, &lo, &hi);
+        eff_s16x8_store(ptr, eff_v4f_gain(lo, gain, dist), eff_v4f_gain(hi, gain, dist));
+        ptr += 8;
+    }
+
+    if (len > vec_len) {
+        _Eff_position_s16lsb(chan, ptr, len - vec_len, udata);
+    }
+}
+
+static void SDLCALL _Eff_position_s16lsb_c6_simd(int chan, void *stream, int len, void *udata)
+{
+    /* 16 signed bits (lsb) * 6 channels, 4 frames at once. */
+    position_args *args = (position_args *)udata;
+    Sint16 *ptr = (Sint16 *) stream;
+    const float d = args->distance_f;
+    const eff_v4f dist = eff_v4f_set(d, d, d, d);
+    const eff_v4f gain0 = eff_v4f_set(args->left_f, args->right_f, args->left_rear_f, args->right_rear_f);
+    const eff_v4f gain1 = eff_v4f_set(args->center_f, args->lfe_f, args->left_f, args->right_f);
+    const eff_v4f gain2 = eff_v4f_set(args->left_rear_f, args->right_rear_f, args->center_f, args->lfe_f);
+    eff_v4f v0, v1, v2, v3, v4, v5;
+    int i, vec_len;
+
+    if (args->room_angle != 0) {
+        _Eff_position_s16lsb_c6(chan, stream, len, udata);
+        return;
+    }
+
+    vec_len = len - (len % (int)(sizeof(Sint16) * 24));
+
+    for (i = 0; i < vec_len; i += sizeof(Sint16) * 24) {
+        eff_s16x8_load(ptr +  0, &v0, &v1);
+        eff_s16x8_load(ptr +  8, &v2, &v3);
+        eff_s16x8_load(ptr + 16, &v4, &v5);
+        eff_s16x8_store(ptr +  0, eff_v4f_gain(v0, gain0, dist), eff_v4f_gain(v1, gain1, dist));
+        eff_s16x8_store(ptr +  8, eff_v4f_gain(v2, gain2, dist), eff_v4f_gain(v3, gain0, dist));
+        eff_s16x8_store(ptr + 16, eff_v4f_gain(v4, gain1, dist), eff_v4f_gain(v5, gain2, dist));
+        ptr += 24;
+    }
+
+    if (len > vec_len) {
+        _Eff_position_s16lsb_c6(chan, ptr, len - vec_len, udata);
+    }
+}
+
+static void SDLCALL _Eff_position_s32lsb_simd(int chan, void *stream, int len, void *udata)
+{
+    /* 32 signed bits (lsb) * 2 channels, 2 frames at once. */
+    position_args *args = (position_args *)udata;
+    Sint32 *ptr = (Sint32 *) stream;
+    const eff_v4f dist = eff_v4f_set(args->distance_f, args->distance_f, args->distance_f, args->distance_f);
+    const eff_v4f gain = eff_v4f_set(args->left_f, args->right_f, args->left_f, args->right_f);
+    int i, vec_len;
+
+    if (args->room_angle == 180) {
+        _Eff_position_s32lsb(chan, stream, len, udata);
+        return;
+    }
+
+    vec_len = len - (len % (int)(sizeof(Sint32) * 4));
+
+    for (i = 0; i < vec_len; i += sizeof(Sint32) * 4) {
+        eff_s32x4_store(ptr, eff_v4f_gain(eff_s32x4_load(ptr), gain, dist));
+        ptr += 4;
+    }
+
+    if (len > vec_len) {
+        _Eff_position_s32lsb(chan, ptr, len - vec_len, udata);
+    }
+}
+
+static void SDLCALL _Eff_position_s32lsb_c6_simd(int chan, void *stream, int len, void *udata)
+{
+    /* 32 signed bits (lsb) * 6 channels, 2 frames at once. */
+    position_args *args = (position_args *)udata;
+    Sint32 *ptr = (Sint32 *) stream;
+    const float d = args->distance_f;
+    const eff_v4f dist = eff_v4f_set(d, d, d, d);
+    const eff_v4f gain0 = eff_v4f_set(args->left_f, args->right_f, args->left_rear_f, args->right_rear_f);
+    const eff_v4f gain1 = eff_v4f_set(args->center_f, args->lfe_f, args->left_f, args->right_f);
+    const eff_v4f gain2 = eff_v4f_set(args->left_rear_f, args->right_rear_f, args->center_f, args->lfe_f);
+    int i, vec_len;
+
+    if (args->room_angle != 0) {
+        _Eff_position_s32lsb_c6(chan, stream, len, udata);
+        return;
+    }
+
+    vec_len = len - (len % (int)(sizeof(Sint32) * 12));
+
+    for (i = 0; i < vec_len; i += sizeof(Sint32) * 12) {
+        eff_s32x4_store(ptr + 0, eff_v4f_gain(eff_s32x4_load(ptr + 0), gain0, dist));
+        eff_s32x4_store(ptr + 4, eff_v4f_gain(eff_s32x4_load(ptr + 4), gain1, dist));
+        eff_s32x4_store(ptr + 8, eff_v4f_gain(eff_s32x4_load(ptr + 8), gain2, dist));
+        ptr += 12;
+    }
+
+    if (len > vec_len) {
+        _Eff_position_s32lsb_c6(chan, ptr, len - vec_len, udata);
+    }
+}
+
+static void SDLCALL _Eff_position_f32sys_simd(int chan, void *stream, int len, void *udata)
+{
+    /* float * 2 channels, 2 frames at once. */
+    position_args *args = (position_args *)udata;
+    float *ptr = (float *) stream;
+    const eff_v4f dist = eff_v4f_set(args->distance_f, args->distance_f, args->distance_f, args->distance_f);
+    const eff_v4f gain = eff_v4f_set(args->left_f, args->right_f, args->left_f, args->right_f);
+    int i, vec_len;
+
+    vec_len = len - (len % (int)(sizeof(float) * 4));
+
+    for (i = 0; i < vec_len; i += sizeof(float) * 4) {
+        eff_v4f_store(ptr, eff_v4f_gain(eff_v4f_load(ptr), gain, dist));
+        ptr += 4;
+    }
+
+    if (len > vec_len) {
+        _Eff_position_f32sys(chan, ptr, len - vec_len, udata);
+    }
+}
+
+static void SDLCALL _Eff_position_f32sys_c6_simd(int chan, void *stream, int len, void *udata)
+{
+    /* float * 6 channels, 2 frames at once. */
+    position_args *args = (position_args *)udata;
+    float *ptr = (float *) stream;
+    const float d = args->distance_f;
+    const eff_v4f dist = eff_v4f_set(d, d, d, d);
+    const eff_v4f gain0 = eff_v4f_set(args->left_f, args->right_f, args->left_rear_f, args->right_rear_f);
+    const eff_v4f gain1 = eff_v4f_set(args->center_f, args->lfe_f, args->left_f, args->right_f);
+    const eff_v4f gain2 = eff_v4f_set(args->left_rear_f, args->right_rear_f, args->center_f, args->lfe_f);
+    int i, vec_len;
+
+    if (args->room_angle != 0) {
+        _Eff_position_f32sys_c6(chan, stream, len, udata);
+        return;
+    }
+
+    vec_len = len - (len % (int)(sizeof(float) * 12));
+
+    for (i = 0; i < vec_len; i += sizeof(float) * 12) {
+        eff_v4f_store(ptr + 0, eff_v4f_gain(eff_v4f_load(ptr + 0), gain0, dist));
+        eff_v4f_store(ptr + 4, eff_v4f_gain(eff_v4f_load(ptr + 4), gain1, dist));
+        eff_v4f_store(ptr + 8, eff_v4f_gain(eff_v4f_load(ptr + 8), gain2, dist));
+        ptr += 12;
+    }
+
+    if (len > vec_len) {
+        _Eff_position_f32sys_c6(chan, ptr, len - vec_len, udata);
+    }
+}
+#endif /* EFF_POSITION_SIMD */
+
+/* Vectorized routines are used when the CPU supports them, and they weren't
+ *  disabled with the MIX_EFFECTSDISABLESIMD environment variable. */
+static SDL_bool _Eff_position_use_simd = SDL_FALSE;
+
+void _Eff_PositionInit(void)
+{
+#if defined(EFF_POSITION_SIMD)
+    _Eff_position_use_simd = (SDL_getenv(MIX_EFFECTSDISABLESIMD) == NULL) && _Eff_position_has_simd();
+#else
+    _Eff_position_use_simd = SDL_FALSE;
+#endif
+}
+
+
 static void init_position_args(position_args *args)
 {
     SDL_memset(args, '\0', sizeof(position_args));
@@ -1609,18 +1920,25 @@ static void init_position_args(position_args *args)
     Mix_QuerySpec(NULL, NULL, (int *) &args->channels);
 }
 
+/* Must be called with the audio lock held */
 static position_args *get_position_arg(int channel)
 {
+    position_args *args;
     void *rc;
     int i;
 
     if (channel < 0) {
         if (pos_args_global == NULL) {
-            pos_args_global = SDL_malloc(sizeof(position_args));
-            if (pos_args_global == NULL) {
+            args = SDL_malloc(sizeof(position_args));
+            if (args == NULL) {
                 Mix_OutOfMemory();
                 return NULL;
             }
+            init_position_args(args);
+            SDL_AtomicLock(&pos_args_lock);
+            pos_args_global = args;
+            SDL_AtomicUnlock(&pos_args_lock);
+        } else if (!pos_args_global->in_use) {
             init_position_args(pos_args_global);
         }
 
@@ -1628,8 +1946,10 @@ static position_args *get_position_arg(int channel)
     }
 
     if (channel >= position_channels) {
+        SDL_AtomicLock(&pos_args_lock);
         rc = SDL_realloc(pos_args_array, (size_t)(channel + 1) * sizeof(position_args *));
         if (rc == NULL) {
+            SDL_AtomicUnlock(&pos_args_lock);
             Mix_OutOfMemory();
             return NULL;
         }
@@ -1638,20 +1958,44 @@ static position_args *get_position_arg(int channel)
             pos_args_array[i] = NULL;
         }
         position_channels = channel + 1;
+        SDL_AtomicUnlock(&pos_args_lock);
     }
 
     if (pos_args_array[channel] == NULL) {
-        pos_args_array[channel] = (position_args *)SDL_malloc(sizeof(position_args));
-        if (pos_args_array[channel] == NULL) {
+        args = (position_args *)SDL_malloc(sizeof(position_args));
+        if (args == NULL) {
             Mix_OutOfMemory();
             return NULL;
         }
+        init_position_args(args);
+        SDL_AtomicLock(&pos_args_lock);
+        pos_args_array[channel] = args;
+        SDL_AtomicUnlock(&pos_args_lock);
+    } else if (!pos_args_array[channel]->in_use) {
+        /* Left from the effect which got done, start over as a new one */
         init_position_args(pos_args_array[channel]);
     }
 
     return pos_args_array[channel];
 }
 
+/* The arguments of the registered effect of the channel, or NULL. Never
+   allocates, it's used without the audio lock and by the audio thread. */
+static position_args *find_position_arg(int channel)
+{
+    position_args *args = NULL;
+
+    SDL_AtomicLock(&pos_args_lock);
+    if (channel < 0) {
+        args = pos_args_global;
+    } else if (channel < position_channels) {
+        args = pos_args_array[channel];
+    }
+    SDL_AtomicUnlock(&pos_args_lock);
+
+    return (args && args->in_use) ? args : NULL;
+}
+
 
 static position_args *get_music_position_arg(Mix_Music *mus)
 {
@@ -1737,12 +2081,22 @@ static Mix_EffectFunc_t get_position_effect_func(Uint16 format, int channels)
             case 1:
             case 2:
                 f = _Eff_position_s16lsb;
+#if defined(EFF_POSITION_SIMD)
+                if (_Eff_position_use_simd) {
+                    f = _Eff_position_s16lsb_simd;
+                }
+#endif
                 break;
             case 4:
                 f = _Eff_position_s16lsb_c4;
                 break;
             case 6:
                 f = _Eff_position_s16lsb_c6;
+#if defined(EFF_POSITION_SIMD)
+                if (_Eff_position_use_simd) {
+                    f = _Eff_position_s16lsb_c6_simd;
+                }
+#endif
                 break;
             default:
                 Mix_SetError("Unsupported audio channels");
@@ -1809,12 +2163,22 @@ static Mix_EffectFunc_t get_position_effect_func(Uint16 format, int channels)
             case 1:
             case 2:
                 f = _Eff_position_s32lsb;
+#if defined(EFF_POSITION_SIMD)
+                if (_Eff_position_use_simd) {
+                    f = _Eff_position_s32lsb_simd;
+                }
+#endif
                 break;
             case 4:
                 f = _Eff_position_s32lsb_c4;
                 break;
             case 6:
                 f = _Eff_position_s32lsb_c6;
+#if defined(EFF_POSITION_SIMD)
+                if (_Eff_position_use_simd) {
+                    f = _Eff_position_s32lsb_c6_simd;
+                }
+#endif
                 break;
             default:
                 Mix_SetError("Unsupported audio channels");
@@ -1827,12 +2191,22 @@ static Mix_EffectFunc_t get_position_effect_func(Uint16 format, int channels)
             case 1:
             case 2:
                 f = _Eff_position_f32sys;
+#if defined(EFF_POSITION_SIMD)
+                if (_Eff_position_use_simd) {
+                    f = _Eff_position_f32sys_simd;
+                }
+#endif
                 break;
             case 4:
                 f = _Eff_position_f32sys_c4;
                 break;
             case 6:
                 f = _Eff_position_f32sys_c6;
+#if defined(EFF_POSITION_SIMD)
+                if (_Eff_position_use_simd) {
+                    f = _Eff_position_f32sys_c6_simd;
+                }
+#endif
                 break;
             default:
                 Mix_SetError("Unsupported audio channels");
@@ -1884,6 +2258,14 @@ MUS_FUNCTION(_Eff_position_s32lsb_c6)
 MUS_FUNCTION(_Eff_position_f32sys)
 MUS_FUNCTION(_Eff_position_f32sys_c4)
 MUS_FUNCTION(_Eff_position_f32sys_c6)
+#if defined(EFF_POSITION_SIMD)
+MUS_FUNCTION(_Eff_position_s16lsb_simd)
+MUS_FUNCTION(_Eff_position_s16lsb_c6_simd)
+MUS_FUNCTION(_Eff_position_s32lsb_simd)
+MUS_FUNCTION(_Eff_position_s32lsb_c6_simd)
+MUS_FUNCTION(_Eff_position_f32sys_simd)
+MUS_FUNCTION(_Eff_position_f32sys_c6_simd)
+#endif
 
 #undef MUS_FUNCTION
 
@@ -1954,12 +2336,22 @@ static Mix_MusicEffectFunc_t get_music_position_effect_func(Uint16 format, int c
             case 1:
             case 2:
                 f = _Eff_position_s16lsb_mus;
+#if defined(EFF_POSITION_SIMD)
+                if (_Eff_position_use_simd) {
+                    f = _Eff_position_s16lsb_simd_mus;
+                }
+#endif
                 break;
             case 4:
                 f = _Eff_position_s16lsb_c4_mus;
                 break;
             case 6:
                 f = _Eff_position_s16lsb_c6_mus;
+#if defined(EFF_POSITION_SIMD)
+                if (_Eff_position_use_simd) {
+                    f = _Eff_position_s16lsb_c6_simd_mus;
+                }
+#endif
                 break;
             default:
                 Mix_SetError("Unsupported audio channels");
@@ -2026,12 +2418,22 @@ static Mix_MusicEffectFunc_t get_music_position_effect_func(Uint16 format, int c
             case 1:
             case 2:
                 f = _Eff_position_s32lsb_mus;
+#if defined(EFF_POSITION_SIMD)
+                if (_Eff_position_use_simd) {
+                    f = _Eff_position_s32lsb_simd_mus;
+                }
+#endif
                 break;
             case 4:
                 f = _Eff_position_s32lsb_c4_mus;
                 break;
             case 6:
                 f = _Eff_position_s32lsb_c6_mus;
+#if defined(EFF_POSITION_SIMD)
+                if (_Eff_position_use_simd) {
+                    f = _Eff_position_s32lsb_c6_simd_mus;
+                }
+#endif
                 break;
             default:
                 Mix_SetError("Unsupported audio channels");
@@ -2044,12 +2446,22 @@ static Mix_MusicEffectFunc_t get_music_position_effect_func(Uint16 format, int c
             case 1:
             case 2:
                 f = _Eff_position_f32sys_mus;
+#if defined(EFF_POSITION_SIMD)
+                if (_Eff_position_use_simd) {
+                    f = _Eff_position_f32sys_simd_mus;
+                }
+#endif
                 break;
             case 4:
                 f = _Eff_position_f32sys_c4_mus;
                 break;
             case 6:
                 f = _Eff_position_f32sys_c6_mus;
+#if defined(EFF_POSITION_SIMD)
+                if (_Eff_position_use_simd) {
+                    f = _Eff_position_f32sys_c6_simd_mus;
+                }
+#endif
                 break;
             default:
                 Mix_SetError("Unsupported audio channels");
@@ -2197,9 +2609,84 @@ static void set_amplitudes(Uint8 *speaker_amplitude, int channels, int angle, in
     speaker_amplitude[5] = 255;
 }
 
-DECLSPEC int MIXCALL Mix_SetPosition(int channel, Sint16 angle, Uint8 distance);
+/* The plain value updates, they never allocate, so they are run by the audio
+   thread for the effects which are registered already. */
+static void store_panning(position_args *args, Uint8 left, Uint8 right)
+{
+    args->left_u8 = left;
+    args->left_f = ((float) left) / 255.0f;
+    args->right_u8 = right;
+    args->right_f = ((float) right) / 255.0f;
+    args->room_angle = 0;
+}
+
+/* The distance is flipped already */
+static void store_distance(position_args *args, Uint8 distance)
+{
+    args->distance_u8 = distance;
+    args->distance_f = ((float) distance) / 255.0f;
+}
 
-int MIXCALLCC Mix_SetPanning(int channel, Uint8 left, Uint8 right)
+/* The angle is between 0 and 359, and the distance is flipped already */
+static void store_position(position_args *args, int channels, Sint16 angle, Uint8 distance)
+{
+    Uint8 speaker_amplitude[6];
+    Sint16 room_angle = 0;
+
+    if (channels == 2) {
+#if 0 /* Buggy code, makes position play at right speaker only. Gets been fixed when room_angle is always 0 */
+        if (angle > 180)
+            room_angle = 180; /* exchange left and right channels */
+        else room_angle = 0;
+#endif
+        /*FIXME: Verify this for correctness */
+        room_angle = 0;
+    }
+
+    if (channels == 4 || channels == 6) {
+        if (angle > 315) room_angle = 0;
+        else if (angle > 225) room_angle = 270;
+        else if (angle > 135) room_angle = 180;
+        else if (angle >  45) room_angle = 90;
+        else room_angle = 0;
+    }
+
+    set_amplitudes(speaker_amplitude, channels, angle, room_angle);
+
+    args->left_u8 = speaker_amplitude[0];
+    args->left_f = ((float) speaker_amplitude[0]) / 255.0f;
+    args->right_u8 = speaker_amplitude[1];
+    args->right_f = ((float) speaker_amplitude[1]) / 255.0f;
+    args->left_rear_u8 = speaker_amplitude[2];
+    args->left_rear_f = ((float) speaker_amplitude[2]) / 255.0f;
+    args->right_rear_u8 = speaker_amplitude[3];
+    args->right_rear_f = ((float) speaker_amplitude[3]) / 255.0f;
+    args->center_u8 = speaker_amplitude[4];
+    args->center_f = ((float) speaker_amplitude[4]) / 255.0f;
+    args->lfe_u8 = speaker_amplitude[5];
+    args->lfe_f = ((float) speaker_amplitude[5]) / 255.0f;
+    store_distance(args, distance);
+    args->room_angle = room_angle;
+}
+
+/* Converts the panning into the angle for the surround output */
+static Sint16 panning_angle(Uint8 left, Uint8 right)
+{
+    /* left = right = 255 => angle = 0, to unregister effect as when channels = 2 */
+    /* left = 255 =>  angle = -90;  left = 0 => angle = +89 */
+    int angle = 0;
+    if ((left != 255) || (right != 255)) {
+        angle = (int)left;
+        angle = 127 - angle;
+        angle = -angle;
+        angle = angle * 90 / 128; /* Make it larger for more effect? */
+    }
+    return (Sint16)angle;
+}
+
+static int set_position(int channel, Sint16 angle, Uint8 distance);
+
+static int set_panning(int channel, Uint8 left, Uint8 right)
 {
     Mix_EffectFunc_t f = NULL;
     int channels;
@@ -2213,16 +2700,7 @@ int MIXCALLCC Mix_SetPanning(int channel, Uint8 left, Uint8 right)
         return 1;
 
     if (channels > 2) {
-        /* left = right = 255 => angle = 0, to unregister effect as when channels = 2 */
-        /* left = 255 =>  angle = -90;  left = 0 => angle = +89 */
-        int angle = 0;
-        if ((left != 255) || (right != 255)) {
-            angle = (int)left;
-            angle = 127 - angle;
-            angle = -angle;
-            angle = angle * 90 / 128; /* Make it larger for more effect? */
-        }
-        return Mix_SetPosition(channel, angle, 0);
+        return set_position(channel, panning_angle(left, right), 0);
     }
 
     f = get_position_effect_func(format, channels);
@@ -2248,11 +2726,7 @@ int MIXCALLCC Mix_SetPanning(int channel, Uint8 left, Uint8 right)
         }
     }
 
-    args->left_u8 = left;
-    args->left_f = ((float) left) / 255.0f;
-    args->right_u8 = right;
-    args->right_f = ((float) right) / 255.0f;
-    args->room_angle = 0;
+    store_panning(args, left, right);
 
     if (!args->in_use) {
         args->in_use = 1;
@@ -2264,7 +2738,7 @@ int MIXCALLCC Mix_SetPanning(int channel, Uint8 left, Uint8 right)
 }
 
 
-int MIXCALLCC Mix_SetDistance(int channel, Uint8 distance)
+static int set_distance(int channel, Uint8 distance)
 {
     Mix_EffectFunc_t f = NULL;
     Uint16 format;
@@ -2298,8 +2772,7 @@ int MIXCALLCC Mix_SetDistance(int channel, Uint8 distance)
         }
     }
 
-    args->distance_u8 = distance;
-    args->distance_f = ((float) distance) / 255.0f;
+    store_distance(args, distance);
     if (!args->in_use) {
         args->in_use = 1;
         retval = _Mix_RegisterEffect_locked(channel, f, _Eff_PositionDone, (void *) args);
@@ -2310,14 +2783,12 @@ int MIXCALLCC Mix_SetDistance(int channel, Uint8 distance)
 }
 
 
-int MIXCALLCC Mix_SetPosition(int channel, Sint16 angle, Uint8 distance)
+static int set_position(int channel, Sint16 angle, Uint8 distance)
 {
-    Uint8 speaker_amplitude[6];
     Mix_EffectFunc_t f = NULL;
     Uint16 format;
     int channels;
     position_args *args = NULL;
-    Sint16 room_angle = 0;
     int retval = 1;
 
     Mix_QuerySpec(NULL, &format, &channels);
@@ -2348,43 +2819,9 @@ int MIXCALLCC Mix_SetPosition(int channel, Sint16 angle, Uint8 distance)
         }
     }
 
-    if (channels == 2) {
-#if 0 /* Buggy code, makes position play at right speaker only. Gets been fixed when room_angle is always 0 */
-        if (angle > 180)
-            room_angle = 180; /* exchange left and right channels */
-        else room_angle = 0;
-#endif
-        /*FIXME: Verify this for correctness */
-        room_angle = 0;
-    }
-
-    if (channels == 4 || channels == 6) {
-        if (angle > 315) room_angle = 0;
-        else if (angle > 225) room_angle = 270;
-        else if (angle > 135) room_angle = 180;
-        else if (angle >  45) room_angle = 90;
-        else room_angle = 0;
-    }
-
     distance = 255 - distance;  /* flip it to scale Mix_SetDistance() uses. */
 
-    set_amplitudes(speaker_amplitude, channels, angle, room_angle);
-
-    args->left_u8 = speaker_amplitude[0];
-    args->left_f = ((float) speaker_amplitude[0]) / 255.0f;
-    args->right_u8 = speaker_amplitude[1];
-    args->right_f = ((float) speaker_amplitude[1]) / 255.0f;
-    args->left_rear_u8 = speaker_amplitude[2];
-    args->left_rear_f = ((float) speaker_amplitude[2]) / 255.0f;
-    args->right_rear_u8 = speaker_amplitude[3];
-    args->right_rear_f = ((float) speaker_amplitude[3]) / 255.0f;
-    args->center_u8 = speaker_amplitude[4];
-    args->center_f = ((float) speaker_amplitude[4]) / 255.0f;
-    args->lfe_u8 = speaker_amplitude[5];
-    args->lfe_f = ((float) speaker_amplitude[5]) / 255.0f;
-    args->distance_u8 = distance;
-    args->distance_f = ((float) distance) / 255.0f;
-    args->room_angle = room_angle;
+    store_position(args, channels, angle, distance);
     if (!args->in_use) {
         args->in_use = 1;
         retval = _Mix_RegisterEffect_locked(channel, f, _Eff_PositionDone, (void *) args);
@@ -2394,6 +2831,122 @@ int MIXCALLCC Mix_SetPosition(int channel, Sint16 angle, Uint8 distance)
     return retval;
 }
 
+/* Positions of the channels are applied by the audio thread, so checking all
+   what can fail there, as the result can't be returned from it */
+static int position_command_valid(int channel)
+{
+    Uint16 format;
+    int channels;
+
+    Mix_QuerySpec(NULL, &format, &channels);
+    if (get_position_effect_func(format, channels) == NULL) {
+        return 0;
+    }
+
+    if (channel != MIX_CHANNEL_POST && (channel < 0 || channel >= Mix_AllocateChannels(-1))) {
+        Mix_SetError("Invalid channel number");
+        return 0;
+    }
+
+    return 1;
+}
+
+/* The commands only update the values of the registered effects, as the
+   audio thread must not allocate. The effect of a channel which finished
+   playing in the meantime got dropped, and so is the late update. */
+static void panning_command(const Mix_Command *cmd)
+{
+    position_args *args = find_position_arg(cmd->which);
+    if (args) {
+        store_panning(args, (Uint8)cmd->arg1, (Uint8)cmd->arg2);
+    }
+}
+
+static void distance_command(const Mix_Command *cmd)
+{
+    position_args *args = find_position_arg(cmd->which);
+    if (args) {
+        store_distance(args, (Uint8)cmd->arg1);
+    }
+}
+
+static void position_command(const Mix_Command *cmd)
+{
+    position_args *args = find_position_arg(cmd->which);
+    if (args) {
+        store_position(args, args->channels, (Sint16)cmd->arg1, (Uint8)cmd->arg2);
+    }
+}
+
+int MIXCALLCC Mix_SetPanning(int channel, Uint8 left, Uint8 right)
+{
+    Mix_Command cmd;
+    int channels;
+
+    Mix_QuerySpec(NULL, NULL, &channels);
+    if (channels != 2 && channels != 4 && channels != 6)    /* it's a no-op; we call that successful. */
+        return 1;
+
+    if (!position_command_valid(channel))
+        return 0;
+
+    if (channels > 2)
+        return Mix_SetPosition(channel, panning_angle(left, right), 0);
+
+    /* Registering and unregistering of the effect are done under the lock */
+    if ((left == 255 && right == 255) || !find_position_arg(channel))
+        return set_panning(channel, left, right);
+
+    SDL_zero(cmd);
+    cmd.func = panning_command;
+    cmd.which = channel;
+    cmd.arg1 = left;
+    cmd.arg2 = right;
+    _Mix_RunCommand(&cmd);
+    return 1;
+}
+
+int MIXCALLCC Mix_SetDistance(int channel, Uint8 distance)
+{
+    Mix_Command cmd;
+
+    if (!position_command_valid(channel))
+        return 0;
+
+    if (distance == 0 || !find_position_arg(channel))
+        return set_distance(channel, distance);
+
+    SDL_zero(cmd);
+    cmd.func = distance_command;
+    cmd.which = channel;
+    cmd.arg1 = 255 - distance;  /* flip it to our scale. */
+    _Mix_RunCommand(&cmd);
+    return 1;
+}
+
+int MIXCALLCC Mix_SetPosition(int channel, Sint16 angle, Uint8 distance)
+{
+    Mix_Command cmd;
+
+    if (!position_command_valid(channel))
+        return 0;
+
+    /* make angle between 0 and 359. */
+    angle %= 360;
+    if (angle < 0) angle += 360;
+
+    if ((!distance && !angle) || !find_position_arg(channel))
+        return set_position(channel, angle, distance);
+
+    SDL_zero(cmd);
+    cmd.func = position_command;
+    cmd.which = channel;
+    cmd.arg1 = angle;
+    cmd.arg2 = 255 - distance;  /* flip it to scale Mix_SetDistance() uses. */
+    _Mix_RunCommand(&cmd);
+    return 1;
+}
+
 
 
 DECLSPEC int MIXCALL Mix_SetMusicEffectPosition(Mix_Music *mus, Sint16 angle, Uint8 distance);
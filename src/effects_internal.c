@@ -38,6 +38,7 @@ int _Mix_effects_max_speed = 0;
 void _Mix_InitEffects(void)
 {
     _Mix_effects_max_speed = (SDL_getenv(MIX_EFFECTSMAXSPEED) != NULL);
+    _Eff_PositionInit();
 }
 
 void _Mix_DeinitEffects(void)
@@ -35,6 +35,7 @@ void *_Eff_build_volume_table_s8(void);
 
 void _Mix_InitEffects(void);
 void _Mix_DeinitEffects(void);
+void _Eff_PositionInit(void);
 void _Eff_PositionDeinit(void);
 
 int _Mix_RegisterEffect_locked(int channel, Mix_EffectFunc_t f,
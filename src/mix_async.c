@@ -0,0 +1,547 @@
+/*
+  SDL_mixer:  An audio mixer library based on the SDL library
+  Copyright (C) 1997-2025 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "SDL.h"
+
+#include "SDL_mixer.h"
+#include "mixer.h"
+#include "music.h"
+#include "mix_async.h"
+
+struct Mix_AsyncLoad
+{
+    SDL_bool is_music;
+    SDL_RWops *src;
+    int freesrc;
+    char *file;
+    Mix_AsyncLoadCallback callback;
+    void *user_data;
+
+    Mix_AsyncLoadStatus status;
+    SDL_bool running;
+    SDL_bool cancelled;
+    SDL_bool in_callback;
+    SDL_bool released;  /* Finished or cancelled from inside the callback */
+    SDL_threadID callback_thread;
+    void *result;
+    char error[256];
+
+    struct Mix_AsyncLoad *next;
+};
+
+/* Loadings may be started by several threads at once, the pool is made once */
+static SDL_SpinLock async_init_lock = 0;
+static SDL_mutex *async_lock = NULL;
+static SDL_cond *async_work = NULL;
+static SDL_cond *async_done = NULL;
+static SDL_Thread *async_threads[MIX_ASYNC_MAX_THREADS];
+static int async_num_threads = 0;
+static int async_idle_threads = 0;
+static int async_queued = 0;
+static SDL_bool async_quit = SDL_FALSE;
+static Mix_AsyncLoad *async_queue_head = NULL;
+static Mix_AsyncLoad *async_queue_tail = NULL;
+
+/* Once the pool got been stopped, no thread touches handles anymore */
+static void async_lock_pool(void)
+{
+    if (async_lock) {
+        SDL_LockMutex(async_lock);
+    }
+}
+
+static void async_unlock_pool(void)
+{
+    if (async_lock) {
+        SDL_UnlockMutex(async_lock);
+    }
+}
+
+static void async_free_result(Mix_AsyncLoad *load, void *result)
+{
+    if (!result) {
+        return;
+    }
+    if (load->is_music) {
+        Mix_FreeMusic((Mix_Music *)result);
+    } else {
+        Mix_FreeChunk((Mix_Chunk *)result);
+    }
+}
+
+static void async_free_load(Mix_AsyncLoad *load)
+{
+    SDL_free(load->file);
+    SDL_free(load);
+}
+
+/* Store the result and notify everyone who waits for it */
+static void async_complete(Mix_AsyncLoad *load, void *result)
+{
+    Mix_AsyncLoadCallback callback;
+    Mix_AsyncLoadStatus status = result ? MIX_ASYNC_DONE : MIX_ASYNC_FAILED;
+
+    if (!result) {
+        SDL_strlcpy(load->error, Mix_GetError(), sizeof(load->error));
+    }
+
+    async_lock_pool();
+    if (load->cancelled) {
+        async_unlock_pool();
+        async_free_result(load, result);
+        async_free_load(load);
+        return;
+    }
+
+    load->result = result;
+    load->in_callback = SDL_TRUE;
+    load->callback_thread = SDL_ThreadID();
+    callback = load->callback;
+    async_unlock_pool();
+
+    if (callback) {
+        callback(load, status, load->user_data);
+    }
+
+    async_lock_pool();
+    load->in_callback = SDL_FALSE;
+    if (load->released || load->cancelled) {
+        async_unlock_pool();
+        async_free_result(load, load->result);
+        async_free_load(load);
+        return;
+    }
+    load->running = SDL_FALSE;
+    load->status = status;
+    if (async_done) {
+        SDL_CondBroadcast(async_done);
+    }
+    async_unlock_pool();
+}
+
+static void *async_run(Mix_AsyncLoad *load)
+{
+    if (load->is_music) {
+        if (load->file) {
+            return Mix_LoadMUS(load->file);
+        }
+        return Mix_LoadMUS_RW(load->src, load->freesrc);
+    }
+    return Mix_LoadWAV_RW(load->src, load->freesrc);
+}
+
+static int SDLCALL async_thread(void *data)
+{
+    Mix_AsyncLoad *load;
+
+    (void)data;
+
+    SDL_LockMutex(async_lock);
+    for (;;) {
+        ++async_idle_threads;
+        while (!async_queue_head && !async_quit) {
+            SDL_CondWait(async_work, async_lock);
+        }
+        --async_idle_threads;
+
+        if (async_quit) {
+            break;
+        }
+
+        load = async_queue_head;
+        --async_queued;
+        async_queue_head = load->next;
+        if (!async_queue_head) {
+            async_queue_tail = NULL;
+        }
+        load->next = NULL;
+        load->running = SDL_TRUE;
+        SDL_UnlockMutex(async_lock);
+
+        async_complete(load, async_run(load));
+
+        SDL_LockMutex(async_lock);
+    }
+    SDL_UnlockMutex(async_lock);
+
+    return 0;
+}
+
+static SDL_bool async_init(void)
+{
+    SDL_mutex *lock;
+    SDL_bool ret = SDL_TRUE;
+
+    /* Musics can't be loaded at once without the locks of the codecs */
+    if (!_Mix_HasMusicCreateLocks()) {
+        return SDL_FALSE;
+    }
+
+    SDL_AtomicLock(&async_init_lock);
+    if (!async_lock) {
+        lock = SDL_CreateMutex();
+        async_work = SDL_CreateCond();
+        async_done = SDL_CreateCond();
+        if (!lock || !async_work || !async_done) {
+            if (lock) {
+                SDL_DestroyMutex(lock);
+            }
+            if (async_work) {
+                SDL_DestroyCond(async_work);
+                async_work = NULL;
+            }
+            if (async_done) {
+                SDL_DestroyCond(async_done);
+                async_done = NULL;
+            }
+            ret = SDL_FALSE;
+        } else {
+            async_quit = SDL_FALSE;
+            async_lock = lock; /* Made the last, it tells that the pool is ready */
+        }
+    }
+    SDL_AtomicUnlock(&async_init_lock);
+
+    return ret;
+}
+
+static Mix_AsyncLoad *async_start(Mix_AsyncLoad *load)
+{
+    int max_threads = SDL_GetCPUCount();
+    SDL_Thread *thread;
+
+    if (max_threads > MIX_ASYNC_MAX_THREADS) {
+        max_threads = MIX_ASYNC_MAX_THREADS;
+    }
+
+    load->status = MIX_ASYNC_LOADING;
+
+    if (!async_init()) {
+        /* No threads? Just load it right now */
+        load->running = SDL_TRUE;
+        async_complete(load, async_run(load));
+        return load;
+    }
+
+    SDL_LockMutex(async_lock);
+    if (async_queue_tail) {
+        async_queue_tail->next = load;
+    } else {
+        async_queue_head = load;
+    }
+    async_queue_tail = load;
+    ++async_queued;
+
+    if (async_queued > async_idle_threads && async_num_threads < max_threads) {
+        thread = SDL_CreateThread(async_thread, "MixerXLoader", NULL);
+        if (thread) {
+            async_threads[async_num_threads++] = thread;
+        }
+    }
+
+    if (async_num_threads == 0) {
+        /* No threads? Just load it right now */
+        async_queue_head = async_queue_tail = NULL;
+        async_queued = 0;
+        load->running = SDL_TRUE;
+        SDL_UnlockMutex(async_lock);
+        async_complete(load, async_run(load));
+        return load;
+    }
+
+    SDL_CondSignal(async_work);
+    SDL_UnlockMutex(async_lock);
+
+    return load;
+}
+
+static Mix_AsyncLoad *async_new(SDL_bool is_music, Mix_AsyncLoadCallback callback, void *user_data)
+{
+    Mix_AsyncLoad *load = (Mix_AsyncLoad *)SDL_calloc(1, sizeof(Mix_AsyncLoad));
+
+    if (!load) {
+        Mix_OutOfMemory();
+        return NULL;
+    }
+
+    load->is_music = is_music;
+    load->callback = callback;
+    load->user_data = user_data;
+    return load;
+}
+
+Mix_AsyncLoad * MIXCALLCC Mix_LoadWAVAsync_RW(SDL_RWops *src, int freesrc, Mix_AsyncLoadCallback callback, void *user_data)
+{
+    Mix_AsyncLoad *load;
+    Uint8 magic[4];
+
+    if (!src) {
+        Mix_SetError("Mix_LoadWAVAsync_RW with NULL src");
+        return NULL;
+    }
+
+    load = async_new(SDL_FALSE, callback, user_data);
+    if (!load) {
+        if (freesrc) {
+            SDL_RWclose(src);
+        }
+        return NULL;
+    }
+
+    /* Compressed formats are decoded through music interfaces, make them ready here */
+    if (SDL_RWread(src, magic, 1, 4) == 4) {
+        SDL_RWseek(src, -4, RW_SEEK_CUR);
+        if (SDL_memcmp(magic, "WAVE", 4) != 0 && SDL_memcmp(magic, "RIFF", 4) != 0 &&
+            SDL_memcmp(magic, "FORM", 4) != 0 && SDL_memcmp(magic, "Crea", 4) != 0) {
+            _Mix_PrepareMusicRW(src, MUS_NONE, NULL);
+        }
+    }
+
+    load->src = src;
+    load->freesrc = freesrc;
+    return async_start(load);
+}
+
+Mix_AsyncLoad * MIXCALLCC Mix_LoadWAVAsync(const char *file, Mix_AsyncLoadCallback callback, void *user_data)
+{
+    SDL_RWops *src = _Mix_RWFromFile(file, "rb");
+
+    if (!src) {
+        return NULL;
+    }
+
+    return Mix_LoadWAVAsync_RW(src, 1, callback, user_data);
+}
+
+Mix_AsyncLoad * MIXCALLCC Mix_LoadMUSAsync_RW(SDL_RWops *src, int freesrc, Mix_AsyncLoadCallback callback, void *user_data)
+{
+    Mix_AsyncLoad *load;
+
+    if (!src) {
+        Mix_SetError("RWops pointer is NULL");
+        return NULL;
+    }
+
+    load = async_new(SDL_TRUE, callback, user_data);
+    if (!load) {
+        if (freesrc) {
+            SDL_RWclose(src);
+        }
+        return NULL;
+    }
+
+    _Mix_PrepareMusicRW(src, MUS_NONE, NULL);
+
+    load->src = src;
+    load->freesrc = freesrc;
+    return async_start(load);
+}
+
+Mix_AsyncLoad * MIXCALLCC Mix_LoadMUSAsync(const char *file, Mix_AsyncLoadCallback callback, void *user_data)
+{
+    Mix_AsyncLoad *load;
+
+    if (!file) {
+        Mix_SetError("Null filename!");
+        return NULL;
+    }
+
+    load = async_new(SDL_TRUE, callback, user_data);
+    if (!load) {
+        return NULL;
+    }
+
+    load->file = SDL_strdup(file);
+    if (!load->file) {
+        Mix_OutOfMemory();
+        async_free_load(load);
+        return NULL;
+    }
+
+    _Mix_PrepareMusicFile(file);
+
+    return async_start(load);
+}
+
+Mix_AsyncLoadStatus MIXCALLCC Mix_GetAsyncLoadStatus(Mix_AsyncLoad *load)
+{
+    Mix_AsyncLoadStatus status;
+
+    if (!load) {
+        Mix_SetError("Invalid loading handle");
+        return MIX_ASYNC_FAILED;
+    }
+
+    async_lock_pool();
+    status = load->status;
+    async_unlock_pool();
+
+    return status;
+}
+
+static void *async_finish(Mix_AsyncLoad *load, SDL_bool is_music)
+{
+    void *result;
+
+    if (!load) {
+        Mix_SetError("Invalid loading handle");
+        return NULL;
+    }
+
+    if (load->is_music != is_music) {
+        Mix_SetError(is_music ? "This handle is loading a chunk" : "This handle is loading a music");
+        return NULL;
+    }
+
+    async_lock_pool();
+    if (load->in_callback && load->callback_thread == SDL_ThreadID()) {
+        /* Called from the callback, the loader thread frees the handle */
+        result = load->result;
+        load->result = NULL;
+        load->released = SDL_TRUE;
+        async_unlock_pool();
+        if (!result) {
+            Mix_SetError("%s", load->error);
+        }
+        return result;
+    }
+
+    while (load->status == MIX_ASYNC_LOADING) {
+        SDL_CondWait(async_done, async_lock);
+    }
+    async_unlock_pool();
+
+    result = load->result;
+    if (!result) {
+        Mix_SetError("%s", load->error);
+    }
+    async_free_load(load);
+
+    return result;
+}
+
+Mix_Chunk * MIXCALLCC Mix_FinishLoadWAVAsync(Mix_AsyncLoad *load)
+{
+    return (Mix_Chunk *)async_finish(load, SDL_FALSE);
+}
+
+Mix_Music * MIXCALLCC Mix_FinishLoadMUSAsync(Mix_AsyncLoad *load)
+{
+    return (Mix_Music *)async_finish(load, SDL_TRUE);
+}
+
+void MIXCALLCC Mix_CancelAsyncLoad(Mix_AsyncLoad *load)
+{
+    Mix_AsyncLoad **it;
+
+    if (!load) {
+        return;
+    }
+
+    async_lock_pool();
+    if (load->status == MIX_ASYNC_LOADING && !load->running) {
+        /* Still queued */
+        for (it = &async_queue_head; *it; it = &(*it)->next) {
+            if (*it == load) {
+                *it = load->next;
+                --async_queued;
+                break;
+            }
+        }
+        async_queue_tail = NULL;
+        for (it = &async_queue_head; *it; it = &(*it)->next) {
+            async_queue_tail = *it;
+        }
+        async_unlock_pool();
+        if (load->src && load->freesrc) {
+            SDL_RWclose(load->src);
+        }
+        async_free_load(load);
+        return;
+    }
+
+    if (load->status == MIX_ASYNC_LOADING) {
+        if (load->in_callback && load->callback_thread == SDL_ThreadID()) {
+            /* Called from the callback */
+            load->released = SDL_TRUE;
+        } else {
+            /* The loader thread drops it once done */
+            load->cancelled = SDL_TRUE;
+        }
+        async_unlock_pool();
+        return;
+    }
+    async_unlock_pool();
+
+    async_free_result(load, load->result);
+    async_free_load(load);
+}
+
+void _Mix_AsyncQuit(void)
+{
+    Mix_AsyncLoad *queued, *load;
+    int i;
+
+    if (!async_lock) {
+        return;
+    }
+
+    SDL_LockMutex(async_lock);
+    async_quit = SDL_TRUE;
+    queued = async_queue_head;
+    async_queue_head = async_queue_tail = NULL;
+    async_queued = 0;
+    for (load = queued; load; load = load->next) {
+        load->running = SDL_TRUE;
+    }
+    SDL_CondBroadcast(async_work);
+    SDL_UnlockMutex(async_lock);
+
+    /* Let running loadings finish */
+    for (i = 0; i < async_num_threads; ++i) {
+        SDL_WaitThread(async_threads[i], NULL);
+        async_threads[i] = NULL;
+    }
+    async_num_threads = 0;
+    async_idle_threads = 0;
+
+    while (queued) {
+        load = queued;
+        queued = queued->next;
+        load->next = NULL;
+        if (load->src && load->freesrc) {
+            SDL_RWclose(load->src);
+        }
+        Mix_SetError("Audio device has been closed");
+        async_complete(load, NULL);
+    }
+
+    SDL_AtomicLock(&async_init_lock);
+    SDL_DestroyCond(async_work);
+    async_work = NULL;
+    SDL_DestroyCond(async_done);
+    async_done = NULL;
+    SDL_DestroyMutex(async_lock);
+    async_lock = NULL;
+    SDL_AtomicUnlock(&async_init_lock);
+}
+
+/* vi: set ts=4 sw=4 expandtab: */
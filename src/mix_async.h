@@ -0,0 +1,35 @@
+/*
+  SDL_mixer:  An audio mixer library based on the SDL library
+  Copyright (C) 1997-2025 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef MIX_ASYNC_H_
+#define MIX_ASYNC_H_
+
+/* Pool of threads loading chunks and musics at background */
+
+/* Maximum number of the loader threads */
+#define MIX_ASYNC_MAX_THREADS   4
+
+/* Finish all running loadings, fail queued ones, and stop the threads */
+extern void _Mix_AsyncQuit(void);
+
+#endif /* MIX_ASYNC_H_ */
+
+/* vi: set ts=4 sw=4 expandtab: */
@@ -0,0 +1,287 @@
+/*
+  SDL_mixer:  An audio mixer library based on the SDL library
+  Copyright (C) 1997-2025 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "SDL_mixer.h"
+#include "mixer.h"
+#include "mix_bank_cache.h"
+
+#if defined(__linux__) || defined(__APPLE__) || defined(__FreeBSD__) || \
+    defined(__NetBSD__) || defined(__OpenBSD__) || defined(__DragonFly__)
+#define MIX_HAVE_STAT
+#include <sys/types.h>
+#include <sys/stat.h>
+#endif
+
+typedef struct Mix_BankCacheEntry {
+    const char *kind;
+    char *key;
+    Uint64 stamp;
+    void *object;
+    Sint64 size;
+    int refcount;
+    SDL_bool exclusive;
+    SDL_bool stale;
+    Mix_BankCacheFreeCb free_object;
+    struct Mix_BankCacheEntry *next;
+} Mix_BankCacheEntry;
+
+static Mix_BankCacheEntry *bank_cache = NULL;
+static SDL_SpinLock bank_cache_lock = 0;
+
+/* Entries are unlinked under the lock, but destroyed out of it */
+static void free_entries(Mix_BankCacheEntry *e)
+{
+    Mix_BankCacheEntry *next;
+
+    while (e) {
+        next = e->next;
+        e->free_object(e->object);
+        SDL_free(e->key);
+        SDL_free(e);
+        e = next;
+    }
+}
+
+static void bank_data_free(void *object)
+{
+    SDL_free(object);
+}
+
+/* Get the modification time and the size of a regular file, where the platform has stat() */
+static SDL_bool file_stat(const char *path, Uint64 *mtime, Sint64 *size)
+{
+#ifdef MIX_HAVE_STAT
+    struct stat st;
+
+    if (stat(path, &st) == 0 && S_ISREG(st.st_mode)) {
+        *mtime = (Uint64)st.st_mtime;
+        *size = (Sint64)st.st_size;
+        return SDL_TRUE;
+    }
+#else
+    (void)path;
+    (void)mtime;
+    (void)size;
+#endif
+    return SDL_FALSE;
+}
+
+Uint64 _Mix_BankCacheFileStamp(const char *path, Sint64 *size)
+{
+    Uint64 stamp = 0;
+    Sint64 fsize = -1;
+
+    if (!file_stat(path, &stamp, &fsize)) {
+        /* No stat() here or not a regular file (maybe it's served by the
+           custom file opener), the size is the only stamp then */
+        SDL_RWops *rw = _Mix_RWFromFile(path, "rb");
+        if (rw) {
+            fsize = SDL_RWsize(rw);
+            SDL_RWclose(rw);
+        }
+    }
+
+    if (fsize > 0) {
+        stamp = stamp * 31 + (Uint64)fsize;
+        if (size) {
+            *size += fsize;
+        }
+    }
+
+    return stamp;
+}
+
+void *_Mix_BankCacheAcquire(const char *kind, const char *key, Uint64 stamp, Sint64 *size)
+{
+    Mix_BankCacheEntry **it, *e, *dead = NULL;
+    void *object = NULL;
+
+    SDL_AtomicLock(&bank_cache_lock);
+    it = &bank_cache;
+    while ((e = *it) != NULL) {
+        if (e->stale || SDL_strcmp(e->kind, kind) != 0 || SDL_strcmp(e->key, key) != 0) {
+            it = &e->next;
+            continue;
+        }
+
+        if (e->stamp != stamp) {
+            /* The file got been changed since it was cached */
+            e->stale = SDL_TRUE;
+            if (e->refcount == 0) {
+                *it = e->next;
+                e->next = dead;
+                dead = e;
+                continue;
+            }
+        } else if (!e->exclusive || e->refcount == 0) {
+            e->refcount++;
+            object = e->object;
+            if (size) {
+                *size = e->size;
+            }
+            break;
+        }
+
+        it = &e->next;
+    }
+    SDL_AtomicUnlock(&bank_cache_lock);
+
+    free_entries(dead);
+
+    return object;
+}
+
+int _Mix_BankCacheInsert(const char *kind, const char *key, Uint64 stamp,
+                         void *object, Sint64 size, SDL_bool exclusive,
+                         Mix_BankCacheFreeCb free_object)
+{
+    Mix_BankCacheEntry *e = (Mix_BankCacheEntry *)SDL_calloc(1, sizeof(Mix_BankCacheEntry));
+
+    if (!e || !(e->key = SDL_strdup(key))) {
+        SDL_free(e);
+        return SDL_OutOfMemory();
+    }
+
+    e->kind = kind;
+    e->stamp = stamp;
+    e->object = object;
+    e->size = size;
+    e->refcount = 1;
+    e->exclusive = exclusive;
+    e->stale = SDL_FALSE;
+    e->free_object = free_object;
+
+    SDL_AtomicLock(&bank_cache_lock);
+    e->next = bank_cache;
+    bank_cache = e;
+    SDL_AtomicUnlock(&bank_cache_lock);
+
+    return 0;
+}
+
+void _Mix_BankCacheRelease(void *object)
+{
+    Mix_BankCacheEntry **it, *e, *o, *dead = NULL;
+
+    if (!object) {
+        return;
+    }
+
+    SDL_AtomicLock(&bank_cache_lock);
+    for (it = &bank_cache; (e = *it) != NULL; it = &e->next) {
+        if (e->object != object) {
+            continue;
+        }
+
+        if (--e->refcount > 0) {
+            break;
+        }
+
+        if (!e->stale && e->exclusive) {
+            /* Keep just one unused exclusive entry per key */
+            for (o = bank_cache; o; o = o->next) {
+                if (o != e && !o->stale && o->refcount == 0 && o->stamp == e->stamp &&
+                    SDL_strcmp(o->kind, e->kind) == 0 && SDL_strcmp(o->key, e->key) == 0) {
+                    e->stale = SDL_TRUE;
+                    break;
+                }
+            }
+        }
+
+        if (e->stale) {
+            *it = e->next;
+            e->next = NULL;
+            dead = e;
+        }
+        break;
+    }
+    SDL_AtomicUnlock(&bank_cache_lock);
+
+    free_entries(dead);
+}
+
+void *_Mix_BankCacheLoadRW(const char *kind, const char *path, SDL_RWops *src, size_t *size)
+{
+    Uint64 stamp = _Mix_BankCacheFileStamp(path, NULL);
+    Sint64 cached_size = 0;
+    void *data;
+
+    data = _Mix_BankCacheAcquire(kind, path, stamp, &cached_size);
+    if (data) {
+        SDL_RWclose(src);
+        *size = (size_t)cached_size;
+        return data;
+    }
+
+    data = SDL_LoadFile_RW(src, size, SDL_TRUE);
+    if (!data) {
+        return NULL;
+    }
+
+    if (_Mix_BankCacheInsert(kind, path, stamp, data, (Sint64)*size, SDL_FALSE, bank_data_free) < 0) {
+        SDL_free(data);
+        return NULL;
+    }
+
+    return data;
+}
+
+void _Mix_BankCacheFlush(const char *kind)
+{
+    Mix_BankCacheEntry **it, *e, *dead = NULL;
+
+    SDL_AtomicLock(&bank_cache_lock);
+    it = &bank_cache;
+    while ((e = *it) != NULL) {
+        if (kind && SDL_strcmp(e->kind, kind) != 0) {
+            it = &e->next;
+            continue;
+        }
+
+        e->stale = SDL_TRUE;
+        if (e->refcount == 0) {
+            *it = e->next;
+            e->next = dead;
+            dead = e;
+        } else {
+            it = &e->next;
+        }
+    }
+    SDL_AtomicUnlock(&bank_cache_lock);
+
+    free_entries(dead);
+}
+
+Sint64 _Mix_BankCacheMemory(void)
+{
+    Mix_BankCacheEntry *e;
+    Sint64 total = 0;
+
+    SDL_AtomicLock(&bank_cache_lock);
+    for (e = bank_cache; e; e = e->next) {
+        total += e->size;
+    }
+    SDL_AtomicUnlock(&bank_cache_lock);
+
+    return total;
+}
+
+/* vi: set ts=4 sw=4 expandtab: */
@@ -0,0 +1,69 @@
+/*
+  SDL_mixer:  An audio mixer library based on the SDL library
+  Copyright (C) 1997-2025 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef MIX_BANK_CACHE_H_
+#define MIX_BANK_CACHE_H_
+
+/* Process-wide cache of the MIDI banks and SoundFonts shared between
+   music objects. Entries are looked up by the codec kind and by a key
+   (usually a file path), and are invalidated once the stamp (size of files
+   behind the key, and their modification time where the platform has
+   stat()) got been changed.
+
+   Shared entries (the bank file data) may be used by any number of music
+   objects at once. Exclusive entries (like a synthesizer with SoundFonts
+   loaded) are handed to one user at time and get back into the cache
+   being released. Unused entries are kept until they got been evicted. */
+
+#include "SDL_stdinc.h"
+#include "SDL_rwops.h"
+
+typedef void (*Mix_BankCacheFreeCb)(void *object);
+
+/* Get the stamp of the file, and add the file size to 'size' when given */
+extern Uint64 _Mix_BankCacheFileStamp(const char *path, Sint64 *size);
+
+/* Find an entry and reference it, returns NULL if nothing found */
+extern void *_Mix_BankCacheAcquire(const char *kind, const char *key, Uint64 stamp, Sint64 *size);
+
+/* Put the new entry being referenced once, returns -1 on out of memory (the
+   object is still owned by the caller then) */
+extern int _Mix_BankCacheInsert(const char *kind, const char *key, Uint64 stamp,
+                                void *object, Sint64 size, SDL_bool exclusive,
+                                Mix_BankCacheFreeCb free_object);
+
+/* Unreference the object which was got by Acquire or put by Insert */
+extern void _Mix_BankCacheRelease(void *object);
+
+/* Get the data of the bank file from the cache, or load it into the cache.
+   The 'src' gets always closed. Release the result once finished. */
+extern void *_Mix_BankCacheLoadRW(const char *kind, const char *path, SDL_RWops *src, size_t *size);
+
+/* Free all unused entries of the kind (or of all kinds if NULL), entries are
+   still in use will be freed once released */
+extern void _Mix_BankCacheFlush(const char *kind);
+
+/* Total size of all cached entries in bytes */
+extern Sint64 _Mix_BankCacheMemory(void);
+
+#endif /* MIX_BANK_CACHE_H_ */
+
+/* vi: set ts=4 sw=4 expandtab: */
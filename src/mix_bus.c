@@ -0,0 +1,273 @@
+/*
+  SDL_mixer:  An audio mixer library based on the SDL library
+  Copyright (C) 1997-2025 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "SDL.h"
+
+#include "mix_bus.h"
+
+void _Mix_BusAccumulate(float *bus, const Uint8 *src, SDL_AudioFormat format, int samples, float gain)
+{
+    int i;
+
+    switch (format) {
+    case AUDIO_U8:
+        gain /= 128.0f;
+        for (i = 0; i < samples; ++i) {
+            bus[i] += (float)((int)src[i] - 128) * gain;
+        }
+        break;
+
+    case AUDIO_S8:
+        gain /= 128.0f;
+        for (i = 0; i < samples; ++i) {
+            bus[i] += (float)((const Sint8 *)src)[i] * gain;
+        }
+        break;
+
+    case AUDIO_S16LSB:
+        gain /= 32768.0f;
+        for (i = 0; i < samples; ++i) {
+            bus[i] += (float)((Sint16)SDL_SwapLE16(((const Uint16 *)src)[i])) * gain;
+        }
+        break;
+
+    case AUDIO_S16MSB:
+        gain /= 32768.0f;
+        for (i = 0; i < samples; ++i) {
+            bus[i] += (float)((Sint16)SDL_SwapBE16(((const Uint16 *)src)[i])) * gain;
+        }
+        break;
+
+    case AUDIO_U16LSB:
+        gain /= 32768.0f;
+        for (i = 0; i < samples; ++i) {
+            bus[i] += (float)((int)SDL_SwapLE16(((const Uint16 *)src)[i]) - 32768) * gain;
+        }
+        break;
+
+    case AUDIO_U16MSB:
+        gain /= 32768.0f;
+        for (i = 0; i < samples; ++i) {
+            bus[i] += (float)((int)SDL_SwapBE16(((const Uint16 *)src)[i]) - 32768) * gain;
+        }
+        break;
+
+    case AUDIO_S32LSB:
+        gain /= 2147483648.0f;
+        for (i = 0; i < samples; ++i) {
+            bus[i] += (float)((Sint32)SDL_SwapLE32(((const Uint32 *)src)[i])) * gain;
+        }
+        break;
+
+    case AUDIO_S32MSB:
+        gain /= 2147483648.0f;
+        for (i = 0; i < samples; ++i) {
+            bus[i] += (float)((Sint32)SDL_SwapBE32(((const Uint32 *)src)[i])) * gain;
+        }
+        break;
+
+    case AUDIO_F32LSB:
+        for (i = 0; i < samples; ++i) {
+            bus[i] += SDL_SwapFloatLE(((const float *)src)[i]) * gain;
+        }
+        break;
+
+    case AUDIO_F32MSB:
+        for (i = 0; i < samples; ++i) {
+            bus[i] += SDL_SwapFloatBE(((const float *)src)[i]) * gain;
+        }
+        break;
+
+    default:
+        break;
+    }
+}
+
+/* Keeps the signal untouched below the knee and bends it smoothly towards
+   the full scale above it, the curve has no breaks at the knee point */
+static SDL_INLINE float soft_clip(float x)
+{
+    const float range = 1.0f - MIX_BUS_SOFTCLIP_KNEE;
+    float t;
+
+    if (x > MIX_BUS_SOFTCLIP_KNEE) {
+        t = (x - MIX_BUS_SOFTCLIP_KNEE) / range;
+        return MIX_BUS_SOFTCLIP_KNEE + range * (t / (1.0f + t));
+    } else if (x < -MIX_BUS_SOFTCLIP_KNEE) {
+        t = (-x - MIX_BUS_SOFTCLIP_KNEE) / range;
+        return -MIX_BUS_SOFTCLIP_KNEE - range * (t / (1.0f + t));
+    }
+
+    return x;
+}
+
+void _Mix_BusConvert(Uint8 *dst, const float *bus, SDL_AudioFormat format, int samples)
+{
+    int i;
+
+    switch (format) {
+    case AUDIO_U8:
+        for (i = 0; i < samples; ++i) {
+            dst[i] = (Uint8)((int)(soft_clip(bus[i]) * 127.0f) + 128);
+        }
+        break;
+
+    case AUDIO_S8:
+        for (i = 0; i < samples; ++i) {
+            ((Sint8 *)dst)[i] = (Sint8)(soft_clip(bus[i]) * 127.0f);
+        }
+        break;
+
+    case AUDIO_S16LSB:
+        for (i = 0; i < samples; ++i) {
+            ((Uint16 *)dst)[i] = SDL_SwapLE16((Uint16)(Sint16)(soft_clip(bus[i]) * 32767.0f));
+        }
+        break;
+
+    case AUDIO_S16MSB:
+        for (i = 0; i < samples; ++i) {
+            ((Uint16 *)dst)[i] = SDL_SwapBE16((Uint16)(Sint16)(soft_clip(bus[i]) * 32767.0f));
+        }
+        break;
+
+    case AUDIO_U16LSB:
+        for (i = 0; i < samples; ++i) {
+            ((Uint16 *)dst)[i] = SDL_SwapLE16((Uint16)((int)(soft_clip(bus[i]) * 32767.0f) + 32768));
+        }
+        break;
+
+    case AUDIO_U16MSB:
+        for (i = 0; i < samples; ++i) {
+            ((Uint16 *)dst)[i] = SDL_SwapBE16((Uint16)((int)(soft_clip(bus[i]) * 32767.0f) + 32768));
+        }
+        break;
+
+    case AUDIO_S32LSB:
+        for (i = 0; i < samples; ++i) {
+            ((Uint32 *)dst)[i] = SDL_SwapLE32((Uint32)(Sint32)((double)soft_clip(bus[i]) * 2147483647.0));
+        }
+        break;
+
+    case AUDIO_S32MSB:
+        for (i = 0; i < samples; ++i) {
+            ((Uint32 *)dst)[i] = SDL_SwapBE32((Uint32)(Sint32)((double)soft_clip(bus[i]) * 2147483647.0));
+        }
+        break;
+
+    case AUDIO_F32LSB:
+        for (i = 0; i < samples; ++i) {
+            ((float *)dst)[i] = SDL_SwapFloatLE(soft_clip(bus[i]));
+        }
+        break;
+
+    case AUDIO_F32MSB:
+        for (i = 0; i < samples; ++i) {
+            ((float *)dst)[i] = SDL_SwapFloatBE(soft_clip(bus[i]));
+        }
+        break;
+
+    default:
+        break;
+    }
+}
+
+#define RAMP_LOOP(type, read, write) \
+    for (f = 0; f < frames; ++f) { \
+        for (c = 0; c < channels; ++c, ++i) { \
+            ((type *)buf)[i] = write(read(((type *)buf)[i]) * gain); \
+        } \
+        gain = exponential ? (gain * step) : (gain + step); \
+        gain = SDL_clamp(gain, 0.0f, 1.0f); \
+    }
+
+#define RAMP_U8_R(x)        ((float)((int)(x) - 128))
+#define RAMP_U8_W(x)        ((Uint8)((int)(x) + 128))
+#define RAMP_S8_R(x)        ((float)(x))
+#define RAMP_S8_W(x)        ((Sint8)(x))
+#define RAMP_S16LSB_R(x)    ((float)(Sint16)SDL_SwapLE16(x))
+#define RAMP_S16LSB_W(x)    SDL_SwapLE16((Uint16)(Sint16)(x))
+#define RAMP_S16MSB_R(x)    ((float)(Sint16)SDL_SwapBE16(x))
+#define RAMP_S16MSB_W(x)    SDL_SwapBE16((Uint16)(Sint16)(x))
+#define RAMP_U16LSB_R(x)    ((float)((int)SDL_SwapLE16(x) - 32768))
+#define RAMP_U16LSB_W(x)    SDL_SwapLE16((Uint16)((int)(x) + 32768))
+#define RAMP_U16MSB_R(x)    ((float)((int)SDL_SwapBE16(x) - 32768))
+#define RAMP_U16MSB_W(x)    SDL_SwapBE16((Uint16)((int)(x) + 32768))
+#define RAMP_S32LSB_R(x)    ((double)(Sint32)SDL_SwapLE32(x))
+#define RAMP_S32LSB_W(x)    SDL_SwapLE32((Uint32)(Sint32)(x))
+#define RAMP_S32MSB_R(x)    ((double)(Sint32)SDL_SwapBE32(x))
+#define RAMP_S32MSB_W(x)    SDL_SwapBE32((Uint32)(Sint32)(x))
+
+void _Mix_ApplyGainRamp(Uint8 *buf, SDL_AudioFormat format, int channels, int frames,
+                        float gain, float step, SDL_bool exponential)
+{
+    int f, c, i = 0;
+
+    gain = SDL_clamp(gain, 0.0f, 1.0f);
+
+    switch (format) {
+    case AUDIO_U8:
+        RAMP_LOOP(Uint8, RAMP_U8_R, RAMP_U8_W)
+        break;
+
+    case AUDIO_S8:
+        RAMP_LOOP(Sint8, RAMP_S8_R, RAMP_S8_W)
+        break;
+
+    case AUDIO_S16LSB:
+        RAMP_LOOP(Uint16, RAMP_S16LSB_R, RAMP_S16LSB_W)
+        break;
+
+    case AUDIO_S16MSB:
+        RAMP_LOOP(Uint16, RAMP_S16MSB_R, RAMP_S16MSB_W)
+        break;
+
+    case AUDIO_U16LSB:
+        RAMP_LOOP(Uint16, RAMP_U16LSB_R, RAMP_U16LSB_W)
+        break;
+
+    case AUDIO_U16MSB:
+        RAMP_LOOP(Uint16, RAMP_U16MSB_R, RAMP_U16MSB_W)
+        break;
+
+    case AUDIO_S32LSB:
+        RAMP_LOOP(Uint32, RAMP_S32LSB_R, RAMP_S32LSB_W)
+        break;
+
+    case AUDIO_S32MSB:
+        RAMP_LOOP(Uint32, RAMP_S32MSB_R, RAMP_S32MSB_W)
+        break;
+
+    case AUDIO_F32LSB:
+        RAMP_LOOP(float, SDL_SwapFloatLE, SDL_SwapFloatLE)
+        break;
+
+    case AUDIO_F32MSB:
+        RAMP_LOOP(float, SDL_SwapFloatBE, SDL_SwapFloatBE)
+        break;
+
+    default:
+        break;
+    }
+}
+
+#undef RAMP_LOOP
+
+/* vi: set ts=4 sw=4 expandtab: */
@@ -0,0 +1,49 @@
+/*
+  SDL_mixer:  An audio mixer library based on the SDL library
+  Copyright (C) 1997-2025 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef MIX_BUS_H_
+#define MIX_BUS_H_
+
+/* Float32 mix bus: converting between the output format and the float
+   accumulator owned by the mixer */
+
+#include "SDL_stdinc.h"
+#include "SDL_audio.h"
+
+/* Samples above this level are softly compressed to fit the [-1..1] range */
+#define MIX_BUS_SOFTCLIP_KNEE   0.9f
+
+/* Convert 'samples' samples of 'format' into floats, scale them by 'gain',
+   and add them to the 'bus' */
+extern void _Mix_BusAccumulate(float *bus, const Uint8 *src, SDL_AudioFormat format, int samples, float gain);
+
+/* Soft-clip the 'bus' and write it to 'dst' as 'format' */
+extern void _Mix_BusConvert(Uint8 *dst, const float *bus, SDL_AudioFormat format, int samples);
+
+/* Scale 'frames' frames of 'format' in place by a gain changing per frame:
+   it starts from 'gain', and gets 'step' added (or multiplied by 'step' if
+   'exponential' is set) after every frame, staying within [0..1] */
+extern void _Mix_ApplyGainRamp(Uint8 *buf, SDL_AudioFormat format, int channels, int frames,
+                               float gain, float step, SDL_bool exponential);
+
+#endif /* MIX_BUS_H_ */
+
+/* vi: set ts=4 sw=4 expandtab: */
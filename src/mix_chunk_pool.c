@@ -0,0 +1,488 @@
+/*
+  SDL_mixer:  An audio mixer library based on the SDL library
+  Copyright (C) 1997-2025 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "SDL.h"
+
+#include "mixer.h"
+#include "music.h"
+#include "mix_mmap.h"
+#include "mix_chunk_pool.h"
+
+/* Most of decoded copies evicted at once while the lock is held */
+#define MIX_CHUNK_EVICT_BATCH   16
+
+typedef struct Mix_CompressedChunk {
+    Mix_Chunk chunk;            /* Must be the first */
+    const Uint8 *data;          /* The compressed file */
+    size_t size;
+    void *data_mem;             /* The heap copy of the file, if any */
+    SDL_RWops *data_src;        /* The mapped file, if any */
+    Mix_MusicInterface *interface;
+    Uint8 *pcm;                 /* The decoded copy, if cached */
+    int pcm_users;
+    SDL_bool capturing;
+    Uint64 last_used;
+    struct Mix_CompressedChunk *prev;
+    struct Mix_CompressedChunk *next;
+} Mix_CompressedChunk;
+
+struct Mix_ChunkVoice {
+    Mix_CompressedChunk *cc;
+    Mix_MusicInterface *interface;
+    void *music;
+    const Uint8 *pcm;           /* Plays the decoded copy when set */
+    Uint8 *buf;
+    int buf_size;
+    Uint8 *capture;             /* Records the decoded copy when set */
+    SDL_bool recorded;          /* The record got been completed */
+    int pos;
+    SDL_bool ended;
+    Mix_ChunkVoice *next;
+};
+
+static Mix_CompressedChunk *chunks = NULL;
+static Sint64 cache_budget = MIX_CHUNK_CACHE_DEFAULT;
+static Sint64 cache_used = 0;
+static Uint64 cache_clock = 0;
+static SDL_SpinLock chunks_lock = 0;
+
+/* Libraries which keep their state globally can't decode out of the audio thread */
+static SDL_bool decoder_needs_lock(Mix_MusicInterface *interface)
+{
+    return (interface->api == MIX_MUSIC_MODPLUG) ? SDL_TRUE : SDL_FALSE;
+}
+
+static void *open_decoder(Mix_CompressedChunk *cc)
+{
+    SDL_RWops *src = SDL_RWFromConstMem(cc->data, (int)cc->size);
+    void *music;
+
+    if (!src) {
+        return NULL;
+    }
+
+    _Mix_LockMusicCreate(cc->interface);
+    music = cc->interface->CreateFromRW(src, SDL_TRUE);
+    _Mix_UnlockMusicCreate(cc->interface);
+    if (!music) {
+        return NULL;
+    }
+
+    if (cc->interface->Play) {
+        if (decoder_needs_lock(cc->interface)) {
+            Mix_LockAudio();
+            cc->interface->Play(music, 1);
+            Mix_UnlockAudio();
+        } else {
+            cc->interface->Play(music, 1);
+        }
+    }
+
+    return music;
+}
+
+static void close_decoder(Mix_MusicInterface *interface, void *music)
+{
+    if (music) {
+        if (interface->Stop) {
+            interface->Stop(music);
+        }
+        interface->Delete(music);
+    }
+}
+
+/* Length of the decoded chunk in bytes: from the duration when it's known,
+   otherwise the whole chunk gets decoded once to count it */
+static Sint64 measure_chunk(Mix_MusicInterface *interface, void *music)
+{
+    int frame_size = (SDL_AUDIO_BITSIZE(music_spec.format) / 8) * music_spec.channels;
+    double duration = -1.0;
+    Sint64 len = 0;
+    Uint8 *buf;
+    int left;
+    SDL_bool locked;
+
+    if (interface->Duration) {
+        duration = interface->Duration(music);
+    }
+    if (duration > 0.0) {
+        return (Sint64)(duration * music_spec.freq + 0.5) * frame_size;
+    }
+
+    buf = (Uint8 *)SDL_malloc(music_spec.size);
+    if (!buf) {
+        return SDL_OutOfMemory();
+    }
+
+    locked = decoder_needs_lock(interface);
+    if (locked) {
+        Mix_LockAudio();
+    }
+
+    if (interface->Play) {
+        interface->Play(music, 1);
+    }
+    do {
+        left = interface->GetAudio(music, buf, (int)music_spec.size);
+        len += (int)music_spec.size - left;
+    } while (left == 0 && (!interface->IsPlaying || interface->IsPlaying(music)) && len < SDL_MAX_SINT32);
+
+    if (locked) {
+        Mix_UnlockAudio();
+    }
+
+    SDL_free(buf);
+
+    return len - (len % frame_size);
+}
+
+Mix_Chunk *_Mix_LoadCompressedChunk(SDL_RWops *src, int freesrc)
+{
+    Mix_CompressedChunk *cc;
+    Mix_MusicInterface *interface = NULL;
+    void *music;
+    Sint64 len;
+
+    cc = (Mix_CompressedChunk *)SDL_calloc(1, sizeof(Mix_CompressedChunk));
+    if (!cc) {
+        if (freesrc) {
+            SDL_RWclose(src);
+        }
+        Mix_OutOfMemory();
+        return NULL;
+    }
+
+    /* The mapped file is kept as is, anything else is copied into the heap */
+    if (freesrc && _Mix_RWIsMapped(src)) {
+        cc->data = (const Uint8 *)_Mix_LoadDataRW(src, &cc->size, &cc->data_mem);
+        cc->data_src = src;
+    } else {
+        cc->data_mem = SDL_LoadFile_RW(src, &cc->size, freesrc);
+        cc->data = (const Uint8 *)cc->data_mem;
+    }
+
+    if (!cc->data || cc->size > (size_t)SDL_MAX_SINT32) {
+        if (cc->data) {
+            Mix_SetError("The file is too big");
+        }
+        _Mix_FreeCompressedChunk(&cc->chunk);
+        SDL_free(cc);
+        return NULL;
+    }
+
+    music = _Mix_CreateChunkDecoder(SDL_RWFromConstMem(cc->data, (int)cc->size), SDL_TRUE, &interface);
+    if (!music) {
+        _Mix_FreeCompressedChunk(&cc->chunk);
+        SDL_free(cc);
+        return NULL;
+    }
+    cc->interface = interface;
+
+    len = measure_chunk(interface, music);
+    close_decoder(interface, music);
+
+    if (len <= 0 || len > SDL_MAX_SINT32) {
+        if (len == 0) {
+            Mix_SetError("No audio data");
+        } else if (len > 0) {
+            Mix_SetError("The chunk is too long");
+        }
+        _Mix_FreeCompressedChunk(&cc->chunk);
+        SDL_free(cc);
+        return NULL;
+    }
+
+    cc->chunk.allocated = MIX_CHUNK_COMPRESSED;
+    cc->chunk.abuf = NULL;
+    cc->chunk.alen = (Uint32)len;
+    cc->chunk.volume = MIX_MAX_VOLUME;
+
+    SDL_AtomicLock(&chunks_lock);
+    cc->next = chunks;
+    if (chunks) {
+        chunks->prev = cc;
+    }
+    chunks = cc;
+    SDL_AtomicUnlock(&chunks_lock);
+
+    return &cc->chunk;
+}
+
+void _Mix_FreeCompressedChunk(Mix_Chunk *chunk)
+{
+    Mix_CompressedChunk *cc = (Mix_CompressedChunk *)chunk;
+    Uint8 *pcm;
+
+    SDL_AtomicLock(&chunks_lock);
+    if (cc->prev) {
+        cc->prev->next = cc->next;
+    } else if (chunks == cc) {
+        chunks = cc->next;
+    }
+    if (cc->next) {
+        cc->next->prev = cc->prev;
+    }
+    cc->prev = cc->next = NULL;
+
+    pcm = cc->pcm;
+    if (pcm) {
+        cache_used -= cc->chunk.alen;
+        cc->pcm = NULL;
+    }
+    SDL_AtomicUnlock(&chunks_lock);
+
+    SDL_free(pcm);
+    if (cc->data_src) {
+        SDL_RWclose(cc->data_src);
+    }
+    SDL_free(cc->data_mem);
+}
+
+/* Drop the least recently played decoded copies until 'need' more bytes fit
+   the budget, returns SDL_FALSE if they won't fit */
+static SDL_bool evict_cache(Sint64 need)
+{
+    Uint8 *evicted[MIX_CHUNK_EVICT_BATCH];
+    Mix_CompressedChunk *cc, *oldest;
+    int i, count;
+    SDL_bool fits;
+
+    do {
+        count = 0;
+
+        SDL_AtomicLock(&chunks_lock);
+        while (cache_used + need > cache_budget && count < MIX_CHUNK_EVICT_BATCH) {
+            oldest = NULL;
+            for (cc = chunks; cc; cc = cc->next) {
+                if (cc->pcm && cc->pcm_users == 0 && (!oldest || cc->last_used < oldest->last_used)) {
+                    oldest = cc;
+                }
+            }
+            if (!oldest) {
+                break;
+            }
+            evicted[count++] = oldest->pcm;
+            cache_used -= oldest->chunk.alen;
+            oldest->pcm = NULL;
+        }
+        fits = (cache_used + need <= cache_budget);
+        SDL_AtomicUnlock(&chunks_lock);
+
+        for (i = 0; i < count; ++i) {
+            SDL_free(evicted[i]);
+        }
+    } while (!fits && count == MIX_CHUNK_EVICT_BATCH);
+
+    return fits;
+}
+
+Mix_ChunkVoice *_Mix_ChunkVoiceNew(Mix_Chunk *chunk)
+{
+    Mix_CompressedChunk *cc = (Mix_CompressedChunk *)chunk;
+    Mix_ChunkVoice *voice;
+    SDL_bool capture = SDL_FALSE;
+
+    voice = (Mix_ChunkVoice *)SDL_calloc(1, sizeof(Mix_ChunkVoice));
+    if (!voice) {
+        Mix_OutOfMemory();
+        return NULL;
+    }
+    voice->cc = cc;
+    voice->interface = cc->interface;
+
+    SDL_AtomicLock(&chunks_lock);
+    cc->last_used = ++cache_clock;
+    if (cc->pcm) {
+        voice->pcm = cc->pcm;
+        cc->pcm_users++;
+    } else if (!cc->capturing && (Sint64)chunk->alen <= cache_budget) {
+        cc->capturing = SDL_TRUE;
+        capture = SDL_TRUE;
+    }
+    SDL_AtomicUnlock(&chunks_lock);
+
+    if (voice->pcm) {
+        return voice;
+    }
+
+    /* Record the decoded copy while playing if it fits the cache */
+    if (capture) {
+        if (evict_cache(chunk->alen)) {
+            voice->capture = (Uint8 *)SDL_malloc(chunk->alen);
+        }
+        SDL_AtomicLock(&chunks_lock);
+        if (voice->capture) {
+            cache_used += chunk->alen;
+        } else {
+            cc->capturing = SDL_FALSE;
+        }
+        SDL_AtomicUnlock(&chunks_lock);
+    }
+
+    voice->buf_size = (int)music_spec.size;
+    voice->buf = (Uint8 *)SDL_malloc((size_t)voice->buf_size);
+    if (!voice->buf) {
+        Mix_OutOfMemory();
+        _Mix_ChunkVoiceFree(voice);
+        return NULL;
+    }
+
+    voice->music = open_decoder(cc);
+    if (!voice->music) {
+        _Mix_ChunkVoiceFree(voice);
+        return NULL;
+    }
+
+    return voice;
+}
+
+void _Mix_ChunkVoiceFree(Mix_ChunkVoice *voice)
+{
+    Mix_ChunkVoice *next;
+    Mix_CompressedChunk *cc;
+    Uint8 *capture;
+
+    while (voice) {
+        next = voice->next;
+        cc = voice->cc;
+        capture = voice->capture;
+
+        SDL_AtomicLock(&chunks_lock);
+        if (voice->pcm && voice->pcm != capture) {
+            cc->pcm_users--;
+        }
+        if (capture) {
+            cc->capturing = SDL_FALSE;
+            if (voice->recorded && !cc->pcm) {
+                /* Played through: the record is the decoded copy now */
+                cc->pcm = capture;
+                capture = NULL;
+            } else {
+                cache_used -= cc->chunk.alen;
+            }
+        }
+        SDL_AtomicUnlock(&chunks_lock);
+
+        SDL_free(capture);
+        close_decoder(voice->interface, voice->music);
+        SDL_free(voice->buf);
+        SDL_free(voice);
+
+        voice = next;
+    }
+}
+
+Mix_ChunkVoice *_Mix_ChunkVoiceLink(Mix_ChunkVoice *voice, Mix_ChunkVoice *list)
+{
+    if (!voice) {
+        return list;
+    }
+    voice->next = list;
+    return voice;
+}
+
+Uint8 *_Mix_ChunkVoiceRead(Mix_ChunkVoice *voice, int *len)
+{
+    int alen = (int)voice->cc->chunk.alen;
+    Uint8 *out;
+    int left;
+
+    if (*len > alen - voice->pos) {
+        *len = alen - voice->pos;
+    }
+
+    if (voice->pcm) {
+        out = (Uint8 *)voice->pcm + voice->pos;
+        voice->pos += *len;
+        return out;
+    }
+
+    if (*len > voice->buf_size) {
+        *len = voice->buf_size;
+    }
+
+    /* The length is estimated by the duration, so pad the short decoding */
+    left = voice->ended ? *len : voice->interface->GetAudio(voice->music, voice->buf, *len);
+    if (left > 0) {
+        SDL_memset(voice->buf + *len - left, music_spec.silence, (size_t)left);
+        voice->ended = SDL_TRUE;
+    }
+
+    if (voice->capture) {
+        SDL_memcpy(voice->capture + voice->pos, voice->buf, (size_t)*len);
+        voice->recorded = (voice->pos + *len == alen);
+    }
+    voice->pos += *len;
+
+    return voice->buf;
+}
+
+void _Mix_ChunkVoiceRewind(Mix_ChunkVoice *voice)
+{
+    if (voice->recorded) {
+        /* Next loops are played from the record */
+        voice->pcm = voice->capture;
+    } else if (!voice->pcm) {
+        /* Most decoders rewind by Play(), seek the rest explicitly */
+        if (voice->interface->Seek) {
+            voice->interface->Seek(voice->music, 0.0);
+        }
+        if (voice->interface->Play) {
+            voice->interface->Play(voice->music, 1);
+        }
+        voice->ended = (!voice->interface->Seek && !voice->interface->Play);
+    }
+    voice->pos = 0;
+}
+
+SDL_bool _Mix_ChunkIsCached(Mix_Chunk *chunk)
+{
+    Mix_CompressedChunk *cc = (Mix_CompressedChunk *)chunk;
+    SDL_bool cached;
+
+    SDL_AtomicLock(&chunks_lock);
+    cached = (cc->pcm != NULL) ? SDL_TRUE : SDL_FALSE;
+    SDL_AtomicUnlock(&chunks_lock);
+
+    return cached;
+}
+
+void _Mix_SetChunkCacheMemory(Sint64 bytes)
+{
+    SDL_AtomicLock(&chunks_lock);
+    cache_budget = (bytes > 0) ? bytes : 0;
+    SDL_AtomicUnlock(&chunks_lock);
+
+    evict_cache(0);
+}
+
+Sint64 _Mix_GetChunkCacheMemory(void)
+{
+    Sint64 bytes;
+
+    SDL_AtomicLock(&chunks_lock);
+    bytes = cache_budget;
+    SDL_AtomicUnlock(&chunks_lock);
+
+    return bytes;
+}
+
+/* vi: set ts=4 sw=4 expandtab: */
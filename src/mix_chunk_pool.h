@@ -0,0 +1,78 @@
+/*
+  SDL_mixer:  An audio mixer library based on the SDL library
+  Copyright (C) 1997-2025 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef MIX_CHUNK_POOL_H_
+#define MIX_CHUNK_POOL_H_
+
+/* Chunks which keep the compressed file in memory and get decoded by every
+   channel playing them. Chunks which got been played from the beginning to
+   the end are kept decoded in a cache limited by the memory budget, the
+   least recently played ones are dropped from it first. */
+
+#include "SDL_stdinc.h"
+#include "SDL_rwops.h"
+#include "SDL_mixer.h"
+
+/* The value of Mix_Chunk::allocated of the compressed chunks */
+#define MIX_CHUNK_COMPRESSED    4
+
+/* Default memory budget of the decoded chunks cache */
+#define MIX_CHUNK_CACHE_DEFAULT (8 * 1024 * 1024)
+
+/* The decoding state of a channel playing the compressed chunk */
+typedef struct Mix_ChunkVoice Mix_ChunkVoice;
+
+/* Load the compressed chunk, the audio must be opened */
+extern Mix_Chunk *_Mix_LoadCompressedChunk(SDL_RWops *src, int freesrc);
+
+/* Free the data of the compressed chunk except the Mix_Chunk itself, all
+   its voices must be freed before */
+extern void _Mix_FreeCompressedChunk(Mix_Chunk *chunk);
+
+/* Start playing the chunk from the beginning */
+extern Mix_ChunkVoice *_Mix_ChunkVoiceNew(Mix_Chunk *chunk);
+
+/* Free the voice and all voices linked after it by the 'next' */
+extern void _Mix_ChunkVoiceFree(Mix_ChunkVoice *voice);
+
+/* Link voices into the list to free them later */
+extern Mix_ChunkVoice *_Mix_ChunkVoiceLink(Mix_ChunkVoice *voice, Mix_ChunkVoice *list);
+
+/* Get up to 'len' next bytes of the chunk, 'len' gets set to the actual
+   amount. Runs at the audio thread. The voice buffers are allocated
+   beforehand, but the decoders may still allocate like they do for the
+   musics (the resampling stream once the rate differs, the buffers of the
+   OGG sections with a new format). */
+extern Uint8 *_Mix_ChunkVoiceRead(Mix_ChunkVoice *voice, int *len);
+
+/* Restart the voice from the beginning of the chunk, at the audio thread */
+extern void _Mix_ChunkVoiceRewind(Mix_ChunkVoice *voice);
+
+/* The chunk is kept decoded in the cache */
+extern SDL_bool _Mix_ChunkIsCached(Mix_Chunk *chunk);
+
+/* Memory budget of the decoded chunks cache, in bytes */
+extern void _Mix_SetChunkCacheMemory(Sint64 bytes);
+extern Sint64 _Mix_GetChunkCacheMemory(void);
+
+#endif /* MIX_CHUNK_POOL_H_ */
+
+/* vi: set ts=4 sw=4 expandtab: */
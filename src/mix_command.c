@@ -0,0 +1,104 @@
+/*
+  SDL_mixer:  An audio mixer library based on the SDL library
+  Copyright (C) 1997-2025 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "SDL_atomic.h"
+
+#include "mix_command.h"
+
+#define MIX_COMMAND_MASK    (MIX_COMMAND_QUEUE_SIZE - 1)
+
+/* The bounded queue where every slot knows the position it's ready for.
+   The sequence is stored relative to the slot index, so the zeroed slots
+   are ready for the first lap without initialization. */
+typedef struct Mix_CommandSlot {
+    SDL_atomic_t sequence;
+    Mix_Command cmd;
+} Mix_CommandSlot;
+
+static Mix_CommandSlot command_queue[MIX_COMMAND_QUEUE_SIZE];
+static SDL_atomic_t command_push_pos;
+static SDL_atomic_t command_run_pos;
+
+static Uint32 slot_sequence(Uint32 index)
+{
+    return (Uint32)SDL_AtomicGet(&command_queue[index].sequence) + index;
+}
+
+static void set_slot_sequence(Uint32 index, Uint32 sequence)
+{
+    SDL_AtomicSet(&command_queue[index].sequence, (int)(sequence - index));
+}
+
+int _Mix_CommandPush(const Mix_Command *cmd)
+{
+    Uint32 pos, index;
+    Sint32 diff;
+
+    for (;;) {
+        pos = (Uint32)SDL_AtomicGet(&command_push_pos);
+        index = pos & MIX_COMMAND_MASK;
+        diff = (Sint32)(slot_sequence(index) - pos);
+
+        if (diff == 0) {
+            if (SDL_AtomicCAS(&command_push_pos, (int)pos, (int)(pos + 1))) {
+                break;
+            }
+        } else if (diff < 0) {
+            return -1; /* The slot still keeps the command of the previous lap */
+        }
+        /* Otherwise another thread took the slot, try the next one */
+    }
+
+    command_queue[index].cmd = *cmd;
+    set_slot_sequence(index, pos + 1);
+
+    return 0;
+}
+
+void _Mix_CommandDrain(void)
+{
+    Mix_Command cmd;
+    Uint32 pos, index;
+
+    for (;;) {
+        pos = (Uint32)SDL_AtomicGet(&command_run_pos);
+        index = pos & MIX_COMMAND_MASK;
+
+        /* Empty, or the command is still being written: it gets run next time */
+        if (slot_sequence(index) != pos + 1) {
+            break;
+        }
+
+        cmd = command_queue[index].cmd;
+        set_slot_sequence(index, pos + MIX_COMMAND_QUEUE_SIZE);
+        /* Release the slot before running, the command may drain the queue itself */
+        SDL_AtomicSet(&command_run_pos, (int)(pos + 1));
+
+        cmd.func(&cmd);
+    }
+}
+
+SDL_bool _Mix_CommandPending(void)
+{
+    return SDL_AtomicGet(&command_push_pos) != SDL_AtomicGet(&command_run_pos) ? SDL_TRUE : SDL_FALSE;
+}
+
+/* vi: set ts=4 sw=4 expandtab: */
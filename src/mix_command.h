@@ -0,0 +1,59 @@
+/*
+  SDL_mixer:  An audio mixer library based on the SDL library
+  Copyright (C) 1997-2025 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef MIX_COMMAND_H_
+#define MIX_COMMAND_H_
+
+/* Queue of the playback control commands which get applied by the audio
+   thread, so the calling threads don't wait for the audio lock. Any number
+   of threads may push commands, they are run by the holder of the audio
+   lock only. Commands of one thread are run in the order of pushing. */
+
+#include "SDL_stdinc.h"
+
+/* Must be a power of two */
+#define MIX_COMMAND_QUEUE_SIZE  1024
+
+typedef struct Mix_Command Mix_Command;
+
+typedef void (*Mix_CommandFunc)(const Mix_Command *cmd);
+
+struct Mix_Command {
+    Mix_CommandFunc func;
+    void *ptr;
+    int which;
+    int arg1;
+    int arg2;
+};
+
+/* Put the command into the queue, returns -1 if the queue is full */
+extern int _Mix_CommandPush(const Mix_Command *cmd);
+
+/* Run all queued commands, the audio lock must be held. Commands may push
+   or drain the queue themselves. */
+extern void _Mix_CommandDrain(void);
+
+/* Whether any commands are waiting in the queue */
+extern SDL_bool _Mix_CommandPending(void);
+
+#endif /* MIX_COMMAND_H_ */
+
+/* vi: set ts=4 sw=4 expandtab: */
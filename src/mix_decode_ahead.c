@@ -0,0 +1,614 @@
+/*
+  SDL_mixer:  An audio mixer library based on the SDL library
+  Copyright (C) 1997-2025 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "SDL_atomic.h"
+#include "SDL_mutex.h"
+#include "SDL_thread.h"
+
+#include "SDL_mixer.h"
+#include "mix_decode_ahead.h"
+
+struct Mix_DecodeAhead {
+    void *context;
+    int (*get_audio)(void *context, void *data, int bytes);
+    void (*set_volume)(void *context, int volume);
+    double (*tell)(void *context);
+    int (*seek)(void *context, double position);
+    double (*get_speed)(void *context);
+    double (*get_tempo)(void *context);
+
+    Uint8 *ring;
+    Uint32 ring_size; /* Power of two, so positions may wrap around */
+    Uint8 *chunk;
+    int chunk_size;
+    Uint8 *scratch;             /* For the volume applied by the reader */
+    Uint32 wait_ms;
+    Uint8 silence;
+    SDL_AudioFormat format;
+    int frame_size;
+    int freq;
+
+    /* Guards the fields below, it's never held while the context is in use */
+    SDL_mutex *lock;
+    SDL_cond *wake;             /* The producer waits for the work */
+    SDL_cond *idle;             /* Others wait for the context */
+    SDL_Thread *thread;
+    SDL_bool quit;
+    SDL_bool busy;              /* Someone works with the context */
+    SDL_bool owns_volume;       /* The decoder got set to the full volume */
+    Mix_DecodeAheadCall calls[MIX_DECODE_AHEAD_CALLS];
+    int num_calls;
+
+    SDL_atomic_t write_pos;
+    SDL_atomic_t read_pos;
+    SDL_atomic_t flush_pos;     /* Where the data of the current epoch begins */
+    SDL_atomic_t epoch;
+    SDL_atomic_t ended;         /* Epoch + 1 once the stream got ended in it */
+    SDL_atomic_t volume;        /* Volume applied to what is read */
+
+    /* Position of the decoder once the data up to position_pos got decoded */
+    SDL_SpinLock position_lock;
+    double position;
+    double position_rate;       /* Seconds of the song per second of the output */
+    Uint32 position_pos;
+    int position_epoch;         /* Epoch + 1 of the published position */
+
+    int read_epoch;             /* Epoch seen by the reader */
+};
+
+/* Bytes the producer can't overwrite: data of older epochs is free already */
+static Uint32 ring_used(Mix_DecodeAhead *a)
+{
+    Uint32 w = (Uint32)SDL_AtomicGet(&a->write_pos);
+    Uint32 r = (Uint32)SDL_AtomicGet(&a->read_pos);
+    Uint32 f = (Uint32)SDL_AtomicGet(&a->flush_pos);
+
+    if ((Sint32)(f - r) > 0) {
+        r = f;
+    }
+
+    return w - r;
+}
+
+static void ring_write(Mix_DecodeAhead *a, const Uint8 *src, Uint32 len)
+{
+    Uint32 w = (Uint32)SDL_AtomicGet(&a->write_pos);
+    Uint32 offset = w & (a->ring_size - 1);
+    Uint32 first = SDL_min(len, a->ring_size - offset);
+
+    SDL_memcpy(a->ring + offset, src, first);
+    SDL_memcpy(a->ring, src + first, len - first);
+    SDL_AtomicSet(&a->write_pos, (int)(w + len));
+}
+
+static Uint32 ring_read(Mix_DecodeAhead *a, Uint8 *dst, Uint32 len)
+{
+    Uint32 r = (Uint32)SDL_AtomicGet(&a->read_pos);
+    Uint32 w = (Uint32)SDL_AtomicGet(&a->write_pos);
+    Uint32 offset = r & (a->ring_size - 1);
+    Uint32 first;
+
+    len = SDL_min(len, w - r);
+    first = SDL_min(len, a->ring_size - offset);
+
+    SDL_memcpy(dst, a->ring + offset, first);
+    SDL_memcpy(dst + first, a->ring, len - first);
+    SDL_AtomicSet(&a->read_pos, (int)(r + len));
+
+    return len;
+}
+
+/* The volume follows what is heard, rather than what the producer decodes
+   a whole ring ahead, so fades end at the end of the fade. Audio thread only. */
+static void apply_volume(Mix_DecodeAhead *a, Uint8 *data, int bytes)
+{
+    int volume = SDL_AtomicGet(&a->volume);
+    int piece;
+
+    if (volume >= MIX_MAX_VOLUME) {
+        return;
+    }
+
+    while (bytes > 0) {
+        piece = SDL_min(bytes, a->chunk_size);
+        SDL_memcpy(a->scratch, data, (size_t)piece);
+        SDL_memset(data, a->silence, (size_t)piece);
+        if (volume > 0) {
+            SDL_MixAudioFormat(data, a->scratch, a->format, (Uint32)piece, volume);
+        }
+        data += piece;
+        bytes -= piece;
+    }
+}
+
+/* Ask the decoder where it is and how fast the song goes, the context must
+   be taken over */
+static void read_position(Mix_DecodeAhead *a, double *position, double *rate)
+{
+    double value;
+
+    *position = a->tell ? a->tell(a->context) : -1.0;
+    *rate = 1.0;
+
+    if (a->get_speed && (value = a->get_speed(a->context)) > 0.0) {
+        *rate *= value;
+    }
+    if (a->get_tempo && (value = a->get_tempo(a->context)) > 0.0) {
+        *rate *= value;
+    }
+}
+
+/* Remember where the decoder is, so the position is told without waiting
+   for the producer. The lock must be held. */
+static void publish_position(Mix_DecodeAhead *a, double position, double rate)
+{
+    if (!a->tell) {
+        return;
+    }
+
+    SDL_AtomicLock(&a->position_lock);
+    a->position = position;
+    a->position_rate = rate;
+    a->position_pos = (Uint32)SDL_AtomicGet(&a->write_pos);
+    a->position_epoch = SDL_AtomicGet(&a->epoch) + 1;
+    SDL_AtomicUnlock(&a->position_lock);
+}
+
+/* Where the playback is: the position the decoder published after its last
+   piece, minus the data still in the ring, which plays the song faster or
+   slower than the output goes. Returns SDL_FALSE if nothing got decoded
+   since the last flush. */
+static SDL_bool heard_position(Mix_DecodeAhead *a, double *position)
+{
+    Uint32 r, f, tell_pos;
+    double tell, rate;
+    int tell_epoch, epoch = SDL_AtomicGet(&a->epoch);
+
+    SDL_AtomicLock(&a->position_lock);
+    tell = a->position;
+    rate = a->position_rate;
+    tell_pos = a->position_pos;
+    tell_epoch = a->position_epoch;
+    SDL_AtomicUnlock(&a->position_lock);
+
+    if (tell_epoch != epoch + 1) {
+        return SDL_FALSE;
+    }
+
+    r = (Uint32)SDL_AtomicGet(&a->read_pos);
+    f = (Uint32)SDL_AtomicGet(&a->flush_pos);
+    if ((Sint32)(f - r) > 0) {
+        r = f;
+    }
+
+    if ((Sint32)(tell_pos - r) > 0 && tell > 0.0) {
+        tell -= (double)((tell_pos - r) / (Uint32)a->frame_size) * rate / a->freq;
+        if (tell < 0.0) {
+            tell = 0.0;
+        }
+    }
+
+    *position = tell;
+    return SDL_TRUE;
+}
+
+static int rewind_run(const Mix_DecodeAheadCall *call)
+{
+    Mix_DecodeAhead *a = (Mix_DecodeAhead *)call->ptr;
+    return a->seek(a->context, call->value);
+}
+
+/* Start a new epoch when the stream got changed. The lock must be held. */
+static void apply_mode(Mix_DecodeAhead *a, int mode)
+{
+    int epoch;
+
+    if (mode == MIX_DECODE_AHEAD_KEEP) {
+        return;
+    }
+    if (mode == MIX_DECODE_AHEAD_REWIND) {
+        mode = MIX_DECODE_AHEAD_FLUSH;
+    }
+
+    /* Readers pick the flush position once they see the new epoch */
+    epoch = SDL_AtomicGet(&a->epoch) + 1;
+    SDL_AtomicSet(&a->flush_pos, SDL_AtomicGet(&a->write_pos));
+    SDL_AtomicSet(&a->ended, (mode == MIX_DECODE_AHEAD_STOP) ? epoch + 1 : 0);
+    SDL_AtomicSet(&a->epoch, epoch);
+}
+
+/* Wait for the context and take it over. The lock must be held. */
+static void acquire_context(Mix_DecodeAhead *a)
+{
+    while (a->busy) {
+        SDL_CondWait(a->idle, a->lock);
+    }
+    a->busy = SDL_TRUE;
+}
+
+/* Run the calls queued while the context was in use, and give it up. The
+   lock must be held, it's released while the calls are run. */
+static void release_context(Mix_DecodeAhead *a)
+{
+    Mix_DecodeAheadCall call;
+    double position, rate;
+    SDL_bool changed = SDL_FALSE;
+    int i;
+
+    while (a->num_calls > 0) {
+        call = a->calls[0];
+        --a->num_calls;
+        for (i = 0; i < a->num_calls; ++i) {
+            a->calls[i] = a->calls[i + 1];
+        }
+
+        SDL_UnlockMutex(a->lock);
+        call.func(&call);
+        SDL_LockMutex(a->lock);
+        changed = SDL_TRUE;
+    }
+
+    if (changed && a->tell) {
+        /* Nothing got decoded since the calls, the decoder is where the playback is */
+        SDL_UnlockMutex(a->lock);
+        read_position(a, &position, &rate);
+        SDL_LockMutex(a->lock);
+        publish_position(a, position, rate);
+    }
+
+    a->busy = SDL_FALSE;
+    SDL_CondBroadcast(a->idle);
+    SDL_CondSignal(a->wake);
+}
+
+/* Decode a piece into 'dst' with the lock released, returns what GetAudio()
+   does, or 0 if the stream got changed meanwhile, and the piece got dropped.
+   The lock must be held, and the context must be taken over. */
+static int decode_piece(Mix_DecodeAhead *a, Uint8 *dst, int bytes, SDL_bool to_ring)
+{
+    int epoch = SDL_AtomicGet(&a->epoch);
+    int left, filled;
+    double position = -1.0, rate = 1.0;
+
+    SDL_UnlockMutex(a->lock);
+    left = a->get_audio(a->context, dst, bytes);
+    if (a->tell) {
+        read_position(a, &position, &rate);
+    }
+    SDL_LockMutex(a->lock);
+
+    if (SDL_AtomicGet(&a->epoch) != epoch) {
+        return 0;
+    }
+
+    if (to_ring) {
+        if (left > 0) {
+            filled = bytes - left;
+        } else if (left < 0) {
+            filled = 0;
+        } else {
+            filled = bytes;
+        }
+        ring_write(a, dst, (Uint32)filled);
+    }
+
+    publish_position(a, position, rate);
+    if (left != 0) {
+        SDL_AtomicSet(&a->ended, epoch + 1);
+    }
+
+    return left;
+}
+
+static int SDLCALL decode_ahead_thread(void *data)
+{
+    Mix_DecodeAhead *a = (Mix_DecodeAhead *)data;
+
+    SDL_LockMutex(a->lock);
+    while (!a->quit) {
+        if (a->busy ||
+            SDL_AtomicGet(&a->ended) != 0 ||
+            a->ring_size - ring_used(a) < (Uint32)a->chunk_size) {
+            SDL_CondWaitTimeout(a->wake, a->lock, a->wait_ms);
+            continue;
+        }
+
+        a->busy = SDL_TRUE;
+        decode_piece(a, a->chunk, a->chunk_size, SDL_TRUE);
+        release_context(a);
+    }
+    SDL_UnlockMutex(a->lock);
+
+    return 0;
+}
+
+Mix_DecodeAhead *_Mix_DecodeAheadCreate(void *context,
+                                        int (*get_audio)(void *context, void *data, int bytes),
+                                        void (*set_volume)(void *context, int volume),
+                                        double (*tell)(void *context),
+                                        int (*seek)(void *context, double position),
+                                        double (*get_speed)(void *context),
+                                        double (*get_tempo)(void *context),
+                                        int ring_bytes, int chunk_bytes,
+                                        Uint32 wait_ms, Uint8 silence,
+                                        SDL_AudioFormat format, int channels, int freq,
+                                        int volume, SDL_bool playing)
+{
+    Mix_DecodeAhead *a = (Mix_DecodeAhead *)SDL_calloc(1, sizeof(Mix_DecodeAhead));
+    Uint32 ring_size = 1;
+
+    if (!a) {
+        SDL_OutOfMemory();
+        return NULL;
+    }
+
+    while (ring_size < (Uint32)ring_bytes || ring_size < (Uint32)chunk_bytes * 2) {
+        ring_size <<= 1;
+    }
+
+    a->context = context;
+    a->get_audio = get_audio;
+    a->set_volume = set_volume;
+    a->tell = tell;
+    a->seek = seek;
+    a->get_speed = get_speed;
+    a->get_tempo = get_tempo;
+    a->ring_size = ring_size;
+    a->chunk_size = chunk_bytes;
+    a->wait_ms = wait_ms;
+    a->silence = silence;
+    a->format = format;
+    a->frame_size = (SDL_AUDIO_BITSIZE(format) / 8) * channels;
+    a->freq = freq;
+    a->ring = (Uint8 *)SDL_malloc(ring_size);
+    a->chunk = (Uint8 *)SDL_malloc((size_t)chunk_bytes);
+    a->scratch = (Uint8 *)SDL_malloc((size_t)chunk_bytes);
+    a->lock = SDL_CreateMutex();
+    a->wake = SDL_CreateCond();
+    a->idle = SDL_CreateCond();
+    SDL_AtomicSet(&a->volume, volume);
+    SDL_AtomicSet(&a->ended, playing ? 0 : 1);
+
+    if (!a->ring || !a->chunk || !a->scratch) {
+        SDL_OutOfMemory();
+        _Mix_DecodeAheadDestroy(a);
+        return NULL;
+    }
+    if (!a->lock || !a->wake || !a->idle) {
+        _Mix_DecodeAheadDestroy(a);
+        return NULL;
+    }
+
+    /* The reader applies the volume, the decoder plays at the full one */
+    if (a->set_volume) {
+        a->set_volume(a->context, MIX_MAX_VOLUME);
+    }
+    a->owns_volume = SDL_TRUE;
+
+    a->thread = SDL_CreateThread(decode_ahead_thread, "MixerXDecodeAhead", a);
+    if (!a->thread) {
+        _Mix_DecodeAheadDestroy(a);
+        return NULL;
+    }
+
+    return a;
+}
+
+void _Mix_DecodeAheadStop(Mix_DecodeAhead *a)
+{
+    if (!a->thread) {
+        return;
+    }
+
+    SDL_LockMutex(a->lock);
+    a->quit = SDL_TRUE;
+    SDL_CondSignal(a->wake);
+    SDL_UnlockMutex(a->lock);
+    SDL_WaitThread(a->thread, NULL);
+    a->thread = NULL;
+}
+
+void _Mix_DecodeAheadDestroy(Mix_DecodeAhead *a)
+{
+    if (!a) {
+        return;
+    }
+
+    _Mix_DecodeAheadStop(a);
+
+    if (a->owns_volume) {
+        /* The calls queued for the producer still apply to the decoder */
+        SDL_LockMutex(a->lock);
+        acquire_context(a);
+        release_context(a);
+        SDL_UnlockMutex(a->lock);
+
+        /* Give the volume back to the decoder */
+        if (a->set_volume) {
+            a->set_volume(a->context, SDL_AtomicGet(&a->volume));
+        }
+    }
+
+    if (a->idle) {
+        SDL_DestroyCond(a->idle);
+    }
+    if (a->wake) {
+        SDL_DestroyCond(a->wake);
+    }
+    if (a->lock) {
+        SDL_DestroyMutex(a->lock);
+    }
+    SDL_free(a->scratch);
+    SDL_free(a->chunk);
+    SDL_free(a->ring);
+    SDL_free(a);
+}
+
+void _Mix_DecodeAheadLock(Mix_DecodeAhead *a)
+{
+    SDL_LockMutex(a->lock);
+    acquire_context(a);
+    SDL_UnlockMutex(a->lock);
+}
+
+void _Mix_DecodeAheadUnlock(Mix_DecodeAhead *a, int mode)
+{
+    SDL_LockMutex(a->lock);
+    apply_mode(a, mode);
+    release_context(a);
+    SDL_UnlockMutex(a->lock);
+}
+
+int _Mix_DecodeAheadCall(Mix_DecodeAhead *a, const Mix_DecodeAheadCall *call, int mode)
+{
+    Mix_DecodeAheadCall calls[2];
+    int i, count = 0, ret = 0;
+
+    SDL_LockMutex(a->lock);
+
+    /* The decoder is ahead of what is heard by the whole ring, take it back */
+    SDL_zero(calls[0]);
+    if (mode == MIX_DECODE_AHEAD_REWIND && a->seek && heard_position(a, &calls[0].value)) {
+        calls[0].func = rewind_run;
+        calls[0].ptr = a;
+        /* A microsecond more, so the rounding errors don't step a frame back */
+        calls[0].value += 0.000001;
+        ++count;
+    }
+    calls[count++] = *call;
+
+    /* The data decoded before the call is dropped right now, not after the call */
+    apply_mode(a, mode);
+
+    if (a->busy && a->num_calls + count <= MIX_DECODE_AHEAD_CALLS) {
+        for (i = 0; i < count; ++i) {
+            a->calls[a->num_calls++] = calls[i];
+        }
+        SDL_UnlockMutex(a->lock);
+        return 0;
+    }
+
+    /* The queue is full: wait for the piece being decoded */
+    acquire_context(a);
+    SDL_UnlockMutex(a->lock);
+
+    for (i = 0; i < count; ++i) {
+        ret = calls[i].func(&calls[i]);
+    }
+
+    SDL_LockMutex(a->lock);
+    release_context(a);
+    SDL_UnlockMutex(a->lock);
+
+    return ret;
+}
+
+void _Mix_DecodeAheadSetVolume(Mix_DecodeAhead *a, int volume)
+{
+    SDL_AtomicSet(&a->volume, volume);
+}
+
+int _Mix_DecodeAheadGetVolume(Mix_DecodeAhead *a)
+{
+    return SDL_AtomicGet(&a->volume);
+}
+
+static int read_ring(Mix_DecodeAhead *a, void *data, int bytes, SDL_bool wait)
+{
+    Uint8 *dst = (Uint8 *)data;
+    Uint32 got;
+    int epoch, left;
+
+    while (bytes > 0) {
+        epoch = SDL_AtomicGet(&a->epoch);
+        if (epoch != a->read_epoch) {
+            a->read_epoch = epoch;
+            SDL_AtomicSet(&a->read_pos, SDL_AtomicGet(&a->flush_pos));
+        }
+
+        got = ring_read(a, dst, (Uint32)bytes);
+        dst += got;
+        bytes -= (int)got;
+        if (bytes == 0) {
+            break;
+        }
+
+        if (SDL_AtomicGet(&a->ended) == a->read_epoch + 1) {
+            /* The tail might be written right before the end got been marked */
+            got = ring_read(a, dst, (Uint32)bytes);
+            bytes -= (int)got;
+            return bytes;
+        }
+
+        if (wait) {
+            /* Rendering offline: wait for the piece being decoded */
+            SDL_LockMutex(a->lock);
+            while (a->busy) {
+                SDL_CondWait(a->idle, a->lock);
+            }
+        } else if (SDL_TryLockMutex(a->lock) != 0) {
+            SDL_memset(dst, a->silence, (size_t)bytes);
+            break;
+        } else if (a->busy) {
+            /* The producer is late, don't wait for it */
+            SDL_UnlockMutex(a->lock);
+            SDL_memset(dst, a->silence, (size_t)bytes);
+            break;
+        }
+
+        /* The producer is idle and the ring is empty: decode right here */
+        if (SDL_AtomicGet(&a->epoch) != a->read_epoch ||
+            SDL_AtomicGet(&a->ended) != 0 ||
+            SDL_AtomicGet(&a->write_pos) != SDL_AtomicGet(&a->read_pos)) {
+            SDL_UnlockMutex(a->lock);
+            continue;
+        }
+
+        a->busy = SDL_TRUE;
+        left = decode_piece(a, dst, bytes, SDL_FALSE);
+        release_context(a);
+        SDL_UnlockMutex(a->lock);
+        return left;
+    }
+
+    /* Without the lock, the producer wakes up by the timeout if it misses that */
+    SDL_CondSignal(a->wake);
+    return 0;
+}
+
+int _Mix_DecodeAheadRead(Mix_DecodeAhead *a, void *data, int bytes, SDL_bool wait)
+{
+    int left = read_ring(a, data, bytes, wait);
+    apply_volume(a, (Uint8 *)data, bytes - left);
+    return left;
+}
+
+int _Mix_DecodeAheadBuffered(Mix_DecodeAhead *a)
+{
+    return (int)ring_used(a);
+}
+
+SDL_bool _Mix_DecodeAheadTell(Mix_DecodeAhead *a, double *position)
+{
+    return heard_position(a, position);
+}
+
+/* vi: set ts=4 sw=4 expandtab: */
@@ -0,0 +1,123 @@
+/*
+  SDL_mixer:  An audio mixer library based on the SDL library
+  Copyright (C) 1997-2025 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef MIX_DECODE_AHEAD_H_
+#define MIX_DECODE_AHEAD_H_
+
+/* Decoding of the music by a producer thread into a ring buffer ahead of
+   the audio callback, so the callback just copies the decoded data.
+
+   The music context is used by one thread at a time: the producer takes
+   it over for every decoded piece, and nobody holds the lock meanwhile.
+   Control calls which change the stream (seek, play, stop, tempo, etc.)
+   never wait for the decoding: they are run right away when the context
+   is free, or are queued and run by the producer between the pieces. They
+   flush the ring at once by starting a new epoch, the reader drops all
+   data of older epochs, and the producer drops the piece it was decoding.
+   Only the calls which need an answer from the context wait for the piece
+   being decoded. The ring is single-producer single-consumer: the audio
+   thread reads it without locking. */
+
+#include "SDL_stdinc.h"
+#include "SDL_audio.h"
+
+typedef struct Mix_DecodeAhead Mix_DecodeAhead;
+
+typedef struct Mix_DecodeAheadCall Mix_DecodeAheadCall;
+
+typedef int (*Mix_DecodeAheadFunc)(const Mix_DecodeAheadCall *call);
+
+/* The call of the music context which may be run later by the producer */
+struct Mix_DecodeAheadCall {
+    Mix_DecodeAheadFunc func;
+    void *ptr;
+    int which;
+    int arg1;
+    int arg2;
+    double value;
+};
+
+/* Number of calls queued while the context is busy, more ones wait for it */
+#define MIX_DECODE_AHEAD_CALLS  32
+
+/* What to do with the decoded data on unlock */
+#define MIX_DECODE_AHEAD_KEEP   0 /* Keep it, the stream wasn't changed */
+#define MIX_DECODE_AHEAD_FLUSH  1 /* Drop it, and decode from the new position */
+#define MIX_DECODE_AHEAD_STOP   2 /* Drop it, and decode nothing until next flush */
+#define MIX_DECODE_AHEAD_REWIND 3 /* Drop it, and seek back to what is heard before the call */
+
+/* Start the producer thread, it decodes nothing until flushed unless
+   'playing' is set. The decoder is set to the full volume, and 'volume'
+   is applied to what is read instead. Returns NULL on error */
+extern Mix_DecodeAhead *_Mix_DecodeAheadCreate(void *context,
+                                               int (*get_audio)(void *context, void *data, int bytes),
+                                               void (*set_volume)(void *context, int volume),
+                                               double (*tell)(void *context),
+                                               int (*seek)(void *context, double position),
+                                               double (*get_speed)(void *context),
+                                               double (*get_tempo)(void *context),
+                                               int ring_bytes, int chunk_bytes,
+                                               Uint32 wait_ms, Uint8 silence,
+                                               SDL_AudioFormat format, int channels, int freq,
+                                               int volume, SDL_bool playing);
+
+/* Stop the producer thread, waits for the piece being decoded. The reader
+   keeps working, it decodes by itself from now on */
+extern void _Mix_DecodeAheadStop(Mix_DecodeAhead *ahead);
+
+/* Stop the producer thread, run the calls still queued, give the volume
+   back to the decoder, and free the ring */
+extern void _Mix_DecodeAheadDestroy(Mix_DecodeAhead *ahead);
+
+/* Take the context over, waits until the current piece is decoded */
+extern void _Mix_DecodeAheadLock(Mix_DecodeAhead *ahead);
+
+/* Give the context back, 'mode' is one of MIX_DECODE_AHEAD_* */
+extern void _Mix_DecodeAheadUnlock(Mix_DecodeAhead *ahead, int mode);
+
+/* Apply 'mode' (one of MIX_DECODE_AHEAD_*) at once, and run the 'call' on
+   the context right away if it's free, or queue it for the producer
+   otherwise. Returns the result of the call, or 0 once it got queued */
+extern int _Mix_DecodeAheadCall(Mix_DecodeAhead *ahead, const Mix_DecodeAheadCall *call, int mode);
+
+/* Volume is applied to the decoded data once it's read, so it changes with
+   what is heard, like the fades do */
+extern void _Mix_DecodeAheadSetVolume(Mix_DecodeAhead *ahead, int volume);
+extern int _Mix_DecodeAheadGetVolume(Mix_DecodeAhead *ahead);
+
+/* Read the decoded data like GetAudio() of the music interface does:
+   returns the number of bytes left unfilled once the stream got ended.
+   If the producer is late, waits for it when 'wait' is set, or pads the
+   rest with silence otherwise. Audio thread only. */
+extern int _Mix_DecodeAheadRead(Mix_DecodeAhead *ahead, void *data, int bytes, SDL_bool wait);
+
+/* Number of bytes decoded but not read yet */
+extern int _Mix_DecodeAheadBuffered(Mix_DecodeAhead *ahead);
+
+/* The position of what is heard, from the one the producer published after
+   its last piece, so it never waits for the producer. The data still in the
+   ring is counted at the speed and the tempo it got decoded with. Returns
+   SDL_FALSE when nothing got decoded since the last flush, or 'tell' was NULL. */
+extern SDL_bool _Mix_DecodeAheadTell(Mix_DecodeAhead *ahead, double *position);
+
+#endif /* MIX_DECODE_AHEAD_H_ */
+
+/* vi: set ts=4 sw=4 expandtab: */
@@ -0,0 +1,254 @@
+/*
+  SDL_mixer:  An audio mixer library based on the SDL library
+  Copyright (C) 1997-2025 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "SDL.h"
+
+#include "mix_mmap.h"
+
+#if defined(__linux__) || defined(__APPLE__) || defined(__FreeBSD__) || \
+    defined(__NetBSD__) || defined(__OpenBSD__) || defined(__DragonFly__)
+#define MIX_HAVE_MMAP
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+typedef struct Mix_MappedOwner {
+    const void *owner;
+    SDL_RWops *src;
+    struct Mix_MappedOwner *next;
+} Mix_MappedOwner;
+
+static Mix_MappedOwner *mapped_owners = NULL;
+static SDL_SpinLock mapped_owners_lock = 0;
+
+#ifdef MIX_HAVE_MMAP
+
+/* Same as memory RWops of SDL, excepting the close */
+static Sint64 SDLCALL mmap_size(SDL_RWops *context)
+{
+    return (Sint64)(context->hidden.mem.stop - context->hidden.mem.base);
+}
+
+static Sint64 SDLCALL mmap_seek(SDL_RWops *context, Sint64 offset, int whence)
+{
+    Uint8 *newpos;
+
+    switch (whence) {
+    case RW_SEEK_SET:
+        newpos = context->hidden.mem.base + offset;
+        break;
+    case RW_SEEK_CUR:
+        newpos = context->hidden.mem.here + offset;
+        break;
+    case RW_SEEK_END:
+        newpos = context->hidden.mem.stop + offset;
+        break;
+    default:
+        return SDL_SetError("Unknown value for 'whence'");
+    }
+    if (newpos < context->hidden.mem.base) {
+        newpos = context->hidden.mem.base;
+    }
+    if (newpos > context->hidden.mem.stop) {
+        newpos = context->hidden.mem.stop;
+    }
+    context->hidden.mem.here = newpos;
+    return (Sint64)(context->hidden.mem.here - context->hidden.mem.base);
+}
+
+static size_t SDLCALL mmap_read(SDL_RWops *context, void *ptr, size_t size, size_t maxnum)
+{
+    size_t total_bytes;
+    size_t mem_available;
+
+    total_bytes = (maxnum * size);
+    if ((maxnum == 0) || (size == 0) || ((total_bytes / maxnum) != size)) {
+        return 0;
+    }
+
+    mem_available = (size_t)(context->hidden.mem.stop - context->hidden.mem.here);
+    if (total_bytes > mem_available) {
+        total_bytes = mem_available;
+    }
+
+    SDL_memcpy(ptr, context->hidden.mem.here, total_bytes);
+    context->hidden.mem.here += total_bytes;
+
+    return (total_bytes / size);
+}
+
+static size_t SDLCALL mmap_write(SDL_RWops *context, const void *ptr, size_t size, size_t num)
+{
+    (void)context;
+    (void)ptr;
+    (void)size;
+    (void)num;
+    SDL_SetError("Can't write to read-only memory");
+    return 0;
+}
+
+static int SDLCALL mmap_close(SDL_RWops *context)
+{
+    if (context) {
+        munmap(context->hidden.mem.base, (size_t)(context->hidden.mem.stop - context->hidden.mem.base));
+        SDL_FreeRW(context);
+    }
+    return 0;
+}
+
+static SDL_RWops *mmap_open(const char *file)
+{
+    SDL_RWops *rw;
+    struct stat st;
+    void *base;
+    int fd;
+
+    fd = open(file, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+
+    /* Empty files can't be mapped, and too big ones can't be addressed */
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0 ||
+        (Uint64)st.st_size != (Uint64)(size_t)st.st_size) {
+        close(fd);
+        return NULL;
+    }
+
+    /* Private writable mapping: pages which got been modified through the
+       chunk buffers are copied and never reach the file */
+    base = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        return NULL;
+    }
+
+    rw = SDL_AllocRW();
+    if (!rw) {
+        munmap(base, (size_t)st.st_size);
+        return NULL;
+    }
+
+    rw->size = mmap_size;
+    rw->seek = mmap_seek;
+    rw->read = mmap_read;
+    rw->write = mmap_write;
+    rw->close = mmap_close;
+    rw->type = SDL_RWOPS_MEMORY_RO;
+    rw->hidden.mem.base = (Uint8 *)base;
+    rw->hidden.mem.here = rw->hidden.mem.base;
+    rw->hidden.mem.stop = rw->hidden.mem.base + st.st_size;
+
+    return rw;
+}
+
+#endif /* MIX_HAVE_MMAP */
+
+SDL_RWops *_Mix_RWFromMappedFile(const char *file, const char *mode)
+{
+#ifdef MIX_HAVE_MMAP
+    SDL_RWops *rw;
+
+    if (file && mode && (SDL_strcmp(mode, "rb") == 0 || SDL_strcmp(mode, "r") == 0)) {
+        rw = mmap_open(file);
+        if (rw) {
+            return rw;
+        }
+    }
+#endif
+
+    return SDL_RWFromFile(file, mode);
+}
+
+SDL_bool _Mix_RWIsMapped(SDL_RWops *src)
+{
+#ifdef MIX_HAVE_MMAP
+    return (src && src->close == mmap_close) ? SDL_TRUE : SDL_FALSE;
+#else
+    (void)src;
+    return SDL_FALSE;
+#endif
+}
+
+const void *_Mix_LoadDataRW(SDL_RWops *src, size_t *size, void **mem)
+{
+    const Uint8 *data;
+
+    *mem = NULL;
+
+    if (!src) {
+        SDL_InvalidParamError("src");
+        return NULL;
+    }
+
+    if (src->type == SDL_RWOPS_MEMORY || src->type == SDL_RWOPS_MEMORY_RO) {
+        data = src->hidden.mem.here;
+        *size = (size_t)(src->hidden.mem.stop - src->hidden.mem.here);
+        src->hidden.mem.here = src->hidden.mem.stop;
+        return data;
+    }
+
+    *mem = SDL_LoadFile_RW(src, size, SDL_FALSE);
+    return *mem;
+}
+
+int _Mix_MappedAttach(const void *owner, SDL_RWops *src)
+{
+    Mix_MappedOwner *o = (Mix_MappedOwner *)SDL_malloc(sizeof(Mix_MappedOwner));
+
+    if (!o) {
+        return SDL_OutOfMemory();
+    }
+
+    o->owner = owner;
+    o->src = src;
+
+    SDL_AtomicLock(&mapped_owners_lock);
+    o->next = mapped_owners;
+    mapped_owners = o;
+    SDL_AtomicUnlock(&mapped_owners_lock);
+
+    return 0;
+}
+
+void _Mix_MappedRelease(const void *owner)
+{
+    Mix_MappedOwner **it, *o;
+
+    SDL_AtomicLock(&mapped_owners_lock);
+    for (it = &mapped_owners; (o = *it) != NULL; it = &o->next) {
+        if (o->owner == owner) {
+            *it = o->next;
+            break;
+        }
+    }
+    SDL_AtomicUnlock(&mapped_owners_lock);
+
+    if (o) {
+        SDL_RWclose(o->src);
+        SDL_free(o);
+    }
+}
+
+/* vi: set ts=4 sw=4 expandtab: */
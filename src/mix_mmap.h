@@ -0,0 +1,58 @@
+/*
+  SDL_mixer:  An audio mixer library based on the SDL library
+  Copyright (C) 1997-2025 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef MIX_MMAP_H_
+#define MIX_MMAP_H_
+
+/* Memory-mapped file RWops, and borrowing of the memory behind RWops.
+
+   Files opened for reading are mapped on systems which have mmap(), other
+   files (or if mapping failed) are opened by SDL_RWFromFile. Mapped RWops
+   look like the read-only memory RWops of SDL, so codecs can take their
+   bytes without copying them into the heap. */
+
+#include "SDL_stdinc.h"
+#include "SDL_rwops.h"
+
+/* The default opener of file paths */
+extern SDL_RWops *_Mix_RWFromMappedFile(const char *file, const char *mode);
+
+/* Is the RWops a mapping of the file made by _Mix_RWFromMappedFile() */
+extern SDL_bool _Mix_RWIsMapped(SDL_RWops *src);
+
+/* Get the rest of the data from the current position of src, the position
+   gets moved to the end. Data of memory RWops (the mapped file, or one made
+   by SDL_RWFromMem/SDL_RWFromConstMem) is returned as is and stays valid
+   until the src got been closed, *mem is set to NULL then. Other RWops are
+   loaded into a new buffer which is returned in *mem too, so always pass
+   *mem to SDL_free() once finished. Returns NULL on error. */
+extern const void *_Mix_LoadDataRW(SDL_RWops *src, size_t *size, void **mem);
+
+/* Keep the mapped src open while the owner (a chunk pointing into the
+   mapping) is alive, returns -1 on out of memory */
+extern int _Mix_MappedAttach(const void *owner, SDL_RWops *src);
+
+/* Close the src attached to the owner */
+extern void _Mix_MappedRelease(const void *owner);
+
+#endif /* MIX_MMAP_H_ */
+
+/* vi: set ts=4 sw=4 expandtab: */
@@ -0,0 +1,173 @@
+/*
+  SDL_mixer:  An audio mixer library based on the SDL library
+  Copyright (C) 1997-2025 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "SDL_atomic.h"
+#include "SDL_timer.h"
+
+#include "mix_perf.h"
+
+int _Mix_perf_enabled = 0;
+
+/* Counters of older generations are treated as empty, so the reset
+   doesn't need to know every counter */
+static SDL_atomic_t perf_generation;
+static SDL_SpinLock perf_lock = 0;
+static Uint32 perf_period_us = 0;
+
+static int perf_bucket(Uint32 us)
+{
+    int octave = 4;
+
+    if (us < 16) {
+        return (int)us;
+    }
+
+    while ((us >> (octave + 1)) != 0) {
+        ++octave;
+    }
+
+    return 16 + (octave - 4) * 4 + (int)((us >> (octave - 2)) & 3);
+}
+
+/* The upper bound of the bucket */
+static Uint32 perf_bucket_limit(int bucket)
+{
+    int octave;
+
+    if (bucket < 16) {
+        return (Uint32)bucket + 1;
+    }
+
+    octave = (bucket - 16) / 4 + 4;
+    return (Uint32)(5 + (bucket - 16) % 4) << (octave - 2);
+}
+
+void _Mix_PerfSetPeriod(int frames, int freq)
+{
+    perf_period_us = (freq > 0) ? (Uint32)(((Uint64)frames * 1000000) / (Uint64)freq) : 0;
+}
+
+Uint64 _Mix_PerfBegin(void)
+{
+    return _Mix_perf_enabled ? SDL_GetPerformanceCounter() : 0;
+}
+
+static void perf_count(Mix_PerfCounter *c, int generation, Uint32 us)
+{
+    if (c->generation != generation) {
+        SDL_memset(c, 0, sizeof(Mix_PerfCounter));
+        c->generation = generation;
+    }
+
+    if (c->count == 0 || us < c->min_us) {
+        c->min_us = us;
+    }
+    if (us > c->max_us) {
+        c->max_us = us;
+    }
+    if (perf_period_us > 0 && us > perf_period_us) {
+        ++c->overruns;
+    }
+
+    ++c->count;
+    c->sum_us += us;
+    ++c->histogram[perf_bucket(us)];
+}
+
+void _Mix_PerfEnd(Mix_PerfCounter *counter, Mix_PerfCounter *also, Uint64 begin)
+{
+    Uint64 elapsed;
+    Uint32 us;
+    int generation;
+
+    if (begin == 0) {
+        return;
+    }
+
+    elapsed = SDL_GetPerformanceCounter() - begin;
+    us = (Uint32)((elapsed * 1000000) / SDL_GetPerformanceFrequency());
+    generation = SDL_AtomicGet(&perf_generation);
+
+    SDL_AtomicLock(&perf_lock);
+    perf_count(counter, generation, us);
+    if (also) {
+        perf_count(also, generation, us);
+    }
+    SDL_AtomicUnlock(&perf_lock);
+}
+
+void _Mix_PerfReport(const Mix_PerfCounter *counter, Mix_PerfStats *stats)
+{
+    Mix_PerfCounter c;
+    Uint32 rank, seen = 0;
+    int i;
+
+    SDL_AtomicLock(&perf_lock);
+    SDL_memcpy(&c, counter, sizeof(Mix_PerfCounter));
+    SDL_AtomicUnlock(&perf_lock);
+
+    SDL_zerop(stats);
+    stats->period_ms = (double)perf_period_us / 1000.0;
+
+    if (c.generation != SDL_AtomicGet(&perf_generation) || c.count == 0) {
+        return;
+    }
+
+    stats->count = c.count;
+    stats->overruns = c.overruns;
+    stats->min_ms = (double)c.min_us / 1000.0;
+    stats->max_ms = (double)c.max_us / 1000.0;
+    stats->avg_ms = (double)c.sum_us / c.count / 1000.0;
+
+    /* The 99th percentile is precise to the bucket width only */
+    rank = c.count - c.count / 100;
+    for (i = 0; i < MIX_PERF_BUCKETS; ++i) {
+        seen += c.histogram[i];
+        if (seen >= rank) {
+            stats->p99_ms = (double)SDL_min(perf_bucket_limit(i), c.max_us) / 1000.0;
+            break;
+        }
+    }
+
+    if (perf_period_us > 0) {
+        stats->avg_load = stats->avg_ms / stats->period_ms;
+        stats->p99_load = stats->p99_ms / stats->period_ms;
+        stats->max_load = stats->max_ms / stats->period_ms;
+    }
+}
+
+int MIXCALLCC Mix_SetPerfStats(int enable)
+{
+    int prev = _Mix_perf_enabled;
+
+    if (enable >= 0) {
+        _Mix_perf_enabled = (enable != 0);
+    }
+
+    return prev;
+}
+
+void MIXCALLCC Mix_ResetPerfStats(void)
+{
+    SDL_AtomicAdd(&perf_generation, 1);
+}
+
+/* vi: set ts=4 sw=4 expandtab: */
@@ -0,0 +1,60 @@
+/*
+  SDL_mixer:  An audio mixer library based on the SDL library
+  Copyright (C) 1997-2025 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef MIX_PERF_H_
+#define MIX_PERF_H_
+
+/* Opt-in timing counters of the audio callback stages */
+
+#include "SDL_stdinc.h"
+#include "SDL_mixer.h"
+
+/* Histogram of durations in microseconds: exact below 16, then four
+   buckets per octave */
+#define MIX_PERF_BUCKETS    128
+
+typedef struct Mix_PerfCounter {
+    int generation;
+    Uint32 count;
+    Uint32 overruns;
+    Uint32 min_us;
+    Uint32 max_us;
+    Uint64 sum_us;
+    Uint32 histogram[MIX_PERF_BUCKETS];
+} Mix_PerfCounter;
+
+extern int _Mix_perf_enabled;
+
+/* Set the duration of the audio buffer, runs longer than it are overruns */
+extern void _Mix_PerfSetPeriod(int frames, int freq);
+
+/* Get the start time of the measured stage, or 0 when disabled */
+extern Uint64 _Mix_PerfBegin(void);
+
+/* Count the stage time into one or two counters ('also' may be NULL) */
+extern void _Mix_PerfEnd(Mix_PerfCounter *counter, Mix_PerfCounter *also, Uint64 begin);
+
+/* Fill the public statistics by the counter */
+extern void _Mix_PerfReport(const Mix_PerfCounter *counter, Mix_PerfStats *stats);
+
+#endif /* MIX_PERF_H_ */
+
+/* vi: set ts=4 sw=4 expandtab: */
@@ -0,0 +1,231 @@
+/*
+  SDL_mixer:  An audio mixer library based on the SDL library
+  Copyright (C) 1997-2025 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "SDL_atomic.h"
+#include "SDL_mutex.h"
+#include "SDL_thread.h"
+
+#include "mix_workers.h"
+
+static SDL_Thread *workers[MIX_WORKERS_MAX_THREADS];
+static int num_workers = 0;
+static SDL_sem *work_sem = NULL;
+static SDL_sem *done_sem = NULL;
+static SDL_atomic_t workers_quit;
+
+/* The current batch. A job is taken with a copy of its item, so the batch
+   may be ended while some jobs are late: these don't count for the next one */
+static SDL_SpinLock batch_lock = 0;
+static Mix_WorkerJob batch_job = NULL;
+static void *batch_ctx = NULL;
+static void **batch_items = NULL;
+static int batch_count = 0;
+static int batch_next = 0;
+static int batch_left = 0;
+static Uint32 batch_id = 0;
+
+/* Take the next job of the batch and do it, returns SDL_FALSE if none left */
+static SDL_bool worker_do_job(void)
+{
+    Mix_WorkerJob job = NULL;
+    void *ctx = NULL, *item = NULL;
+    Uint32 id = 0;
+
+    SDL_AtomicLock(&batch_lock);
+    if (batch_next < batch_count) {
+        item = batch_items[batch_next++];
+        job = batch_job;
+        ctx = batch_ctx;
+        id = batch_id;
+    }
+    SDL_AtomicUnlock(&batch_lock);
+
+    if (!job) {
+        return SDL_FALSE;
+    }
+
+    job(ctx, item);
+
+    /* Posted under the lock, so the caller knows whether it got posted */
+    SDL_AtomicLock(&batch_lock);
+    if (id == batch_id && --batch_left == 0) {
+        SDL_SemPost(done_sem);
+    }
+    SDL_AtomicUnlock(&batch_lock);
+
+    return SDL_TRUE;
+}
+
+static int SDLCALL worker_thread(void *data)
+{
+    (void)data;
+
+    SDL_SetThreadPriority(SDL_THREAD_PRIORITY_HIGH);
+
+    for (;;) {
+        SDL_SemWait(work_sem);
+        if (SDL_AtomicGet(&workers_quit)) {
+            break;
+        }
+        while (worker_do_job()) {
+        }
+    }
+
+    return 0;
+}
+
+static void workers_stop(void)
+{
+    int i;
+
+    SDL_AtomicSet(&workers_quit, 1);
+    for (i = 0; i < num_workers; ++i) {
+        SDL_SemPost(work_sem);
+    }
+    for (i = 0; i < num_workers; ++i) {
+        SDL_WaitThread(workers[i], NULL);
+        workers[i] = NULL;
+    }
+    num_workers = 0;
+
+    if (work_sem) {
+        SDL_DestroySemaphore(work_sem);
+        work_sem = NULL;
+    }
+    if (done_sem) {
+        SDL_DestroySemaphore(done_sem);
+        done_sem = NULL;
+    }
+}
+
+int _Mix_WorkersSetThreads(int threads)
+{
+    SDL_Thread *thread;
+
+    if (threads > MIX_WORKERS_MAX_THREADS) {
+        threads = MIX_WORKERS_MAX_THREADS;
+    }
+
+    if (threads == num_workers) {
+        return num_workers;
+    }
+
+    /* Just restart the pool, it's not changed often */
+    workers_stop();
+
+    if (threads <= 0) {
+        return 0;
+    }
+
+    work_sem = SDL_CreateSemaphore(0);
+    done_sem = SDL_CreateSemaphore(0);
+    if (!work_sem || !done_sem) {
+        workers_stop();
+        return 0;
+    }
+
+    SDL_AtomicSet(&workers_quit, 0);
+    while (num_workers < threads) {
+        thread = SDL_CreateThread(worker_thread, "MixerXWorker", NULL);
+        if (!thread) {
+            break;
+        }
+        workers[num_workers++] = thread;
+    }
+
+    if (num_workers == 0) {
+        workers_stop();
+    }
+
+    return num_workers;
+}
+
+int _Mix_WorkersCount(void)
+{
+    return num_workers;
+}
+
+SDL_bool _Mix_WorkersRun(Mix_WorkerJob job, void *ctx, void **items, int count, Uint32 timeout_ms)
+{
+    SDL_bool in_time = SDL_TRUE;
+    int wake, first, i;
+
+    if (count <= 0) {
+        return SDL_TRUE;
+    }
+
+    if (num_workers == 0) {
+        for (i = 0; i < count; ++i) {
+            job(ctx, items[i]);
+        }
+        return SDL_TRUE;
+    }
+
+    SDL_AtomicLock(&batch_lock);
+    batch_job = job;
+    batch_ctx = ctx;
+    batch_items = items;
+    batch_count = count;
+    batch_next = 0;
+    batch_left = count;
+    ++batch_id;
+    SDL_AtomicUnlock(&batch_lock);
+
+    /* The calling thread takes one job too, don't wake up more threads than needed */
+    wake = count - 1;
+    if (wake > num_workers) {
+        wake = num_workers;
+    }
+    wake -= (int)SDL_SemValue(work_sem);
+    for (i = 0; i < wake; ++i) {
+        SDL_SemPost(work_sem);
+    }
+
+    while (worker_do_job()) {
+    }
+
+    if (SDL_SemWaitTimeout(done_sem, timeout_ms) == 0) {
+        return SDL_TRUE;
+    }
+
+    /* A worker got stuck: end the batch, so the late jobs don't count for
+       the next one, and do the jobs nobody took yet right here */
+    SDL_AtomicLock(&batch_lock);
+    first = batch_next;
+    batch_next = batch_count;
+    if (batch_left == 0) {
+        SDL_SemTryWait(done_sem); /* Done just now, it got posted */
+    } else if (batch_left > count - first) {
+        in_time = SDL_FALSE;
+    }
+    batch_count = 0;
+    batch_items = NULL;
+    ++batch_id;
+    SDL_AtomicUnlock(&batch_lock);
+
+    for (i = first; i < count; ++i) {
+        job(ctx, items[i]);
+    }
+
+    return in_time;
+}
+
+/* vi: set ts=4 sw=4 expandtab: */
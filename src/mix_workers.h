@@ -0,0 +1,50 @@
+/*
+  SDL_mixer:  An audio mixer library based on the SDL library
+  Copyright (C) 1997-2025 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef MIX_WORKERS_H_
+#define MIX_WORKERS_H_
+
+/* Pool of threads helping the audio callback to render several jobs at once */
+
+#include "SDL_stdinc.h"
+
+/* Maximum number of the worker threads */
+#define MIX_WORKERS_MAX_THREADS 8
+
+typedef void (*Mix_WorkerJob)(void *ctx, void *item);
+
+/* Run the given number of worker threads (0 to stop them all), returns
+   the number of actually running threads */
+extern int _Mix_WorkersSetThreads(int threads);
+
+/* Number of running worker threads */
+extern int _Mix_WorkersCount(void);
+
+/* Run job(ctx, items[0]) ... job(ctx, items[count - 1]) on the workers and
+   on the calling thread. Jobs nobody took yet are done by the calling thread
+   itself. The jobs taken by the workers are waited for 'timeout_ms' at most:
+   then the late ones are left running, and SDL_FALSE is returned. The caller
+   must keep away from their items until the jobs tell they are done. */
+extern SDL_bool _Mix_WorkersRun(Mix_WorkerJob job, void *ctx, void **items, int count, Uint32 timeout_ms);
+
+#endif /* MIX_WORKERS_H_ */
+
+/* vi: set ts=4 sw=4 expandtab: */
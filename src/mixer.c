@@ -26,6 +26,15 @@
 #include "music.h"
 #include "load_aiff.h"
 #include "load_voc.h"
+#include "mix_bus.h"
+#include "mix_async.h"
+#include "mix_perf.h"
+#include "mix_mmap.h"
+#include "mix_chunk_pool.h"
+#include "mix_command.h"
+#ifdef USE_CUSTOM_AUDIO_STREAM
+#include "stream_custom.h"
+#endif
 
 #define MIX_INTERNAL_EFFECT__
 #include "effects_internal.h"
@@ -59,11 +68,15 @@ SDL_COMPILE_TIME_ASSERT(SDL_MIXER_PATCHLEVEL_min, SDL_MIXER_PATCHLEVEL >= 0);
 SDL_COMPILE_TIME_ASSERT(SDL_MIXER_PATCHLEVEL_max, SDL_MIXER_PATCHLEVEL <= 99);
 #endif
 
-Mix_RWFromFile_cb _Mix_RWFromFile = SDL_RWFromFile;
+Mix_RWFromFile_cb _Mix_RWFromFile = _Mix_RWFromMappedFile;
 
 static int audio_opened = 0;
 static SDL_AudioSpec mixer;
 static SDL_AudioDeviceID audio_device;
+/* Nesting of the audio lock, queued commands get run by the outermost one */
+static SDL_atomic_t audio_lock_depth;
+/* The thread holding the audio lock, it's written by the holder only */
+static SDL_threadID audio_lock_owner;
 
 typedef struct _Mix_effectinfo
 {
@@ -78,24 +91,72 @@ static struct _Mix_Channel {
     int playing;
     int paused;
     Uint8 *samples;
+    Mix_ChunkVoice *voice;
     int volume;
     int looping;
     int tag;
-    Uint32 expire;
+    Uint64 start_frame;
+    Uint64 expire;
+    Uint64 paused_frame;
     Uint32 start_time;
     Mix_Fading fading;
+    Mix_FadeCurve fade_curve;
     int fade_volume;
     int fade_volume_reset;
-    Uint32 fade_length;
-    Uint32 ticks_fade;
+    Uint64 fade_start;
+    Uint64 fade_length;
     effect_info *effects;
+    Mix_PerfCounter perf;
+    int priority;
+    /* Tail of the sound stolen by a new one, faded out under it */
+    Mix_Chunk *release_chunk;
+    Mix_ChunkVoice *release_voice;
+    Uint8 *release_samples;
+    int release_left;
+    int release_volume;
+    Uint64 release_pos;
+    Uint64 release_length;
 } *mix_channel = NULL;
 
 static effect_info *posteffects = NULL;
 
+/* Timings of the callback stages and of the post-mix effects chain */
+static Mix_PerfCounter mix_perf[MIX_PERF_POST_EFFECTS + 1];
+static Mix_PerfCounter mix_perf_posteffects;
+
+/* Scratch buffer the per-channel effect chains are running on, allocated
+   once with the mixer so the audio callback never touches the heap */
+static Uint8 *mix_effects_buffer = NULL;
+static int mix_effects_buffer_size = 0;
+
+/* Float32 accumulator all channels and music streams are mixed into when
+   enabled, it gets converted into the output format once per callback */
+static float *mix_bus = NULL;
+static int mix_bus_samples = 0;
+static int mix_bus_enabled = 0;
+static SDL_bool mix_bus_active = SDL_FALSE;
+
 static int num_channels;
 static int reserved_channels = 0;
 
+/* Whether Mix_PlayChannel(-1, ...) takes busy channels when none is free */
+static SDL_bool voice_stealing = SDL_FALSE;
+static int voice_steal_fade_ms = 0;
+
+/* Priorities and voice limits of the chunks which got them set */
+typedef struct Mix_ChunkPolicy {
+    Mix_Chunk *chunk;
+    int priority;
+    int max_voices;
+} Mix_ChunkPolicy;
+
+static Mix_ChunkPolicy *chunk_policies = NULL;
+static int num_chunk_policies = 0;
+
+/* Number of frames mixed since the mixer got been opened: channels are
+   started, expired and faded at exact frames of this clock */
+static Uint64 mix_clock = 0;
+
 
 /* Support for hooking into the mixer callback system */
 static void (SDLCALL *mix_postmix)(void *udata, Uint8 *stream, int len) = NULL;
@@ -312,14 +373,16 @@ static void *Mix_DoEffects(int chan, void *snd, int len)
     int posteffect = (chan == MIX_CHANNEL_POST);
     effect_info *e = ((posteffect) ? posteffects : mix_channel[chan].effects);
     void *buf = snd;
+    Uint64 perf_begin;
 
     if (e != NULL) {    /* are there any registered effects? */
+        perf_begin = _Mix_PerfBegin();
+
         /* if this is the postmix, we can just overwrite the original. */
         if (!posteffect) {
-            buf = SDL_malloc((size_t)len);
-            if (buf == NULL) {
-                return snd;
-            }
+            /* The caller never passes more than the scratch buffer can hold */
+            SDL_assert(len <= mix_effects_buffer_size);
+            buf = mix_effects_buffer;
             SDL_memcpy(buf, snd, (size_t)len);
         }
 
@@ -328,134 +391,444 @@ static void *Mix_DoEffects(int chan, void *snd, int len)
                 e->callback(chan, buf, len, e->udata);
             }
         }
+
+        _Mix_PerfEnd(posteffect ? &mix_perf_posteffects : &mix_channel[chan].perf, NULL, perf_begin);
     }
 
-    /* be sure to SDL_free() the return value if != snd ... */
+    /* the returned buffer is owned by the mixer, never free it */
     return buf;
 }
 
+/* Add the piece at the byte 'offset' of the output into the float mix bus,
+   returns SDL_FALSE if the bus isn't in use by the current callback */
+SDL_bool _Mix_MixBusAdd(int offset, const Uint8 *src, int len, int volume)
+{
+    int sample_size;
+
+    if (!mix_bus_active) {
+        return SDL_FALSE;
+    }
+
+    if (volume > 0) {
+        sample_size = SDL_AUDIO_BITSIZE(mixer.format) / 8;
+        _Mix_BusAccumulate(mix_bus + (offset / sample_size), src, mixer.format,
+                           len / sample_size, (float)volume / MIX_MAX_VOLUME);
+    }
+
+    return SDL_TRUE;
+}
+
+static int Mix_FrameSize(void)
+{
+    return (SDL_AUDIO_BITSIZE(mixer.format) / 8) * mixer.channels;
+}
+
+static Uint64 Mix_MsToFrames(int ms)
+{
+    return ((Uint64)ms * (Uint64)mixer.freq) / 1000;
+}
+
+/* Gain of the fading channel at the frame of the mixer clock */
+static double Mix_FadeGain(int chan, Uint64 frame)
+{
+    double pos = 1.0;
+
+    if (frame < mix_channel[chan].fade_start) {
+        pos = 0.0;
+    } else if (frame - mix_channel[chan].fade_start < mix_channel[chan].fade_length) {
+        pos = (double)(frame - mix_channel[chan].fade_start) / (double)mix_channel[chan].fade_length;
+    }
+
+    if (mix_channel[chan].fading == MIX_FADING_OUT) {
+        pos = 1.0 - pos;
+    }
+
+    if (mix_channel[chan].fade_curve == MIX_FADE_EXPONENTIAL) {
+        /* -60 dB at the silent end */
+        return SDL_pow(1000.0, pos - 1.0);
+    }
+
+    return pos;
+}
+
+/* Apply the fade of the channel to the piece mixed at the byte 'index' */
+static void Mix_ApplyFade(int chan, Uint8 *buf, int index, int len)
+{
+    int frame_size = Mix_FrameSize();
+    double length = (double)(mix_channel[chan].fade_length > 0 ? mix_channel[chan].fade_length : 1);
+    double step = (mix_channel[chan].fading == MIX_FADING_OUT) ? -1.0 / length : 1.0 / length;
+    SDL_bool exponential = (mix_channel[chan].fade_curve == MIX_FADE_EXPONENTIAL);
+    Uint64 frame = mix_clock + (Uint64)(index / frame_size);
+
+    if (exponential) {
+        step = SDL_pow(1000.0, step);
+    }
+
+    _Mix_ApplyGainRamp(buf, mixer.format, mixer.channels, len / frame_size,
+                       (float)Mix_FadeGain(chan, frame), (float)step, exponential);
+}
+
+/* Run the effects of the channel and mix the result, pieces that don't fit
+   the effects scratch buffer are being processed by several steps */
+static void Mix_MixChannelPiece(int chan, Uint8 *stream, int index, Uint8 *src, int len, int volume)
+{
+    SDL_bool fading = (mix_channel[chan].fading != MIX_NO_FADING);
+    Uint8 *mix_input;
+    int piece;
+
+    while (len > 0) {
+        piece = len;
+        if ((mix_channel[chan].effects != NULL || fading) && piece > mix_effects_buffer_size) {
+            piece = mix_effects_buffer_size;
+        }
+
+        mix_input = Mix_DoEffects(chan, src, piece);
+        if (fading) {
+            /* Never touch the chunk data itself */
+            if (mix_input == src) {
+                SDL_memcpy(mix_effects_buffer, src, (size_t)piece);
+                mix_input = mix_effects_buffer;
+            }
+            Mix_ApplyFade(chan, mix_input, index, piece);
+        }
+
+        if (!_Mix_MixBusAdd(index, mix_input, piece, volume)) {
+            SDL_MixAudioFormat(stream + index, mix_input, mixer.format, (Uint32)piece, volume);
+        }
+
+        index += piece;
+        src += piece;
+        len -= piece;
+    }
+}
+
+static int Mix_BufferFrames(const SDL_AudioSpec *spec)
+{
+    return spec->samples > 0 ? spec->samples : 4096;
+}
+
+static int Mix_AllocEffectsBuffer(const SDL_AudioSpec *spec)
+{
+    int frame_size = (SDL_AUDIO_BITSIZE(spec->format) / 8) * spec->channels;
+
+    SDL_free(mix_effects_buffer);
+    mix_effects_buffer_size = Mix_BufferFrames(spec) * frame_size;
+    mix_effects_buffer = (Uint8 *)SDL_malloc((size_t)mix_effects_buffer_size);
+    if (!mix_effects_buffer) {
+        mix_effects_buffer_size = 0;
+        return -1;
+    }
+
+    return 0;
+}
+
+static int Mix_AllocMixBus(const SDL_AudioSpec *spec)
+{
+    SDL_free(mix_bus);
+    mix_bus_samples = Mix_BufferFrames(spec) * spec->channels;
+    mix_bus = (float *)SDL_malloc((size_t)mix_bus_samples * sizeof(float));
+    if (!mix_bus) {
+        mix_bus_samples = 0;
+        return -1;
+    }
+
+    return 0;
+}
+
+static void Mix_FreeMixBus(void)
+{
+    SDL_free(mix_bus);
+    mix_bus = NULL;
+    mix_bus_samples = 0;
+}
+
+
+/* Mixer clock frame the channel has to be stopped at, 0 if none */
+static Uint64 Mix_ChannelStopFrame(int chan)
+{
+    Uint64 stop = mix_channel[chan].expire;
+    Uint64 fade_end;
+
+    if (mix_channel[chan].fading == MIX_FADING_OUT) {
+        fade_end = mix_channel[chan].fade_start + mix_channel[chan].fade_length;
+        if (stop == 0 || fade_end < stop) {
+            stop = fade_end;
+        }
+    }
+
+    return stop;
+}
+
+/* Byte range [start..stop) of the buffer of 'len' bytes the channel plays in */
+static void Mix_ChannelRange(int chan, int len, int *start, int *stop)
+{
+    int frame_size = Mix_FrameSize();
+    Uint64 end = mix_clock + (Uint64)(len / frame_size);
+    Uint64 frame;
+
+    frame = mix_channel[chan].start_frame;
+    if (frame >= end) {
+        *start = len;
+    } else if (frame > mix_clock) {
+        *start = (int)(frame - mix_clock) * frame_size;
+    } else {
+        *start = 0;
+    }
+
+    frame = Mix_ChannelStopFrame(chan);
+    if (frame == 0 || frame >= end) {
+        *stop = len;
+    } else if (frame > mix_clock) {
+        *stop = (int)(frame - mix_clock) * frame_size;
+    } else {
+        *stop = 0;
+    }
+}
+
+/* MAKE SURE you hold the audio lock (Mix_LockAudio()) before calling this! */
+static void Mix_StopFading_locked(int which)
+{
+    if (mix_channel[which].fading != MIX_NO_FADING) { /* Restore volume */
+        mix_channel[which].volume = mix_channel[which].fade_volume_reset;
+    }
+    mix_channel[which].fading = MIX_NO_FADING;
+}
+
+static int Mix_ChannelVolume(int chan, int master_vol)
+{
+    int volume = mix_channel[chan].volume;
+
+    if (mix_channel[chan].fading != MIX_NO_FADING) {
+        /* The fade itself is applied per frame by Mix_ApplyFade() */
+        volume = mix_channel[chan].fade_volume;
+    }
+
+    return (master_vol * (volume * mix_channel[chan].chunk->volume)) / (MIX_MAX_VOLUME * MIX_MAX_VOLUME);
+}
+
+/* Mix the next piece of the channel up to 'len' bytes long, returns its length */
+static int Mix_MixChannelSamples(int i, Uint8 *stream, int index, int len, int volume)
+{
+    int mixable = mix_channel[i].playing;
+
+    if (mixable > len) {
+        mixable = len;
+    }
+
+    if (mix_channel[i].voice) {
+        /* Compressed chunks get decoded while playing */
+        mix_channel[i].samples = _Mix_ChunkVoiceRead(mix_channel[i].voice, &mixable);
+    }
+
+    Mix_MixChannelPiece(i, stream, index, mix_channel[i].samples, mixable, volume);
+
+    mix_channel[i].samples += mixable;
+    mix_channel[i].playing -= mixable;
+
+    return mixable;
+}
+
+/* Start the chunk of the channel over */
+static void Mix_RewindChannel(int i)
+{
+    if (mix_channel[i].voice) {
+        _Mix_ChunkVoiceRewind(mix_channel[i].voice);
+    }
+    mix_channel[i].samples = mix_channel[i].chunk->abuf;
+    mix_channel[i].playing = (int)mix_channel[i].chunk->alen;
+}
+
+/* Fade the tail of the stolen sound out under the new sound of the channel */
+static void Mix_MixRelease(int i, Uint8 *stream, int len, int master_vol)
+{
+    int frame_size = Mix_FrameSize();
+    int volume = (master_vol * mix_channel[i].release_volume) / MIX_MAX_VOLUME;
+    int index = 0, piece;
+    Uint64 frames_left;
+    float length = (float)mix_channel[i].release_length;
+
+    while (mix_channel[i].release_left > 0 && index < len) {
+        frames_left = mix_channel[i].release_length - mix_channel[i].release_pos;
+        piece = SDL_min(len - index, mix_channel[i].release_left);
+        piece = SDL_min(piece, mix_effects_buffer_size);
+        if ((Uint64)(piece / frame_size) > frames_left) {
+            piece = (int)frames_left * frame_size;
+        }
+
+        if (mix_channel[i].release_voice) {
+            mix_channel[i].release_samples = _Mix_ChunkVoiceRead(mix_channel[i].release_voice, &piece);
+        }
+        if (piece <= 0) {
+            break;
+        }
+
+        SDL_memcpy(mix_effects_buffer, mix_channel[i].release_samples, (size_t)piece);
+        _Mix_ApplyGainRamp(mix_effects_buffer, mixer.format, mixer.channels, piece / frame_size,
+                           1.0f - (float)mix_channel[i].release_pos / length, -1.0f / length, SDL_FALSE);
+        if (!_Mix_MixBusAdd(index, mix_effects_buffer, piece, volume)) {
+            SDL_MixAudioFormat(stream + index, mix_effects_buffer, mixer.format, (Uint32)piece, volume);
+        }
+
+        mix_channel[i].release_samples += piece;
+        mix_channel[i].release_left -= piece;
+        mix_channel[i].release_pos += (Uint64)(piece / frame_size);
+        index += piece;
+    }
+
+    /* The voice gets freed by Mix_ReapVoices_locked() */
+    if (mix_channel[i].release_pos >= mix_channel[i].release_length || index < len) {
+        mix_channel[i].release_left = 0;
+    }
+}
+
+/* Mix the channel into the output, the channel gets started, expired and
+   faded out right at its frames of the mixer clock */
+static void Mix_MixChannel(int i, Uint8 *stream, int len, int master_vol)
+{
+    Uint64 end = mix_clock + (Uint64)(len / Mix_FrameSize());
+    Uint64 stop;
+    int volume, index, limit, mixed;
+
+    if (mix_channel[i].paused || mix_channel[i].playing <= 0) {
+        return;
+    }
+
+    Mix_ChannelRange(i, len, &index, &limit);
+    volume = Mix_ChannelVolume(i, master_vol);
+
+    while (mix_channel[i].playing > 0 && index < limit) {
+        index += Mix_MixChannelSamples(i, stream, index, limit - index, volume);
+
+        /* rcg06072001 Alert app if channel is done playing. */
+        if (!mix_channel[i].playing && !mix_channel[i].looping) {
+            Mix_StopFading_locked(i);
+            mix_channel[i].expire = 0;
+            _Mix_channel_done_playing(i);
+
+            if (mix_channel[i].playing > 0) {
+                /* Another chunk got been started by the application callback */
+                mixed = index;
+                Mix_ChannelRange(i, len, &index, &limit);
+                if (index < mixed) {
+                    index = mixed;
+                }
+                volume = Mix_ChannelVolume(i, master_vol);
+            }
+        }
+    }
+
+    /* If looping the sample and we are at its end, make sure
+       we will still return a full buffer */
+    while (mix_channel[i].looping && index < limit) {
+        if (mix_channel[i].looping > 0) {
+            --mix_channel[i].looping;
+        }
+        Mix_RewindChannel(i);
+
+        /* Compressed chunks come by pieces up to the voice buffer size */
+        do {
+            index += Mix_MixChannelSamples(i, stream, index, limit - index, volume);
+        } while (mix_channel[i].playing > 0 && index < limit);
+    }
+    if (! mix_channel[i].playing && mix_channel[i].looping) {
+        if (mix_channel[i].looping > 0) {
+            --mix_channel[i].looping;
+        }
+        Mix_RewindChannel(i);
+    }
+
+    if (mix_channel[i].playing <= 0 && !mix_channel[i].looping) {
+        return;
+    }
+
+    stop = Mix_ChannelStopFrame(i);
+    if (stop != 0 && stop <= end) {
+        /* Expiration delay or the fade out is over */
+        Mix_StopFading_locked(i);
+        mix_channel[i].playing = 0;
+        mix_channel[i].looping = 0;
+        mix_channel[i].expire = 0;
+        _Mix_channel_done_playing(i);
+    } else if (mix_channel[i].fading != MIX_NO_FADING) {
+        if (mix_channel[i].fade_start + mix_channel[i].fade_length <= end) {
+            Mix_StopFading_locked(i);
+        } else {
+            /* Keep the reported volume following the fade */
+            mix_channel[i].volume = (int)(mix_channel[i].fade_volume * Mix_FadeGain(i, end));
+        }
+    }
+}
 
 /* Mixing function */
 static void SDLCALL
 mix_channels(void *udata, Uint8 *stream, int len)
 {
-    Uint8 *mix_input;
-    int i, mixable, master_vol;
-    Uint32 sdl_ticks;
+    int i, master_vol;
+    int bus_samples = len / (SDL_AUDIO_BITSIZE(mixer.format) / 8);
+    Uint64 perf_callback = _Mix_PerfBegin();
+    Uint64 perf_stage;
 
     (void)udata;
 
+    /* The callback runs under the audio lock, apply the control commands first */
+    SDL_AtomicAdd(&audio_lock_depth, 1);
+    audio_lock_owner = SDL_ThreadID();
+    _Mix_CommandDrain();
+
     /* Need to initialize the stream in SDL 1.3+ */
     SDL_memset(stream, mixer.silence, (size_t)len);
 
     /* Mix the music (must be done before the channels are added) */
+    perf_stage = _Mix_PerfBegin();
     mix_music(music_data, stream, len);
+    _Mix_PerfEnd(&mix_perf[MIX_PERF_MUSIC], NULL, perf_stage);
+
+    /* Buffers bigger than the bus are mixed directly into the output */
+    if (mix_bus && bus_samples <= mix_bus_samples) {
+        SDL_memset(mix_bus, 0, (size_t)bus_samples * sizeof(float));
+        _Mix_BusAccumulate(mix_bus, stream, mixer.format, bus_samples, 1.0f);
+        mix_bus_active = SDL_TRUE;
+    }
+
     if (mix_multi_music) {
+        perf_stage = _Mix_PerfBegin();
         mix_multi_music(music_data, stream, len);
+        _Mix_PerfEnd(&mix_perf[MIX_PERF_MULTI_MUSIC], NULL, perf_stage);
     }
 
     master_vol = SDL_AtomicGet(&master_volume);
 
     /* Mix any playing channels... */
-    sdl_ticks = SDL_GetTicks();
+    perf_stage = _Mix_PerfBegin();
     for (i = 0; i < num_channels; ++i) {
-        if (!mix_channel[i].paused) {
-            if (mix_channel[i].expire > 0 && mix_channel[i].expire < sdl_ticks) {
-                /* Expiration delay for that channel is reached */
-                mix_channel[i].playing = 0;
-                mix_channel[i].looping = 0;
-                mix_channel[i].fading = MIX_NO_FADING;
-                mix_channel[i].expire = 0;
-                _Mix_channel_done_playing(i);
-            } else if (mix_channel[i].fading != MIX_NO_FADING) {
-                Uint32 ticks = sdl_ticks - mix_channel[i].ticks_fade;
-                if (ticks >= mix_channel[i].fade_length) {
-                    Mix_Volume(i, mix_channel[i].fade_volume_reset); /* Restore the volume */
-                    if (mix_channel[i].fading == MIX_FADING_OUT) {
-                        mix_channel[i].playing = 0;
-                        mix_channel[i].looping = 0;
-                        mix_channel[i].expire = 0;
-                        _Mix_channel_done_playing(i);
-                    }
-                    mix_channel[i].fading = MIX_NO_FADING;
-                } else {
-                    if (mix_channel[i].fading == MIX_FADING_OUT) {
-                        Mix_Volume(i, (mix_channel[i].fade_volume * (mix_channel[i].fade_length-ticks))
-                                   / mix_channel[i].fade_length);
-                    } else {
-                        Mix_Volume(i, (mix_channel[i].fade_volume * ticks) / mix_channel[i].fade_length);
-                    }
-                }
-            }
-            if (mix_channel[i].playing > 0) {
-                int volume = (master_vol * (mix_channel[i].volume * mix_channel[i].chunk->volume)) / (MIX_MAX_VOLUME * MIX_MAX_VOLUME);
-                int index = 0;
-                int remaining = len;
-                while (mix_channel[i].playing > 0 && index < len) {
-                    remaining = len - index;
-                    mixable = mix_channel[i].playing;
-                    if (mixable > remaining) {
-                        mixable = remaining;
-                    }
-
-                    mix_input = Mix_DoEffects(i, mix_channel[i].samples, mixable);
-                    SDL_MixAudioFormat(stream+index, mix_input, mixer.format, mixable, volume);
-                    if (mix_input != mix_channel[i].samples)
-                        SDL_free(mix_input);
-
-                    mix_channel[i].samples += mixable;
-                    mix_channel[i].playing -= mixable;
-                    index += mixable;
-
-                    /* rcg06072001 Alert app if channel is done playing. */
-                    if (!mix_channel[i].playing && !mix_channel[i].looping) {
-                        mix_channel[i].fading = MIX_NO_FADING;
-                        mix_channel[i].expire = 0;
-                        _Mix_channel_done_playing(i);
-
-                        /* Update the volume after the application callback */
-                        volume = (master_vol * (mix_channel[i].volume * mix_channel[i].chunk->volume)) / (MIX_MAX_VOLUME * MIX_MAX_VOLUME);
-                    }
-                }
-
-                /* If looping the sample and we are at its end, make sure
-                   we will still return a full buffer */
-                while (mix_channel[i].looping && index < len) {
-                    int alen = mix_channel[i].chunk->alen;
-                    remaining = len - index;
-                    if (remaining > alen) {
-                        remaining = alen;
-                    }
-
-                    mix_input = Mix_DoEffects(i, mix_channel[i].chunk->abuf, remaining);
-                    SDL_MixAudioFormat(stream+index, mix_input, mixer.format, remaining, volume);
-                    if (mix_input != mix_channel[i].chunk->abuf)
-                        SDL_free(mix_input);
-
-                    if (mix_channel[i].looping > 0) {
-                        --mix_channel[i].looping;
-                    }
-                    mix_channel[i].samples = mix_channel[i].chunk->abuf + remaining;
-                    mix_channel[i].playing = mix_channel[i].chunk->alen - remaining;
-                    index += remaining;
-                }
-                if (! mix_channel[i].playing && mix_channel[i].looping) {
-                    if (mix_channel[i].looping > 0) {
-                        --mix_channel[i].looping;
-                    }
-                    mix_channel[i].samples = mix_channel[i].chunk->abuf;
-                    mix_channel[i].playing = mix_channel[i].chunk->alen;
-                }
-            }
+        if (mix_channel[i].release_left > 0) {
+            Mix_MixRelease(i, stream, len, master_vol);
         }
+        Mix_MixChannel(i, stream, len, master_vol);
+    }
+
+    _Mix_PerfEnd(&mix_perf[MIX_PERF_CHANNELS], NULL, perf_stage);
+
+    /* Convert and clip the whole mix once */
+    if (mix_bus_active) {
+        _Mix_BusConvert(stream, mix_bus, mixer.format, bus_samples);
+        mix_bus_active = SDL_FALSE;
     }
 
     /* rcg06122001 run posteffects... */
+    perf_stage = _Mix_PerfBegin();
     Mix_DoEffects(MIX_CHANNEL_POST, stream, len);
 
     if (mix_postmix) {
         mix_postmix(mix_postmix_data, stream, len);
     }
+    _Mix_PerfEnd(&mix_perf[MIX_PERF_POST_EFFECTS], NULL, perf_stage);
+
+    mix_clock += (Uint64)(len / Mix_FrameSize());
+
+    audio_lock_owner = 0;
+    SDL_AtomicAdd(&audio_lock_depth, -1);
+    _Mix_PerfEnd(&mix_perf[MIX_PERF_CALLBACK], NULL, perf_callback);
 }
 
 #if 0
@@ -511,27 +884,47 @@ int MIXCALLCC Mix_InitMixer(const SDL_AudioSpec *spec, SDL_bool skip_init_check)
     }
 
     SDL_memcpy(&mixer, spec, sizeof(SDL_AudioSpec));
+    _Mix_PerfSetPeriod(Mix_BufferFrames(&mixer), mixer.freq);
 
 #if 0
     PrintFormat("Audio device", &mixer);
 #endif
 
+    if (Mix_AllocEffectsBuffer(&mixer) < 0) {
+        Mix_OutOfMemory();
+        return(-1);
+    }
+
+    if (mix_bus_enabled && Mix_AllocMixBus(&mixer) < 0) {
+        Mix_OutOfMemory();
+        return(-1);
+    }
+
     num_channels = MIX_CHANNELS;
+    mix_clock = 0;
     mix_channel = (struct _Mix_Channel *) SDL_malloc(num_channels * sizeof(struct _Mix_Channel));
 
     /* Clear out the audio channels */
     for (i = 0; i < num_channels; ++i) {
         mix_channel[i].chunk = NULL;
+        mix_channel[i].voice = NULL;
         mix_channel[i].playing = 0;
         mix_channel[i].looping = 0;
         mix_channel[i].volume = SDL_MIX_MAXVOLUME;
         mix_channel[i].fade_volume = SDL_MIX_MAXVOLUME;
         mix_channel[i].fade_volume_reset = SDL_MIX_MAXVOLUME;
         mix_channel[i].fading = MIX_NO_FADING;
+        mix_channel[i].fade_curve = MIX_FADE_LINEAR;
         mix_channel[i].tag = -1;
+        mix_channel[i].start_frame = 0;
         mix_channel[i].expire = 0;
         mix_channel[i].effects = NULL;
         mix_channel[i].paused = 0;
+        SDL_zero(mix_channel[i].perf);
+        mix_channel[i].priority = 0;
+        mix_channel[i].release_chunk = NULL;
+        mix_channel[i].release_voice = NULL;
+        mix_channel[i].release_left = 0;
     }
     Mix_VolumeMusicStream(NULL, SDL_MIX_MAXVOLUME);
 
@@ -594,6 +987,160 @@ int MIXCALLCC Mix_OpenAudio(int frequency, Uint16 format, int nchannels, int chu
                                 SDL_AUDIO_ALLOW_CHANNELS_CHANGE);
 }
 
+/* Open the mixer without the audio device, it's driven by Mix_RenderFrames() */
+int MIXCALLCC Mix_OpenAudioOffline(int frequency, Uint16 format, int nchannels, int chunksize)
+{
+    SDL_AudioSpec spec;
+
+    if (audio_opened) {
+        return Mix_SetError("Audio device is already opened");
+    }
+
+    if (frequency <= 0 || nchannels <= 0 || nchannels > 8 || chunksize <= 0 ||
+        (SDL_AUDIO_BITSIZE(format) != 8 && SDL_AUDIO_BITSIZE(format) != 16 && SDL_AUDIO_BITSIZE(format) != 32)) {
+        return Mix_SetError("Invalid audio format");
+    }
+
+    SDL_zero(spec);
+    spec.freq = frequency;
+    spec.format = format;
+    spec.channels = (Uint8)nchannels;
+    spec.samples = (Uint16)SDL_min(chunksize, 0xFFFF);
+    /* Same as SDL does, 0x80 isn't perfect for U16, but it's the closest byte */
+    spec.silence = (format == AUDIO_U8 || format == AUDIO_U16LSB || format == AUDIO_U16MSB) ? 0x80 : 0x00;
+    spec.size = (Uint32)(SDL_AUDIO_BITSIZE(format) / 8) * spec.channels * spec.samples;
+    spec.callback = mix_channels;
+    spec.userdata = NULL;
+
+    if (Mix_InitMixer(&spec, SDL_TRUE) < 0) {
+        return -1;
+    }
+
+    _Mix_SetMusicOffline(SDL_TRUE);
+    return 0;
+}
+
+/* Run the mixer for the given number of frames into the buffer */
+int MIXCALLCC Mix_RenderFrames(void *buffer, int frames)
+{
+    Uint8 *out = (Uint8 *)buffer;
+    int frame_size, piece, rendered = 0;
+
+    if (!audio_opened) {
+        return Mix_SetError("Audio device hasn't been opened");
+    }
+
+    if (audio_device) {
+        return Mix_SetError("Can't render while the audio device is playing");
+    }
+
+    if (!buffer || frames < 0) {
+        return Mix_SetError("Invalid parameters");
+    }
+
+    frame_size = Mix_FrameSize();
+
+    while (rendered < frames) {
+        piece = SDL_min(frames - rendered, Mix_BufferFrames(&mixer));
+        SDL_memset(out, mixer.silence, (size_t)piece * frame_size);
+        mix_channels(NULL, out, piece * frame_size);
+        out += (size_t)piece * frame_size;
+        rendered += piece;
+    }
+
+    return rendered;
+}
+
+/* Render into a RIFF WAVE stream */
+int MIXCALLCC Mix_RenderWAV_RW(SDL_RWops *dst, int freedst, int frames)
+{
+    Uint8 *buffer = NULL;
+    Uint16 tag;
+    Uint32 data_size;
+    int frame_size, piece, left, ret = -1;
+
+    if (!dst) {
+        return Mix_SetError("Invalid parameters");
+    }
+
+    if (!audio_opened) {
+        Mix_SetError("Audio device hasn't been opened");
+        goto done;
+    }
+
+    switch (mixer.format) {
+    case AUDIO_U8:
+    case AUDIO_S16LSB:
+    case AUDIO_S32LSB:
+        tag = 1; /* PCM */
+        break;
+    case AUDIO_F32LSB:
+        tag = 3; /* IEEE float */
+        break;
+    default:
+        Mix_SetError("The mixer format can't be stored as WAVE");
+        goto done;
+    }
+
+    frame_size = Mix_FrameSize();
+    if (frames < 0 || (Uint64)frames * (Uint64)frame_size > 0xFFFFFFFF - 36) {
+        Mix_SetError("Invalid number of frames");
+        goto done;
+    }
+    data_size = (Uint32)frames * (Uint32)frame_size;
+
+    if (SDL_RWwrite(dst, "RIFF", 4, 1) != 1 ||
+        SDL_WriteLE32(dst, 36 + data_size) != 1 ||
+        SDL_RWwrite(dst, "WAVEfmt ", 8, 1) != 1 ||
+        SDL_WriteLE32(dst, 16) != 1 ||
+        SDL_WriteLE16(dst, tag) != 1 ||
+        SDL_WriteLE16(dst, mixer.channels) != 1 ||
+        SDL_WriteLE32(dst, (Uint32)mixer.freq) != 1 ||
+        SDL_WriteLE32(dst, (Uint32)(mixer.freq * frame_size)) != 1 ||
+        SDL_WriteLE16(dst, (Uint16)frame_size) != 1 ||
+        SDL_WriteLE16(dst, (Uint16)SDL_AUDIO_BITSIZE(mixer.format)) != 1 ||
+        SDL_RWwrite(dst, "data", 4, 1) != 1 ||
+        SDL_WriteLE32(dst, data_size) != 1) {
+        goto done;
+    }
+
+    buffer = (Uint8 *)SDL_malloc((size_t)Mix_BufferFrames(&mixer) * frame_size);
+    if (!buffer) {
+        Mix_OutOfMemory();
+        goto done;
+    }
+
+    for (left = frames; left > 0; left -= piece) {
+        piece = SDL_min(left, Mix_BufferFrames(&mixer));
+        if (Mix_RenderFrames(buffer, piece) < 0) {
+            goto done;
+        }
+        if (SDL_RWwrite(dst, buffer, (size_t)piece * frame_size, 1) != 1) {
+            goto done;
+        }
+    }
+
+    ret = 0;
+
+done:
+    SDL_free(buffer);
+    if (freedst && SDL_RWclose(dst) < 0) {
+        ret = -1;
+    }
+    return ret;
+}
+
+int MIXCALLCC Mix_RenderWAV(const char *file, int frames)
+{
+    SDL_RWops *dst = SDL_RWFromFile(file, "wb");
+
+    if (!dst) {
+        return -1;
+    }
+
+    return Mix_RenderWAV_RW(dst, 1, frames);
+}
+
 /* Pause or resume the audio streaming */
 void MIXCALLCC Mix_PauseAudio(int pause_on)
 {
@@ -610,6 +1157,7 @@ void MIXCALLCC Mix_PauseAudio(int pause_on)
 int MIXCALLCC Mix_AllocateChannels(int numchans)
 {
     struct _Mix_Channel *mix_channel_tmp;
+    Mix_ChunkVoice *dead = NULL;
     int i;
 
     if (numchans < 0 || numchans == num_channels) {
@@ -625,6 +1173,14 @@ int MIXCALLCC Mix_AllocateChannels(int numchans)
     }
 
     Mix_LockAudio();
+    /* Voices of the removed channels */
+    for (i = numchans; i < num_channels; i++) {
+        dead = _Mix_ChunkVoiceLink(mix_channel[i].voice, dead);
+        mix_channel[i].voice = NULL;
+        dead = _Mix_ChunkVoiceLink(mix_channel[i].release_voice, dead);
+        mix_channel[i].release_voice = NULL;
+    }
+
     /* Allocate channels into temporary pointer */
     if (numchans) {
         mix_channel_tmp = (struct _Mix_Channel *)SDL_realloc(mix_channel, numchans * sizeof(struct _Mix_Channel));
@@ -645,16 +1201,24 @@ int MIXCALLCC Mix_AllocateChannels(int numchans)
             /* Initialize the new channels */
             for (i = num_channels; i < numchans; i++) {
                 mix_channel[i].chunk = NULL;
+                mix_channel[i].voice = NULL;
                 mix_channel[i].playing = 0;
                 mix_channel[i].looping = 0;
                 mix_channel[i].volume = MIX_MAX_VOLUME;
                 mix_channel[i].fade_volume = MIX_MAX_VOLUME;
                 mix_channel[i].fade_volume_reset = MIX_MAX_VOLUME;
                 mix_channel[i].fading = MIX_NO_FADING;
+                mix_channel[i].fade_curve = MIX_FADE_LINEAR;
                 mix_channel[i].tag = -1;
+                mix_channel[i].start_frame = 0;
                 mix_channel[i].expire = 0;
                 mix_channel[i].effects = NULL;
                 mix_channel[i].paused = 0;
+                SDL_zero(mix_channel[i].perf);
+                mix_channel[i].priority = 0;
+                mix_channel[i].release_chunk = NULL;
+                mix_channel[i].release_voice = NULL;
+                mix_channel[i].release_left = 0;
             }
         }
         num_channels = numchans;
@@ -664,6 +1228,8 @@ int MIXCALLCC Mix_AllocateChannels(int numchans)
     }
     Mix_UnlockAudio();
 
+    _Mix_ChunkVoiceFree(dead);
+
     return num_channels; /* If the return value equals numchans the allocation was successful */
 }
 
@@ -694,112 +1260,128 @@ int MIXCALLCC Mix_QuerySpecEx(SDL_AudioSpec *out_spec)
     return(audio_opened);
 }
 
-typedef struct _MusicFragment
+int MIXCALLCC Mix_SetResamplerQuality(Mix_ResamplerQuality quality)
 {
-    Uint8 *data;
-    int size;
-    struct _MusicFragment *next;
-} MusicFragment;
+#ifdef USE_CUSTOM_AUDIO_STREAM
+    if (quality < MIX_RESAMPLER_NEAREST || quality > MIX_RESAMPLER_SINC) {
+        Mix_SetError("Unknown resampler quality %d", (int)quality);
+        return -1;
+    }
+    Mix_AudioStreamSetDefaultQuality((int)quality);
+    return 0;
+#else
+    (void)quality;
+    Mix_SetError("The library is built without the low-end resampler");
+    return -1;
+#endif
+}
+
+int MIXCALLCC Mix_GetResamplerQuality(void)
+{
+#ifdef USE_CUSTOM_AUDIO_STREAM
+    return Mix_AudioStreamGetDefaultQuality();
+#else
+    return -1;
+#endif
+}
+
+/* Grow the decoding buffer to fit at least 'need' bytes */
+static SDL_bool grow_decode_buffer(Uint8 **buf, size_t *capacity, size_t need)
+{
+    size_t new_capacity = *capacity;
+    Uint8 *new_buf;
+
+    if (need <= *capacity) {
+        return SDL_TRUE;
+    }
+
+    while (new_capacity < need) {
+        new_capacity += new_capacity / 2;
+    }
+
+    new_buf = (Uint8 *)SDL_realloc(*buf, new_capacity);
+    if (!new_buf) {
+        return SDL_FALSE;
+    }
+
+    *buf = new_buf;
+    *capacity = new_capacity;
+    return SDL_TRUE;
+}
 
 static SDL_AudioSpec *Mix_LoadMusic_RW(SDL_RWops *src, int freesrc, SDL_AudioSpec *spec, Uint8 **audio_buf, Uint32 *audio_len)
 {
-    int i;
-    Mix_MusicType music_type;
     Mix_MusicInterface *interface = NULL;
     void *music = NULL;
-    Sint64 start;
     SDL_bool playing;
-    MusicFragment *first = NULL, *last = NULL, *fragment = NULL;
-    int count = 0;
+    SDL_bool locked;
+    Uint8 *buf = NULL, *shrunk_buf;
+    size_t len = 0, capacity;
+    double duration = -1.0;
+    int frame_size;
     int fragment_size;
 
-    music_type = detect_music_type(src);
-    if (!load_music_type(music_type) || !open_music_type_ex(music_type, midiplayer_current)) {
+    music = _Mix_CreateChunkDecoder(src, freesrc, &interface);
+    if (!music) {
         return NULL;
     }
+    /* The interface owns the data source now */
+    freesrc = SDL_FALSE;
 
     *spec = mixer;
 
     /* Use fragments sized on full audio frame boundaries - this'll do */
     fragment_size = spec->size;
 
-    start = SDL_RWtell(src);
-    for (i = 0; i < get_num_music_interfaces(); ++i) {
-        interface = get_music_interface(i);
-        if (!interface->opened) {
-            continue;
-        }
-        if (interface->type != music_type) {
-            continue;
-        }
-        if (!interface->CreateFromRW || !interface->GetAudio) {
-            continue;
-        }
-
-        /* These music interfaces are not safe to use while music is playing */
-        if (interface->api == MIX_MUSIC_CMD ||
-             interface->api == MIX_MUSIC_NATIVEMIDI) {
-            continue;
-        }
-
-        music = interface->CreateFromRW(src, freesrc);
-        if (music) {
-            /* The interface owns the data source now */
-            freesrc = SDL_FALSE;
-            break;
-        }
-
-        /* Reset the stream for the next decoder */
-        SDL_RWseek(src, start, RW_SEEK_SET);
+    /* The music object is private here, so the audio thread isn't blocked
+       while decoding, except of libraries which keep their state globally */
+    locked = (interface->api == MIX_MUSIC_MODPLUG);
+    if (locked) {
+        Mix_LockAudio();
     }
 
-    if (!music) {
-        if (freesrc) {
-            SDL_RWclose(src);
-        }
-        Mix_SetError("Unrecognized audio format");
-        return NULL;
+    /* Decode straight into the buffer of the whole length when it's known,
+       otherwise let the buffer grow while decoding */
+    frame_size = (SDL_AUDIO_BITSIZE(spec->format) / 8) * spec->channels;
+    if (interface->Duration) {
+        duration = interface->Duration(music);
+    }
+    if (duration > 0.0 && duration * spec->freq * frame_size < (double)(SDL_MAX_UINT32 - fragment_size)) {
+        capacity = (size_t)(duration * spec->freq) * frame_size + fragment_size;
+    } else {
+        capacity = (size_t)spec->freq * frame_size;
+    }
+    if (capacity < (size_t)fragment_size) {
+        capacity = (size_t)fragment_size;
     }
 
-    Mix_LockAudio();
+    buf = (Uint8 *)SDL_malloc(capacity);
 
     if (interface->Play) {
         interface->Play(music, 1);
     }
-    playing = SDL_TRUE;
+    playing = (buf != NULL);
 
     while (playing) {
         int left;
 
-        fragment = (MusicFragment *)SDL_malloc(sizeof(*fragment));
-        if (!fragment) {
-            /* Uh oh, out of memory, let's return what we have */
-            break;
-        }
-        fragment->data = (Uint8 *)SDL_malloc(fragment_size);
-        if (!fragment->data) {
+        if (!grow_decode_buffer(&buf, &capacity, len + fragment_size)) {
             /* Uh oh, out of memory, let's return what we have */
-            SDL_free(fragment);
             break;
         }
-        fragment->next = NULL;
 
-        left = interface->GetAudio(music, fragment->data, fragment_size);
+        left = interface->GetAudio(music, buf + len, fragment_size);
         if (left > 0) {
             playing = SDL_FALSE;
         } else if (interface->IsPlaying) {
             playing = interface->IsPlaying(music);
         }
-        fragment->size = (fragment_size - left);
+        len += (size_t)(fragment_size - left);
 
-        if (!first) {
-            first = fragment;
-        }
-        if (last) {
-            last->next = fragment;
+        if (len > SDL_MAX_UINT32 - (size_t)fragment_size) {
+            /* Chunks can't be longer */
+            break;
         }
-        last = fragment;
-        ++count;
     }
 
     if (interface->Stop) {
@@ -810,39 +1392,116 @@ static SDL_AudioSpec *Mix_LoadMusic_RW(SDL_RWops *src, int freesrc, SDL_AudioSpe
         interface->Delete(music);
     }
 
-    Mix_UnlockAudio();
+    if (locked) {
+        Mix_UnlockAudio();
+    }
 
-    if (count > 0) {
-        *audio_len = (count - 1) * fragment_size + last->size;
-        *audio_buf = (Uint8 *)SDL_malloc(*audio_len);
-        if (*audio_buf) {
-            Uint8 *dst = *audio_buf;
-            for (fragment = first; fragment; fragment = fragment->next) {
-                SDL_memcpy(dst, fragment->data, fragment->size);
-                dst += fragment->size;
+    if (!buf) {
+        Mix_OutOfMemory();
+        spec = NULL;
+    } else if (len > 0) {
+        /* Give back the unused tail */
+        if (len < capacity) {
+            shrunk_buf = (Uint8 *)SDL_realloc(buf, len);
+            if (shrunk_buf) {
+                buf = shrunk_buf;
             }
-        } else {
-            Mix_OutOfMemory();
-            spec = NULL;
         }
+        *audio_buf = buf;
+        *audio_len = (Uint32)len;
     } else {
+        SDL_free(buf);
         Mix_SetError("No audio data");
         spec = NULL;
     }
 
-    while (first) {
-        fragment = first;
-        first = first->next;
-        SDL_free(fragment->data);
-        SDL_free(fragment);
-    }
-
     if (freesrc) {
         SDL_RWclose(src);
     }
     return spec;
 }
 
+static Uint32 Mix_GetLE32(const Uint8 *p)
+{
+    return (Uint32)p[0] | ((Uint32)p[1] << 8) | ((Uint32)p[2] << 16) | ((Uint32)p[3] << 24);
+}
+
+/* Point the chunk straight at the samples of the mapped PCM wave file when
+   they are already in the mixer format, the src is kept open by the chunk */
+static SDL_bool Mix_MapWAV(SDL_RWops *src, Mix_Chunk *chunk)
+{
+    const Uint8 *p, *end, *data = NULL;
+    Uint32 size, data_len = 0;
+    Uint16 tag, channels = 0, bits = 0;
+    Uint32 freq = 0;
+    SDL_AudioFormat format = 0;
+    int frame_size;
+
+    p = src->hidden.mem.here;
+    end = src->hidden.mem.stop;
+    if (end - p < 12 || SDL_memcmp(p, "RIFF", 4) != 0 || SDL_memcmp(p + 8, "WAVE", 4) != 0) {
+        return SDL_FALSE;
+    }
+
+    p += 12;
+    while (end - p >= 8) {
+        size = Mix_GetLE32(p + 4);
+        if (SDL_memcmp(p, "fmt ", 4) == 0 && size >= 16 && (Uint64)(end - p - 8) >= size) {
+            tag = (Uint16)(p[8] | (p[9] << 8));
+            if (tag == 0xFFFE && size >= 40) {
+                /* WAVE_FORMAT_EXTENSIBLE: the tag is the beginning of the sub-format GUID */
+                tag = (Uint16)(p[32] | (p[33] << 8));
+            }
+            channels = (Uint16)(p[10] | (p[11] << 8));
+            freq = Mix_GetLE32(p + 12);
+            bits = (Uint16)(p[22] | (p[23] << 8));
+            if (tag == 1 && bits == 8) {
+                format = AUDIO_U8;
+            } else if (tag == 1 && bits == 16) {
+                format = AUDIO_S16LSB;
+            } else if (tag == 1 && bits == 32) {
+                format = AUDIO_S32LSB;
+            } else if (tag == 3 && bits == 32) {
+                format = AUDIO_F32LSB;
+            } else {
+                return SDL_FALSE;
+            }
+        } else if (SDL_memcmp(p, "data", 4) == 0) {
+            data = p + 8;
+            data_len = size;
+            if ((Uint64)(end - data) < size) {
+                data_len = (Uint32)(end - data);
+            }
+            break;
+        }
+        if ((Uint64)(end - p - 8) < (Uint64)size + (size & 1)) {
+            return SDL_FALSE;
+        }
+        p += 8 + (size_t)size + (size & 1);
+    }
+
+    if (!data || format != mixer.format || channels != mixer.channels || (int)freq != mixer.freq) {
+        return SDL_FALSE;
+    }
+
+    /* Samples must be aligned to be read in place */
+    frame_size = (bits / 8) * channels;
+    if (((size_t)data % (bits / 8)) != 0) {
+        return SDL_FALSE;
+    }
+
+    if (_Mix_MappedAttach(chunk, src) < 0) {
+        return SDL_FALSE;
+    }
+
+    chunk->abuf = (Uint8 *)data;
+    chunk->alen = data_len - (data_len % (Uint32)frame_size);
+    chunk->allocated = 3; /* see Mix_FreeChunk() */
+    chunk->volume = MIX_MAX_VOLUME;
+
+    return SDL_TRUE;
+}
+
 /* Load a wave file */
 Mix_Chunk * MIXCALLCC Mix_LoadWAV_RW(SDL_RWops *src, int freesrc)
 {
@@ -891,6 +1550,11 @@ Mix_Chunk * MIXCALLCC Mix_LoadWAV_RW(SDL_RWops *src, int freesrc)
     /* Seek backwards for compatibility with older loaders */
     SDL_RWseek(src, -4, RW_SEEK_CUR);
 
+    /* Files mapped into the memory don't need to be copied */
+    if (freesrc && _Mix_RWIsMapped(src) && Mix_MapWAV(src, chunk)) {
+        return chunk;
+    }
+
     wavfree = 0;
     if (SDL_memcmp(magic, "WAVE", 4) == 0 || SDL_memcmp(magic, "RIFF", 4) == 0) {
         wavfree = 1;
@@ -1046,24 +1710,151 @@ Mix_Chunk * MIXCALLCC Mix_QuickLoad_RAW(Uint8 *mem, Uint32 len)
     return chunk;
 }
 
+/* Load a chunk which stays compressed until it's played */
+Mix_Chunk * MIXCALLCC Mix_LoadWAVCompressed_RW(SDL_RWops *src, int freesrc)
+{
+    if (!src) {
+        Mix_SetError("Mix_LoadWAVCompressed_RW with NULL src");
+        return NULL;
+    }
+
+    /* Make sure audio has been opened */
+    if (!audio_opened) {
+        Mix_SetError("Audio device hasn't been opened");
+        if (freesrc) {
+            SDL_RWclose(src);
+        }
+        return NULL;
+    }
+
+    return _Mix_LoadCompressedChunk(src, freesrc);
+}
+
+Mix_Chunk * MIXCALLCC Mix_LoadWAVCompressed(const char *file)
+{
+    return Mix_LoadWAVCompressed_RW(_Mix_RWFromFile(file, "rb"), 1);
+}
+
+void MIXCALLCC Mix_SetChunkCacheMemory(Sint64 bytes)
+{
+    _Mix_SetChunkCacheMemory(bytes);
+}
+
+Sint64 MIXCALLCC Mix_GetChunkCacheMemory(void)
+{
+    return _Mix_GetChunkCacheMemory();
+}
+
+/* The state as the audio thread sees it, the queued commands aren't applied */
+static int Mix_ChannelPlaying(int which)
+{
+    int status;
+
+    status = 0;
+    if (which == -1) {
+        int i;
+
+        for (i = 0; i < num_channels; ++i) {
+            if ((mix_channel[i].playing > 0) ||
+                mix_channel[i].looping)
+            {
+                ++status;
+            }
+        }
+    } else if (which < num_channels) {
+        if ((mix_channel[which].playing > 0) ||
+             mix_channel[which].looping)
+        {
+            ++status;
+        }
+    }
+    return status;
+}
+
+/* MAKE SURE you hold the audio lock (Mix_LockAudio()) before calling this!
+   Take the voices of the stopped channels to free them out of the lock */
+static Mix_ChunkVoice *Mix_ReapVoices_locked(void)
+{
+    Mix_ChunkVoice *dead = NULL;
+    int i;
+
+    for (i = 0; i < num_channels; ++i) {
+        if (mix_channel[i].voice && !Mix_ChannelPlaying(i)) {
+            dead = _Mix_ChunkVoiceLink(mix_channel[i].voice, dead);
+            mix_channel[i].voice = NULL;
+        }
+        if (mix_channel[i].release_voice && mix_channel[i].release_left <= 0) {
+            dead = _Mix_ChunkVoiceLink(mix_channel[i].release_voice, dead);
+            mix_channel[i].release_voice = NULL;
+        }
+    }
+
+    return dead;
+}
+
 /* MAKE SURE you hold the audio lock (Mix_LockAudio()) before calling this! */
 static void  Mix_HaltChannel_locked(int which)
 {
-    if (Mix_Playing(which)) {
+    if (Mix_ChannelPlaying(which)) {
         mix_channel[which].playing = 0;
         mix_channel[which].looping = 0;
         _Mix_channel_done_playing(which);
     }
     mix_channel[which].expire = 0;
-    if (mix_channel[which].fading != MIX_NO_FADING) /* Restore volume */
-        mix_channel[which].volume = mix_channel[which].fade_volume_reset;
-    mix_channel[which].fading = MIX_NO_FADING;
+    mix_channel[which].release_left = 0;
+    Mix_StopFading_locked(which);
+}
+
+/* MAKE SURE you hold the audio lock (Mix_LockAudio()) before calling this! */
+static Mix_ChunkPolicy *Mix_FindChunkPolicy_locked(const Mix_Chunk *chunk)
+{
+    int i;
+
+    for (i = 0; i < num_chunk_policies; ++i) {
+        if (chunk_policies[i].chunk == chunk) {
+            return &chunk_policies[i];
+        }
+    }
+
+    return NULL;
+}
+
+/* MAKE SURE you hold the audio lock (Mix_LockAudio()) before calling this! */
+static Mix_ChunkPolicy *Mix_AddChunkPolicy_locked(Mix_Chunk *chunk)
+{
+    Mix_ChunkPolicy *policy = Mix_FindChunkPolicy_locked(chunk);
+
+    if (!policy) {
+        policy = (Mix_ChunkPolicy *)SDL_realloc(chunk_policies, (size_t)(num_chunk_policies + 1) * sizeof(Mix_ChunkPolicy));
+        if (!policy) {
+            Mix_OutOfMemory();
+            return NULL;
+        }
+        chunk_policies = policy;
+        policy = &chunk_policies[num_chunk_policies++];
+        policy->chunk = chunk;
+        policy->priority = 0;
+        policy->max_voices = 0;
+    }
+
+    return policy;
+}
+
+/* MAKE SURE you hold the audio lock (Mix_LockAudio()) before calling this! */
+static void Mix_RemoveChunkPolicy_locked(const Mix_Chunk *chunk)
+{
+    Mix_ChunkPolicy *policy = Mix_FindChunkPolicy_locked(chunk);
+
+    if (policy) {
+        *policy = chunk_policies[--num_chunk_policies];
+    }
 }
 
 /* Free an audio chunk previously loaded */
 void MIXCALLCC Mix_FreeChunk(Mix_Chunk *chunk)
 {
     int i;
+    Mix_ChunkVoice *dead = NULL;
 
     /* Caution -- if the chunk is playing, the mixer will crash */
     if (chunk) {
@@ -1074,9 +1865,15 @@ void MIXCALLCC Mix_FreeChunk(Mix_Chunk *chunk)
                 if (chunk == mix_channel[i].chunk) {
                     Mix_HaltChannel_locked(i);
                 }
+                if (chunk == mix_channel[i].release_chunk) {
+                    mix_channel[i].release_left = 0;
+                }
             }
+            dead = Mix_ReapVoices_locked();
         }
+        Mix_RemoveChunkPolicy_locked(chunk);
         Mix_UnlockAudio();
+        _Mix_ChunkVoiceFree(dead);
         /* Actually free the chunk */
         switch (chunk->allocated) {
         case 1:
@@ -1085,6 +1882,12 @@ void MIXCALLCC Mix_FreeChunk(Mix_Chunk *chunk)
         case 2:
             SDL_FreeWAV(chunk->abuf);
             break;
+        case 3:
+            _Mix_MappedRelease(chunk);
+            break;
+        case MIX_CHUNK_COMPRESSED:
+            _Mix_FreeCompressedChunk(chunk);
+            break;
         }
         SDL_free(chunk);
     }
@@ -1168,6 +1971,19 @@ int MIXCALLCC Mix_ReserveChannels(int num)
     return num;
 }
 
+/* Prepare the decoding of the compressed chunk before it gets played */
+static int Mix_NewChunkVoice(Mix_Chunk *chunk, Mix_ChunkVoice **voice)
+{
+    *voice = NULL;
+    if (chunk->allocated == MIX_CHUNK_COMPRESSED) {
+        *voice = _Mix_ChunkVoiceNew(chunk);
+        if (!*voice) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
 static int checkchunkintegral(Mix_Chunk *chunk)
 {
     int frame_width = 1;
@@ -1178,16 +1994,146 @@ static int checkchunkintegral(Mix_Chunk *chunk)
     return chunk->alen;
 }
 
+/* Whether the channel 'a' is better to steal than 'b': it has the lower
+   priority, or it's quieter, or it's older */
+static SDL_bool Mix_StealBefore(int a, int b)
+{
+    int volume_a, volume_b;
+
+    if (b < 0) {
+        return SDL_TRUE;
+    }
+    if (mix_channel[a].priority != mix_channel[b].priority) {
+        return mix_channel[a].priority < mix_channel[b].priority;
+    }
+
+    volume_a = mix_channel[a].volume * mix_channel[a].chunk->volume;
+    volume_b = mix_channel[b].volume * mix_channel[b].chunk->volume;
+    if (volume_a != volume_b) {
+        return volume_a < volume_b;
+    }
+
+    return mix_channel[a].start_frame < mix_channel[b].start_frame;
+}
+
+/* MAKE SURE you hold the audio lock (Mix_LockAudio()) before calling this!
+   Find the channel for the chunk played at any channel: a free one, or the
+   voice to steal when 'steal' gets set. Returns -1 if there is none. */
+static int Mix_PickChannel_locked(Mix_Chunk *chunk, int priority, int max_voices, SDL_bool *steal)
+{
+    int i, voices = 0, victim = -1;
+
+    *steal = SDL_FALSE;
+
+    if (max_voices > 0) {
+        for (i = 0; i < num_channels; ++i) {
+            if (mix_channel[i].chunk != chunk || !Mix_ChannelPlaying(i)) {
+                continue;
+            }
+            ++voices;
+            if (i >= reserved_channels && mix_channel[i].priority <= priority && Mix_StealBefore(i, victim)) {
+                victim = i;
+            }
+        }
+
+        if (voices >= max_voices) {
+            if (!voice_stealing || victim < 0) {
+                Mix_SetError("Too many voices of the chunk are playing");
+                return -1;
+            }
+            *steal = SDL_TRUE;
+            return victim;
+        }
+    }
+
+    for (i = reserved_channels; i < num_channels; ++i) {
+        if (!Mix_ChannelPlaying(i)) {
+            return i;
+        }
+    }
+
+    if (voice_stealing) {
+        for (i = reserved_channels; i < num_channels; ++i) {
+            if (mix_channel[i].priority <= priority && Mix_StealBefore(i, victim)) {
+                victim = i;
+            }
+        }
+        if (victim >= 0) {
+            *steal = SDL_TRUE;
+            return victim;
+        }
+    }
+
+    Mix_SetError("No free channels available");
+    return -1;
+}
+
+/* MAKE SURE you hold the audio lock (Mix_LockAudio()) before calling this!
+   Stop the playing sound of the channel to start a new one, its tail gets
+   faded out under the new sound. Returns the voice which is not needed. */
+static Mix_ChunkVoice *Mix_StealChannel_locked(int which)
+{
+    Mix_ChunkVoice *dead = mix_channel[which].release_voice;
+    Uint64 length = Mix_MsToFrames(voice_steal_fade_ms);
+
+    mix_channel[which].release_voice = NULL;
+    mix_channel[which].release_left = 0;
+
+    if (length > 0 && mix_effects_buffer && !mix_channel[which].paused &&
+        mix_channel[which].start_frame <= mix_clock) {
+        mix_channel[which].release_chunk = mix_channel[which].chunk;
+        mix_channel[which].release_voice = mix_channel[which].voice;
+        mix_channel[which].voice = NULL;
+        mix_channel[which].release_samples = mix_channel[which].samples;
+        mix_channel[which].release_left = mix_channel[which].playing;
+        mix_channel[which].release_volume = (mix_channel[which].volume * mix_channel[which].chunk->volume) / MIX_MAX_VOLUME;
+        mix_channel[which].release_pos = 0;
+        mix_channel[which].release_length = length;
+    }
+
+    _Mix_channel_done_playing(which);
+
+    return dead;
+}
+
+/* MAKE SURE you hold the audio lock (Mix_LockAudio()) before calling this!
+   Choose the channel to play the chunk at and stop what it plays, 'stolen'
+   gets the voice to free. Returns -1 if there is no channel. */
+static int Mix_TakeChannel_locked(int which, Mix_Chunk *chunk, Mix_ChunkVoice **stolen)
+{
+    Mix_ChunkPolicy *policy = Mix_FindChunkPolicy_locked(chunk);
+    int priority = policy ? policy->priority : 0;
+    SDL_bool steal;
+
+    *stolen = NULL;
+
+    if (which == -1) {
+        which = Mix_PickChannel_locked(chunk, priority, policy ? policy->max_voices : 0, &steal);
+        if (steal) {
+            *stolen = Mix_StealChannel_locked(which);
+        }
+    } else if (Mix_ChannelPlaying(which)) {
+        _Mix_channel_done_playing(which);
+    }
+
+    if (which >= 0 && which < num_channels) {
+        mix_channel[which].priority = priority;
+    }
+
+    return which;
+}
+
 /* Play an audio chunk on a specific channel.
    If the specified channel is -1, play on the first free channel.
    'ticks' is the number of milliseconds at most to play the sample, or -1
    if there is no limit.
    'volume' is the initial volume on play begining. -1 means the volume will not be changed.
+   'frame' is the frame of the mixer clock to start at, the past frames mean now.
    Returns which channel was used to play the sound.
 */
-int MIXCALLCC Mix_PlayChannelTimedVolume(int which, Mix_Chunk *chunk, int loops, int ticks, int volume)
+static int Mix_PlayChannelFrame(int which, Mix_Chunk *chunk, int loops, int ticks, int volume, Uint64 frame)
 {
-    int i;
+    Mix_ChunkVoice *voice, *dead, *stolen;
 
     /* Don't play null pointers :-) */
     if (chunk == NULL) {
@@ -1196,38 +2142,36 @@ int MIXCALLCC Mix_PlayChannelTimedVolume(int which, Mix_Chunk *chunk, int loops,
     if (!checkchunkintegral(chunk)) {
         return Mix_SetError("Tried to play a chunk with a bad frame");
     }
+    if (Mix_NewChunkVoice(chunk, &voice) < 0) {
+        return -1;
+    }
 
     /* Lock the mixer while modifying the playing channels */
     Mix_LockAudio();
     {
-        /* If which is -1, play on the first free channel */
-        if (which == -1) {
-            for (i = reserved_channels; i < num_channels; ++i) {
-                if (!Mix_Playing(i))
-                    break;
-            }
-            if (i == num_channels) {
-                Mix_SetError("No free channels available");
-                which = -1;
-            } else {
-                which = i;
-            }
-        } else {
-            if (Mix_Playing(which))
-                _Mix_channel_done_playing(which);
-        }
+        /* If which is -1, play on the first free channel, or steal one */
+        which = Mix_TakeChannel_locked(which, chunk, &stolen);
+
+        dead = Mix_ReapVoices_locked();
+        dead = _Mix_ChunkVoiceLink(stolen, dead);
 
         /* Queue up the audio data for this channel */
         if (which >= 0 && which < num_channels) {
-            Uint32 sdl_ticks = SDL_GetTicks();
+            if (frame < mix_clock) {
+                frame = mix_clock;
+            }
+            dead = _Mix_ChunkVoiceLink(mix_channel[which].voice, dead);
+            mix_channel[which].voice = voice;
+            voice = NULL;
             mix_channel[which].samples = chunk->abuf;
             mix_channel[which].playing = (int)chunk->alen;
             mix_channel[which].looping = loops;
             mix_channel[which].chunk = chunk;
             mix_channel[which].paused = 0;
             mix_channel[which].fading = MIX_NO_FADING;
-            mix_channel[which].start_time = sdl_ticks;
-            mix_channel[which].expire = (ticks > 0) ? (sdl_ticks + (Uint32)ticks) : 0;
+            mix_channel[which].start_time = SDL_GetTicks();
+            mix_channel[which].start_frame = frame;
+            mix_channel[which].expire = (ticks > 0) ? (frame + Mix_MsToFrames(ticks)) : 0;
             if (volume >= 0) {
                 mix_channel[which].volume = (volume > MIX_MAX_VOLUME) ? MIX_MAX_VOLUME : volume;
             }
@@ -1235,10 +2179,23 @@ int MIXCALLCC Mix_PlayChannelTimedVolume(int which, Mix_Chunk *chunk, int loops,
     }
     Mix_UnlockAudio();
 
+    _Mix_ChunkVoiceFree(voice);
+    _Mix_ChunkVoiceFree(dead);
+
     /* Return the channel on which the sound is being played */
     return which;
 }
 
+int MIXCALLCC Mix_PlayChannelTimedVolume(int which, Mix_Chunk *chunk, int loops, int ticks, int volume)
+{
+    return Mix_PlayChannelFrame(which, chunk, loops, ticks, volume, 0);
+}
+
+int MIXCALLCC Mix_PlayChannelAt(int which, Mix_Chunk *chunk, int loops, Uint64 frame)
+{
+    return Mix_PlayChannelFrame(which, chunk, loops, -1, -1, frame);
+}
+
 int MIXCALLCC Mix_PlayChannel(int channel, Mix_Chunk *chunk, int loops)
 {
     return Mix_PlayChannelTimedVolume(channel, chunk, loops, -1, -1);
@@ -1261,7 +2218,27 @@ int MIXCALLCC Mix_ExpireChannel(int which, int ticks)
         }
     } else if (which < num_channels) {
         Mix_LockAudio();
-        mix_channel[which].expire = (ticks>0) ? (SDL_GetTicks() + (Uint32)ticks) : 0;
+        mix_channel[which].expire = (ticks>0) ? (mix_clock + Mix_MsToFrames(ticks)) : 0;
+        Mix_UnlockAudio();
+        ++status;
+    }
+    return status;
+}
+
+/* Change the expiration frame of the mixer clock for a channel */
+int MIXCALLCC Mix_ExpireChannelAt(int which, Uint64 frame)
+{
+    int status = 0;
+
+    if (which == -1) {
+        int i;
+        for (i = 0; i < num_channels; ++i) {
+            status += Mix_ExpireChannelAt(i, frame);
+        }
+    } else if (which < num_channels) {
+        Mix_LockAudio();
+        /* Past frames expire the channel with the next callback */
+        mix_channel[which].expire = (frame > 0 && frame < mix_clock) ? mix_clock : frame;
         Mix_UnlockAudio();
         ++status;
     }
@@ -1271,7 +2248,7 @@ int MIXCALLCC Mix_ExpireChannel(int which, int ticks)
 /* Fade in a sound on a channel, over ms milliseconds */
 int MIXCALLCC Mix_FadeInChannelTimedVolume(int which, Mix_Chunk *chunk, int loops, int ms, int ticks, int volume)
 {
-    int i;
+    Mix_ChunkVoice *voice, *dead, *stolen;
 
     /* Don't play null pointers :-) */
     if (chunk == NULL) {
@@ -1280,29 +2257,24 @@ int MIXCALLCC Mix_FadeInChannelTimedVolume(int which, Mix_Chunk *chunk, int loop
     if (!checkchunkintegral(chunk)) {
         return Mix_SetError("Tried to play a chunk with a bad frame");
     }
+    if (Mix_NewChunkVoice(chunk, &voice) < 0) {
+        return -1;
+    }
 
     /* Lock the mixer while modifying the playing channels */
     Mix_LockAudio();
     {
-        /* If which is -1, play on the first free channel */
-        if (which == -1) {
-            for (i = reserved_channels; i < num_channels; ++i) {
-                if (!Mix_Playing(i))
-                    break;
-            }
-            if (i == num_channels) {
-                which = -1;
-            } else {
-                which = i;
-            }
-        } else {
-            if (Mix_Playing(which))
-                _Mix_channel_done_playing(which);
-        }
+        /* If which is -1, play on the first free channel, or steal one */
+        which = Mix_TakeChannel_locked(which, chunk, &stolen);
+
+        dead = Mix_ReapVoices_locked();
+        dead = _Mix_ChunkVoiceLink(stolen, dead);
 
         /* Queue up the audio data for this channel */
         if (which >= 0 && which < num_channels) {
-            Uint32 sdl_ticks = SDL_GetTicks();
+            dead = _Mix_ChunkVoiceLink(mix_channel[which].voice, dead);
+            mix_channel[which].voice = voice;
+            voice = NULL;
             mix_channel[which].samples = chunk->abuf;
             mix_channel[which].playing = (int)chunk->alen;
             mix_channel[which].looping = loops;
@@ -1317,13 +2289,17 @@ int MIXCALLCC Mix_FadeInChannelTimedVolume(int which, Mix_Chunk *chunk, int loop
             mix_channel[which].fading = MIX_FADING_IN;
             mix_channel[which].fade_volume = mix_channel[which].volume;
             mix_channel[which].volume = 0;
-            mix_channel[which].fade_length = (Uint32)ms;
-            mix_channel[which].start_time = mix_channel[which].ticks_fade = sdl_ticks;
-            mix_channel[which].expire = (ticks > 0) ? (sdl_ticks+(Uint32)ticks) : 0;
+            mix_channel[which].fade_length = Mix_MsToFrames(ms);
+            mix_channel[which].start_time = SDL_GetTicks();
+            mix_channel[which].start_frame = mix_channel[which].fade_start = mix_clock;
+            mix_channel[which].expire = (ticks > 0) ? (mix_clock + Mix_MsToFrames(ticks)) : 0;
         }
     }
     Mix_UnlockAudio();
 
+    _Mix_ChunkVoiceFree(voice);
+    _Mix_ChunkVoiceFree(dead);
+
     /* Return the channel on which the sound is being played */
     return(which);
 }
@@ -1384,20 +2360,28 @@ int MIXCALLCC Mix_VolumeChunk(Mix_Chunk *chunk, int volume)
     return prev_volume;
 }
 
-/* Halt playing of a particular channel */
-int MIXCALLCC Mix_HaltChannel(int which)
+static void Mix_HaltChannelCommand(const Mix_Command *cmd)
 {
     int i;
 
-    Mix_LockAudio();
-    if (which == -1) {
+    if (cmd->which == -1) {
         for (i = 0; i < num_channels; ++i) {
             Mix_HaltChannel_locked(i);
         }
-    } else if (which < num_channels) {
-        Mix_HaltChannel_locked(which);
+    } else if (cmd->which < num_channels) {
+        Mix_HaltChannel_locked(cmd->which);
     }
-    Mix_UnlockAudio();
+}
+
+/* Halt playing of a particular channel */
+int MIXCALLCC Mix_HaltChannel(int which)
+{
+    Mix_Command cmd;
+
+    SDL_zero(cmd);
+    cmd.func = Mix_HaltChannelCommand;
+    cmd.which = which;
+    _Mix_RunCommand(&cmd);
     return 0;
 }
 
@@ -1429,12 +2413,16 @@ int MIXCALLCC Mix_FadeOutChannel(int which, int ms)
             }
         } else if (which < num_channels) {
             Mix_LockAudio();
-            if (Mix_Playing(which) &&
+            if (Mix_ChannelPlaying(which) &&
                 (mix_channel[which].volume > 0) &&
                 (mix_channel[which].fading != MIX_FADING_OUT)) {
                 mix_channel[which].fade_volume = mix_channel[which].volume;
-                mix_channel[which].fade_length = (Uint32)ms;
-                mix_channel[which].ticks_fade = SDL_GetTicks();
+                mix_channel[which].fade_length = Mix_MsToFrames(ms);
+                mix_channel[which].fade_start = mix_clock;
+                if (mix_channel[which].start_frame > mix_clock) {
+                    /* Not started yet, fade it out from its beginning */
+                    mix_channel[which].fade_start = mix_channel[which].start_frame;
+                }
 
                 /* only change fade_volume_reset if we're not fading. */
                 if (mix_channel[which].fading == MIX_NO_FADING) {
@@ -1472,32 +2460,50 @@ Mix_Fading MIXCALLCC Mix_FadingChannel(int which)
     return mix_channel[which].fading;
 }
 
-/* Check the status of a specific channel.
-   If the specified mix_channel is -1, check all mix channels.
-*/
-int MIXCALLCC Mix_Playing(int which)
+int MIXCALLCC Mix_SetChannelFadeCurve(int which, Mix_FadeCurve curve)
 {
-    int status;
+    int i;
 
-    status = 0;
-    if (which == -1) {
-        int i;
+    if (curve != MIX_FADE_LINEAR && curve != MIX_FADE_EXPONENTIAL) {
+        return Mix_SetError("Invalid fade curve");
+    }
 
+    if (which == -1) {
+        Mix_LockAudio();
         for (i = 0; i < num_channels; ++i) {
-            if ((mix_channel[i].playing > 0) ||
-                mix_channel[i].looping)
-            {
-                ++status;
-            }
-        }
-    } else if (which < num_channels) {
-        if ((mix_channel[which].playing > 0) ||
-             mix_channel[which].looping)
-        {
-            ++status;
+            mix_channel[i].fade_curve = curve;
         }
+        Mix_UnlockAudio();
+    } else if (which >= 0 && which < num_channels) {
+        Mix_LockAudio();
+        mix_channel[which].fade_curve = curve;
+        Mix_UnlockAudio();
+    } else {
+        return Mix_SetError("Invalid channel number");
     }
-    return status;
+
+    return 0;
+}
+
+Uint64 MIXCALLCC Mix_GetMixerClock(void)
+{
+    Uint64 clock;
+
+    Mix_LockAudio();
+    clock = mix_clock;
+    Mix_UnlockAudio();
+
+    return clock;
+}
+
+/* Check the status of a specific channel.
+   If the specified mix_channel is -1, check all mix channels.
+*/
+
+int MIXCALLCC Mix_Playing(int which)
+{
+    _Mix_SyncCommands();
+    return Mix_ChannelPlaying(which);
 }
 
 /* rcg06072001 Get the chunk associated with a channel. */
@@ -1520,24 +2526,43 @@ Mix_Chunk * MIXCALLCC Mix_GetChunk(int channel)
 void MIXCALLCC Mix_FreeMixer(void)
 {
     int i;
+    Mix_ChunkVoice *dead;
 
     if (audio_opened) {
         if (audio_opened == 1) {
+            /* Background loaders may still use the mixer */
+            _Mix_AsyncQuit();
             for (i = 0; i < num_channels; i++) {
                 Mix_UnregisterAllEffects(i);
             }
             Mix_UnregisterAllEffects(MIX_CHANNEL_POST);
+            /* Compressed chunks are decoded by the music interfaces */
+            Mix_HaltChannel(-1);
+            Mix_LockAudio();
+            dead = Mix_ReapVoices_locked();
+            Mix_UnlockAudio();
+            _Mix_ChunkVoiceFree(dead);
             close_music();
             Mix_SetMusicCMD(NULL);
-            Mix_HaltChannel(-1);
+            /* Nothing may refer to the channels in the queue once they are freed */
+            _Mix_SyncCommands();
             _Mix_DeinitEffects();
             SDL_free(mix_channel);
             mix_channel = NULL;
+            SDL_free(mix_effects_buffer);
+            mix_effects_buffer = NULL;
+            mix_effects_buffer_size = 0;
+            Mix_FreeMixBus();
+            SDL_free(chunk_policies);
+            chunk_policies = NULL;
+            num_chunk_policies = 0;
 
             /* rcg06042009 report available decoders at runtime. */
             SDL_free((void *)chunk_decoders);
             chunk_decoders = NULL;
             num_decoders = 0;
+
+            _Mix_SetMusicOffline(SDL_FALSE);
         }
         --audio_opened;
     }
@@ -1545,7 +2570,13 @@ void MIXCALLCC Mix_FreeMixer(void)
 
 /**
  * Set a function that MixerX will use to open RWops handles from file paths,
- * or pass NULL to use the default SDL_RWFromFile.
+ * or pass NULL to use the default opener.
+ *
+ * The default opener maps files opened for reading into the memory on
+ * systems which have mmap() (Linux, BSD, macOS), so uncompressed wave files
+ * of the mixer format and whole-file codecs (MIDI, GME, MOD) are used
+ * without copying them, and uses SDL_RWFromFile otherwise. Pass
+ * SDL_RWFromFile to always read files through it.
  *
  * This is the MixerX fork exclusive function.
  */
@@ -1554,8 +2585,76 @@ void MIXCALLCC Mix_SetRWFromFile(Mix_RWFromFile_cb cb)
     if (cb) {
         _Mix_RWFromFile = cb;
     } else {
-        _Mix_RWFromFile = SDL_RWFromFile;
+        _Mix_RWFromFile = _Mix_RWFromMappedFile;
+    }
+}
+
+/**
+ * Enable or disable mixing through the Float32 internal bus.
+ *
+ * This is the MixerX fork exclusive function.
+ */
+int MIXCALLCC Mix_SetFloatMixBus(int enable)
+{
+    int prev = mix_bus_enabled;
+    int ret = 0;
+
+    if (enable < 0) {
+        return prev;
+    }
+
+    Mix_LockAudio();
+    mix_bus_enabled = (enable != 0);
+    if (!mix_bus_enabled) {
+        Mix_FreeMixBus();
+    } else if (audio_opened && !mix_bus) {
+        ret = Mix_AllocMixBus(&mixer);
+        if (ret < 0) {
+            mix_bus_enabled = 0;
+        }
+    }
+    Mix_UnlockAudio();
+
+    if (ret < 0) {
+        Mix_OutOfMemory();
+        return -1;
+    }
+
+    return prev;
+}
+
+int MIXCALLCC Mix_GetPerfStats(Mix_PerfStage stage, Mix_PerfStats *stats)
+{
+    if (!stats || (int)stage < 0 || stage > MIX_PERF_POST_EFFECTS) {
+        return Mix_SetError("Invalid stage");
+    }
+
+    _Mix_PerfReport(&mix_perf[stage], stats);
+    return 0;
+}
+
+int MIXCALLCC Mix_GetChannelPerfStats(int channel, Mix_PerfStats *stats)
+{
+    int ret = 0;
+
+    if (!stats) {
+        return Mix_SetError("Invalid stats");
+    }
+
+    if (channel == MIX_CHANNEL_POST) {
+        _Mix_PerfReport(&mix_perf_posteffects, stats);
+        return 0;
+    }
+
+    Mix_LockAudio();
+    if (channel >= 0 && channel < num_channels) {
+        _Mix_PerfReport(&mix_channel[channel].perf, stats);
+    } else {
+        ret = Mix_SetError("Invalid channel number");
     }
+    Mix_UnlockAudio();
+
+    return ret;
 }
 
 /* Close the audio device, stop, and free all our mixer elements */
@@ -1573,64 +2672,100 @@ void MIXCALLCC Mix_CloseAudio(void)
     }
 }
 
-/* Pause a particular channel (or all) */
-void MIXCALLCC Mix_Pause(int which)
+static void Mix_PauseCommand(const Mix_Command *cmd)
 {
-    Uint32 sdl_ticks = SDL_GetTicks();
+    int which = cmd->which;
+
     if (which == -1) {
         int i;
 
         for (i=0; i<num_channels; ++i) {
-            if (Mix_Playing(i)) {
-                mix_channel[i].paused = sdl_ticks;
+            if (Mix_ChannelPlaying(i) && !mix_channel[i].paused) {
+                mix_channel[i].paused = 1;
+                mix_channel[i].paused_frame = mix_clock;
             }
         }
     } else if (which < num_channels) {
-        if (Mix_Playing(which)) {
-            mix_channel[which].paused = sdl_ticks;
+        if (Mix_ChannelPlaying(which) && !mix_channel[which].paused) {
+            mix_channel[which].paused = 1;
+            mix_channel[which].paused_frame = mix_clock;
         }
     }
 }
 
-/* Resume a paused channel */
-void MIXCALLCC Mix_Resume(int which)
+/* Pause a particular channel (or all) */
+void MIXCALLCC Mix_Pause(int which)
 {
-    Uint32 sdl_ticks = SDL_GetTicks();
+    Mix_Command cmd;
 
-    Mix_LockAudio();
-    if (which == -1) {
-        int i;
+    SDL_zero(cmd);
+    cmd.func = Mix_PauseCommand;
+    cmd.which = which;
+    _Mix_RunCommand(&cmd);
+}
 
-        for (i=0; i<num_channels; ++i) {
-            if (Mix_Playing(i)) {
-                if (mix_channel[i].expire > 0)
-                    mix_channel[i].expire += sdl_ticks - mix_channel[i].paused;
-                mix_channel[i].paused = 0;
-            }
-        }
-    } else if (which < num_channels) {
-        if (Mix_Playing(which)) {
-            if (mix_channel[which].expire > 0)
-                mix_channel[which].expire += sdl_ticks - mix_channel[which].paused;
-            mix_channel[which].paused = 0;
+/* MAKE SURE you hold the audio lock (Mix_LockAudio()) before calling this! */
+static void Mix_Resume_locked(int which)
+{
+    Uint64 paused_for;
+
+    if (!Mix_ChannelPlaying(which) || !mix_channel[which].paused) {
+        return;
+    }
+
+    /* Shift all the frames the channel is waiting for by the pause */
+    paused_for = mix_clock - mix_channel[which].paused_frame;
+    if (mix_channel[which].expire > 0) {
+        mix_channel[which].expire += paused_for;
+    }
+    if (mix_channel[which].start_frame > mix_channel[which].paused_frame) {
+        mix_channel[which].start_frame += paused_for;
+    }
+    if (mix_channel[which].fading != MIX_NO_FADING) {
+        mix_channel[which].fade_start += paused_for;
+    }
+    mix_channel[which].paused = 0;
+}
+
+static void Mix_ResumeCommand(const Mix_Command *cmd)
+{
+    int i;
+
+    if (cmd->which == -1) {
+        for (i = 0; i < num_channels; ++i) {
+            Mix_Resume_locked(i);
         }
+    } else if (cmd->which < num_channels) {
+        Mix_Resume_locked(cmd->which);
     }
-    Mix_UnlockAudio();
+}
+
+/* Resume a paused channel */
+void MIXCALLCC Mix_Resume(int which)
+{
+    Mix_Command cmd;
+
+    SDL_zero(cmd);
+    cmd.func = Mix_ResumeCommand;
+    cmd.which = which;
+    _Mix_RunCommand(&cmd);
 }
 
 int MIXCALLCC Mix_Paused(int which)
 {
+    _Mix_SyncCommands();
+
     if (which < 0) {
         int status = 0;
         int i;
         for (i = 0; i < num_channels; ++i) {
-            if (Mix_Playing(i) && mix_channel[i].paused) {
+            if (Mix_ChannelPlaying(i) && mix_channel[i].paused) {
                 ++status;
             }
         }
         return status;
     } else if (which < num_channels) {
-        return Mix_Playing(which) && mix_channel[which].paused != 0;
+        return Mix_ChannelPlaying(which) && mix_channel[which].paused != 0;
     } else {
         return 0;
     }
@@ -1720,6 +2855,107 @@ int MIXCALLCC Mix_GroupNewer(int tag)
     return chan;
 }
 
+int MIXCALLCC Mix_SetVoiceStealing(int enable, int fade_ms)
+{
+    Mix_LockAudio();
+    voice_stealing = enable ? SDL_TRUE : SDL_FALSE;
+    voice_steal_fade_ms = fade_ms > 0 ? fade_ms : 0;
+    Mix_UnlockAudio();
+    return 0;
+}
+
+int MIXCALLCC Mix_SetChunkPriority(Mix_Chunk *chunk, int priority)
+{
+    Mix_ChunkPolicy *policy;
+
+    if (!chunk) {
+        return Mix_SetError("Invalid chunk");
+    }
+
+    Mix_LockAudio();
+    policy = Mix_AddChunkPolicy_locked(chunk);
+    if (policy) {
+        policy->priority = priority;
+    }
+    Mix_UnlockAudio();
+
+    return policy ? 0 : -1;
+}
+
+int MIXCALLCC Mix_GetChunkPriority(Mix_Chunk *chunk)
+{
+    Mix_ChunkPolicy *policy;
+    int priority;
+
+    Mix_LockAudio();
+    policy = Mix_FindChunkPolicy_locked(chunk);
+    priority = policy ? policy->priority : 0;
+    Mix_UnlockAudio();
+
+    return priority;
+}
+
+int MIXCALLCC Mix_SetChunkMaxVoices(Mix_Chunk *chunk, int max_voices)
+{
+    Mix_ChunkPolicy *policy;
+
+    if (!chunk) {
+        return Mix_SetError("Invalid chunk");
+    }
+
+    Mix_LockAudio();
+    policy = Mix_AddChunkPolicy_locked(chunk);
+    if (policy) {
+        policy->max_voices = max_voices > 0 ? max_voices : 0;
+    }
+    Mix_UnlockAudio();
+
+    return policy ? 0 : -1;
+}
+
+int MIXCALLCC Mix_GetChunkMaxVoices(Mix_Chunk *chunk)
+{
+    Mix_ChunkPolicy *policy;
+    int max_voices;
+
+    Mix_LockAudio();
+    policy = Mix_FindChunkPolicy_locked(chunk);
+    max_voices = policy ? policy->max_voices : 0;
+    Mix_UnlockAudio();
+
+    return max_voices;
+}
+
+int MIXCALLCC Mix_SetChannelPriority(int which, int priority)
+{
+    int i;
+
+    if (which == -1) {
+        Mix_LockAudio();
+        for (i = 0; i < num_channels; ++i) {
+            mix_channel[i].priority = priority;
+        }
+        Mix_UnlockAudio();
+    } else if (which >= 0 && which < num_channels) {
+        Mix_LockAudio();
+        mix_channel[which].priority = priority;
+        Mix_UnlockAudio();
+    } else {
+        return Mix_SetError("Invalid channel number");
+    }
+
+    return 0;
+}
+
+int MIXCALLCC Mix_GetChannelPriority(int which)
+{
+    if (which < 0 || which >= num_channels) {
+        return 0;
+    }
+
+    return mix_channel[which].priority;
+}
+
 
 
 /*
@@ -1919,13 +3155,67 @@ int MIXCALLCC Mix_UnregisterAllEffects(int channel)
 void Mix_LockAudio(void)
 {
     SDL_LockAudioDevice(audio_device);
+    /* Commands queued earlier must be applied before the caller's changes */
+    if (SDL_AtomicAdd(&audio_lock_depth, 1) == 0) {
+        audio_lock_owner = SDL_ThreadID();
+        _Mix_CommandDrain();
+    }
 }
 
 void Mix_UnlockAudio(void)
 {
+    if (SDL_AtomicGet(&audio_lock_depth) == 1) {
+        audio_lock_owner = 0;
+    }
+    SDL_AtomicAdd(&audio_lock_depth, -1);
     SDL_UnlockAudioDevice(audio_device);
 }
 
+/* Whether the calling thread holds the audio lock already, like inside of
+   Mix_LockAudio() or any of the callbacks run by the mixer. The owner is
+   only ever set to the own ID by the thread itself, so the racy read can't
+   give a false match. */
+static SDL_bool audio_lock_held(void)
+{
+    return (SDL_AtomicGet(&audio_lock_depth) > 0 && audio_lock_owner == SDL_ThreadID()) ? SDL_TRUE : SDL_FALSE;
+}
+
+void _Mix_RunCommand(const Mix_Command *cmd)
+{
+    /* The lock holder would only see its command applied after unlocking,
+       later than its direct calls, so it runs the command right away */
+    if (audio_lock_held()) {
+        cmd->func(cmd);
+        return;
+    }
+
+    /* Without the audio thread nobody would run the queue */
+    if (audio_device && _Mix_CommandPush(cmd) == 0) {
+        return;
+    }
+
+    /* The queue is full, the lock runs all queued commands first */
+    Mix_LockAudio();
+    cmd->func(cmd);
+    Mix_UnlockAudio();
+}
+
+void _Mix_SyncCommands(void)
+{
+    if (!_Mix_CommandPending()) {
+        return;
+    }
+
+    /* The nested lock doesn't drain, the holder runs the queue itself */
+    if (audio_lock_held()) {
+        _Mix_CommandDrain();
+        return;
+    }
+
+    Mix_LockAudio();
+    Mix_UnlockAudio();
+}
+
 int MIXCALLCC Mix_MasterVolume(int volume)
 {
     int prev_volume = SDL_AtomicGet(&master_volume);
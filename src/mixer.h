@@ -30,10 +30,21 @@ typedef SDL_RWops* (*Mix_RWFromFile_cb)(const char *file, const char *mode);
 extern void Mix_LockAudio(void);
 extern void Mix_UnlockAudio(void);
 
+struct Mix_Command;
+
+/* Run the command by the audio thread, or right now if there is no one */
+extern void _Mix_RunCommand(const struct Mix_Command *cmd);
+
+/* Apply the queued commands before reading the state they change */
+extern void _Mix_SyncCommands(void);
+
 extern void add_chunk_decoder(const char *decoder);
 
 extern Mix_RWFromFile_cb _Mix_RWFromFile;
 
+/* Mix the piece into the Float32 bus if it's used by the current callback */
+extern SDL_bool _Mix_MixBusAdd(int offset, const Uint8 *src, int len, int volume);
+
 #endif /* MIXER_H_ */
 
 /* vi: set ts=4 sw=4 expandtab: */
@@ -50,6 +50,11 @@
 #include "music_qoa.h"
 
 #include "utils.h"
+#include "mix_bank_cache.h"
+#include "mix_workers.h"
+#include "mix_decode_ahead.h"
+#include "mix_perf.h"
+#include "mix_command.h"
 #include "mp3utils.h"
 
 /* Check to make sure we are building with a new enough SDL */
@@ -74,6 +79,20 @@ static Uint8         *mix_streams_buffer = NULL;
 static int            num_streams_capacity = 0;
 static int            music_general_volume = MIX_MAX_VOLUME;
 
+/* Parallel rendering of multi-music streams */
+
+/* Callbacks to render serially once workers were late */
+#define MIX_MULTIMUSIC_SERIAL_PERIODS   64
+
+static int                mix_streams_threads = 0;
+static void             **mix_streams_jobs = NULL;
+static int                mix_streams_jobs_capacity = 0;
+static int                mix_streams_serial_left = 0;
+
+/* Rendering faster than the real time by Mix_RenderFrames(): never drop
+   the decoded data and never give up on workers being late */
+static SDL_bool music_offline = SDL_FALSE;
+
 typedef struct _Mix_effectinfo
 {
     Mix_MusicEffectFunc_t callback;
@@ -82,6 +101,48 @@ typedef struct _Mix_effectinfo
     struct _Mix_effectinfo *next;
 } mus_effect_info;
 
+static SDL_bool _Mix_MultiMusic_ReserveJobBuffer(Mix_Music *mus);
+
+/* Allocate buffers to render given number of streams at once */
+static SDL_bool _Mix_MultiMusic_ReserveJobs(int capacity)
+{
+    void **jobs;
+    SDL_bool ret = SDL_TRUE;
+    int i;
+
+    for (i = 0; i < num_streams; ++i) {
+        if (mix_streams[i] && !_Mix_MultiMusic_ReserveJobBuffer(mix_streams[i])) {
+            ret = SDL_FALSE;
+        }
+    }
+
+    if (capacity <= mix_streams_jobs_capacity) {
+        return ret;
+    }
+
+    jobs = (void **)SDL_realloc(mix_streams_jobs, sizeof(void *) * (size_t)capacity);
+    if (!jobs) {
+        return SDL_FALSE;
+    }
+    mix_streams_jobs = jobs;
+    mix_streams_jobs_capacity = capacity;
+
+    return ret;
+}
+
+static void _Mix_MultiMusic_FreeJobs(void)
+{
+    _Mix_WorkersSetThreads(0);
+    mix_streams_threads = 0;
+    mix_streams_serial_left = 0;
+
+    if (mix_streams_jobs) {
+        SDL_free(mix_streams_jobs);
+        mix_streams_jobs = NULL;
+    }
+    mix_streams_jobs_capacity = 0;
+}
+
 /* Add music into the chain of playing songs, reject duplicated songs */
 static SDL_bool _Mix_MultiMusic_Add(Mix_Music *mus)
 {
@@ -127,6 +188,11 @@ static SDL_bool _Mix_MultiMusic_Add(Mix_Music *mus)
 
     mix_streams[num_streams++] = mus;
 
+    if (mix_streams_threads > 0) {
+        /* On failure, streams just get rendered serially */
+        _Mix_MultiMusic_ReserveJobs(num_streams_capacity);
+    }
+
     return SDL_TRUE;
 }
 
@@ -261,6 +327,19 @@ struct Mix_Music {
     int music_halted;
     int free_on_stop;
 
+    Mix_DecodeAhead *ahead;
+    int ahead_ms;
+
+    /* Set while a worker renders the stream, a late one keeps it after
+       the audio callback, and the stream is kept out of the mix until then */
+    SDL_atomic_t job_busy;
+    SDL_bool job_finished;
+    Uint8 *job_buffer;
+    int job_buffer_size;
+    int job_len;
+
+    Mix_PerfCounter perf;
+
     char filename[1024];
 };
 
@@ -275,6 +354,169 @@ position_args *_Mix_GetMusicPositionArgs(Mix_Music *mus)
     return mus->pos_args;
 }
 
+/* The buffer of the stream rendered by workers, it's not shared with other
+   streams, so a worker late for an older piece can't spoil the next ones */
+static SDL_bool _Mix_MultiMusic_ReserveJobBuffer(Mix_Music *mus)
+{
+    Uint8 *buffer;
+
+    if (mus->job_buffer && mus->job_buffer_size >= (int)music_spec.size) {
+        return SDL_TRUE;
+    }
+    if (SDL_AtomicGet(&mus->job_busy)) {
+        return SDL_FALSE;
+    }
+
+    buffer = (Uint8 *)SDL_realloc(mus->job_buffer, (size_t)music_spec.size);
+    if (!buffer) {
+        return SDL_FALSE;
+    }
+    mus->job_buffer = buffer;
+    mus->job_buffer_size = (int)music_spec.size;
+
+    return SDL_TRUE;
+}
+
+/* Wait for a worker which was late for the audio callback, but still renders the stream */
+static void music_job_wait(Mix_Music *music)
+{
+    while (SDL_AtomicGet(&music->job_busy)) {
+        SDL_Delay(1);
+    }
+}
+
+/* Keep the decode-ahead thread away while the getters use the music context */
+static void music_context_lock(Mix_Music *music)
+{
+    music_job_wait(music);
+    if (music->ahead) {
+        _Mix_DecodeAheadLock(music->ahead);
+    }
+}
+
+static void music_context_unlock(Mix_Music *music, int mode)
+{
+    if (music->ahead) {
+        _Mix_DecodeAheadUnlock(music->ahead, mode);
+    }
+}
+
+/* Setters of the music context which the decode-ahead producer may apply later */
+enum {
+    MUSIC_CALL_PLAY,
+    MUSIC_CALL_STOP,
+    MUSIC_CALL_PAUSE,
+    MUSIC_CALL_RESUME,
+    MUSIC_CALL_SEEK,
+    MUSIC_CALL_JUMP,
+    MUSIC_CALL_TEMPO,
+    MUSIC_CALL_SPEED,
+    MUSIC_CALL_PITCH,
+    MUSIC_CALL_TRACK_MUTE,
+    MUSIC_CALL_GAIN,
+    MUSIC_CALL_START_TRACK
+};
+
+static int music_context_run(const Mix_DecodeAheadCall *call)
+{
+    Mix_Music *music = (Mix_Music *)call->ptr;
+    Mix_MusicInterface *interface = music->interface;
+
+    switch (call->which) {
+    case MUSIC_CALL_PLAY:
+        return interface->Play(music->context, call->arg1);
+    case MUSIC_CALL_STOP:
+        if (interface->Stop) {
+            interface->Stop(music->context);
+        }
+        return 0;
+    case MUSIC_CALL_PAUSE:
+        interface->Pause(music->context);
+        return 0;
+    case MUSIC_CALL_RESUME:
+        interface->Resume(music->context);
+        return 0;
+    case MUSIC_CALL_SEEK:
+        return interface->Seek(music->context, call->value);
+    case MUSIC_CALL_JUMP:
+        return interface->Jump(music->context, call->arg1);
+    case MUSIC_CALL_TEMPO:
+        return interface->SetTempo(music->context, call->value);
+    case MUSIC_CALL_SPEED:
+        return interface->SetSpeed(music->context, call->value);
+    case MUSIC_CALL_PITCH:
+        return interface->SetPitch(music->context, call->value);
+    case MUSIC_CALL_TRACK_MUTE:
+        return interface->SetTrackMute(music->context, call->arg1, call->arg2);
+    case MUSIC_CALL_GAIN:
+        interface->SetGain(music->context, (float)call->value);
+        return 0;
+    case MUSIC_CALL_START_TRACK:
+        if (interface->Pause) {
+            interface->Pause(music->context);
+        }
+        return interface->StartTrack(music->context, call->arg1);
+    default:
+        return -1;
+    }
+}
+
+/* Run the setter on the music context. With decode-ahead it never waits for
+   the piece being decoded: the setter is queued for the producer then, and
+   0 is returned as its result */
+static int music_context_call(Mix_Music *music, int which, int arg1, int arg2, double value, int mode)
+{
+    Mix_DecodeAheadCall call;
+
+    SDL_zero(call);
+    call.func = music_context_run;
+    call.ptr = music;
+    call.which = which;
+    call.arg1 = arg1;
+    call.arg2 = arg2;
+    call.value = value;
+
+    music_job_wait(music);
+    if (music->ahead) {
+        return _Mix_DecodeAheadCall(music->ahead, &call, mode);
+    }
+
+    return music_context_run(&call);
+}
+
+/* Timings of GetAudio() of every music interface */
+static Mix_PerfCounter music_perf_decoders[MIX_MUSIC_LAST];
+
+static int music_get_audio(Mix_Music *music, void *data, int bytes)
+{
+    Uint64 perf_begin = _Mix_PerfBegin();
+    int left;
+
+    if (music->ahead) {
+        left = _Mix_DecodeAheadRead(music->ahead, data, bytes, music_offline);
+    } else {
+        left = music->interface->GetAudio(music->context, data, bytes);
+    }
+
+    _Mix_PerfEnd(&music->perf, &music_perf_decoders[music->interface->api], perf_begin);
+
+    return left;
+}
+
+static void music_delete(Mix_Music *music)
+{
+    music_job_wait(music);
+    if (music->ahead) {
+        _Mix_DecodeAheadDestroy(music->ahead);
+        music->ahead = NULL;
+    }
+    if (music->job_buffer) {
+        SDL_free(music->job_buffer);
+        music->job_buffer = NULL;
+    }
+    music->interface->Delete(music->context);
+}
+
 /* ========== Multi-Music effects ==========  */
 
 /*
@@ -783,8 +1025,36 @@ int music_pcm_getaudio(void *context, void *data, int bytes, int volume,
     return len;
 }
 
+/* Tells that PCM of the given spec needs no conversion into the music output.
+   Codecs make no audio stream then, and their GetSome decodes right into the
+   output buffer, until a conversion gets needed (like by a speed change).
+ */
+SDL_bool music_pcm_is_native(SDL_AudioFormat format, int channels, int freq)
+{
+    return (format == music_spec.format &&
+            channels == music_spec.channels &&
+            freq == music_spec.freq) ? SDL_TRUE : SDL_FALSE;
+}
+
+/* Call hooks of the finished multi-music stream, or just mark it as finished
+   when it's rendered by a worker: hooks must be called by the audio thread */
+static void music_stream_finished(Mix_Music *music, SDL_bool *finished)
+{
+    if (finished) {
+        *finished = SDL_TRUE;
+        return;
+    }
+
+    if (music->music_finished_hook) {
+        music->music_finished_hook(music, music->music_finished_hook_user_data);
+    }
+    if (music_finished_hook_mm) {
+        music_finished_hook_mm();
+    }
+}
+
 /* Mixing function */
-static SDL_INLINE int music_mix_stream(Mix_Music *music, void *udata, Uint8 *stream, int len)
+static SDL_INLINE int music_mix_stream(Mix_Music *music, void *udata, Uint8 *stream, int len, SDL_bool *finished)
 {
     SDL_bool done = SDL_FALSE;
 
@@ -807,12 +1077,7 @@ static SDL_INLINE int music_mix_stream(Mix_Music *music, void *udata, Uint8 *str
             } else {
                 if (music->fading == MIX_FADING_OUT) {
                     music_internal_halt(music);
-                    if (music->music_finished_hook) {
-                        music->music_finished_hook(music, music->music_finished_hook_user_data);
-                    }
-                    if (music_finished_hook_mm) {
-                        music_finished_hook_mm();
-                    }
+                    music_stream_finished(music, finished);
                     return -1;
                 }
                 music->fading = MIX_NO_FADING;
@@ -820,7 +1085,7 @@ static SDL_INLINE int music_mix_stream(Mix_Music *music, void *udata, Uint8 *str
         }
 
         if (music->interface->GetAudio) {
-            int left = music->interface->GetAudio(music->context, stream, len);
+            int left = music_get_audio(music, stream, len);
             if (left != 0) {
                 /* Either an error or finished playing with data left */
                 music->playing = SDL_FALSE;
@@ -838,46 +1103,151 @@ static SDL_INLINE int music_mix_stream(Mix_Music *music, void *udata, Uint8 *str
 
         if (!music_internal_playing(music)) {
             music_internal_halt(music);
-            if (music->music_finished_hook) {
-                music->music_finished_hook(music, music->music_finished_hook_user_data);
-            }
-            if (music_finished_hook_mm) {
-                music_finished_hook_mm();
-            }
+            music_stream_finished(music, finished);
         }
     }
 
     return 0;
 }
 
-void SDLCALL multi_music_mixer(void *udata, Uint8 *stream, int len)
+static void multi_music_mix_add(Uint8 *stream, Uint8 *src, int len)
+{
+    if (!_Mix_MixBusAdd(0, src, len, music_general_volume)) {
+        SDL_MixAudioFormat(stream, src, music_spec.format, len, music_general_volume);
+    }
+}
+
+/* Render the stream and its effects into own buffer, runs on a worker */
+static void multi_music_job(void *udata, void *item)
+{
+    Mix_Music *music = (Mix_Music *)item;
+
+    SDL_memset(music->job_buffer, music_spec.silence, (size_t)music->job_len);
+    music_mix_stream(music, udata, music->job_buffer, music->job_len, &music->job_finished);
+    Mix_Music_DoEffects(music, music->job_buffer, music->job_len);
+
+    /* The last touch of the stream, it may be mixed again from now on */
+    SDL_AtomicSet(&music->job_busy, 0);
+}
+
+/* Some libraries render through global state, keep them on the audio thread */
+static SDL_bool multi_music_parallel_safe(Mix_Music *music)
+{
+    switch (music->interface->api) {
+    case MIX_MUSIC_CMD:
+    case MIX_MUSIC_MODPLUG:
+    case MIX_MUSIC_NATIVEMIDI:
+        return SDL_FALSE;
+    default:
+        return SDL_TRUE;
+    }
+}
+
+/* Call the hooks of streams finished by workers, late ones included */
+static void multi_music_finish_jobs(void)
 {
     int i;
     Mix_Music *m;
 
-    if (!mix_streams) {
-        return; /* Nothing to process */
+    for (i = 0; i < num_streams; ++i) {
+        m = mix_streams[i];
+        if (m && m->job_finished && !SDL_AtomicGet(&m->job_busy)) {
+            m->job_finished = SDL_FALSE;
+            music_stream_finished(m, NULL);
+        }
+    }
+}
+
+static SDL_bool multi_music_mix_parallel(void *udata, Uint8 *stream, int len)
+{
+    int i, count = 0;
+    int frame_size = (SDL_AUDIO_BITSIZE(music_spec.format) / 8) * music_spec.channels;
+    Uint32 timeout;
+    Mix_Music *m;
+
+    if (mix_streams_threads <= 0 || _Mix_WorkersCount() == 0 || num_streams < 2 ||
+        mix_streams_jobs_capacity < num_streams || len > (int)music_spec.size) {
+        return SDL_FALSE;
+    }
+
+    if (mix_streams_serial_left > 0) {
+        --mix_streams_serial_left;
+        return SDL_FALSE;
     }
 
-    /* Mix currently working streams */
     for (i = 0; i < num_streams; ++i) {
         m = mix_streams[i];
-        if (m && m->music_active) {
+        if (!m || !m->music_active || SDL_AtomicGet(&m->job_busy)) {
+            continue;
+        }
+
+        if (!multi_music_parallel_safe(m) || m->job_buffer_size < len) {
             SDL_memset(mix_streams_buffer, music_spec.silence, (size_t)len);
-            music_mix_stream(m, udata, mix_streams_buffer, len);
+            music_mix_stream(m, udata, mix_streams_buffer, len, NULL);
             Mix_Music_DoEffects(m, mix_streams_buffer, len);
-            SDL_MixAudioFormat(stream, mix_streams_buffer, music_spec.format, len, music_general_volume);
+            multi_music_mix_add(stream, mix_streams_buffer, len);
+            continue;
+        }
+
+        m->job_len = len;
+        m->job_finished = SDL_FALSE;
+        SDL_AtomicSet(&m->job_busy, 1);
+        mix_streams_jobs[count++] = m;
+    }
+
+    /* Wait no longer than the duration of the rendered piece (the offline
+       rendering has no deadline), the late streams are silent this time */
+    timeout = music_offline ? SDL_MUTEX_MAXWAIT :
+              (Uint32)(((Sint64)len * 1000) / ((Sint64)frame_size * music_spec.freq)) + 1;
+    if (!_Mix_WorkersRun(multi_music_job, udata, mix_streams_jobs, count, timeout)) {
+        mix_streams_serial_left = MIX_MULTIMUSIC_SERIAL_PERIODS;
+    }
+
+    for (i = 0; i < count; ++i) {
+        m = (Mix_Music *)mix_streams_jobs[i];
+        if (!SDL_AtomicGet(&m->job_busy)) {
+            multi_music_mix_add(stream, m->job_buffer, len);
+        }
+    }
+
+    /* Hooks may start new streams and reallocate the jobs array */
+    multi_music_finish_jobs();
+
+    return SDL_TRUE;
+}
+
+void SDLCALL multi_music_mixer(void *udata, Uint8 *stream, int len)
+{
+    int i;
+    Mix_Music *m;
+
+    if (!mix_streams) {
+        return; /* Nothing to process */
+    }
+
+    /* Mix currently working streams */
+    if (!multi_music_mix_parallel(udata, stream, len)) {
+        multi_music_finish_jobs();
+        for (i = 0; i < num_streams; ++i) {
+            m = mix_streams[i];
+            /* Skip ones still rendered by the workers late for older pieces */
+            if (m && m->music_active && !SDL_AtomicGet(&m->job_busy)) {
+                SDL_memset(mix_streams_buffer, music_spec.silence, (size_t)len);
+                music_mix_stream(m, udata, mix_streams_buffer, len, NULL);
+                Mix_Music_DoEffects(m, mix_streams_buffer, len);
+                multi_music_mix_add(stream, mix_streams_buffer, len);
+            }
         }
     }
 
     /* Clean-up halted streams */
     for (i = 0; i < num_streams; ++i) {
         m = mix_streams[i];
-        if (!m || m->music_halted) {
+        if (!m || (m->music_halted && !SDL_AtomicGet(&m->job_busy))) {
             _Mix_MultiMusic_Remove(m);
             if (m && m->free_on_stop) {
                 _Mix_remove_all_mus_effects(m, &m->effects);
-                m->interface->Delete(m->context);
+                music_delete(m);
                 SDL_free(m);
             }
             i--;
@@ -926,7 +1296,7 @@ void SDLCALL music_mixer(void *udata, Uint8 *stream, int len)
         }
 
         if (music_playing->interface->GetAudio) {
-            int left = music_playing->interface->GetAudio(music_playing->context, stream, len);
+            int left = music_get_audio(music_playing, stream, len);
             if (left != 0) {
                 /* Either an error or finished playing with data left */
                 music_playing->playing = SDL_FALSE;
@@ -967,11 +1337,11 @@ void pause_async_music(int pause_on)
 
     if (pause_on) {
         if (music_playing->interface->Pause) {
-            music_playing->interface->Pause(music_playing->context);
+            music_context_call(music_playing, MUSIC_CALL_PAUSE, 0, 0, 0.0, MIX_DECODE_AHEAD_KEEP);
         }
     } else {
         if (music_playing->interface->Resume) {
-            music_playing->interface->Resume(music_playing->context);
+            music_context_call(music_playing, MUSIC_CALL_RESUME, 0, 0, 0.0, MIX_DECODE_AHEAD_KEEP);
         }
     }
 }
@@ -1198,6 +1568,12 @@ SDL_bool open_music_type_ex(Mix_MusicType type, int midi_player)
     return (opened > 0) ? SDL_TRUE : SDL_FALSE;
 }
 
+/* Switch the music mixing between the device and the offline rendering */
+void _Mix_SetMusicOffline(SDL_bool offline)
+{
+    music_offline = offline;
+}
+
 /* Initialize the music interfaces with a certain desired audio format */
 void open_music(const SDL_AudioSpec *spec)
 {
@@ -1211,6 +1587,9 @@ void open_music(const SDL_AudioSpec *spec)
     load_music_type(MUS_CMD);
     load_music_type(MUS_WAV);
 
+    /* Made once for all loadings, the synchronous ones take them too */
+    _Mix_InitMusicCreateLocks();
+
     /* Open all the interfaces that are loaded */
     music_spec = *spec;
     open_music_type(MUS_NONE);
@@ -2016,12 +2395,39 @@ static int split_path_and_params(const char *path, char **file, char **args)
     return 1;
 }
 
+/* Some formats can't be detected by their content, so only the extension tells */
+static Mix_MusicType guess_music_type_by_ext(const char *file)
+{
+    const char *ext = SDL_strrchr(file, '.');
+
+    if (ext) {
+        ++ext; /* skip the dot in the extension */
+        if (SDL_strcasecmp(ext, "AMS") == 0 ||
+            SDL_strcasecmp(ext, "MOL") == 0 ||
+            SDL_strcasecmp(ext, "NST") == 0 ||
+            SDL_strcasecmp(ext, "STM") == 0 ||
+            SDL_strcasecmp(ext, "WOW") == 0) {
+            return MUS_MOD;
+        }
+        else if (SDL_strcasecmp(ext, "MP4") == 0 ||
+                 SDL_strcasecmp(ext, "MKV") == 0 ||
+                 SDL_strcasecmp(ext, "WEBM") == 0 ||
+                 SDL_strcasecmp(ext, "M4A") == 0 ||
+                 SDL_strcasecmp(ext, "WMA") == 0 ||
+                 SDL_strcasecmp(ext, "MOV") == 0 ||
+                 SDL_strcasecmp(ext, "TS") == 0) {
+            return MUS_FFMPEG;
+        }
+    }
+
+    return MUS_NONE;
+}
+
 /* Load a music file */
 Mix_Music * MIXCALLCC Mix_LoadMUS(const char *file)
 {
     int i;
     void *context;
-    char *ext;
     Mix_MusicType type;
     SDL_RWops *src;
     Mix_Music *ret = NULL;
@@ -2066,11 +2472,13 @@ Mix_Music * MIXCALLCC Mix_LoadMUS(const char *file)
             }
         }
 
+        _Mix_LockMusicCreate(interface);
         if (interface->CreateFromFileEx) {
             context = interface->CreateFromFileEx(file, music_args);
         } else {
             context = interface->CreateFromFile(file);
         }
+        _Mix_UnlockMusicCreate(interface);
 
         if (context) {
             const char *p;
@@ -2102,27 +2510,7 @@ Mix_Music * MIXCALLCC Mix_LoadMUS(const char *file)
     }
 
     /* Use the extension as a first guess on the file type */
-    type = MUS_NONE;
-    ext = SDL_strrchr(file, '.');
-    if (ext) {
-        ++ext; /* skip the dot in the extension */
-        if (SDL_strcasecmp(ext, "AMS") == 0 ||
-            SDL_strcasecmp(ext, "MOL") == 0 ||
-            SDL_strcasecmp(ext, "NST") == 0 ||
-            SDL_strcasecmp(ext, "STM") == 0 ||
-            SDL_strcasecmp(ext, "WOW") == 0) {
-            type = MUS_MOD;
-        }
-        else if (SDL_strcasecmp(ext, "MP4") == 0 ||
-                 SDL_strcasecmp(ext, "MKV") == 0 ||
-                 SDL_strcasecmp(ext, "WEBM") == 0 ||
-                 SDL_strcasecmp(ext, "M4A") == 0 ||
-                 SDL_strcasecmp(ext, "WMA") == 0 ||
-                 SDL_strcasecmp(ext, "MOV") == 0 ||
-                 SDL_strcasecmp(ext, "TS") == 0) {
-            type = MUS_FFMPEG;
-        }
-    }
+    type = guess_music_type_by_ext(file);
     ret = Mix_LoadMUSType_RW_ARG(src, type, SDL_TRUE, music_args);
     if (ret) {
         const char *p = get_last_dirsep(music_file);
@@ -2215,11 +2603,13 @@ Mix_Music * MIXCALLCC Mix_LoadMUSType_RW_ARG(SDL_RWops *src, Mix_MusicType type,
                 continue;
             }
 
+            _Mix_LockMusicCreate(interface);
             if (interface->CreateFromRWex) {
                 context = interface->CreateFromRWex(src, freesrc, args);
             } else {
                 context = interface->CreateFromRW(src, freesrc);
             }
+            _Mix_UnlockMusicCreate(interface);
 
             if (context) {
                 /* Allocate memory for the music structure */
@@ -2255,6 +2645,192 @@ Mix_Music * MIXCALLCC Mix_LoadMUSType_RW_ARG(SDL_RWops *src, Mix_MusicType type,
     return NULL;
 }
 
+/* Codecs allowed to create several musics at once from the loader threads:
+   they keep everything in the music's own context, and their libraries got
+   been loaded and opened beforehand. Everything else (MIDI synths sharing the
+   banks and the setup, trackers, GME, FFmpeg, PXTone) creates one at a time */
+static SDL_bool music_create_is_reentrant(Mix_MusicAPI api)
+{
+    switch (api) {
+    case MIX_MUSIC_WAVE:
+    case MIX_MUSIC_OGG:
+    case MIX_MUSIC_DRMP3:
+    case MIX_MUSIC_MPG123:
+    case MIX_MUSIC_DRFLAC:
+    case MIX_MUSIC_FLAC:
+    case MIX_MUSIC_OPUS:
+    case MIX_MUSIC_WAVPACK:
+    case MIX_MUSIC_QOA:
+        return SDL_TRUE;
+    default:
+        return SDL_FALSE;
+    }
+}
+
+static SDL_mutex *music_create_locks[MIX_MUSIC_LAST];
+static SDL_bool music_create_locks_ready = SDL_FALSE;
+
+int _Mix_InitMusicCreateLocks(void)
+{
+    int i;
+
+    for (i = 0; i < MIX_MUSIC_LAST; ++i) {
+        if (music_create_locks[i] || music_create_is_reentrant((Mix_MusicAPI)i)) {
+            continue;
+        }
+        music_create_locks[i] = SDL_CreateMutex();
+        if (!music_create_locks[i]) {
+            _Mix_QuitMusicCreateLocks();
+            return -1;
+        }
+    }
+
+    music_create_locks_ready = SDL_TRUE;
+    return 0;
+}
+
+SDL_bool _Mix_HasMusicCreateLocks(void)
+{
+    return music_create_locks_ready;
+}
+
+void _Mix_QuitMusicCreateLocks(void)
+{
+    int i;
+
+    music_create_locks_ready = SDL_FALSE;
+    for (i = 0; i < MIX_MUSIC_LAST; ++i) {
+        if (music_create_locks[i]) {
+            SDL_DestroyMutex(music_create_locks[i]);
+            music_create_locks[i] = NULL;
+        }
+    }
+}
+
+void _Mix_LockMusicCreate(const Mix_MusicInterface *interface)
+{
+    if (music_create_locks[interface->api]) {
+        SDL_LockMutex(music_create_locks[interface->api]);
+    }
+}
+
+void _Mix_UnlockMusicCreate(const Mix_MusicInterface *interface)
+{
+    if (music_create_locks[interface->api]) {
+        SDL_UnlockMutex(music_create_locks[interface->api]);
+    }
+}
+
+/* Load and open the music interfaces needed for the stream beforehand, so the
+   stream itself may be loaded at another thread without touching them */
+void _Mix_PrepareMusicRW(SDL_RWops *src, Mix_MusicType type, const char *args)
+{
+    Sint64 start;
+    int midi_player = midiplayer_current;
+
+    if (!src) {
+        return;
+    }
+
+    start = SDL_RWtell(src);
+    if (type == MUS_NONE) {
+        type = detect_music_type(src);
+        SDL_RWseek(src, start, RW_SEEK_SET);
+        if (type == MUS_NONE) {
+            return;
+        }
+    }
+
+    if (type == MUS_MID) {
+        midi_player = parse_midi_args(args);
+        if (midi_player < 0) {
+            midi_player = midiplayer_current;
+        }
+    }
+
+    if (load_music_type(type)) {
+        open_music_type_ex(type, midi_player);
+    }
+}
+
+void _Mix_PrepareMusicFile(const char *file)
+{
+    char *music_file = NULL;
+    char *music_args = NULL;
+    SDL_RWops *src;
+
+    if (!file) {
+        return;
+    }
+
+    if (split_path_and_params(file, &music_file, &music_args) != 0) {
+        src = _Mix_RWFromFile(music_file, "rb");
+        if (src) {
+            _Mix_PrepareMusicRW(src, guess_music_type_by_ext(music_file), music_args);
+            SDL_RWclose(src);
+        }
+    }
+
+    SDL_free(music_file);
+    SDL_free(music_args);
+}
+
+/* Create a private decoder of the stream to render chunks from it */
+void *_Mix_CreateChunkDecoder(SDL_RWops *src, int freesrc, Mix_MusicInterface **out_interface)
+{
+    int i;
+    Mix_MusicType music_type;
+    Mix_MusicInterface *interface;
+    void *music = NULL;
+    Sint64 start;
+
+    music_type = detect_music_type(src);
+    if (!load_music_type(music_type) || !open_music_type_ex(music_type, midiplayer_current)) {
+        if (freesrc) {
+            SDL_RWclose(src);
+        }
+        return NULL;
+    }
+
+    start = SDL_RWtell(src);
+    for (i = 0; i < get_num_music_interfaces(); ++i) {
+        interface = get_music_interface(i);
+        if (!interface->opened) {
+            continue;
+        }
+        if (interface->type != music_type) {
+            continue;
+        }
+        if (!interface->CreateFromRW || !interface->GetAudio) {
+            continue;
+        }
+
+        /* These music interfaces are not safe to use while music is playing */
+        if (interface->api == MIX_MUSIC_CMD ||
+             interface->api == MIX_MUSIC_NATIVEMIDI) {
+            continue;
+        }
+
+        _Mix_LockMusicCreate(interface);
+        music = interface->CreateFromRW(src, freesrc);
+        _Mix_UnlockMusicCreate(interface);
+        if (music) {
+            /* The interface owns the data source now */
+            *out_interface = interface;
+            return music;
+        }
+
+        /* Reset the stream for the next decoder */
+        SDL_RWseek(src, start, RW_SEEK_SET);
+    }
+
+    if (freesrc) {
+        SDL_RWclose(src);
+    }
+    Mix_SetError("Unrecognized audio format");
+    return NULL;
+}
+
 /* Free a music chunk previously loaded */
 void MIXCALLCC Mix_FreeMusic(Mix_Music *music)
 {
@@ -2307,7 +2883,7 @@ void MIXCALLCC Mix_FreeMusic(Mix_Music *music)
 
         _Mix_remove_all_mus_effects(music, &music->effects);
 
-        music->interface->Delete(music->context);
+        music_delete(music);
         SDL_free(music);
     }
 }
@@ -2423,7 +2999,7 @@ static int music_internal_play(Mix_Music *music, int play_count, double position
     music_internal_initialize_volume();
 
     /* Set up for playback */
-    retval = music->interface->Play(music->context, play_count);
+    retval = music_context_call(music, MUSIC_CALL_PLAY, play_count, 0, 0.0, MIX_DECODE_AHEAD_FLUSH);
 
     /* Set the playback position, note any errors if an offset is used */
     if (retval == 0) {
@@ -2540,7 +3116,7 @@ static int music_internal_play_stream(Mix_Music *music, int play_count, double p
     music_internal_initialize_volume_stream(music);
 
     /* Set up for playback */
-    retval = music->interface->Play(music->context, play_count);
+    retval = music_context_call(music, MUSIC_CALL_PLAY, play_count, 0, 0.0, MIX_DECODE_AHEAD_FLUSH);
 
     /* Set the playback position, note any errors if an offset is used */
     if (retval == 0) {
@@ -2651,7 +3227,7 @@ int MIXCALLCC Mix_ModMusicJumpToOrder(int order)
     Mix_LockAudio();
     if (music_playing) {
         if (music_playing->interface->Jump) {
-            retval = music_playing->interface->Jump(music_playing->context, order);
+            retval = music_context_call(music_playing, MUSIC_CALL_JUMP, order, 0, 0.0, MIX_DECODE_AHEAD_FLUSH);
         } else {
             Mix_SetError("Jump not implemented for music type");
         }
@@ -2669,7 +3245,7 @@ int MIXCALLCC Mix_ModMusicStreamJumpToOrder(Mix_Music *music, int order)
     Mix_LockAudio();
     if (music && (music->is_multimusic || music_playing)) {
         if (music->interface->Jump) {
-            retval = music->interface->Jump(music->context, order);
+            retval = music_context_call(music, MUSIC_CALL_JUMP, order, 0, 0.0, MIX_DECODE_AHEAD_FLUSH);
         } else {
             Mix_SetError("Jump not implemented for music type");
         }
@@ -2685,7 +3261,9 @@ int MIXCALLCC Mix_ModMusicStreamJumpToOrder(Mix_Music *music, int order)
 int music_internal_position(Mix_Music *music, double position)
 {
     if (music->interface->Seek) {
-        return music->interface->Seek(music->context, position);
+        int ret;
+        ret = music_context_call(music, MUSIC_CALL_SEEK, 0, 0, position, MIX_DECODE_AHEAD_FLUSH);
+        return ret;
     }
     return -1;
 }
@@ -2723,7 +3301,23 @@ int MIXCALLCC Mix_SetMusicPosition(double position)
 static double music_internal_position_get(Mix_Music *music)
 {
     if (music->interface->Tell) {
-        return music->interface->Tell(music->context);
+        double ret;
+        /* The decoder is ahead of what is heard, and mustn't be waited for */
+        if (music->ahead &&
+            _Mix_DecodeAheadTell(music->ahead, &ret)) {
+            return ret;
+        }
+        music_context_lock(music);
+        ret = music->interface->Tell(music->context);
+        if (music->ahead && ret > 0.0) {
+            ret -= (double)_Mix_DecodeAheadBuffered(music->ahead) /
+                   ((SDL_AUDIO_BITSIZE(music_spec.format) / 8) * music_spec.channels * music_spec.freq);
+            if (ret < 0.0) {
+                ret = 0.0;
+            }
+        }
+        music_context_unlock(music, MIX_DECODE_AHEAD_KEEP);
+        return ret;
     }
     return -1;
 }
@@ -2748,7 +3342,11 @@ double MIXCALLCC Mix_GetMusicPosition(Mix_Music *music)
 static double music_internal_duration(Mix_Music *music)
 {
     if (music->interface->Duration) {
-        return music->interface->Duration(music->context);
+        double ret;
+        music_context_lock(music);
+        ret = music->interface->Duration(music->context);
+        music_context_unlock(music, MIX_DECODE_AHEAD_KEEP);
+        return ret;
     } else {
         Mix_SetError("Duration not implemented for music type");
         return -1;
@@ -2782,7 +3380,9 @@ double MIXCALLCC Mix_GetMusicTotalTime(Mix_Music *music)
 int music_internal_set_tempo(Mix_Music *music, double tempo)
 {
     if (music->interface->SetTempo) {
-        return music->interface->SetTempo(music->context, tempo);
+        int ret;
+        ret = music_context_call(music, MUSIC_CALL_TEMPO, 0, 0, tempo, MIX_DECODE_AHEAD_REWIND);
+        return ret;
     }
     return -1;
 }
@@ -2814,7 +3414,11 @@ int MIXCALLCC Mix_SetMusicTempo(Mix_Music *music, double tempo)
 static double music_internal_tempo(Mix_Music *music)
 {
     if (music->interface->GetTempo) {
-        return music->interface->GetTempo(music->context);
+        double ret;
+        music_context_lock(music);
+        ret = music->interface->GetTempo(music->context);
+        music_context_unlock(music, MIX_DECODE_AHEAD_KEEP);
+        return ret;
     }
     return -1.0;
 }
@@ -2840,7 +3444,9 @@ double MIXCALLCC Mix_GetMusicTempo(Mix_Music *music)
 int music_internal_set_speed(Mix_Music *music, double speed)
 {
     if (music->interface->SetSpeed) {
-        return music->interface->SetSpeed(music->context, speed);
+        int ret;
+        ret = music_context_call(music, MUSIC_CALL_SPEED, 0, 0, speed, MIX_DECODE_AHEAD_REWIND);
+        return ret;
     }
     return -1;
 }
@@ -2872,7 +3478,11 @@ int MIXCALLCC Mix_SetMusicSpeed(Mix_Music *music, double speed)
 static double music_internal_speed(Mix_Music *music)
 {
     if (music->interface->GetSpeed) {
-        return music->interface->GetSpeed(music->context);
+        double ret;
+        music_context_lock(music);
+        ret = music->interface->GetSpeed(music->context);
+        music_context_unlock(music, MIX_DECODE_AHEAD_KEEP);
+        return ret;
     }
     return -1.0;
 }
@@ -2898,7 +3508,9 @@ double MIXCALLCC Mix_GetMusicSpeed(Mix_Music *music)
 int music_internal_set_pitch(Mix_Music *music, double pitch)
 {
     if (music->interface->SetPitch) {
-        return music->interface->SetPitch(music->context, pitch);
+        int ret;
+        ret = music_context_call(music, MUSIC_CALL_PITCH, 0, 0, pitch, MIX_DECODE_AHEAD_REWIND);
+        return ret;
     }
     return -1;
 }
@@ -2930,7 +3542,11 @@ int MIXCALLCC Mix_SetMusicPitch(Mix_Music *music, double pitch)
 static double music_internal_pitch(Mix_Music *music)
 {
     if (music->interface->GetPitch) {
-        return music->interface->GetPitch(music->context);
+        double ret;
+        music_context_lock(music);
+        ret = music->interface->GetPitch(music->context);
+        music_context_unlock(music, MIX_DECODE_AHEAD_KEEP);
+        return ret;
     }
     return -1.0;
 }
@@ -2956,7 +3572,11 @@ double MIXCALLCC Mix_GetMusicPitch(Mix_Music *music)
 static int music_internal_tracks(Mix_Music *music)
 {
     if (music->interface->GetTracksCount) {
-        return music->interface->GetTracksCount(music->context);
+        int ret;
+        music_context_lock(music);
+        ret = music->interface->GetTracksCount(music->context);
+        music_context_unlock(music, MIX_DECODE_AHEAD_KEEP);
+        return ret;
     }
     return -1;
 }
@@ -2982,7 +3602,9 @@ int MIXCALLCC Mix_GetMusicTracks(Mix_Music *music)
 int music_internal_set_track_mute(Mix_Music *music, int track, int mute)
 {
     if (music->interface->SetTrackMute) {
-        return music->interface->SetTrackMute(music->context, track, mute);
+        int ret;
+        ret = music_context_call(music, MUSIC_CALL_TRACK_MUTE, track, mute, 0.0, MIX_DECODE_AHEAD_REWIND);
+        return ret;
     }
     return -1;
 }
@@ -3015,7 +3637,11 @@ int MIXCALLCC Mix_SetMusicTrackMute(Mix_Music *music, int track, int mute)
 static double music_internal_loop_start(Mix_Music *music)
 {
     if (music->interface->LoopStart) {
-        return music->interface->LoopStart(music->context);
+        double ret;
+        music_context_lock(music);
+        ret = music->interface->LoopStart(music->context);
+        music_context_unlock(music, MIX_DECODE_AHEAD_KEEP);
+        return ret;
     }
     return -1;
 }
@@ -3041,7 +3667,11 @@ double MIXCALLCC Mix_GetMusicLoopStartTime(Mix_Music *music)
 static double music_internal_loop_end(Mix_Music *music)
 {
     if (music->interface->LoopEnd) {
-        return music->interface->LoopEnd(music->context);
+        double ret;
+        music_context_lock(music);
+        ret = music->interface->LoopEnd(music->context);
+        music_context_unlock(music, MIX_DECODE_AHEAD_KEEP);
+        return ret;
     }
     return -1;
 }
@@ -3067,7 +3697,11 @@ double MIXCALLCC Mix_GetMusicLoopEndTime(Mix_Music *music)
 static double music_internal_loop_length(Mix_Music *music)
 {
     if (music->interface->LoopLength) {
-        return music->interface->LoopLength(music->context);
+        double ret;
+        music_context_lock(music);
+        ret = music->interface->LoopLength(music->context);
+        music_context_unlock(music, MIX_DECODE_AHEAD_KEEP);
+        return ret;
     }
     return -1;
 }
@@ -3113,12 +3747,37 @@ static void music_internal_initialize_volume_stream(Mix_Music *music)
 /* Set the music volume */
 static void music_internal_volume(Mix_Music *music, int volume)
 {
-    if (music->interface->SetVolume) {
+    if (music->ahead) {
+        /* Applied to what is heard, not a whole ring ahead of it */
+        _Mix_DecodeAheadSetVolume(music->ahead, volume);
+    } else if (music->interface->SetVolume) {
         music->interface->SetVolume(music->context, volume);
     }
 }
+
+static int music_internal_get_volume(Mix_Music *music)
+{
+    if (music->ahead) {
+        return _Mix_DecodeAheadGetVolume(music->ahead);
+    }
+    return music->interface->GetVolume(music->context);
+}
+static void music_volume_command(const Mix_Command *cmd)
+{
+    Mix_Music *music = (Mix_Music *)cmd->ptr;
+
+    if (music) {
+        music->music_volume = cmd->arg1;
+        music_internal_volume(music, cmd->arg1);
+    } else if (music_playing) {
+        music_playing->music_volume = cmd->arg1;
+        music_internal_volume(music_playing, cmd->arg1);
+    }
+}
+
 int MIXCALLCC Mix_VolumeMusicStream(Mix_Music *music, int volume)
 {
+    Mix_Command cmd;
     int prev_volume;
 
     prev_volume = Mix_GetVolumeMusicStream(music);
@@ -3134,15 +3793,11 @@ int MIXCALLCC Mix_VolumeMusicStream(Mix_Music *music, int volume)
         music_volume = volume;
     }
 
-    Mix_LockAudio();
-    if (music) {
-        music->music_volume = volume;
-        music_internal_volume(music, volume);
-    } else if (music_playing) {
-        music_playing->music_volume = volume;
-        music_internal_volume(music_playing, volume);
-    }
-    Mix_UnlockAudio();
+    SDL_zero(cmd);
+    cmd.func = music_volume_command;
+    cmd.ptr = music;
+    cmd.arg1 = volume;
+    _Mix_RunCommand(&cmd);
     return(prev_volume);
 }
 int MIXCALLCC Mix_VolumeMusic(int volume)
@@ -3154,10 +3809,12 @@ int MIXCALLCC Mix_GetMusicVolume(Mix_Music *music)
 {
     int prev_volume;
 
+    _Mix_SyncCommands();
+
     if (music && music->interface->GetVolume) {
-        prev_volume = music->interface->GetVolume(music->context);
+        prev_volume = music_internal_get_volume(music);
     } else if (music_playing && music_playing->interface->GetVolume) {
-        prev_volume = music_playing->interface->GetVolume(music_playing->context);
+        prev_volume = music_internal_get_volume(music_playing);
     } else {
         prev_volume = music_volume;
     }
@@ -3170,24 +3827,165 @@ int MIXCALLCC Mix_GetVolumeMusicStream(Mix_Music *music)
     return Mix_GetMusicVolume(music);
 }
 
+static void music_general_volume_command(const Mix_Command *cmd)
+{
+    music_general_volume = cmd->arg1;
+}
+
 void MIXCALLCC Mix_VolumeMusicGeneral(int volume)
 {
-    Mix_LockAudio();
+    Mix_Command cmd;
+
     if (volume < 0) {
         volume = 0;
     }
     if (volume > SDL_MIX_MAXVOLUME) {
         volume = SDL_MIX_MAXVOLUME;
     }
-    music_general_volume = volume;
-    Mix_UnlockAudio();
+
+    SDL_zero(cmd);
+    cmd.func = music_general_volume_command;
+    cmd.arg1 = volume;
+    _Mix_RunCommand(&cmd);
 }
 
 int MIXCALLCC Mix_GetVolumeMusicGeneral(void)
 {
+    _Mix_SyncCommands();
     return music_general_volume;
 }
 
+int MIXCALLCC Mix_SetMultiMusicThreads(int threads)
+{
+    int ret = 0;
+
+    if (!Mix_QuerySpec(NULL, NULL, NULL)) {
+        return Mix_SetError("Audio device hasn't been opened");
+    }
+
+    Mix_LockAudio();
+    if (threads <= 0) {
+        _Mix_MultiMusic_FreeJobs();
+    } else if (!_Mix_MultiMusic_ReserveJobs(num_streams_capacity)) {
+        _Mix_MultiMusic_FreeJobs();
+        ret = SDL_OutOfMemory();
+    } else {
+        mix_streams_threads = _Mix_WorkersSetThreads(threads);
+        mix_streams_serial_left = 0;
+        if (mix_streams_threads == 0) {
+            _Mix_MultiMusic_FreeJobs();
+            ret = Mix_SetError("Can't start worker threads");
+        }
+    }
+    Mix_UnlockAudio();
+
+    return ret;
+}
+
+int MIXCALLCC Mix_GetMultiMusicThreads(void)
+{
+    return mix_streams_threads;
+}
+
+int MIXCALLCC Mix_GetMusicPerfStats(Mix_Music *music, Mix_PerfStats *stats)
+{
+    if (!music) {
+        return Mix_SetError("Invalid music");
+    }
+    if (!stats) {
+        return Mix_SetError("Invalid stats");
+    }
+
+    _Mix_PerfReport(&music->perf, stats);
+    return 0;
+}
+
+int MIXCALLCC Mix_GetMusicDecoderPerfStats(const char *name, Mix_PerfStats *stats)
+{
+    int i;
+
+    if (!name || !stats) {
+        return Mix_SetError("Invalid argument");
+    }
+
+    for (i = 0; i < get_num_music_interfaces(); ++i) {
+        Mix_MusicInterface *interface = s_music_interfaces[i];
+        if (interface && SDL_strcasecmp(interface->tag, name) == 0) {
+            _Mix_PerfReport(&music_perf_decoders[interface->api], stats);
+            return 0;
+        }
+    }
+
+    return Mix_SetError("Unknown music decoder '%s'", name);
+}
+
+int MIXCALLCC Mix_SetMusicDecodeAhead(Mix_Music *music, int ms)
+{
+    Mix_DecodeAhead *ahead;
+    int frame_size, ring_bytes, volume;
+    Uint32 wait_ms;
+    int ret = 0;
+
+    if (!music) {
+        return Mix_SetError("Invalid music");
+    }
+
+    if (!music->interface->GetAudio) {
+        return Mix_SetError("Decode-ahead is not supported for music type");
+    }
+
+    if (!Mix_QuerySpec(NULL, NULL, NULL)) {
+        return Mix_SetError("Audio device hasn't been opened");
+    }
+
+    frame_size = (SDL_AUDIO_BITSIZE(music_spec.format) / 8) * music_spec.channels;
+    ring_bytes = (int)(((Sint64)music_spec.freq * ms) / 1000) * frame_size;
+    /* Wake up the producer twice per audio buffer at least */
+    wait_ms = (Uint32)((music_spec.samples * 1000) / music_spec.freq / 2) + 1;
+
+    /* Joining the producer takes a piece to decode, so it's done out of the
+       audio lock, the audio thread decodes by itself meanwhile */
+    ahead = music->ahead;
+    if (ahead) {
+        _Mix_DecodeAheadStop(ahead);
+    }
+
+    Mix_LockAudio();
+    music->ahead = NULL;
+    music->ahead_ms = 0;
+    /* Nobody else uses it anymore, and the producer is gone already */
+    _Mix_DecodeAheadDestroy(ahead);
+
+    if (ms > 0) {
+        volume = music->interface->GetVolume ? music->interface->GetVolume(music->context) : MIX_MAX_VOLUME;
+        music->ahead = _Mix_DecodeAheadCreate(music->context,
+                                              music->interface->GetAudio,
+                                              music->interface->SetVolume,
+                                              music->interface->Tell,
+                                              music->interface->Seek,
+                                              music->interface->GetSpeed,
+                                              music->interface->GetTempo,
+                                              ring_bytes, (int)music_spec.size,
+                                              wait_ms, music_spec.silence,
+                                              music_spec.format, music_spec.channels,
+                                              music_spec.freq, volume,
+                                              music->playing);
+        if (music->ahead) {
+            music->ahead_ms = ms;
+        } else {
+            ret = -1;
+        }
+    }
+    Mix_UnlockAudio();
+
+    return ret;
+}
+
+int MIXCALLCC Mix_GetMusicDecodeAhead(Mix_Music *music)
+{
+    return music ? music->ahead_ms : 0;
+}
+
 int MIXCALLCC Mix_SetMusicGain(Mix_Music *music, float gain)
 {
     int ret = -1;
@@ -3198,7 +3996,7 @@ int MIXCALLCC Mix_SetMusicGain(Mix_Music *music, float gain)
 
     Mix_LockAudio();
     if (music && music->interface && music->interface->SetGain) {
-        music->interface->SetGain(music->context, gain);
+        music_context_call(music, MUSIC_CALL_GAIN, 0, 0, gain, MIX_DECODE_AHEAD_KEEP);
         ret = 0;
     }
     Mix_UnlockAudio();
@@ -3212,7 +4010,9 @@ float MIXCALLCC Mix_GetMusicGain(Mix_Music *music)
 
     Mix_LockAudio();
     if (music && music->interface && music->interface->GetGain) {
+        music_context_lock(music);
         ret = music->interface->GetGain(music->context);
+        music_context_unlock(music, MIX_DECODE_AHEAD_KEEP);
     }
     Mix_UnlockAudio();
 
@@ -3222,9 +4022,9 @@ float MIXCALLCC Mix_GetMusicGain(Mix_Music *music)
 /* Halt playing of music */
 static void music_internal_halt(Mix_Music *music)
 {
-    if (music->interface->Stop) {
-        music->interface->Stop(music->context);
-    }
+    /* Runs at the audio thread once a fade-out or the stream ends, so it never
+       waits for the decode-ahead producer */
+    music_context_call(music, MUSIC_CALL_STOP, 0, 0, 0.0, MIX_DECODE_AHEAD_STOP);
 
     music->playing = SDL_FALSE;
     music->fading = MIX_NO_FADING;
@@ -3372,41 +4172,52 @@ Mix_Fading MIXCALLCC Mix_FadingMusic(void)
 }
 
 /* Pause/Resume the music stream */
-void MIXCALLCC Mix_PauseMusicStream(Mix_Music *music)
+static void music_pause_command(const Mix_Command *cmd)
 {
-    Mix_LockAudio();
+    Mix_Music *music = (Mix_Music *)cmd->ptr;
+
     if (music) {
         if (music->interface->Pause) {
-            music->interface->Pause(music->context);
+            music_context_call(music, MUSIC_CALL_PAUSE, 0, 0, 0.0, MIX_DECODE_AHEAD_KEEP);
         }
         if (music->is_multimusic) {
             music->music_active = SDL_FALSE;
         }
     } else if (music_playing) {
         if (music_playing->interface->Pause) {
-            music_playing->interface->Pause(music_playing->context);
+            music_context_call(music_playing, MUSIC_CALL_PAUSE, 0, 0, 0.0, MIX_DECODE_AHEAD_KEEP);
         }
     }
     if (music == music_playing || music == NULL) {
         music_active = SDL_FALSE;
     }
-    Mix_UnlockAudio();
+}
+
+void MIXCALLCC Mix_PauseMusicStream(Mix_Music *music)
+{
+    Mix_Command cmd;
+
+    SDL_zero(cmd);
+    cmd.func = music_pause_command;
+    cmd.ptr = music;
+    _Mix_RunCommand(&cmd);
 }
 void MIXCALLCC Mix_PauseMusic(void)
 {
     Mix_PauseMusicStream(NULL);
 }
 
-void MIXCALLCC Mix_ResumeMusicStream(Mix_Music *music)
+static void music_resume_command(const Mix_Command *cmd)
 {
-    Mix_LockAudio();
+    Mix_Music *music = (Mix_Music *)cmd->ptr;
+
     if (music) {
         if (music->interface->Resume) {
-            music->interface->Resume(music->context);
+            music_context_call(music, MUSIC_CALL_RESUME, 0, 0, 0.0, MIX_DECODE_AHEAD_KEEP);
         }
     } else if (music_playing) {
         if (music_playing->interface->Resume) {
-            music_playing->interface->Resume(music_playing->context);
+            music_context_call(music_playing, MUSIC_CALL_RESUME, 0, 0, 0.0, MIX_DECODE_AHEAD_KEEP);
         }
     }
 
@@ -3415,8 +4226,16 @@ void MIXCALLCC Mix_ResumeMusicStream(Mix_Music *music)
     } else if (music == music_playing || music == NULL) {
         music_active = SDL_TRUE;
     }
+}
 
-    Mix_UnlockAudio();
+void MIXCALLCC Mix_ResumeMusicStream(Mix_Music *music)
+{
+    Mix_Command cmd;
+
+    SDL_zero(cmd);
+    cmd.func = music_resume_command;
+    cmd.ptr = music;
+    _Mix_RunCommand(&cmd);
 }
 void MIXCALLCC Mix_ResumeMusic(void)
 {
@@ -3442,7 +4261,7 @@ void MIXCALLCC Mix_RewindMusic(void)
 
 int MIXCALLCC Mix_PausedMusicStream(Mix_Music *music)
 {
-    (void)music;
+    _Mix_SyncCommands();
 
     if (music && music->is_multimusic) {
         return (music->music_active == SDL_FALSE);
@@ -3453,6 +4272,7 @@ int MIXCALLCC Mix_PausedMusicStream(Mix_Music *music)
 
 int MIXCALLCC Mix_PausedMusic(void)
 {
+    _Mix_SyncCommands();
     return (music_active == SDL_FALSE);
 }
 
@@ -3462,10 +4282,7 @@ int MIXCALLCC Mix_StartTrack(Mix_Music *music, int track)
 
     Mix_LockAudio();
     if (music && music->interface->StartTrack) {
-        if (music->interface->Pause) {
-            music->interface->Pause(music->context);
-        }
-        result = music->interface->StartTrack(music->context, track);
+        result = music_context_call(music, MUSIC_CALL_START_TRACK, track, 0, 0.0, MIX_DECODE_AHEAD_FLUSH);
     } else {
         result = Mix_SetError("That operation is not supported");
     }
@@ -3480,7 +4297,9 @@ int MIXCALLCC Mix_GetNumTracks(Mix_Music *music)
 
     Mix_LockAudio();
     if (music && music->interface->GetNumTracks) {
+        music_context_lock(music);
         result = music->interface->GetNumTracks(music->context);
+        music_context_unlock(music, MIX_DECODE_AHEAD_KEEP);
     } else {
         result = Mix_SetError("That operation is not supported");
     }
@@ -3495,7 +4314,8 @@ static SDL_bool music_internal_playing(Mix_Music *music)
         return SDL_FALSE;
     }
 
-    if (music->interface->IsPlaying) {
+    /* The decode-ahead reader tracks the end of the stream by itself */
+    if (music->interface->IsPlaying && !music->ahead) {
         music->playing = music->interface->IsPlaying(music->context);
     }
     return music->playing;
@@ -3525,6 +4345,7 @@ int MIXCALLCC Mix_SetMusicCMD(const char *command)
 {
     Mix_HaltMusicStream(music_playing);
     _Mix_MultiMusic_HaltAll();
+    _Mix_MultiMusic_FreeJobs();
     if (music_cmd) {
         SDL_free(music_cmd);
         music_cmd = NULL;
@@ -3574,6 +4395,12 @@ void close_music(void)
         interface->opened = SDL_FALSE;
     }
 
+    /* Cached synthesizers are made for the closing audio spec */
+    _Mix_BankCacheFlush(NULL);
+
+    /* The loader threads got been stopped already */
+    _Mix_QuitMusicCreateLocks();
+
     if (soundfont_paths) {
         SDL_free(soundfont_paths);
         soundfont_paths = NULL;
@@ -3720,6 +4547,40 @@ int MIXCALLCC Mix_EachSoundFontEx(const char* cpaths, int (SDLCALL *function)(co
 }
 
 
+int MIXCALLCC Mix_PreloadMidiBanks(void)
+{
+    int ret = 0;
+
+#ifdef MUSIC_MID_ADLMIDI
+    if (_Mix_ADLMIDI_preloadCustomBank() < 0) {
+        ret = -1;
+    }
+#endif
+#ifdef MUSIC_MID_OPNMIDI
+    if (_Mix_OPNMIDI_preloadCustomBank() < 0) {
+        ret = -1;
+    }
+#endif
+#ifdef MUSIC_MID_FLUIDSYNTH
+    if (Mix_MusicInterface_FLUIDSYNTH.opened && _Mix_FLUIDSYNTH_preloadSoundFonts() < 0) {
+        ret = -1;
+    }
+#endif
+
+    return ret;
+}
+
+void MIXCALLCC Mix_EvictMidiBanks(void)
+{
+    _Mix_BankCacheFlush(NULL);
+}
+
+Sint64 MIXCALLCC Mix_GetMidiBanksMemory(void)
+{
+    return _Mix_BankCacheMemory();
+}
+
+
 int MIXCALLCC Mix_GetMidiPlayer()
 {
     return midiplayer_current;
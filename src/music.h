@@ -217,9 +217,22 @@ extern SDL_bool load_music_type(Mix_MusicType type);
 extern SDL_bool open_music_type(Mix_MusicType type);
 extern SDL_bool open_music_type_ex(Mix_MusicType type, int midi_player);
 extern SDL_bool has_music(Mix_MusicType type);
+extern void _Mix_PrepareMusicRW(SDL_RWops *src, Mix_MusicType type, const char *args);
+extern void _Mix_PrepareMusicFile(const char *file);
+/* Serialize the creation of musics by the codecs which aren't reentrant,
+   the locks exist while the audio is open. Without them (out of memory),
+   nothing may be loaded by the loader threads */
+extern int _Mix_InitMusicCreateLocks(void);
+extern SDL_bool _Mix_HasMusicCreateLocks(void);
+extern void _Mix_QuitMusicCreateLocks(void);
+extern void _Mix_LockMusicCreate(const Mix_MusicInterface *interface);
+extern void _Mix_UnlockMusicCreate(const Mix_MusicInterface *interface);
+extern void *_Mix_CreateChunkDecoder(SDL_RWops *src, int freesrc, Mix_MusicInterface **out_interface);
+extern void _Mix_SetMusicOffline(SDL_bool offline);
 extern void open_music(const SDL_AudioSpec *spec);
 extern int music_pcm_getaudio(void *context, void *data, int bytes, int volume,
                               int (*GetSome)(void *context, void *data, int bytes, SDL_bool *done));
+extern SDL_bool music_pcm_is_native(SDL_AudioFormat format, int channels, int freq);
 extern void SDLCALL multi_music_mixer(void *udata, Uint8 *stream, int len);
 extern void SDLCALL music_mixer(void *udata, Uint8 *stream, int len);
 extern void pause_async_music(int pause_on);
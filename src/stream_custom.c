@@ -22,6 +22,31 @@
 #define STREAM_CUSTOM_INTERNAL
 #include "stream_custom.h"
 #include "SDL_audio.h"
+#include "SDL_endian.h"
+#include "SDL_mixer.h"
+
+#if !defined(MIXERX_DISABLE_SIMD) && (SDL_BYTEORDER == SDL_LIL_ENDIAN)
+#   if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#       define STREAM_CUSTOM_SSE2
+#       include <emmintrin.h>
+#   elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+#       define STREAM_CUSTOM_NEON
+#       include <arm_neon.h>
+#   endif
+#endif
+
+/* The linear resampler keeps the last frame of S16 streams in place */
+#define LINEAR_MAX_CHANNELS 8
+
+/* The windowed-sinc filter: 16 taps (a multiple of 4 for the SIMD dot
+   product), and 256 phases between two input frames */
+#define SINC_HALF_TAPS      8
+#define SINC_TAPS           (SINC_HALF_TAPS * 2)
+#define SINC_PHASE_BITS     8
+#define SINC_PHASES         (1 << SINC_PHASE_BITS)
+#define SINC_CUTOFF         0.95
+
+static int s_default_quality = MIX_RESAMPLER_NEAREST;
 
 
 struct _Mix_AudioStream
@@ -38,10 +63,32 @@ struct _Mix_AudioStream
     int src_rate;
     int dst_rate;
 
+    SDL_AudioFormat dst_format;
+    Uint8 dst_channels;
+
     double ratio;
     double resample_pos;
     double resample_offset;
 
+    int quality;
+    /* Format of the resampler output */
+    SDL_AudioFormat out_format;
+    size_t out_sample_size;
+
+    /* Position of the next output frame and input frames per output frame, 32.32 fixed point */
+    Uint64 pos_fixed;
+    Uint64 step_fixed;
+
+    /* Linear S16: the last input frame of the previous call */
+    Sint16 last_frame[LINEAR_MAX_CHANNELS];
+
+    /* Linear and sinc in floats: planar input history, and the filter phases */
+    float *work;
+    int    work_cap;
+    int    work_frames;
+    int    taps;
+    float *coeffs;
+
     void (*filter)(Mix_AudioStream *res, const Uint8 *in, int len, size_t sample_size);
     size_t sample_size;
 
@@ -51,10 +98,13 @@ struct _Mix_AudioStream
 
 static int s_reallocBuffer(Mix_AudioStream *stream, int len)
 {
+    size_t in_frame = stream->src_channels * stream->sample_size;
+    size_t out_frame = stream->src_channels * stream->out_sample_size;
+
     stream->local_buffer_len_src = len;
 
     if (stream->ratio > 0.0) {
-        stream->local_buffer_len = (size_t)SDL_ceil(len * stream->ratio) + 32;
+        stream->local_buffer_len = ((size_t)SDL_ceil((len / in_frame) * stream->ratio) + 32) * out_frame;
     } else {
         stream->local_buffer_len = (size_t)len + 32;
     }
@@ -74,6 +124,255 @@ static int s_reallocBuffer(Mix_AudioStream *stream, int len)
 }
 
 
+/* Fixed-point linear interpolation of the native 16-bit streams. The input
+   frame 0 is the last frame of the previous call, frame N is in[N - 1] */
+static void s_linearS16(Mix_AudioStream *stream, const Uint8 *in, int len, size_t sample_size)
+{
+    const Sint16 *src = (const Sint16 *)in;
+    const Sint16 *a, *b;
+    Sint16 *dst = (Sint16 *)stream->local_buffer;
+    Sint16 *dst_end = (Sint16 *)(stream->local_buffer + stream->local_buffer_len);
+    int channels = stream->src_channels;
+    int frames = len / (int)(channels * sample_size);
+    Uint64 pos = stream->pos_fixed;
+    Sint32 w;
+    int idx, c;
+
+    stream->local_buffer_stored = 0;
+
+    if (frames <= 0) {
+        return;
+    }
+
+    while ((idx = (int)(pos >> 32)) < frames && dst_end - dst >= channels) {
+        a = idx == 0 ? stream->last_frame : src + (idx - 1) * channels;
+        b = src + idx * channels;
+        w = (Sint32)((Uint32)pos >> 17);
+        for (c = 0; c < channels; ++c) {
+            dst[c] = (Sint16)(a[c] + (((b[c] - a[c]) * w) >> 15));
+        }
+        dst += channels;
+        pos += stream->step_fixed;
+    }
+
+    stream->local_buffer_stored = (size_t)((Uint8 *)dst - stream->local_buffer);
+    SDL_memcpy(stream->last_frame, src + (frames - 1) * channels, channels * sizeof(Sint16));
+    stream->pos_fixed = pos - ((Uint64)frames << 32);
+}
+
+
+static float *s_makeSincTable(double cutoff)
+{
+    const double pi = 3.14159265358979323846;
+    float *table = (float *)SDL_malloc(sizeof(float) * SINC_TAPS * (SINC_PHASES + 1));
+    double row[SINC_TAPS], x, y, sum;
+    int p, k;
+
+    if (!table) {
+        SDL_OutOfMemory();
+        return NULL;
+    }
+
+    /* Row p is for the output at p / SINC_PHASES after the input frame
+       SINC_HALF_TAPS - 1 of the taps, the extra last row is for 1.0 */
+    for (p = 0; p <= SINC_PHASES; ++p) {
+        sum = 0.0;
+        for (k = 0; k < SINC_TAPS; ++k) {
+            x = (double)(k - (SINC_HALF_TAPS - 1)) - (double)p / SINC_PHASES;
+            y = cutoff * x;
+            row[k] = (y == 0.0) ? cutoff : cutoff * SDL_sin(pi * y) / (pi * y);
+            /* Blackman window */
+            row[k] *= 0.42 + 0.5 * SDL_cos(pi * x / SINC_HALF_TAPS) + 0.08 * SDL_cos(2.0 * pi * x / SINC_HALF_TAPS);
+            sum += row[k];
+        }
+        for (k = 0; k < SINC_TAPS; ++k) {
+            table[p * SINC_TAPS + k] = (float)(row[k] / sum);
+        }
+    }
+
+    return table;
+}
+
+static float s_dotSinc(const float *x, const float *h)
+{
+#if defined(STREAM_CUSTOM_SSE2)
+    __m128 acc = _mm_mul_ps(_mm_loadu_ps(x), _mm_loadu_ps(h));
+    int k;
+
+    for (k = 4; k < SINC_TAPS; k += 4) {
+        acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(x + k), _mm_loadu_ps(h + k)));
+    }
+    acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+    acc = _mm_add_ss(acc, _mm_shuffle_ps(acc, acc, 1));
+    return _mm_cvtss_f32(acc);
+#elif defined(STREAM_CUSTOM_NEON)
+    float32x4_t acc = vmulq_f32(vld1q_f32(x), vld1q_f32(h));
+    float32x2_t sum;
+    int k;
+
+    for (k = 4; k < SINC_TAPS; k += 4) {
+        acc = vmlaq_f32(acc, vld1q_f32(x + k), vld1q_f32(h + k));
+    }
+    sum = vadd_f32(vget_low_f32(acc), vget_high_f32(acc));
+    return vget_lane_f32(vpadd_f32(sum, sum), 0);
+#else
+    float acc = 0.0f;
+    int k;
+
+    for (k = 0; k < SINC_TAPS; ++k) {
+        acc += x[k] * h[k];
+    }
+    return acc;
+#endif
+}
+
+static int s_growWork(Mix_AudioStream *stream, int frames)
+{
+    int channels = stream->src_channels;
+    int cap = frames + frames / 2 + SINC_TAPS;
+    float *work;
+    int c;
+
+    if (frames <= stream->work_cap) {
+        return 1;
+    }
+
+    work = (float *)SDL_malloc(sizeof(float) * channels * cap);
+    if (!work) {
+        SDL_OutOfMemory();
+        return 0;
+    }
+
+    if (stream->work) {
+        for (c = 0; c < channels; ++c) {
+            SDL_memcpy(work + c * cap, stream->work + c * stream->work_cap, sizeof(float) * stream->work_frames);
+        }
+        SDL_free(stream->work);
+    }
+
+    stream->work = work;
+    stream->work_cap = cap;
+    return 1;
+}
+
+#define F_TO_FLOAT(expr) \
+    for (i = 0; i < frames; ++i) {\
+        for (c = 0; c < channels; ++c, src += sample_size) {\
+            out[c * cap + i] = (expr);\
+        }\
+    }
+
+/* Append the input frames to the planes of the history, or silence if 'in' is NULL */
+static void s_appendFloat(Mix_AudioStream *stream, const Uint8 *in, int frames, size_t sample_size)
+{
+    const Uint8 *src = in;
+    float *out = stream->work + stream->work_frames;
+    int channels = stream->src_channels;
+    int cap = stream->work_cap;
+    int i, c;
+
+    if (!in) {
+        for (c = 0; c < channels; ++c) {
+            SDL_memset(out + c * cap, 0, sizeof(float) * frames);
+        }
+        stream->work_frames += frames;
+        return;
+    }
+
+    switch (stream->src_format) {
+    case AUDIO_U8:
+        F_TO_FLOAT(((float)*src - 128.0f) * (1.0f / 128.0f))
+        break;
+    case AUDIO_S8:
+        F_TO_FLOAT((float)*(const Sint8 *)src * (1.0f / 128.0f))
+        break;
+    case AUDIO_S16LSB:
+        F_TO_FLOAT((float)(Sint16)SDL_SwapLE16(*(const Uint16 *)src) * (1.0f / 32768.0f))
+        break;
+    case AUDIO_S16MSB:
+        F_TO_FLOAT((float)(Sint16)SDL_SwapBE16(*(const Uint16 *)src) * (1.0f / 32768.0f))
+        break;
+    case AUDIO_S32LSB:
+        F_TO_FLOAT((float)(Sint32)SDL_SwapLE32(*(const Uint32 *)src) * (1.0f / 2147483648.0f))
+        break;
+    case AUDIO_S32MSB:
+        F_TO_FLOAT((float)(Sint32)SDL_SwapBE32(*(const Uint32 *)src) * (1.0f / 2147483648.0f))
+        break;
+    case AUDIO_F32LSB:
+        F_TO_FLOAT(SDL_SwapFloatLE(*(const float *)src))
+        break;
+    case AUDIO_F32MSB:
+        F_TO_FLOAT(SDL_SwapFloatBE(*(const float *)src))
+        break;
+    default:
+        /* Unsupported formats never get here, see s_setupResampler() */
+        break;
+    }
+
+    stream->work_frames += frames;
+}
+
+#undef F_TO_FLOAT
+
+/* Linear or sinc interpolation of the planar float history, the output is
+   interleaved floats */
+static void s_resampleFloat(Mix_AudioStream *stream, const Uint8 *in, int len, size_t sample_size)
+{
+    int channels = stream->src_channels;
+    int frames = len / (int)(channels * sample_size);
+    int half = stream->taps / 2;
+    float *dst = (float *)stream->local_buffer;
+    float *dst_end = (float *)(stream->local_buffer + stream->local_buffer_len);
+    Uint64 pos = stream->pos_fixed;
+    const float *plane, *row;
+    float f;
+    int idx, shift, c;
+
+    stream->local_buffer_stored = 0;
+
+    if (frames <= 0 || !s_growWork(stream, stream->work_frames + frames)) {
+        return;
+    }
+
+    s_appendFloat(stream, in, frames, sample_size);
+
+    while ((idx = (int)(pos >> 32)) + half < stream->work_frames && dst_end - dst >= channels) {
+        if (stream->taps == 2) {
+            f = (float)(Uint32)pos * (1.0f / 4294967296.0f);
+            for (c = 0; c < channels; ++c) {
+                plane = stream->work + c * stream->work_cap + idx;
+                dst[c] = plane[0] + (plane[1] - plane[0]) * f;
+            }
+        } else {
+            row = stream->coeffs + (size_t)(((Uint64)(Uint32)pos + (1u << (31 - SINC_PHASE_BITS))) >> (32 - SINC_PHASE_BITS)) * SINC_TAPS;
+            for (c = 0; c < channels; ++c) {
+                dst[c] = s_dotSinc(stream->work + c * stream->work_cap + idx - half + 1, row);
+            }
+        }
+        dst += channels;
+        pos += stream->step_fixed;
+    }
+
+    stream->local_buffer_stored = (size_t)((Uint8 *)dst - stream->local_buffer);
+
+    /* Drop the frames which are not needed anymore */
+    shift = (int)(pos >> 32) - half + 1;
+    if (shift > stream->work_frames) {
+        shift = stream->work_frames;
+    }
+    if (shift > 0) {
+        for (c = 0; c < channels; ++c) {
+            plane = stream->work + c * stream->work_cap;
+            SDL_memmove((float *)plane, plane + shift, sizeof(float) * (stream->work_frames - shift));
+        }
+        stream->work_frames -= shift;
+        pos -= (Uint64)shift << 32;
+    }
+
+    stream->pos_fixed = pos;
+}
+
+
 static void s_upSampleAny(Mix_AudioStream *stream, const Uint8 *in, int len, size_t sample_size)
 {
     const Uint8 *src = in;
@@ -179,6 +478,148 @@ F_RESAMPLE_BY_BYTE(4, Uint32)
 F_RESAMPLE_BY_BYTE(8, Uint64)
 
 
+static SDL_bool s_floatFormatSupported(SDL_AudioFormat format)
+{
+    switch (format) {
+    case AUDIO_U8:
+    case AUDIO_S8:
+    case AUDIO_S16LSB:
+    case AUDIO_S16MSB:
+    case AUDIO_S32LSB:
+    case AUDIO_S32MSB:
+    case AUDIO_F32LSB:
+    case AUDIO_F32MSB:
+        return SDL_TRUE;
+    default:
+        return SDL_FALSE;
+    }
+}
+
+static void s_setupNearest(Mix_AudioStream *stream)
+{
+    int src_rate = stream->src_rate, dst_rate = stream->dst_rate;
+
+    stream->resample_pos = src_rate < dst_rate ? 0.0 : 1.0;
+
+    switch(stream->sample_size * stream->src_channels)
+    {
+    case 1:
+        stream->filter = src_rate < dst_rate ? s_upSample1byte : s_downSample1byte;
+        break;
+
+    case 2:
+        stream->filter = src_rate < dst_rate ? s_upSample2byte : s_downSample2byte;
+        break;
+
+    case 4:
+        stream->filter = src_rate < dst_rate ? s_upSample4byte : s_downSample4byte;
+        break;
+
+    case 8:
+        stream->filter = src_rate < dst_rate ? s_upSample8byte : s_downSample8byte;
+        break;
+
+    default:
+        stream->filter = src_rate < dst_rate ? s_upSampleAny : s_downSampleAny;
+        break;
+    }
+}
+
+/* Pick the filter of the quality, or the nearest one which can handle the format */
+static int s_setupResampler(Mix_AudioStream *stream, int quality)
+{
+    double cutoff;
+
+    if (stream->coeffs) {
+        SDL_free(stream->coeffs);
+        stream->coeffs = NULL;
+    }
+    stream->work_frames = 0;
+    stream->out_format = stream->src_format;
+    stream->out_sample_size = stream->sample_size;
+    stream->local_buffer_len_src = 0; /* Size of the output frame may change */
+
+    if (!stream->resampler_needed) {
+        stream->quality = quality;
+        return 0;
+    }
+
+    if (quality == MIX_RESAMPLER_LINEAR && stream->src_format == AUDIO_S16SYS &&
+        stream->src_channels <= LINEAR_MAX_CHANNELS) {
+        stream->filter = s_linearS16;
+        stream->pos_fixed = (Uint64)1 << 32;
+        SDL_memset(stream->last_frame, 0, sizeof(stream->last_frame));
+    } else if (quality != MIX_RESAMPLER_NEAREST && s_floatFormatSupported(stream->src_format)) {
+        if (quality == MIX_RESAMPLER_SINC) {
+            cutoff = stream->ratio < 1.0 ? stream->ratio * SINC_CUTOFF : SINC_CUTOFF;
+            stream->coeffs = s_makeSincTable(cutoff);
+            if (!stream->coeffs) {
+                return -1;
+            }
+            stream->taps = SINC_TAPS;
+        } else {
+            stream->taps = 2;
+        }
+        /* Silence before the first frame, so it's at the middle of the taps */
+        if (!s_growWork(stream, stream->taps)) {
+            return -1;
+        }
+        s_appendFloat(stream, NULL, stream->taps / 2 - 1, stream->sample_size);
+        stream->pos_fixed = (Uint64)(stream->taps / 2 - 1) << 32;
+        stream->filter = s_resampleFloat;
+        stream->out_format = AUDIO_F32SYS;
+        stream->out_sample_size = sizeof(float);
+    } else {
+        quality = MIX_RESAMPLER_NEAREST;
+        s_setupNearest(stream);
+    }
+
+    stream->quality = quality;
+    return 0;
+}
+
+/* Recreate the stream which converts the resampler output into the destination format */
+static int s_setupStream(Mix_AudioStream *stream)
+{
+    if (stream->stream) {
+        SDL_FreeAudioStream(stream->stream);
+    }
+
+    stream->stream = SDL_NewAudioStream(stream->out_format, stream->src_channels, stream->dst_rate,
+                                        stream->dst_format, stream->dst_channels, stream->dst_rate);
+
+    return stream->stream ? 0 : -1;
+}
+
+void Mix_AudioStreamSetDefaultQuality(int quality)
+{
+    s_default_quality = quality;
+}
+
+int Mix_AudioStreamGetDefaultQuality(void)
+{
+    return s_default_quality;
+}
+
+int Mix_AudioStreamSetQuality(Mix_AudioStream *stream, int quality)
+{
+    if (quality == stream->quality) {
+        return 0;
+    }
+
+    if (s_setupResampler(stream, quality) < 0 || s_setupStream(stream) < 0) {
+        return -1;
+    }
+
+    return 0;
+}
+
+int Mix_AudioStreamGetQuality(Mix_AudioStream *stream)
+{
+    return stream->quality;
+}
+
+
 Mix_AudioStream *Mix_NewAudioStream(const SDL_AudioFormat src_format,
                                     const Uint8 src_channels,
                                     const int src_rate,
@@ -188,44 +629,27 @@ Mix_AudioStream *Mix_NewAudioStream(const SDL_AudioFormat src_format,
 {
     Mix_AudioStream *stream = SDL_calloc(1, sizeof(Mix_AudioStream));
 
+    if (!stream) {
+        SDL_OutOfMemory();
+        return NULL;
+    }
+
+    stream->src_channels = src_channels;
+    stream->src_format = src_format;
+    stream->src_rate = src_rate;
+    stream->dst_rate = dst_rate;
+    stream->dst_format = dst_format;
+    stream->dst_channels = dst_channels;
+    stream->sample_size = SDL_AUDIO_BITSIZE(stream->src_format) / 8;
+
     if (src_rate != dst_rate) {
-        stream->src_channels = src_channels;
-        stream->src_format = src_format;
-        stream->src_rate = src_rate;
-        stream->dst_rate = dst_rate;
         stream->ratio = (double)dst_rate / (double)src_rate;
-        stream->resample_pos = src_rate < dst_rate ? 0.0 : 1.0;
         stream->resample_offset   = src_rate < dst_rate ? 1.0 / stream->ratio : stream->ratio;
+        stream->step_fixed = ((Uint64)src_rate << 32) / (Uint64)dst_rate;
         stream->resampler_needed = SDL_TRUE;
-        stream->sample_size = SDL_AUDIO_BITSIZE(stream->src_format) / 8;
-
-        switch(stream->sample_size * stream->src_channels)
-        {
-        case 1:
-            stream->filter = src_rate < dst_rate ? s_upSample1byte : s_downSample1byte;
-            break;
-
-        case 2:
-            stream->filter = src_rate < dst_rate ? s_upSample2byte : s_downSample2byte;
-            break;
-
-        case 4:
-            stream->filter = src_rate < dst_rate ? s_upSample4byte : s_downSample4byte;
-            break;
-
-        case 8:
-            stream->filter = src_rate < dst_rate ? s_upSample8byte : s_downSample8byte;
-            break;
-
-        default:
-            stream->filter = src_rate < dst_rate ? s_upSampleAny : s_downSampleAny;
-            break;
-        }
     }
 
-    stream->stream = SDL_NewAudioStream(src_format, src_channels, dst_rate,
-                                        dst_format, dst_channels, dst_rate);
-    if (!stream->stream) {
+    if (s_setupResampler(stream, s_default_quality) < 0 || s_setupStream(stream) < 0) {
         Mix_FreeAudioStream(stream);
         return NULL;
     }
@@ -265,12 +689,41 @@ int Mix_AudioStreamAvailable(Mix_AudioStream *stream)
 
 int Mix_AudioStreamFlush(Mix_AudioStream *stream)
 {
+    int len;
+
+    /* Push the frames still held by the filter taps out with silence */
+    if (stream->resampler_needed && stream->filter == s_resampleFloat) {
+        len = (int)((stream->taps / 2) * stream->src_channels * stream->sample_size);
+        if (!stream->local_buffer || stream->local_buffer_len_src < len) {
+            if (!s_reallocBuffer(stream, len)) {
+                return -1;
+            }
+        }
+
+        s_resampleFloat(stream, NULL, len, stream->sample_size);
+        if (SDL_AudioStreamPut(stream->stream, stream->local_buffer, (int)stream->local_buffer_stored) < 0) {
+            return -1;
+        }
+    }
+
     return SDL_AudioStreamFlush(stream->stream);
 }
 
 void Mix_AudioStreamClear(Mix_AudioStream *stream)
 {
-    SDL_memset(stream->local_buffer, 0, stream->local_buffer_len);
+    if (stream->local_buffer) {
+        SDL_memset(stream->local_buffer, 0, stream->local_buffer_len);
+    }
+
+    if (stream->resampler_needed && stream->filter == s_resampleFloat) {
+        stream->work_frames = 0;
+        s_appendFloat(stream, NULL, stream->taps / 2 - 1, stream->sample_size);
+        stream->pos_fixed = (Uint64)(stream->taps / 2 - 1) << 32;
+    } else if (stream->resampler_needed && stream->filter == s_linearS16) {
+        SDL_memset(stream->last_frame, 0, sizeof(stream->last_frame));
+        stream->pos_fixed = (Uint64)1 << 32;
+    }
+
     SDL_AudioStreamClear(stream->stream);
 }
 
@@ -280,6 +733,14 @@ void Mix_FreeAudioStream(Mix_AudioStream *stream)
         SDL_free(stream->local_buffer);
     }
 
+    if (stream->work) {
+        SDL_free(stream->work);
+    }
+
+    if (stream->coeffs) {
+        SDL_free(stream->coeffs);
+    }
+
     if (stream->stream) {
         SDL_FreeAudioStream(stream->stream);
     }
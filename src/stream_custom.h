@@ -26,7 +26,9 @@
 
 /*
     This is a wrapper over the SDL AudioStream that provides the
-    custom and extremely simple resampler for the very low end hardware
+    custom and extremely simple resampler for the very low end hardware.
+    Besides the nearest-neighbour one, it has the fixed-point linear and
+    the windowed-sinc resamplers, see the Mix_ResamplerQuality.
  */
 
 #ifndef SDL_audio_h_
@@ -50,6 +52,14 @@ int Mix_AudioStreamFlush(Mix_AudioStream *stream);
 void Mix_AudioStreamClear(Mix_AudioStream *stream);
 void Mix_FreeAudioStream(Mix_AudioStream *stream);
 
+/* Quality of streams created since now, one of Mix_ResamplerQuality */
+void Mix_AudioStreamSetDefaultQuality(int quality);
+int Mix_AudioStreamGetDefaultQuality(void);
+
+/* Switch the resampler of the stream, data which is still in the stream gets dropped */
+int Mix_AudioStreamSetQuality(Mix_AudioStream *stream, int quality);
+int Mix_AudioStreamGetQuality(Mix_AudioStream *stream);
+
 #ifndef STREAM_CUSTOM_INTERNAL
 #define SDL_NewAudioStream          Mix_NewAudioStream
 #define SDL_AudioStreamPut          Mix_AudioStreamPut
@@ -0,0 +1,825 @@
+/*
+  Throughput benchmarks of the mixer, effects, resamplers and decoders.
+
+  The mixer is driven offline: it's initialized by Mix_InitMixer() without
+  an audio device, and the mixing callback is called directly. Every case
+  runs for the given time, and is reported in frames per second (calls per
+  second for the music type detection) as JSON.
+
+  Usage: mix_benchmark [--time seconds] [--output file.json] [--filter text] [music files...]
+*/
+
+#include "SDL.h"
+#include "SDL_mixer.h"
+#include "music.h"
+
+#ifdef USE_CUSTOM_AUDIO_STREAM
+#define STREAM_CUSTOM_INTERNAL
+#include "stream_custom.h"
+#endif
+
+#include <stdio.h>
+
+#define BENCH_FREQ          44100
+#define BENCH_CHANNELS      2
+#define BENCH_FRAMES        1024
+#define BENCH_WAV_SECONDS   4
+#define BENCH_MAX_SAMPLES   64
+#define BENCH_BUNDLED_MP3   "../mp3tags/data/id3v23tagwithchapters.mp3"
+
+typedef struct BenchSample
+{
+    char name[128];
+    Uint8 *data;
+    size_t size;
+} BenchSample;
+
+static double bench_time = 0.5;
+static const char *bench_filter = NULL;
+static FILE *bench_out = NULL;
+static int bench_results = 0;
+
+static BenchSample samples[BENCH_MAX_SAMPLES];
+static int samples_count = 0;
+
+
+/* ============================ Reporting ============================ */
+
+static double bench_now(void)
+{
+    return (double)SDL_GetPerformanceCounter() / (double)SDL_GetPerformanceFrequency();
+}
+
+static SDL_bool bench_wanted(const char *group, const char *name)
+{
+    char full[256];
+
+    if (!bench_filter) {
+        return SDL_TRUE;
+    }
+
+    SDL_snprintf(full, sizeof(full), "%s/%s", group, name);
+    return SDL_strstr(full, bench_filter) != NULL;
+}
+
+static void json_string(const char *str)
+{
+    fputc('"', bench_out);
+    for (; *str; ++str) {
+        if (*str == '"' || *str == '\\') {
+            fprintf(bench_out, "\\%c", *str);
+        } else if ((unsigned char)*str < 0x20) {
+            fprintf(bench_out, "\\u%04x", (unsigned char)*str);
+        } else {
+            fputc(*str, bench_out);
+        }
+    }
+    fputc('"', bench_out);
+}
+
+/* Report one case, the second value is skipped if 'key2' is NULL */
+static void bench_report(const char *group, const char *name,
+                         const char *key, double value,
+                         const char *key2, double value2)
+{
+    fprintf(bench_out, "%s\n    {\"group\": ", bench_results++ ? "," : "");
+    json_string(group);
+    fprintf(bench_out, ", \"name\": ");
+    json_string(name);
+    fprintf(bench_out, ", \"%s\": %.1f", key, value);
+    if (key2) {
+        fprintf(bench_out, ", \"%s\": %.1f", key2, value2);
+    }
+    fprintf(bench_out, "}");
+    fflush(bench_out);
+
+    if (bench_out != stdout) {
+        SDL_Log("%-10s %-48s %14.1f %s", group, name, value, key);
+    }
+}
+
+static void bench_report_frames(const char *group, const char *name, double frames_per_sec,
+                                const char *key2, double value2)
+{
+    bench_report(group, name, "frames_per_sec", frames_per_sec, key2, value2);
+}
+
+
+/* ============================ Samples ============================ */
+
+static void put_le32(Uint8 *dst, Uint32 value)
+{
+    dst[0] = (Uint8)(value & 0xFF);
+    dst[1] = (Uint8)((value >> 8) & 0xFF);
+    dst[2] = (Uint8)((value >> 16) & 0xFF);
+    dst[3] = (Uint8)((value >> 24) & 0xFF);
+}
+
+static void put_le16(Uint8 *dst, Uint16 value)
+{
+    dst[0] = (Uint8)(value & 0xFF);
+    dst[1] = (Uint8)((value >> 8) & 0xFF);
+}
+
+static BenchSample *add_sample(const char *name, Uint8 *data, size_t size)
+{
+    BenchSample *s;
+
+    if (!data || samples_count >= BENCH_MAX_SAMPLES) {
+        SDL_free(data);
+        return NULL;
+    }
+
+    s = &samples[samples_count++];
+    SDL_strlcpy(s->name, name, sizeof(s->name));
+    s->data = data;
+    s->size = size;
+    return s;
+}
+
+/* A chord of sines, the format is 1 (PCM) or 3 (IEEE float) */
+static void make_wav(const char *name, int format, int bits, int channels, int freq)
+{
+    Uint32 frames = (Uint32)freq * BENCH_WAV_SECONDS;
+    Uint32 data_size = frames * (Uint32)channels * (Uint32)(bits / 8);
+    Uint8 *wav = (Uint8 *)SDL_malloc(44 + data_size), *out;
+    double v;
+    Uint32 i;
+    int c;
+
+    if (!wav) {
+        return;
+    }
+
+    SDL_memcpy(wav, "RIFF", 4);
+    put_le32(wav + 4, 36 + data_size);
+    SDL_memcpy(wav + 8, "WAVEfmt ", 8);
+    put_le32(wav + 16, 16);
+    put_le16(wav + 20, (Uint16)format);
+    put_le16(wav + 22, (Uint16)channels);
+    put_le32(wav + 24, (Uint32)freq);
+    put_le32(wav + 28, (Uint32)(freq * channels * (bits / 8)));
+    put_le16(wav + 32, (Uint16)(channels * (bits / 8)));
+    put_le16(wav + 34, (Uint16)bits);
+    SDL_memcpy(wav + 36, "data", 4);
+    put_le32(wav + 40, data_size);
+
+    out = wav + 44;
+    for (i = 0; i < frames; ++i) {
+        v = 0.3 * SDL_sin(2.0 * M_PI * 220.0 * i / freq) +
+            0.2 * SDL_sin(2.0 * M_PI * 277.2 * i / freq) +
+            0.2 * SDL_sin(2.0 * M_PI * 329.6 * i / freq);
+        for (c = 0; c < channels; ++c) {
+            if (format == 3) {
+                float f = (float)v;
+                Uint32 u;
+                SDL_memcpy(&u, &f, 4);
+                put_le32(out, u);
+                out += 4;
+            } else if (bits == 8) {
+                *out++ = (Uint8)(128 + (int)(v * 127.0));
+            } else {
+                put_le16(out, (Uint16)(Sint16)(v * 32767.0));
+                out += 2;
+            }
+        }
+    }
+
+    add_sample(name, wav, 44 + data_size);
+}
+
+static Uint8 *midi_varlen(Uint8 *out, Uint32 value)
+{
+    Uint8 bytes[4];
+    int n = 0;
+
+    do {
+        bytes[n++] = (Uint8)(value & 0x7F);
+        value >>= 7;
+    } while (value);
+
+    while (n--) {
+        *out++ = (Uint8)(bytes[n] | (n ? 0x80 : 0));
+    }
+
+    return out;
+}
+
+/* A type 0 MIDI file with chords, a bass line and drums at 120 BPM */
+static void make_midi(void)
+{
+    static const Uint8 chords[4][3] = {
+        { 60, 64, 67 }, { 57, 60, 64 }, { 53, 57, 60 }, { 55, 59, 62 }
+    };
+    Uint8 *mid = (Uint8 *)SDL_malloc(16384), *out, *track;
+    int bar, beat, n;
+
+    if (!mid) {
+        return;
+    }
+
+    SDL_memcpy(mid, "MThd\0\0\0\x06\0\0\0\x01\x01\xE0", 14); /* 480 ticks per quarter */
+    SDL_memcpy(mid + 14, "MTrk", 4);
+    track = out = mid + 22;
+
+    /* Strings, bass and the drum kit */
+    out = midi_varlen(out, 0); *out++ = 0xC0; *out++ = 48;
+    out = midi_varlen(out, 0); *out++ = 0xC1; *out++ = 33;
+
+    for (bar = 0; bar < 16; ++bar) {
+        const Uint8 *chord = chords[bar % 4];
+        for (n = 0; n < 3; ++n) {
+            out = midi_varlen(out, 0); *out++ = 0x90; *out++ = chord[n]; *out++ = 90;
+        }
+        for (beat = 0; beat < 4; ++beat) {
+            out = midi_varlen(out, 0); *out++ = 0x91; *out++ = (Uint8)(chord[0] - 24); *out++ = 100;
+            out = midi_varlen(out, 0); *out++ = 0x99; *out++ = (Uint8)(beat % 2 ? 38 : 36); *out++ = 110;
+            out = midi_varlen(out, 0); *out++ = 0x99; *out++ = 42; *out++ = 80;
+            out = midi_varlen(out, 240); *out++ = 0x99; *out++ = 42; *out++ = 70;
+            out = midi_varlen(out, 240); *out++ = 0x81; *out++ = (Uint8)(chord[0] - 24); *out++ = 0;
+        }
+        for (n = 0; n < 3; ++n) {
+            out = midi_varlen(out, 0); *out++ = 0x80; *out++ = chord[n]; *out++ = 0;
+        }
+    }
+
+    out = midi_varlen(out, 0); *out++ = 0xFF; *out++ = 0x2F; *out++ = 0x00;
+    /* The track length is big endian */
+    n = (int)(out - track);
+    mid[18] = (Uint8)((n >> 24) & 0xFF);
+    mid[19] = (Uint8)((n >> 16) & 0xFF);
+    mid[20] = (Uint8)((n >> 8) & 0xFF);
+    mid[21] = (Uint8)(n & 0xFF);
+
+    add_sample("generated.mid", mid, (size_t)(out - mid));
+}
+
+static void load_file_sample(const char *path)
+{
+    size_t size = 0;
+    void *data = SDL_LoadFile(path, &size);
+
+    if (!data) {
+        SDL_Log("Can't load %s: %s", path, SDL_GetError());
+        return;
+    }
+
+    add_sample(path, (Uint8 *)data, size);
+}
+
+static void free_samples(void)
+{
+    int i;
+
+    for (i = 0; i < samples_count; ++i) {
+        SDL_free(samples[i].data);
+    }
+    samples_count = 0;
+}
+
+
+/* ============================ Mixer ============================ */
+
+static int init_mixer(SDL_AudioSpec *spec, SDL_AudioFormat format, int channels, int freq)
+{
+    SDL_zerop(spec);
+    spec->freq = freq;
+    spec->format = format;
+    spec->channels = (Uint8)channels;
+    spec->samples = BENCH_FRAMES;
+    spec->silence = (format == AUDIO_U8 || format == AUDIO_U16LSB || format == AUDIO_U16MSB) ? 0x80 : 0;
+    spec->size = (Uint32)(SDL_AUDIO_BITSIZE(format) / 8) * spec->channels * spec->samples;
+
+    return Mix_InitMixer(spec, SDL_TRUE);
+}
+
+/* Random bytes of one second in the mixer format, played as a raw chunk */
+static Mix_Chunk *make_noise_chunk(const SDL_AudioSpec *spec, Uint8 **data)
+{
+    Uint32 len = (Uint32)spec->freq * (spec->size / spec->samples);
+    Uint32 i, seed = 12345;
+    Mix_Chunk *chunk;
+
+    *data = (Uint8 *)SDL_malloc(len);
+    if (!*data) {
+        return NULL;
+    }
+
+    for (i = 0; i < len; ++i) {
+        seed = seed * 1103515245 + 12345;
+        (*data)[i] = (Uint8)(seed >> 16);
+    }
+
+    /* Keep float samples in a sane range */
+    if (SDL_AUDIO_ISFLOAT(spec->format)) {
+        float *f = (float *)*data;
+        for (i = 0; i < len / 4; ++i) {
+            f[i] = (float)((Sint32)(i * 2654435761u) >> 16) / 32768.0f;
+        }
+    }
+
+    chunk = Mix_QuickLoad_RAW(*data, len);
+    if (!chunk) {
+        SDL_free(*data);
+        *data = NULL;
+    }
+
+    return chunk;
+}
+
+/* Call the mixing callback for the time given, returns frames per second */
+static double run_mixer(const SDL_AudioSpec *spec, Uint8 *buf)
+{
+    Mix_CommonMixer_t mixer = Mix_GetGeneralMixer();
+    double start, elapsed;
+    Uint64 frames = 0;
+
+    mixer(NULL, buf, (int)spec->size); /* Warm up */
+
+    start = bench_now();
+    do {
+        SDL_memset(buf, spec->silence, spec->size);
+        mixer(NULL, buf, (int)spec->size);
+        frames += spec->samples;
+        elapsed = bench_now() - start;
+    } while (elapsed < bench_time);
+
+    return (double)frames / elapsed;
+}
+
+static void bench_channels(void)
+{
+    static const int counts[] = { 1, 8, 32, 128 };
+    SDL_AudioSpec spec;
+    Mix_Chunk *chunk;
+    Uint8 *data, *buf;
+    char name[64];
+    size_t k;
+    int i, positional;
+
+    if (init_mixer(&spec, AUDIO_S16SYS, BENCH_CHANNELS, BENCH_FREQ) < 0) {
+        SDL_Log("Can't init the mixer: %s", Mix_GetError());
+        return;
+    }
+
+    chunk = make_noise_chunk(&spec, &data);
+    buf = (Uint8 *)SDL_malloc(spec.size);
+    Mix_AllocateChannels(counts[SDL_arraysize(counts) - 1]);
+
+    for (k = 0; chunk && buf && k < SDL_arraysize(counts); ++k) {
+        for (positional = 0; positional < 2; ++positional) {
+            SDL_snprintf(name, sizeof(name), "%dch_s16_stereo%s", counts[k], positional ? "_position" : "");
+            if (!bench_wanted("channels", name)) {
+                continue;
+            }
+
+            for (i = 0; i < counts[k]; ++i) {
+                Mix_PlayChannel(i, chunk, -1);
+                if (positional) {
+                    Mix_SetPosition(i, (Sint16)((i * 37) % 360), (Uint8)(i % 200));
+                }
+            }
+
+            bench_report_frames("channels", name, run_mixer(&spec, buf), NULL, 0.0);
+            Mix_HaltChannel(-1);
+        }
+    }
+
+    SDL_free(buf);
+    Mix_FreeChunk(chunk);
+    SDL_free(data);
+    Mix_FreeMixer();
+}
+
+static void bench_position_variant(SDL_AudioFormat format, const char *format_name, int channels, const char *suffix)
+{
+    SDL_AudioSpec spec;
+    Mix_PerfStats stats;
+    Mix_Chunk *chunk;
+    Uint8 *data, *buf;
+    double fps;
+    char name[64];
+
+    SDL_snprintf(name, sizeof(name), "%s_%dch%s", format_name, channels, suffix);
+    if (!bench_wanted("position", name)) {
+        return;
+    }
+
+    if (init_mixer(&spec, format, channels, BENCH_FREQ) < 0) {
+        SDL_Log("Can't init the mixer for %s: %s", name, Mix_GetError());
+        return;
+    }
+
+    chunk = make_noise_chunk(&spec, &data);
+    buf = (Uint8 *)SDL_malloc(spec.size);
+
+    if (chunk && buf) {
+        Mix_PlayChannel(0, chunk, -1);
+        Mix_SetPosition(0, 135, 100);
+        Mix_SetPerfStats(1);
+        Mix_ResetPerfStats();
+        fps = run_mixer(&spec, buf);
+        Mix_SetPerfStats(0);
+
+        /* The effect chain alone, as measured by the mixer itself */
+        if (Mix_GetChannelPerfStats(0, &stats) == 0 && stats.count > 0 && stats.avg_ms > 0.0) {
+            bench_report_frames("position", name, fps, "effect_frames_per_sec", spec.samples / (stats.avg_ms / 1000.0));
+        } else {
+            bench_report_frames("position", name, fps, NULL, 0.0);
+        }
+        Mix_HaltChannel(-1);
+    }
+
+    SDL_free(buf);
+    Mix_FreeChunk(chunk);
+    SDL_free(data);
+    Mix_FreeMixer();
+}
+
+static void bench_position(void)
+{
+    static const struct {
+        SDL_AudioFormat format;
+        const char *name;
+        SDL_bool simd;
+    } formats[] = {
+        { AUDIO_U8,     "u8",     SDL_FALSE },
+        { AUDIO_S8,     "s8",     SDL_FALSE },
+        { AUDIO_U16LSB, "u16lsb", SDL_FALSE },
+        { AUDIO_S16LSB, "s16lsb", SDL_TRUE },
+        { AUDIO_U16MSB, "u16msb", SDL_FALSE },
+        { AUDIO_S16MSB, "s16msb", SDL_FALSE },
+        { AUDIO_S32LSB, "s32lsb", SDL_TRUE },
+        { AUDIO_S32MSB, "s32msb", SDL_FALSE },
+        { AUDIO_F32SYS, "f32",    SDL_TRUE }
+    };
+    static const int channels[] = { 2, 4, 6 };
+    size_t f, c;
+
+    for (f = 0; f < SDL_arraysize(formats); ++f) {
+        for (c = 0; c < SDL_arraysize(channels); ++c) {
+            bench_position_variant(formats[f].format, formats[f].name, channels[c], "");
+        }
+    }
+
+    /* Scalar versions of the vectorized ones, the variable is read by Mix_InitMixer() */
+    SDL_setenv(MIX_EFFECTSDISABLESIMD, "1", 1);
+    for (f = 0; f < SDL_arraysize(formats); ++f) {
+        if (!formats[f].simd) {
+            continue;
+        }
+        for (c = 0; c < SDL_arraysize(channels); ++c) {
+            bench_position_variant(formats[f].format, formats[f].name, channels[c], "_scalar");
+        }
+    }
+}
+
+
+/* ============================ Resamplers ============================ */
+
+static const int resample_rates[][2] = {
+    { 44100, 48000 }, { 22050, 48000 }, { 48000, 44100 }, { 32000, 44100 }
+};
+
+#define RESAMPLE_CHUNK_FRAMES   4096
+
+static void bench_sdl_stream(int src_rate, int dst_rate, const Sint16 *in, Uint8 *out, int out_len)
+{
+    SDL_AudioStream *stream;
+    double start, elapsed;
+    Uint64 frames = 0;
+    char name[64];
+    int got;
+
+    SDL_snprintf(name, sizeof(name), "sdl_%d_%d", src_rate, dst_rate);
+    if (!bench_wanted("resampler", name)) {
+        return;
+    }
+
+    stream = SDL_NewAudioStream(AUDIO_S16SYS, BENCH_CHANNELS, src_rate, AUDIO_S16SYS, BENCH_CHANNELS, dst_rate);
+    if (!stream) {
+        return;
+    }
+
+    start = bench_now();
+    do {
+        SDL_AudioStreamPut(stream, in, RESAMPLE_CHUNK_FRAMES * BENCH_CHANNELS * 2);
+        while ((got = SDL_AudioStreamGet(stream, out, out_len)) > 0) {
+            frames += (Uint64)got / (BENCH_CHANNELS * 2);
+        }
+        elapsed = bench_now() - start;
+    } while (elapsed < bench_time);
+
+    bench_report_frames("resampler", name, (double)frames / elapsed, NULL, 0.0);
+    SDL_FreeAudioStream(stream);
+}
+
+#ifdef USE_CUSTOM_AUDIO_STREAM
+static void bench_custom_stream(int quality, int src_rate, int dst_rate, const Sint16 *in, Uint8 *out, int out_len)
+{
+    static const char *quality_names[] = { "nearest", "linear", "sinc" };
+    Mix_AudioStream *stream;
+    double start, elapsed;
+    Uint64 frames = 0;
+    char name[64];
+    int got;
+
+    SDL_snprintf(name, sizeof(name), "custom_%s_%d_%d", quality_names[quality], src_rate, dst_rate);
+    if (!bench_wanted("resampler", name)) {
+        return;
+    }
+
+    stream = Mix_NewAudioStream(AUDIO_S16SYS, BENCH_CHANNELS, src_rate, AUDIO_S16SYS, BENCH_CHANNELS, dst_rate);
+    if (!stream || Mix_AudioStreamSetQuality(stream, quality) < 0) {
+        if (stream) {
+            Mix_FreeAudioStream(stream);
+        }
+        return;
+    }
+
+    start = bench_now();
+    do {
+        Mix_AudioStreamPut(stream, in, RESAMPLE_CHUNK_FRAMES * BENCH_CHANNELS * 2);
+        while ((got = Mix_AudioStreamGet(stream, out, out_len)) > 0) {
+            frames += (Uint64)got / (BENCH_CHANNELS * 2);
+        }
+        elapsed = bench_now() - start;
+    } while (elapsed < bench_time);
+
+    bench_report_frames("resampler", name, (double)frames / elapsed, NULL, 0.0);
+    Mix_FreeAudioStream(stream);
+}
+#endif
+
+static void bench_resamplers(void)
+{
+    Sint16 *in = (Sint16 *)SDL_malloc(RESAMPLE_CHUNK_FRAMES * BENCH_CHANNELS * sizeof(Sint16));
+    int out_len = RESAMPLE_CHUNK_FRAMES * BENCH_CHANNELS * 2 * 4;
+    Uint8 *out = (Uint8 *)SDL_malloc((size_t)out_len);
+    size_t r;
+    int i;
+
+    if (!in || !out) {
+        SDL_free(in);
+        SDL_free(out);
+        return;
+    }
+
+    for (i = 0; i < RESAMPLE_CHUNK_FRAMES * BENCH_CHANNELS; ++i) {
+        in[i] = (Sint16)(10000.0 * SDL_sin(2.0 * M_PI * 440.0 * (i / BENCH_CHANNELS) / 44100.0));
+    }
+
+    for (r = 0; r < SDL_arraysize(resample_rates); ++r) {
+        bench_sdl_stream(resample_rates[r][0], resample_rates[r][1], in, out, out_len);
+#ifdef USE_CUSTOM_AUDIO_STREAM
+        bench_custom_stream(MIX_RESAMPLER_NEAREST, resample_rates[r][0], resample_rates[r][1], in, out, out_len);
+        bench_custom_stream(MIX_RESAMPLER_LINEAR, resample_rates[r][0], resample_rates[r][1], in, out, out_len);
+        bench_custom_stream(MIX_RESAMPLER_SINC, resample_rates[r][0], resample_rates[r][1], in, out, out_len);
+#endif
+    }
+
+    SDL_free(in);
+    SDL_free(out);
+}
+
+
+/* ============================ Codecs ============================ */
+
+static void bench_decoder(Mix_MusicInterface *interface, const BenchSample *sample, Uint8 *buf, int len, int frame_size)
+{
+    double start, elapsed;
+    Uint64 frames = 0;
+    void *music;
+    char name[192];
+    int left, stalls = 0;
+
+    SDL_snprintf(name, sizeof(name), "%s:%s", interface->tag, sample->name);
+    if (!bench_wanted("decode", name)) {
+        return;
+    }
+
+    music = interface->CreateFromRW(SDL_RWFromConstMem(sample->data, (int)sample->size), 1);
+    if (!music) {
+        SDL_Log("%s can't open %s: %s", interface->tag, sample->name, Mix_GetError());
+        return;
+    }
+
+    if (interface->SetVolume) {
+        interface->SetVolume(music, MIX_MAX_VOLUME);
+    }
+    if (interface->Play) {
+        interface->Play(music, -1);
+    }
+
+    start = bench_now();
+    do {
+        left = interface->GetAudio(music, buf, len);
+        if (left >= len || left < 0) {
+            /* Nothing got been decoded, restart unless it's stuck */
+            if (++stalls > 4 || !interface->Play) {
+                break;
+            }
+            interface->Play(music, -1);
+        } else {
+            stalls = 0;
+            frames += (Uint64)((len - left) / frame_size);
+        }
+        elapsed = bench_now() - start;
+    } while (elapsed < bench_time);
+
+    elapsed = bench_now() - start;
+    if (frames > 0) {
+        bench_report_frames("decode", name, (double)frames / elapsed, NULL, 0.0);
+    }
+
+    if (interface->Stop) {
+        interface->Stop(music);
+    }
+    interface->Delete(music);
+}
+
+static void bench_codecs(void)
+{
+    SDL_AudioSpec spec;
+    Mix_MusicInterface *interface;
+    Mix_MusicType type;
+    SDL_RWops *rw;
+    Uint8 *buf;
+    int s, i;
+
+    if (init_mixer(&spec, AUDIO_S16SYS, BENCH_CHANNELS, BENCH_FREQ) < 0) {
+        SDL_Log("Can't init the mixer: %s", Mix_GetError());
+        return;
+    }
+
+    buf = (Uint8 *)SDL_malloc(spec.size);
+
+    for (s = 0; buf && s < samples_count; ++s) {
+        rw = SDL_RWFromConstMem(samples[s].data, (int)samples[s].size);
+        type = rw ? detect_music_type(rw) : MUS_NONE;
+        if (rw) {
+            SDL_RWclose(rw);
+        }
+
+        if (type == MUS_NONE || !load_music_type(type) || !open_music_type_ex(type, MIDI_ANY)) {
+            SDL_Log("No decoders for %s", samples[s].name);
+            continue;
+        }
+
+        /* Every decoder of the type, not only the preferred one */
+        for (i = 0; i < get_num_music_interfaces(); ++i) {
+            interface = get_music_interface(i);
+            if (interface->type != type || !interface->opened ||
+                !interface->CreateFromRW || !interface->GetAudio) {
+                continue;
+            }
+            bench_decoder(interface, &samples[s], buf, (int)spec.size, (int)(spec.size / spec.samples));
+        }
+    }
+
+    SDL_free(buf);
+    Mix_FreeMixer();
+}
+
+/* Decoding of whole files into chunks by Mix_LoadWAV_RW() */
+static void bench_chunk_load(void)
+{
+    SDL_AudioSpec spec;
+    Mix_Chunk *chunk;
+    double start, elapsed;
+    Uint64 frames;
+    int s, frame_size;
+
+    if (init_mixer(&spec, AUDIO_S16SYS, BENCH_CHANNELS, BENCH_FREQ) < 0) {
+        SDL_Log("Can't init the mixer: %s", Mix_GetError());
+        return;
+    }
+
+    frame_size = (int)(spec.size / spec.samples);
+
+    for (s = 0; s < samples_count; ++s) {
+        if (!bench_wanted("chunk_load", samples[s].name)) {
+            continue;
+        }
+
+        frames = 0;
+        start = bench_now();
+        do {
+            chunk = Mix_LoadWAV_RW(SDL_RWFromConstMem(samples[s].data, (int)samples[s].size), 1);
+            if (!chunk) {
+                break;
+            }
+            frames += chunk->alen / (Uint32)frame_size;
+            Mix_FreeChunk(chunk);
+            elapsed = bench_now() - start;
+        } while (elapsed < bench_time);
+
+        elapsed = bench_now() - start;
+        if (frames > 0) {
+            bench_report_frames("chunk_load", samples[s].name, (double)frames / elapsed, NULL, 0.0);
+        } else {
+            SDL_Log("Can't load %s as a chunk: %s", samples[s].name, Mix_GetError());
+        }
+    }
+
+    Mix_FreeMixer();
+}
+
+static void bench_detect(void)
+{
+    SDL_AudioSpec spec;
+    SDL_RWops *rw;
+    double start, elapsed;
+    Uint64 calls;
+    int s;
+
+    if (init_mixer(&spec, AUDIO_S16SYS, BENCH_CHANNELS, BENCH_FREQ) < 0) {
+        return;
+    }
+
+    for (s = 0; s < samples_count; ++s) {
+        if (!bench_wanted("detect", samples[s].name)) {
+            continue;
+        }
+
+        rw = SDL_RWFromConstMem(samples[s].data, (int)samples[s].size);
+        if (!rw) {
+            continue;
+        }
+
+        calls = 0;
+        start = bench_now();
+        do {
+            SDL_RWseek(rw, 0, RW_SEEK_SET);
+            detect_music_type(rw);
+            ++calls;
+            elapsed = bench_now() - start;
+        } while (elapsed < bench_time);
+
+        bench_report("detect", samples[s].name, "calls_per_sec", (double)calls / elapsed, NULL, 0.0);
+        SDL_RWclose(rw);
+    }
+
+    Mix_FreeMixer();
+}
+
+
+int main(int argc, char *argv[])
+{
+    const SDL_version *ver = Mix_Linked_Version();
+    const char *output = NULL;
+    int i;
+
+    for (i = 1; i < argc; ++i) {
+        if (SDL_strcmp(argv[i], "--time") == 0 && i + 1 < argc) {
+            bench_time = SDL_atof(argv[++i]);
+        } else if (SDL_strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            output = argv[++i];
+        } else if (SDL_strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            bench_filter = argv[++i];
+        } else if (argv[i][0] == '-') {
+            fprintf(stderr, "Usage: %s [--time seconds] [--output file.json] [--filter text] [music files...]\n", argv[0]);
+            return 1;
+        } else {
+            load_file_sample(argv[i]);
+        }
+    }
+
+    if (bench_time <= 0.0) {
+        bench_time = 0.5;
+    }
+
+    bench_out = output ? fopen(output, "w") : stdout;
+    if (!bench_out) {
+        fprintf(stderr, "Can't open %s for writing\n", output);
+        return 1;
+    }
+
+    make_wav("generated_s16_44100_stereo.wav", 1, 16, 2, 44100);
+    make_wav("generated_u8_22050_mono.wav", 1, 8, 1, 22050);
+    make_wav("generated_f32_48000_stereo.wav", 3, 32, 2, 48000);
+    make_midi();
+    load_file_sample(BENCH_BUNDLED_MP3);
+
+    fprintf(bench_out, "{\n  \"version\": \"%d.%d.%d\",\n  \"platform\": ", ver->major, ver->minor, ver->patch);
+    json_string(SDL_GetPlatform());
+    fprintf(bench_out, ",\n  \"cpus\": %d,\n  \"bench_time\": %.3f,\n  \"results\": [", SDL_GetCPUCount(), bench_time);
+
+    bench_channels();
+    bench_resamplers();
+    bench_codecs();
+    bench_chunk_load();
+    bench_detect();
+    bench_position(); /* The last one, it switches SIMD off */
+
+    fprintf(bench_out, "\n  ]\n}\n");
+
+    if (bench_out != stdout) {
+        fclose(bench_out);
+    }
+
+    free_samples();
+    SDL_Quit();
+
+    return 0;
+}
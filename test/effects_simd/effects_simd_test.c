@@ -0,0 +1,157 @@
+#include "SDL_test.h"
+#include "SDL_mixer.h"
+
+#define TEST_FREQ       44100
+#define TEST_FRAMES     1021 /* Not a multiple of the vector size to cover the tail */
+#define TEST_CASES      6
+#define TEST_POSITIONS  5
+
+static const SDL_AudioFormat test_formats[TEST_CASES] = {
+    AUDIO_S16LSB, AUDIO_S16LSB, AUDIO_S32LSB, AUDIO_S32LSB, AUDIO_F32SYS, AUDIO_F32SYS
+};
+
+static const Uint8 test_channels[TEST_CASES] = {
+    2, 6, 2, 6, 2, 6
+};
+
+static const Sint16 test_angles[TEST_POSITIONS] = {
+    0, 45, 135, 180, 300
+};
+
+static const Uint8 test_distances[TEST_POSITIONS] = {
+    0, 30, 100, 200, 255
+};
+
+static void fill_noise(Uint8 *pcm, int len, SDL_AudioFormat format)
+{
+    int i;
+
+    if (format == AUDIO_F32SYS) {
+        float *out = (float *)pcm;
+        for (i = 0; i < len / 4; ++i) {
+            out[i] = (float)SDLTest_RandomIntegerInRange(-32768, 32767) / 32768.0f;
+        }
+    } else {
+        for (i = 0; i < len; ++i) {
+            pcm[i] = SDLTest_RandomUint8();
+        }
+    }
+}
+
+/* Renders one buffer of every position with the chunk at the full volume */
+static int render_positions(SDL_AudioSpec *spec, const Uint8 *pcm, Uint8 *out)
+{
+    Mix_CommonMixer_t mixer;
+    Mix_Chunk *chunk;
+    int i, len = (int)spec->size;
+
+    if (Mix_InitMixer(spec, SDL_TRUE) < 0) {
+        return -1;
+    }
+
+    chunk = Mix_QuickLoad_RAW((Uint8 *)pcm, (Uint32)len);
+    if (!chunk) {
+        Mix_FreeMixer();
+        return -1;
+    }
+
+    mixer = Mix_GetGeneralMixer();
+
+    for (i = 0; i < TEST_POSITIONS; ++i) {
+        Mix_PlayChannel(0, chunk, 0);
+        Mix_SetPosition(0, test_angles[i], test_distances[i]);
+        SDL_memset(out + len * i, spec->silence, (size_t)len);
+        mixer(NULL, out + len * i, len);
+        Mix_HaltChannel(0);
+    }
+
+    Mix_FreeChunk(chunk);
+    Mix_FreeMixer();
+
+    return 0;
+}
+
+static int effects_simd_match_scalar(void *arg)
+{
+    SDL_AudioSpec spec[TEST_CASES];
+    Uint8 *pcm[TEST_CASES], *vector_out[TEST_CASES], *scalar_out[TEST_CASES];
+    int i, len;
+    (void)arg;
+
+    for (i = 0; i < TEST_CASES; ++i) {
+        SDL_zero(spec[i]);
+        spec[i].freq = TEST_FREQ;
+        spec[i].format = test_formats[i];
+        spec[i].channels = test_channels[i];
+        spec[i].samples = TEST_FRAMES;
+        /* SDL_CalculateAudioSpec */
+        spec[i].size = (Uint32)(SDL_AUDIO_BITSIZE(spec[i].format) / 8) * spec[i].channels * spec[i].samples;
+
+        len = (int)spec[i].size;
+        pcm[i] = (Uint8 *)SDL_malloc((size_t)len);
+        vector_out[i] = (Uint8 *)SDL_malloc((size_t)len * TEST_POSITIONS);
+        scalar_out[i] = (Uint8 *)SDL_malloc((size_t)len * TEST_POSITIONS);
+        fill_noise(pcm[i], len, spec[i].format);
+
+        SDLTest_AssertCheck(render_positions(&spec[i], pcm[i], vector_out[i]) == 0,
+                            "Check that case %d got been rendered with default effects", i);
+    }
+
+    /* There is no way to unset the variable, so, the scalar pass goes last */
+    SDL_setenv(MIX_EFFECTSDISABLESIMD, "1", 1);
+
+    for (i = 0; i < TEST_CASES; ++i) {
+        len = (int)spec[i].size;
+        SDLTest_AssertCheck(render_positions(&spec[i], pcm[i], scalar_out[i]) == 0,
+                            "Check that case %d got been rendered with scalar effects", i);
+        SDLTest_AssertCheck(SDL_memcmp(vector_out[i], scalar_out[i], (size_t)len * TEST_POSITIONS) == 0,
+                            "Check that format 0x%04X with %d channels matches the scalar output",
+                            (unsigned)spec[i].format, (int)spec[i].channels);
+        SDL_free(pcm[i]);
+        SDL_free(vector_out[i]);
+        SDL_free(scalar_out[i]);
+    }
+
+    return TEST_COMPLETED;
+}
+
+static const SDLTest_TestCaseReference effectsTest1 =
+        { (SDLTest_TestCaseFp)effects_simd_match_scalar, "effects_simd_match_scalar", "Tests that vectorized positional effects are matching the scalar ones", TEST_ENABLED };
+
+static const SDLTest_TestCaseReference *effectsTests[] =  {
+    &effectsTest1,
+    NULL
+};
+
+SDLTest_TestSuiteReference effectsSimdTestSuite = {
+    "effects_simd",
+    NULL,
+    effectsTests,
+    NULL
+};
+
+/* All test suites */
+SDLTest_TestSuiteReference *testSuites[] =  {
+    &effectsSimdTestSuite,
+    NULL
+};
+
+/* Call this instead of exit(), so we can clean up SDL: atexit() is evil. */
+static void quit(int rc)
+{
+    exit(rc);
+}
+
+int
+main(int argc, char *argv[])
+{
+    int result;
+    (void)argc; (void)argv;
+
+    /* Call Harness */
+    result = SDLTest_RunSuites(testSuites, NULL, 0, NULL, 1);
+
+    /* Shutdown everything */
+    quit(result);
+    return(result);
+}
@@ -0,0 +1,160 @@
+#include "SDL_test.h"
+#include "SDL_mixer.h"
+
+#define TEST_FREQ       44100
+#define TEST_CHANNELS   2
+#define TEST_FRAMES     1024
+#define TEST_VOICES     64
+
+static SDL_malloc_func  real_malloc;
+static SDL_calloc_func  real_calloc;
+static SDL_realloc_func real_realloc;
+static SDL_free_func    real_free;
+
+static SDL_atomic_t count_allocs;
+static SDL_atomic_t num_allocs;
+
+static void *SDLCALL counting_malloc(size_t size)
+{
+    if (SDL_AtomicGet(&count_allocs)) {
+        SDL_AtomicAdd(&num_allocs, 1);
+    }
+    return real_malloc(size);
+}
+
+static void *SDLCALL counting_calloc(size_t nmemb, size_t size)
+{
+    if (SDL_AtomicGet(&count_allocs)) {
+        SDL_AtomicAdd(&num_allocs, 1);
+    }
+    return real_calloc(nmemb, size);
+}
+
+static void *SDLCALL counting_realloc(void *mem, size_t size)
+{
+    if (SDL_AtomicGet(&count_allocs)) {
+        SDL_AtomicAdd(&num_allocs, 1);
+    }
+    return real_realloc(mem, size);
+}
+
+static void SDLCALL counting_free(void *mem)
+{
+    if (SDL_AtomicGet(&count_allocs) && mem) {
+        SDL_AtomicAdd(&num_allocs, 1);
+    }
+    real_free(mem);
+}
+
+static void SDLCALL dummy_effect(int chan, void *stream, int len, void *udata)
+{
+    (void)chan;
+    (void)udata;
+    /* Touch the whole buffer to be sure it's writable */
+    SDL_memset(stream, 0, (size_t)len);
+}
+
+static int mix_effects_no_alloc(void *arg)
+{
+    SDL_AudioSpec spec;
+    Mix_CommonMixer_t mixer;
+    Mix_Chunk *chunk;
+    Uint8 *pcm, *stream;
+    int i, pass, stream_len;
+    (void)arg;
+
+    SDL_zero(spec);
+    spec.freq = TEST_FREQ;
+    spec.format = AUDIO_S16SYS;
+    spec.channels = TEST_CHANNELS;
+    spec.samples = TEST_FRAMES;
+    /* SDL_CalculateAudioSpec */
+    spec.size = (Uint32)(SDL_AUDIO_BITSIZE(spec.format) / 8) * spec.channels * spec.samples;
+
+    SDLTest_AssertCheck(Mix_InitMixer(&spec, SDL_TRUE) == 0, "Check that mixer got been initialized");
+    Mix_AllocateChannels(TEST_VOICES);
+
+    stream_len = (int)spec.size;
+    stream = (Uint8 *)SDL_malloc((size_t)stream_len);
+    /* The chunk is shorter than a buffer to cover the looping path too */
+    pcm = (Uint8 *)SDL_calloc(1, (size_t)stream_len / 3 * 2);
+    chunk = Mix_QuickLoad_RAW(pcm, (Uint32)stream_len / 3 * 2);
+    SDLTest_AssertCheck(chunk != NULL, "Check that chunk got been created");
+
+    for (i = 0; i < TEST_VOICES; ++i) {
+        Mix_PlayChannel(i, chunk, -1);
+        Mix_SetPanning(i, (Uint8)(i * 4), (Uint8)(255 - i * 4));
+        Mix_RegisterEffect(i, dummy_effect, NULL, NULL);
+    }
+
+    mixer = Mix_GetGeneralMixer();
+
+    SDL_AtomicSet(&num_allocs, 0);
+    SDL_AtomicSet(&count_allocs, 1);
+    for (pass = 0; pass < 16; ++pass) {
+        mixer(NULL, stream, stream_len);
+    }
+    /* Twice larger than the mixer's buffer, effects must be run by pieces */
+    SDL_AtomicSet(&count_allocs, 0);
+    SDL_free(stream);
+    stream = (Uint8 *)SDL_malloc((size_t)stream_len * 2);
+    SDL_AtomicSet(&count_allocs, 1);
+    mixer(NULL, stream, stream_len * 2);
+    SDL_AtomicSet(&count_allocs, 0);
+
+    SDLTest_AssertCheck(SDL_AtomicGet(&num_allocs) == 0,
+                        "Check that mixing did no heap calls (%d made)", SDL_AtomicGet(&num_allocs));
+
+    Mix_HaltChannel(-1);
+    Mix_FreeChunk(chunk);
+    SDL_free(pcm);
+    SDL_free(stream);
+    Mix_FreeMixer();
+
+    return TEST_COMPLETED;
+}
+
+static const SDLTest_TestCaseReference mixTest1 =
+        { (SDLTest_TestCaseFp)mix_effects_no_alloc, "mix_effects_no_alloc", "Tests that channel effects are mixed without heap calls", TEST_ENABLED };
+
+static const SDLTest_TestCaseReference *mixTests[] =  {
+    &mixTest1,
+    NULL
+};
+
+SDLTest_TestSuiteReference mixAllocTestSuite = {
+    "mix_alloc",
+    NULL,
+    mixTests,
+    NULL
+};
+
+/* All test suites */
+SDLTest_TestSuiteReference *testSuites[] =  {
+    &mixAllocTestSuite,
+    NULL
+};
+
+/* Call this instead of exit(), so we can clean up SDL: atexit() is evil. */
+static void quit(int rc)
+{
+    exit(rc);
+}
+
+int
+main(int argc, char *argv[])
+{
+    int result;
+    (void)argc; (void)argv;
+
+    /* Must be set before anything got been allocated */
+    SDL_GetMemoryFunctions(&real_malloc, &real_calloc, &real_realloc, &real_free);
+    SDL_SetMemoryFunctions(counting_malloc, counting_calloc, counting_realloc, counting_free);
+
+    /* Call Harness */
+    result = SDLTest_RunSuites(testSuites, NULL, 0, NULL, 1);
+
+    /* Shutdown everything */
+    quit(result);
+    return(result);
+}
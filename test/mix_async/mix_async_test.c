@@ -0,0 +1,183 @@
+#include "SDL_test.h"
+#include "SDL_mixer.h"
+
+#define TEST_FREQ       44100
+#define TEST_CHANNELS   2
+#define TEST_FRAMES     1024
+#define TEST_WAV_FRAMES 22050
+#define TEST_LOADS      16
+
+static Uint8 *wav_data;
+static Uint32 wav_size;
+
+static SDL_atomic_t callbacks_done;
+static SDL_atomic_t callbacks_failed;
+
+static void put_le32(Uint8 *dst, Uint32 value)
+{
+    dst[0] = (Uint8)(value & 0xFF);
+    dst[1] = (Uint8)((value >> 8) & 0xFF);
+    dst[2] = (Uint8)((value >> 16) & 0xFF);
+    dst[3] = (Uint8)((value >> 24) & 0xFF);
+}
+
+static void put_le16(Uint8 *dst, Uint16 value)
+{
+    dst[0] = (Uint8)(value & 0xFF);
+    dst[1] = (Uint8)((value >> 8) & 0xFF);
+}
+
+/* 16-bit stereo PCM WAV of the mixer format, so it's loaded without conversion */
+static void make_wav(void)
+{
+    Uint32 data_size = TEST_WAV_FRAMES * TEST_CHANNELS * 2;
+    Uint32 i;
+
+    wav_size = 44 + data_size;
+    wav_data = (Uint8 *)SDL_malloc(wav_size);
+
+    SDL_memcpy(wav_data, "RIFF", 4);
+    put_le32(wav_data + 4, wav_size - 8);
+    SDL_memcpy(wav_data + 8, "WAVEfmt ", 8);
+    put_le32(wav_data + 16, 16);
+    put_le16(wav_data + 20, 1);
+    put_le16(wav_data + 22, TEST_CHANNELS);
+    put_le32(wav_data + 24, TEST_FREQ);
+    put_le32(wav_data + 28, TEST_FREQ * TEST_CHANNELS * 2);
+    put_le16(wav_data + 32, TEST_CHANNELS * 2);
+    put_le16(wav_data + 34, 16);
+    SDL_memcpy(wav_data + 36, "data", 4);
+    put_le32(wav_data + 40, data_size);
+
+    for (i = 0; i < data_size / 2; ++i) {
+        put_le16(wav_data + 44 + i * 2, (Uint16)(i * 37));
+    }
+}
+
+static void SDLCALL load_finished(Mix_AsyncLoad *load, Mix_AsyncLoadStatus status, void *user_data)
+{
+    (void)load;
+    (void)user_data;
+    if (status == MIX_ASYNC_DONE) {
+        SDL_AtomicAdd(&callbacks_done, 1);
+    } else {
+        SDL_AtomicAdd(&callbacks_failed, 1);
+    }
+}
+
+static void SDLCALL finish_in_callback(Mix_AsyncLoad *load, Mix_AsyncLoadStatus status, void *user_data)
+{
+    Mix_Chunk **out = (Mix_Chunk **)user_data;
+    (void)status;
+    *out = Mix_FinishLoadWAVAsync(load);
+}
+
+static int mix_async_load(void *arg)
+{
+    SDL_AudioSpec spec;
+    Mix_AsyncLoad *loads[TEST_LOADS];
+    Mix_Chunk *sync_chunk, *chunk, *volatile cb_chunk = NULL;
+    Mix_AsyncLoad *load;
+    int i, matched = 0;
+    (void)arg;
+
+    SDL_zero(spec);
+    spec.freq = TEST_FREQ;
+    spec.format = AUDIO_S16LSB;
+    spec.channels = TEST_CHANNELS;
+    spec.samples = TEST_FRAMES;
+    /* SDL_CalculateAudioSpec */
+    spec.size = (Uint32)(SDL_AUDIO_BITSIZE(spec.format) / 8) * spec.channels * spec.samples;
+
+    SDLTest_AssertCheck(Mix_InitMixer(&spec, SDL_TRUE) == 0, "Check that mixer got been initialized");
+
+    make_wav();
+    sync_chunk = Mix_LoadWAV_RW(SDL_RWFromConstMem(wav_data, (int)wav_size), 1);
+    SDLTest_AssertCheck(sync_chunk != NULL, "Check that chunk got been loaded synchronously");
+
+    SDL_AtomicSet(&callbacks_done, 0);
+    SDL_AtomicSet(&callbacks_failed, 0);
+    for (i = 0; i < TEST_LOADS; ++i) {
+        loads[i] = Mix_LoadWAVAsync_RW(SDL_RWFromConstMem(wav_data, (int)wav_size), 1, load_finished, NULL);
+        SDLTest_AssertCheck(loads[i] != NULL, "Check that loading %d got been started", i);
+    }
+
+    for (i = 0; i < TEST_LOADS; ++i) {
+        chunk = Mix_FinishLoadWAVAsync(loads[i]);
+        if (chunk && sync_chunk && chunk->alen == sync_chunk->alen &&
+            SDL_memcmp(chunk->abuf, sync_chunk->abuf, chunk->alen) == 0) {
+            ++matched;
+        }
+        Mix_FreeChunk(chunk);
+    }
+
+    SDLTest_AssertCheck(matched == TEST_LOADS, "Check that all chunks are equal to the synchronously loaded (%d of %d)", matched, TEST_LOADS);
+    SDLTest_AssertCheck(SDL_AtomicGet(&callbacks_done) == TEST_LOADS, "Check that all callbacks got been called (%d)", SDL_AtomicGet(&callbacks_done));
+    SDLTest_AssertCheck(SDL_AtomicGet(&callbacks_failed) == 0, "Check that no loadings failed");
+
+    /* Garbage must fail, and the error must reach the caller */
+    load = Mix_LoadWAVAsync_RW(SDL_RWFromConstMem(wav_data + 44, 64), 1, NULL, NULL);
+    SDLTest_AssertCheck(Mix_FinishLoadWAVAsync(load) == NULL, "Check that garbage didn't get loaded");
+    SDLTest_AssertCheck(*Mix_GetError() != '\0', "Check that error got been reported: %s", Mix_GetError());
+
+    /* Take the result right inside the callback */
+    load = Mix_LoadWAVAsync_RW(SDL_RWFromConstMem(wav_data, (int)wav_size), 1, finish_in_callback, (void *)&cb_chunk);
+    SDLTest_AssertCheck(load != NULL, "Check that loading got been started");
+    for (i = 0; i < 500 && !cb_chunk; ++i) {
+        SDL_Delay(10);
+    }
+    SDLTest_AssertCheck(cb_chunk != NULL, "Check that chunk got been taken by the callback");
+    Mix_FreeChunk(cb_chunk);
+
+    /* Dropped loadings must not leak or crash */
+    for (i = 0; i < TEST_LOADS; ++i) {
+        Mix_CancelAsyncLoad(Mix_LoadWAVAsync_RW(SDL_RWFromConstMem(wav_data, (int)wav_size), 1, load_finished, NULL));
+    }
+
+    Mix_FreeChunk(sync_chunk);
+    Mix_FreeMixer();
+    SDL_free(wav_data);
+
+    return TEST_COMPLETED;
+}
+
+static const SDLTest_TestCaseReference mixTest1 =
+        { (SDLTest_TestCaseFp)mix_async_load, "mix_async_load", "Tests that chunks are loaded at background", TEST_ENABLED };
+
+static const SDLTest_TestCaseReference *mixTests[] =  {
+    &mixTest1,
+    NULL
+};
+
+SDLTest_TestSuiteReference mixAsyncTestSuite = {
+    "mix_async",
+    NULL,
+    mixTests,
+    NULL
+};
+
+/* All test suites */
+SDLTest_TestSuiteReference *testSuites[] =  {
+    &mixAsyncTestSuite,
+    NULL
+};
+
+/* Call this instead of exit(), so we can clean up SDL: atexit() is evil. */
+static void quit(int rc)
+{
+    exit(rc);
+}
+
+int
+main(int argc, char *argv[])
+{
+    int result;
+    (void)argc; (void)argv;
+
+    /* Call Harness */
+    result = SDLTest_RunSuites(testSuites, NULL, 0, NULL, 1);
+
+    /* Shutdown everything */
+    quit(result);
+    return(result);
+}
@@ -0,0 +1,122 @@
+#include "SDL_test.h"
+#include "SDL_mixer.h"
+
+#define TEST_FREQ       44100
+#define TEST_CHANNELS   2
+#define TEST_CHUNKSIZE  512
+#define TEST_SEGMENT    256
+#define TEST_LEVELS     4
+
+/* Every segment of the chunk holds one level, two channels play it at once */
+static const Sint16 test_levels[TEST_LEVELS] = { 4000, 20000, 30000, -30000 };
+
+#define TEST_FRAMES     (TEST_SEGMENT * TEST_LEVELS)
+
+static void render_levels(Mix_Chunk *chunk, Sint16 *rendered, Sint16 *out)
+{
+    int i;
+
+    Mix_PlayChannel(0, chunk, 0);
+    Mix_PlayChannel(1, chunk, 0);
+    Mix_RenderFrames(rendered, TEST_FRAMES);
+
+    /* Take a sample from the middle of every segment */
+    for (i = 0; i < TEST_LEVELS; ++i) {
+        out[i] = rendered[(i * TEST_SEGMENT + TEST_SEGMENT / 2) * TEST_CHANNELS];
+    }
+}
+
+static int mix_bus_clipping(void *arg)
+{
+    Sint16 *samples, *rendered;
+    Sint16 integer[TEST_LEVELS], bus[TEST_LEVELS];
+    Mix_Chunk *chunk;
+    int i, total = TEST_FRAMES * TEST_CHANNELS;
+    int knee = (int)(0.9f * 32767.0f);
+    (void)arg;
+
+    samples = (Sint16 *)SDL_malloc(total * sizeof(Sint16));
+    rendered = (Sint16 *)SDL_malloc(total * sizeof(Sint16));
+    for (i = 0; i < total; ++i) {
+        samples[i] = test_levels[i / (TEST_SEGMENT * TEST_CHANNELS)];
+    }
+
+    SDLTest_AssertCheck(Mix_OpenAudioOffline(TEST_FREQ, AUDIO_S16SYS, TEST_CHANNELS, TEST_CHUNKSIZE) == 0,
+                        "Check that mixer got been opened offline: %s", Mix_GetError());
+    chunk = Mix_QuickLoad_RAW((Uint8 *)samples, (Uint32)(total * sizeof(Sint16)));
+    SDLTest_AssertCheck(chunk != NULL, "Check that chunk got been loaded");
+
+    SDLTest_AssertCheck(Mix_SetFloatMixBus(-1) == 0, "Check that float bus is disabled by default");
+    render_levels(chunk, rendered, integer);
+
+    SDLTest_AssertCheck(Mix_SetFloatMixBus(1) == 0, "Check that float bus got been enabled: %s", Mix_GetError());
+    SDLTest_AssertCheck(Mix_SetFloatMixBus(-1) == 1, "Check that float bus is enabled");
+    render_levels(chunk, rendered, bus);
+
+    /* Below the knee both paths give the plain sum */
+    SDLTest_AssertCheck(integer[0] == 8000, "Check the integer sum: %d", integer[0]);
+    SDLTest_AssertCheck(SDL_abs(bus[0] - integer[0]) <= 1, "Check that float sum matches the integer one: %d", bus[0]);
+
+    /* Above the full scale the integer path clips hard, different levels become equal */
+    SDLTest_AssertCheck(integer[1] == 32767 && integer[2] == 32767, "Check the integer clipping: %d, %d", integer[1], integer[2]);
+    SDLTest_AssertCheck(integer[3] == -32768, "Check the negative integer clipping: %d", integer[3]);
+
+    /* The float bus saturates between the knee and the full scale and keeps the levels apart */
+    SDLTest_AssertCheck(bus[1] > knee && bus[1] < 32767, "Check the float saturation: %d", bus[1]);
+    SDLTest_AssertCheck(bus[2] > bus[1] && bus[2] < 32767, "Check that louder level stays louder: %d", bus[2]);
+    SDLTest_AssertCheck(bus[3] == -bus[2], "Check that saturation is symmetric: %d", bus[3]);
+
+    SDLTest_AssertCheck(Mix_SetFloatMixBus(0) == 1, "Check that float bus got been disabled");
+    render_levels(chunk, rendered, bus);
+    SDLTest_AssertCheck(SDL_memcmp(bus, integer, sizeof(integer)) == 0, "Check that integer path got been restored");
+
+    Mix_HaltChannel(-1);
+    Mix_FreeChunk(chunk);
+    Mix_CloseAudio();
+
+    SDL_free(rendered);
+    SDL_free(samples);
+
+    return TEST_COMPLETED;
+}
+
+static const SDLTest_TestCaseReference mixTest1 =
+        { (SDLTest_TestCaseFp)mix_bus_clipping, "mix_bus_clipping", "Tests the float bus saturation against the integer clipping", TEST_ENABLED };
+
+static const SDLTest_TestCaseReference *mixTests[] =  {
+    &mixTest1,
+    NULL
+};
+
+SDLTest_TestSuiteReference mixBusTestSuite = {
+    "mix_bus",
+    NULL,
+    mixTests,
+    NULL
+};
+
+/* All test suites */
+SDLTest_TestSuiteReference *testSuites[] =  {
+    &mixBusTestSuite,
+    NULL
+};
+
+/* Call this instead of exit(), so we can clean up SDL: atexit() is evil. */
+static void quit(int rc)
+{
+    exit(rc);
+}
+
+int
+main(int argc, char *argv[])
+{
+    int result;
+    (void)argc; (void)argv;
+
+    /* Call Harness */
+    result = SDLTest_RunSuites(testSuites, NULL, 0, NULL, 1);
+
+    /* Shutdown everything */
+    quit(result);
+    return(result);
+}
@@ -0,0 +1,181 @@
+#include "SDL_test.h"
+#include "SDL_mixer.h"
+#include "mix_chunk_pool.h"
+
+#define TEST_FREQ       44100
+#define TEST_CHANNELS   2
+#define TEST_CHUNKSIZE  512
+#define TEST_FRAMES     4410
+#define TEST_SOUNDS     3
+
+#define TEST_PCM_BYTES  (TEST_FRAMES * TEST_CHANNELS * 2)
+#define TEST_WAV_BYTES  (44 + TEST_PCM_BYTES)
+
+static Uint8 wavs[TEST_SOUNDS][TEST_WAV_BYTES];
+static Sint16 expected[TEST_SOUNDS][TEST_FRAMES * TEST_CHANNELS];
+static Sint16 rendered[TEST_FRAMES * TEST_CHANNELS];
+
+static Uint8 *write_le(Uint8 *p, Uint32 value, int bytes)
+{
+    int i;
+    for (i = 0; i < bytes; ++i) {
+        *p++ = (Uint8)(value >> (i * 8));
+    }
+    return p;
+}
+
+/* A WAV file of noise, every sound is different */
+static void make_wav(Uint8 *wav, Uint32 seed)
+{
+    Uint8 *p = wav;
+    int i;
+
+    SDL_memcpy(p, "RIFF", 4);
+    p = write_le(p + 4, TEST_WAV_BYTES - 8, 4);
+    SDL_memcpy(p, "WAVEfmt ", 8);
+    p = write_le(p + 8, 16, 4);
+    p = write_le(p, 1, 2); /* PCM */
+    p = write_le(p, TEST_CHANNELS, 2);
+    p = write_le(p, TEST_FREQ, 4);
+    p = write_le(p, TEST_FREQ * TEST_CHANNELS * 2, 4);
+    p = write_le(p, TEST_CHANNELS * 2, 2);
+    p = write_le(p, 16, 2);
+    SDL_memcpy(p, "data", 4);
+    p = write_le(p + 4, TEST_PCM_BYTES, 4);
+
+    for (i = 0; i < TEST_FRAMES * TEST_CHANNELS; ++i) {
+        seed = seed * 1103515245 + 12345;
+        p = write_le(p, (Uint32)((Sint32)(seed >> 16) % 16000), 2);
+    }
+}
+
+static void render_chunk(Mix_Chunk *chunk, Sint16 *out)
+{
+    Mix_PlayChannel(0, chunk, 0);
+    Mix_RenderFrames(out, TEST_FRAMES);
+}
+
+static int mix_chunk_pool_eviction(void *arg)
+{
+    Mix_Chunk *decoded, *chunks[TEST_SOUNDS];
+    int i;
+    (void)arg;
+
+    SDLTest_AssertCheck(Mix_OpenAudioOffline(TEST_FREQ, AUDIO_S16SYS, TEST_CHANNELS, TEST_CHUNKSIZE) == 0,
+                        "Check that mixer got been opened offline: %s", Mix_GetError());
+    Mix_AllocateChannels(1);
+
+    /* What the fully decoded chunks play */
+    for (i = 0; i < TEST_SOUNDS; ++i) {
+        make_wav(wavs[i], (Uint32)(i + 1) * 7919);
+        decoded = Mix_LoadWAV_RW(SDL_RWFromConstMem(wavs[i], TEST_WAV_BYTES), 1);
+        SDLTest_AssertCheck(decoded != NULL, "Check that chunk %d got been decoded: %s", i, Mix_GetError());
+        if (!decoded) {
+            Mix_CloseAudio();
+            return TEST_ABORTED;
+        }
+        render_chunk(decoded, expected[i]);
+        Mix_HaltChannel(-1);
+        Mix_FreeChunk(decoded);
+    }
+
+    for (i = 0; i < TEST_SOUNDS; ++i) {
+        chunks[i] = Mix_LoadWAVCompressed_RW(SDL_RWFromConstMem(wavs[i], TEST_WAV_BYTES), 1);
+        SDLTest_AssertCheck(chunks[i] != NULL, "Check that compressed chunk %d got been loaded: %s", i, Mix_GetError());
+        if (!chunks[i]) {
+            Mix_CloseAudio();
+            return TEST_ABORTED;
+        }
+        SDLTest_AssertCheck(chunks[i]->alen == TEST_PCM_BYTES, "Check the length of compressed chunk %d: %u", i, chunks[i]->alen);
+    }
+
+    /* Two decoded chunks fit the cache */
+    Mix_SetChunkCacheMemory(2 * TEST_PCM_BYTES);
+    SDLTest_AssertCheck(Mix_GetChunkCacheMemory() == 2 * TEST_PCM_BYTES, "Check the cache budget");
+
+    render_chunk(chunks[0], rendered);
+    SDLTest_AssertCheck(SDL_memcmp(rendered, expected[0], sizeof(rendered)) == 0, "Check that decoding chunk 0 plays it right");
+    SDLTest_AssertCheck(!_Mix_ChunkIsCached(chunks[0]), "Check that chunk 0 isn't cached while its voice lives");
+
+    /* The voice played through is freed by the next play, it's the cached copy now */
+    render_chunk(chunks[1], rendered);
+    SDLTest_AssertCheck(SDL_memcmp(rendered, expected[1], sizeof(rendered)) == 0, "Check that decoding chunk 1 plays it right");
+    SDLTest_AssertCheck(_Mix_ChunkIsCached(chunks[0]), "Check that chunk 0 got been cached");
+
+    /* The third one is over the budget, the least recently played goes */
+    render_chunk(chunks[2], rendered);
+    SDLTest_AssertCheck(SDL_memcmp(rendered, expected[2], sizeof(rendered)) == 0, "Check that decoding chunk 2 plays it right");
+    SDLTest_AssertCheck(!_Mix_ChunkIsCached(chunks[0]), "Check that chunk 0 got been evicted");
+    SDLTest_AssertCheck(_Mix_ChunkIsCached(chunks[1]), "Check that chunk 1 got been cached");
+
+    /* Evicted one gets decoded again, then chunk 1 is the oldest */
+    render_chunk(chunks[0], rendered);
+    SDLTest_AssertCheck(SDL_memcmp(rendered, expected[0], sizeof(rendered)) == 0, "Check that evicted chunk 0 plays it right");
+    SDLTest_AssertCheck(!_Mix_ChunkIsCached(chunks[1]), "Check that chunk 1 got been evicted");
+    SDLTest_AssertCheck(_Mix_ChunkIsCached(chunks[2]), "Check that chunk 2 got been cached");
+
+    /* The cached copy plays the same as the decoding */
+    render_chunk(chunks[2], rendered);
+    SDLTest_AssertCheck(SDL_memcmp(rendered, expected[2], sizeof(rendered)) == 0, "Check that cached chunk 2 plays it right");
+
+    /* Once the budget shrinks, the copies nobody plays are dropped */
+    Mix_SetChunkCacheMemory(TEST_PCM_BYTES - 1);
+    SDLTest_AssertCheck(!_Mix_ChunkIsCached(chunks[0]), "Check that chunk 0 got been evicted by the budget");
+    SDLTest_AssertCheck(_Mix_ChunkIsCached(chunks[2]), "Check that chunk 2 is kept while its voice lives");
+
+    /* Chunks bigger than the budget are never cached */
+    render_chunk(chunks[1], rendered);
+    render_chunk(chunks[0], rendered);
+    SDLTest_AssertCheck(!_Mix_ChunkIsCached(chunks[1]), "Check that chunk 1 doesn't fit the cache");
+    SDLTest_AssertCheck(SDL_memcmp(rendered, expected[0], sizeof(rendered)) == 0, "Check that uncached chunk 0 plays it right");
+
+    Mix_HaltChannel(-1);
+    for (i = 0; i < TEST_SOUNDS; ++i) {
+        Mix_FreeChunk(chunks[i]);
+    }
+    Mix_SetChunkCacheMemory(8 * 1024 * 1024);
+    Mix_CloseAudio();
+
+    return TEST_COMPLETED;
+}
+
+static const SDLTest_TestCaseReference mixTest1 =
+        { (SDLTest_TestCaseFp)mix_chunk_pool_eviction, "mix_chunk_pool_eviction", "Tests the cache of compressed chunks against the decoded ones", TEST_ENABLED };
+
+static const SDLTest_TestCaseReference *mixTests[] =  {
+    &mixTest1,
+    NULL
+};
+
+SDLTest_TestSuiteReference mixChunkPoolTestSuite = {
+    "mix_chunk_pool",
+    NULL,
+    mixTests,
+    NULL
+};
+
+/* All test suites */
+SDLTest_TestSuiteReference *testSuites[] =  {
+    &mixChunkPoolTestSuite,
+    NULL
+};
+
+/* Call this instead of exit(), so we can clean up SDL: atexit() is evil. */
+static void quit(int rc)
+{
+    exit(rc);
+}
+
+int
+main(int argc, char *argv[])
+{
+    int result;
+    (void)argc; (void)argv;
+
+    /* Call Harness */
+    result = SDLTest_RunSuites(testSuites, NULL, 0, NULL, 1);
+
+    /* Shutdown everything */
+    quit(result);
+    return(result);
+}
@@ -0,0 +1,185 @@
+#include "SDL_test.h"
+#include "SDL_mixer.h"
+
+#define TEST_FREQ       44100
+#define TEST_CHANNELS   2
+#define TEST_THREADS    4
+#define TEST_CALLS      5000
+
+static Sint16 samples[4096];
+
+static Mix_Chunk *replay_chunk;
+static SDL_atomic_t replay_done;
+static int replay_halted_playing = -1;
+
+/* The commands of the callback must apply in its order, and right away */
+static void SDLCALL replay_finished(int channel)
+{
+    if (channel != 0 || SDL_AtomicGet(&replay_done)) {
+        return;
+    }
+
+    Mix_HaltChannel(1);
+    replay_halted_playing = Mix_Playing(1);
+    Mix_HaltChannel(0);
+    Mix_PlayChannel(0, replay_chunk, -1);
+    SDL_AtomicSet(&replay_done, 1);
+}
+
+/* Every thread drives its own mixer channel */
+static int SDLCALL control_thread(void *data)
+{
+    int channel = (int)(size_t)data;
+    int i;
+
+    for (i = 0; i < TEST_CALLS; ++i) {
+        Mix_Pause(channel);
+        Mix_SetPanning(channel, (Uint8)(i & 0xFF), (Uint8)(255 - (i & 0xFF)));
+        Mix_SetPosition(channel, (Sint16)(i % 360), (Uint8)(i & 0x7F));
+        Mix_Resume(channel);
+    }
+
+    /* The last call wins */
+    if (channel & 1) {
+        Mix_Pause(channel);
+    }
+
+    return 0;
+}
+
+static int mix_command_queue(void *arg)
+{
+    SDL_Thread *threads[TEST_THREADS];
+    Mix_Chunk *chunk;
+    int i, paused;
+    (void)arg;
+
+    SDL_setenv("SDL_AUDIODRIVER", "dummy", 1);
+    SDLTest_AssertCheck(SDL_Init(SDL_INIT_AUDIO) == 0, "Check that audio got been initialized: %s", SDL_GetError());
+    SDLTest_AssertCheck(Mix_OpenAudio(TEST_FREQ, AUDIO_S16SYS, TEST_CHANNELS, 512) == 0,
+                        "Check that audio got been opened: %s", Mix_GetError());
+
+    chunk = Mix_QuickLoad_RAW((Uint8 *)samples, sizeof(samples));
+    SDLTest_AssertCheck(chunk != NULL, "Check that chunk got been loaded");
+    for (i = 0; i < TEST_THREADS; ++i) {
+        Mix_PlayChannel(i, chunk, -1);
+    }
+
+    for (i = 0; i < TEST_THREADS; ++i) {
+        threads[i] = SDL_CreateThread(control_thread, "control", (void *)(size_t)i);
+    }
+    for (i = 0; i < TEST_THREADS; ++i) {
+        SDL_WaitThread(threads[i], NULL);
+    }
+
+    for (i = 0; i < TEST_THREADS; ++i) {
+        paused = Mix_Paused(i);
+        SDLTest_AssertCheck(paused == (i & 1), "Check that channel %d got the last command (%d)", i, paused);
+    }
+
+    /* More commands than the queue holds while nothing runs it */
+    Mix_PauseAudio(1);
+    for (i = 0; i < TEST_CALLS; ++i) {
+        Mix_Resume(0);
+        Mix_Pause(0);
+    }
+    SDLTest_AssertCheck(Mix_Paused(0) == 1, "Check that overflowed commands kept the order");
+    Mix_PauseAudio(0);
+
+    /* Queries see the commands of the calling thread */
+    Mix_HaltChannel(-1);
+    SDLTest_AssertCheck(Mix_Playing(-1) == 0, "Check that all channels got been halted");
+
+    SDLTest_AssertCheck(Mix_SetPanning(TEST_CHANNELS * 1000, 0, 255) == 0, "Check that invalid channel is reported");
+
+    Mix_FreeChunk(chunk);
+    Mix_CloseAudio();
+    SDL_Quit();
+
+    return TEST_COMPLETED;
+}
+
+static int mix_command_callback(void *arg)
+{
+    Mix_Chunk *chunk;
+    int i;
+    (void)arg;
+
+    SDL_setenv("SDL_AUDIODRIVER", "dummy", 1);
+    SDLTest_AssertCheck(SDL_Init(SDL_INIT_AUDIO) == 0, "Check that audio got been initialized: %s", SDL_GetError());
+    SDLTest_AssertCheck(Mix_OpenAudio(TEST_FREQ, AUDIO_S16SYS, TEST_CHANNELS, 512) == 0,
+                        "Check that audio got been opened: %s", Mix_GetError());
+
+    chunk = Mix_QuickLoad_RAW((Uint8 *)samples, sizeof(samples));
+    SDLTest_AssertCheck(chunk != NULL, "Check that chunk got been loaded");
+    replay_chunk = chunk;
+    SDL_AtomicSet(&replay_done, 0);
+
+    Mix_ChannelFinished(replay_finished);
+    Mix_PlayChannel(1, chunk, -1);
+    Mix_PlayChannel(0, chunk, 0);
+
+    for (i = 0; i < 500 && !SDL_AtomicGet(&replay_done); ++i) {
+        SDL_Delay(10);
+    }
+    SDLTest_AssertCheck(SDL_AtomicGet(&replay_done) == 1, "Check that the channel got been finished");
+
+    /* Let a few more callbacks run any command left behind */
+    SDL_Delay(100);
+    SDLTest_AssertCheck(replay_halted_playing == 0, "Check that the halt got been seen inside of the callback (%d)", replay_halted_playing);
+    SDLTest_AssertCheck(Mix_Playing(0) == 1, "Check that the channel replayed from the callback still plays");
+    SDLTest_AssertCheck(Mix_Playing(1) == 0, "Check that the channel halted from the callback stays halted");
+
+    Mix_ChannelFinished(NULL);
+    Mix_HaltChannel(-1);
+    Mix_FreeChunk(chunk);
+    Mix_CloseAudio();
+    SDL_Quit();
+
+    return TEST_COMPLETED;
+}
+
+static const SDLTest_TestCaseReference mixTest1 =
+        { (SDLTest_TestCaseFp)mix_command_queue, "mix_command_queue", "Tests that control commands are applied in order", TEST_ENABLED };
+
+static const SDLTest_TestCaseReference mixTest2 =
+        { (SDLTest_TestCaseFp)mix_command_callback, "mix_command_callback", "Tests that commands from the callbacks keep their order", TEST_ENABLED };
+
+static const SDLTest_TestCaseReference *mixTests[] =  {
+    &mixTest1,
+    &mixTest2,
+    NULL
+};
+
+SDLTest_TestSuiteReference mixCommandTestSuite = {
+    "mix_command",
+    NULL,
+    mixTests,
+    NULL
+};
+
+/* All test suites */
+SDLTest_TestSuiteReference *testSuites[] =  {
+    &mixCommandTestSuite,
+    NULL
+};
+
+/* Call this instead of exit(), so we can clean up SDL: atexit() is evil. */
+static void quit(int rc)
+{
+    exit(rc);
+}
+
+int
+main(int argc, char *argv[])
+{
+    int result;
+    (void)argc; (void)argv;
+
+    /* Call Harness */
+    result = SDLTest_RunSuites(testSuites, NULL, 0, NULL, 1);
+
+    /* Shutdown everything */
+    quit(result);
+    return(result);
+}
@@ -0,0 +1,208 @@
+#include "SDL_test.h"
+#include "SDL_mixer.h"
+
+#define TEST_FREQ       44100
+#define TEST_CHANNELS   2
+#define TEST_CHUNKSIZE  512
+#define TEST_AHEAD_MS   200
+
+/* The QOA frame: 256 slices of 20 samples per channel */
+#define QOA_FRAME_SAMPLES   5120
+#define QOA_FRAME_BYTES     (8 + 16 * TEST_CHANNELS + 8 * 256 * TEST_CHANNELS)
+#define QOA_FRAMES          40
+#define QOA_FILE_BYTES      (8 + QOA_FRAME_BYTES * QOA_FRAMES)
+
+/* What is rendered: milliseconds, and the call made before them */
+enum {
+    STEP_PLAY,
+    STEP_SEEK,
+    STEP_PAUSE,
+    STEP_RESUME,
+    STEP_SPEED
+};
+
+typedef struct {
+    int call;
+    int ms;
+} TestStep;
+
+static const TestStep test_steps[] = {
+    { STEP_PLAY,   500 },
+    { STEP_SEEK,   300 },
+    { STEP_PAUSE,  100 },
+    { STEP_RESUME, 300 },
+    { STEP_SPEED,  500 }
+};
+
+#define TEST_STEPS  (int)(sizeof(test_steps) / sizeof(test_steps[0]))
+
+static Uint8 *write_be(Uint8 *p, Uint32 hi, Uint32 lo)
+{
+    int i;
+    for (i = 0; i < 4; ++i) {
+        *p++ = (Uint8)(hi >> (24 - i * 8));
+    }
+    for (i = 0; i < 4; ++i) {
+        *p++ = (Uint8)(lo >> (24 - i * 8));
+    }
+    return p;
+}
+
+/* A QOA file of noise, so no frame sounds like any other */
+static Uint8 *make_qoa(void)
+{
+    Uint8 *qoa = (Uint8 *)SDL_malloc(QOA_FILE_BYTES), *p = qoa;
+    Uint32 seed = 12345, lo, hi;
+    int f, c, s;
+
+    p = write_be(p, 0x716f6166 /* 'qoaf' */, QOA_FRAME_SAMPLES * QOA_FRAMES);
+    for (f = 0; f < QOA_FRAMES; ++f) {
+        p = write_be(p, ((Uint32)TEST_CHANNELS << 24) | TEST_FREQ,
+                     ((Uint32)QOA_FRAME_SAMPLES << 16) | QOA_FRAME_BYTES);
+        for (c = 0; c < TEST_CHANNELS; ++c) {
+            p = write_be(p, 0, 0); /* History */
+            p = write_be(p, 0, 1 << 13); /* Weights: the last sample is predicted */
+        }
+        for (s = 0; s < 256 * TEST_CHANNELS; ++s) {
+            seed = seed * 1103515245 + 12345;
+            hi = (seed & 0x0fffffff) | (((seed >> 28) & 3) << 28); /* Small scale factors */
+            seed = seed * 1103515245 + 12345;
+            lo = seed;
+            p = write_be(p, hi, lo);
+        }
+    }
+
+    return qoa;
+}
+
+static int render_steps(const Uint8 *qoa, int ahead_ms, Sint16 *rendered, double *positions)
+{
+    Mix_Music *music;
+    int i, frames, total = 0;
+
+    music = Mix_LoadMUS_RW(SDL_RWFromConstMem(qoa, QOA_FILE_BYTES), 1);
+    SDLTest_AssertCheck(music != NULL, "Check that music got been loaded: %s", Mix_GetError());
+    if (!music) {
+        return 0;
+    }
+
+    if (ahead_ms > 0) {
+        SDLTest_AssertCheck(Mix_SetMusicDecodeAhead(music, ahead_ms) == 0,
+                            "Check that decode-ahead got been enabled: %s", Mix_GetError());
+    }
+
+    for (i = 0; i < TEST_STEPS; ++i) {
+        switch (test_steps[i].call) {
+        case STEP_PLAY:
+            Mix_PlayMusic(music, 0);
+            break;
+        case STEP_SEEK:
+            Mix_SetMusicPosition(1.5);
+            break;
+        case STEP_PAUSE:
+            Mix_PauseMusic();
+            break;
+        case STEP_RESUME:
+            Mix_ResumeMusic();
+            break;
+        case STEP_SPEED:
+            Mix_SetMusicSpeed(music, 1.5);
+            break;
+        }
+
+        frames = TEST_FREQ * test_steps[i].ms / 1000;
+        Mix_RenderFrames(rendered + total * TEST_CHANNELS, frames);
+        total += frames;
+        positions[i] = Mix_GetMusicPosition(music);
+    }
+
+    Mix_HaltMusic();
+    Mix_FreeMusic(music);
+
+    return total;
+}
+
+static int mix_decode_ahead_match(void *arg)
+{
+    Uint8 *qoa;
+    Sint16 *direct, *ahead;
+    double direct_pos[TEST_STEPS], ahead_pos[TEST_STEPS];
+    int i, direct_frames, ahead_frames, total = 0;
+    (void)arg;
+
+    for (i = 0; i < TEST_STEPS; ++i) {
+        total += TEST_FREQ * test_steps[i].ms / 1000;
+    }
+
+    qoa = make_qoa();
+    direct = (Sint16 *)SDL_calloc(total * TEST_CHANNELS, sizeof(Sint16));
+    ahead = (Sint16 *)SDL_calloc(total * TEST_CHANNELS, sizeof(Sint16));
+
+    SDLTest_AssertCheck(Mix_OpenAudioOffline(TEST_FREQ, AUDIO_S16SYS, TEST_CHANNELS, TEST_CHUNKSIZE) == 0,
+                        "Check that mixer got been opened offline: %s", Mix_GetError());
+
+    direct_frames = render_steps(qoa, 0, direct, direct_pos);
+    ahead_frames = render_steps(qoa, TEST_AHEAD_MS, ahead, ahead_pos);
+    SDLTest_AssertCheck(direct_frames == total && ahead_frames == total,
+                        "Check that all frames got been rendered: %d, %d", direct_frames, ahead_frames);
+
+    /* Seeking, pausing and changing of the speed must neither skip nor repeat the decoded data */
+    SDLTest_AssertCheck(SDL_memcmp(direct, ahead, total * TEST_CHANNELS * sizeof(Sint16)) == 0,
+                        "Check that decoding ahead renders the same frames");
+
+    /* The position is of what is heard, not of what got decoded. Once resampled,
+       the decoder counts what waits in its stream too, so stop at the speed change */
+    for (i = 0; i < TEST_STEPS && test_steps[i].call != STEP_SPEED; ++i) {
+        SDLTest_AssertCheck(SDL_fabs(direct_pos[i] - ahead_pos[i]) < 0.001,
+                            "Check the position after step %d: %f, %f", i, direct_pos[i], ahead_pos[i]);
+    }
+
+    Mix_CloseAudio();
+
+    SDL_free(ahead);
+    SDL_free(direct);
+    SDL_free(qoa);
+
+    return TEST_COMPLETED;
+}
+
+static const SDLTest_TestCaseReference mixTest1 =
+        { (SDLTest_TestCaseFp)mix_decode_ahead_match, "mix_decode_ahead_match", "Tests that decoding ahead renders the same as decoding in the callback", TEST_ENABLED };
+
+static const SDLTest_TestCaseReference *mixTests[] =  {
+    &mixTest1,
+    NULL
+};
+
+SDLTest_TestSuiteReference mixDecodeAheadTestSuite = {
+    "mix_decode_ahead",
+    NULL,
+    mixTests,
+    NULL
+};
+
+/* All test suites */
+SDLTest_TestSuiteReference *testSuites[] =  {
+    &mixDecodeAheadTestSuite,
+    NULL
+};
+
+/* Call this instead of exit(), so we can clean up SDL: atexit() is evil. */
+static void quit(int rc)
+{
+    exit(rc);
+}
+
+int
+main(int argc, char *argv[])
+{
+    int result;
+    (void)argc; (void)argv;
+
+    /* Call Harness */
+    result = SDLTest_RunSuites(testSuites, NULL, 0, NULL, 1);
+
+    /* Shutdown everything */
+    quit(result);
+    return(result);
+}
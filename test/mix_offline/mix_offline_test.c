@@ -0,0 +1,123 @@
+#include "SDL_test.h"
+#include "SDL_mixer.h"
+
+#define TEST_FREQ       44100
+#define TEST_CHANNELS   2
+#define TEST_CHUNKSIZE  512
+#define TEST_FRAMES     3000
+
+static Uint32 get_le32(const Uint8 *src)
+{
+    return (Uint32)src[0] | ((Uint32)src[1] << 8) | ((Uint32)src[2] << 16) | ((Uint32)src[3] << 24);
+}
+
+static Uint16 get_le16(const Uint8 *src)
+{
+    return (Uint16)(src[0] | (src[1] << 8));
+}
+
+static int mix_offline_render(void *arg)
+{
+    Sint16 *samples, *rendered;
+    Uint8 *wav;
+    Uint32 wav_size;
+    Mix_Chunk *chunk;
+    SDL_RWops *rw;
+    int i, total = TEST_FRAMES * TEST_CHANNELS;
+    (void)arg;
+
+    samples = (Sint16 *)SDL_malloc(total * sizeof(Sint16));
+    rendered = (Sint16 *)SDL_malloc((total + TEST_CHANNELS * 100) * sizeof(Sint16));
+    for (i = 0; i < total; ++i) {
+        samples[i] = (Sint16)((i * 211) % 20000 - 10000);
+    }
+
+    SDLTest_AssertCheck(Mix_RenderFrames(rendered, 16) < 0, "Check that rendering fails before opening");
+    SDLTest_AssertCheck(Mix_OpenAudioOffline(TEST_FREQ, AUDIO_S16SYS, TEST_CHANNELS, TEST_CHUNKSIZE) == 0,
+                        "Check that mixer got been opened offline: %s", Mix_GetError());
+    SDLTest_AssertCheck(Mix_OpenAudioOffline(TEST_FREQ, AUDIO_S16SYS, TEST_CHANNELS, TEST_CHUNKSIZE) < 0,
+                        "Check that mixer can't be opened twice");
+
+    /* A chunk of the mixer format at the full volume must come out untouched */
+    chunk = Mix_QuickLoad_RAW((Uint8 *)samples, (Uint32)(total * sizeof(Sint16)));
+    SDLTest_AssertCheck(chunk != NULL, "Check that chunk got been loaded");
+    SDLTest_AssertCheck(Mix_PlayChannel(0, chunk, 0) == 0, "Check that chunk got been played");
+
+    SDLTest_AssertCheck(Mix_RenderFrames(rendered, TEST_FRAMES + 100) == TEST_FRAMES + 100,
+                        "Check that all frames got been rendered");
+    SDLTest_AssertCheck(SDL_memcmp(rendered, samples, total * sizeof(Sint16)) == 0,
+                        "Check that rendered audio is equal to the chunk");
+    for (i = total; i < total + TEST_CHANNELS * 100; ++i) {
+        if (rendered[i] != 0) {
+            break;
+        }
+    }
+    SDLTest_AssertCheck(i == total + TEST_CHANNELS * 100, "Check that the rest is silent");
+    SDLTest_AssertCheck(Mix_Playing(0) == 0, "Check that channel got been finished");
+
+    /* The WAVE header must describe the rendered data */
+    wav_size = 44 + TEST_CHUNKSIZE * 3 * TEST_CHANNELS * 2;
+    wav = (Uint8 *)SDL_calloc(1, wav_size);
+    rw = SDL_RWFromMem(wav, (int)wav_size);
+    Mix_PlayChannel(0, chunk, 0);
+    SDLTest_AssertCheck(Mix_RenderWAV_RW(rw, 1, TEST_CHUNKSIZE * 3) == 0, "Check that WAVE got been rendered: %s", Mix_GetError());
+    SDLTest_AssertCheck(SDL_memcmp(wav, "RIFF", 4) == 0 && SDL_memcmp(wav + 8, "WAVEfmt ", 8) == 0, "Check the RIFF header");
+    SDLTest_AssertCheck(get_le32(wav + 4) == wav_size - 8, "Check the RIFF size");
+    SDLTest_AssertCheck(get_le16(wav + 20) == 1 && get_le16(wav + 22) == TEST_CHANNELS &&
+                        get_le32(wav + 24) == TEST_FREQ && get_le16(wav + 34) == 16, "Check the format");
+    SDLTest_AssertCheck(SDL_memcmp(wav + 36, "data", 4) == 0 && get_le32(wav + 40) == wav_size - 44, "Check the data size");
+    SDLTest_AssertCheck(SDL_memcmp(wav + 44, samples, wav_size - 44) == 0, "Check that WAVE data is equal to the chunk");
+
+    Mix_HaltChannel(-1);
+    Mix_FreeChunk(chunk);
+    Mix_CloseAudio();
+
+    SDLTest_AssertCheck(Mix_RenderFrames(rendered, 16) < 0, "Check that rendering fails after closing");
+
+    SDL_free(wav);
+    SDL_free(rendered);
+    SDL_free(samples);
+
+    return TEST_COMPLETED;
+}
+
+static const SDLTest_TestCaseReference mixTest1 =
+        { (SDLTest_TestCaseFp)mix_offline_render, "mix_offline_render", "Tests that mixer renders without the audio device", TEST_ENABLED };
+
+static const SDLTest_TestCaseReference *mixTests[] =  {
+    &mixTest1,
+    NULL
+};
+
+SDLTest_TestSuiteReference mixOfflineTestSuite = {
+    "mix_offline",
+    NULL,
+    mixTests,
+    NULL
+};
+
+/* All test suites */
+SDLTest_TestSuiteReference *testSuites[] =  {
+    &mixOfflineTestSuite,
+    NULL
+};
+
+/* Call this instead of exit(), so we can clean up SDL: atexit() is evil. */
+static void quit(int rc)
+{
+    exit(rc);
+}
+
+int
+main(int argc, char *argv[])
+{
+    int result;
+    (void)argc; (void)argv;
+
+    /* Call Harness */
+    result = SDLTest_RunSuites(testSuites, NULL, 0, NULL, 1);
+
+    /* Shutdown everything */
+    quit(result);
+    return(result);
+}
@@ -0,0 +1,132 @@
+#include "SDL_test.h"
+#include "SDL_mixer.h"
+
+#define TEST_FREQ       44100
+#define TEST_CHANNELS   2
+#define TEST_CHUNKSIZE  512
+#define TEST_FRAMES     8192
+#define TEST_FADE_MS    10
+#define TEST_LEVEL      8000
+
+static Sint16 loud[TEST_FRAMES * TEST_CHANNELS];
+static Sint16 silent[TEST_FRAMES * TEST_CHANNELS];
+static Sint16 rendered[TEST_CHUNKSIZE * 2 * TEST_CHANNELS];
+
+static int mix_voices_steal(void *arg)
+{
+    Mix_Chunk *a, *b;
+    int i, ch, fade_frames = TEST_FREQ * TEST_FADE_MS / 1000;
+    SDL_bool ramp = SDL_TRUE;
+    (void)arg;
+
+    for (i = 0; i < TEST_FRAMES * TEST_CHANNELS; ++i) {
+        loud[i] = TEST_LEVEL;
+    }
+
+    SDLTest_AssertCheck(Mix_OpenAudioOffline(TEST_FREQ, AUDIO_S16SYS, TEST_CHANNELS, TEST_CHUNKSIZE) == 0,
+                        "Check that mixer got been opened: %s", Mix_GetError());
+    Mix_AllocateChannels(4);
+
+    a = Mix_QuickLoad_RAW((Uint8 *)loud, sizeof(loud));
+    b = Mix_QuickLoad_RAW((Uint8 *)silent, sizeof(silent));
+
+    /* Full mixer without stealing */
+    for (i = 0; i < 4; ++i) {
+        Mix_PlayChannel(-1, a, -1);
+    }
+    SDLTest_AssertCheck(Mix_PlayChannel(-1, b, 0) == -1, "Check that nothing is stolen by default");
+
+    /* The quietest voice goes first */
+    Mix_SetVoiceStealing(1, TEST_FADE_MS);
+    Mix_Volume(2, 10);
+    ch = Mix_PlayChannel(-1, b, -1);
+    SDLTest_AssertCheck(ch == 2, "Check that the quietest channel got been stolen (%d)", ch);
+
+    /* Important voices stay */
+    Mix_SetChannelPriority(-1, 5);
+    SDLTest_AssertCheck(Mix_PlayChannel(-1, b, 0) == -1, "Check that higher priority voices aren't stolen");
+    Mix_SetChunkPriority(b, 5);
+    SDLTest_AssertCheck(Mix_GetChunkPriority(b) == 5, "Check the chunk priority");
+    Mix_SetChannelPriority(1, 4);
+    ch = Mix_PlayChannel(-1, b, -1);
+    SDLTest_AssertCheck(ch == 1, "Check that the lowest priority channel got been stolen (%d)", ch);
+    SDLTest_AssertCheck(Mix_GetChannelPriority(1) == 5, "Check that channel got the chunk priority");
+
+    /* The stolen sound fades out under the new one */
+    Mix_HaltChannel(-1);
+    Mix_Volume(-1, MIX_MAX_VOLUME);
+    Mix_PlayChannel(0, a, -1);
+    Mix_RenderFrames(rendered, TEST_CHUNKSIZE);
+    Mix_AllocateChannels(1);
+    ch = Mix_PlayChannel(-1, b, -1);
+    SDLTest_AssertCheck(ch == 0, "Check that the only channel got been stolen (%d)", ch);
+    Mix_RenderFrames(rendered, TEST_CHUNKSIZE * 2);
+    for (i = 1; i < fade_frames; ++i) {
+        if (rendered[i * TEST_CHANNELS] > rendered[(i - 1) * TEST_CHANNELS]) {
+            ramp = SDL_FALSE;
+        }
+    }
+    SDLTest_AssertCheck(rendered[0] > TEST_LEVEL * 9 / 10 && ramp, "Check that the tail fades out from %d", rendered[0]);
+    SDLTest_AssertCheck(rendered[fade_frames * TEST_CHANNELS] == 0 && rendered[TEST_CHUNKSIZE * 2 * TEST_CHANNELS - 1] == 0,
+                        "Check that the tail is over after the fade");
+
+    /* Voices of the chunk are limited */
+    Mix_HaltChannel(-1);
+    Mix_AllocateChannels(8);
+    Mix_SetChunkMaxVoices(a, 2);
+    SDLTest_AssertCheck(Mix_GetChunkMaxVoices(a) == 2, "Check the voice limit");
+    SDLTest_AssertCheck(Mix_PlayChannel(-1, a, -1) == 0 && Mix_PlayChannel(-1, a, -1) == 1, "Check that chunk got been played twice");
+    Mix_RenderFrames(rendered, 16);
+    SDLTest_AssertCheck(Mix_PlayChannel(-1, a, -1) == 0, "Check that the oldest voice of the chunk got been taken");
+    Mix_SetVoiceStealing(0, 0);
+    SDLTest_AssertCheck(Mix_PlayChannel(-1, a, -1) == -1, "Check that chunk is limited without stealing");
+    SDLTest_AssertCheck(Mix_PlayChannel(-1, b, -1) == 2, "Check that other chunks aren't limited");
+
+    Mix_HaltChannel(-1);
+    Mix_FreeChunk(a);
+    Mix_FreeChunk(b);
+    Mix_CloseAudio();
+
+    return TEST_COMPLETED;
+}
+
+static const SDLTest_TestCaseReference mixTest1 =
+        { (SDLTest_TestCaseFp)mix_voices_steal, "mix_voices_steal", "Tests that busy channels are stolen by priority", TEST_ENABLED };
+
+static const SDLTest_TestCaseReference *mixTests[] =  {
+    &mixTest1,
+    NULL
+};
+
+SDLTest_TestSuiteReference mixVoicesTestSuite = {
+    "mix_voices",
+    NULL,
+    mixTests,
+    NULL
+};
+
+/* All test suites */
+SDLTest_TestSuiteReference *testSuites[] =  {
+    &mixVoicesTestSuite,
+    NULL
+};
+
+/* Call this instead of exit(), so we can clean up SDL: atexit() is evil. */
+static void quit(int rc)
+{
+    exit(rc);
+}
+
+int
+main(int argc, char *argv[])
+{
+    int result;
+    (void)argc; (void)argv;
+
+    /* Call Harness */
+    result = SDLTest_RunSuites(testSuites, NULL, 0, NULL, 1);
+
+    /* Shutdown everything */
+    quit(result);
+    return(result);
+}